@@ -0,0 +1,161 @@
+#include "AhoCorasick.h"
+#include <algorithm>
+
+namespace {
+
+bool isWordChar(QChar c) { return c.isLetterOrNumber() || c == '_'; }
+
+quint64 edgeKey(int node, char16_t c) { return (quint64(node) << 16) | c; }
+
+} // namespace
+
+AhoCorasick::AhoCorasick(const QStringList &patterns, Options options)
+    : m_patterns(patterns), m_options(options) {
+  std::fill(std::begin(m_rootAscii), std::end(m_rootAscii), 0);
+  m_nodes.append(Node());
+
+  // The trie, keeping each node's children for the breadth-first pass
+  QVector<QVector<QPair<char16_t, int>>> children(1);
+  for (int i = 0; i < m_patterns.size(); ++i) {
+    const QString &pattern = m_patterns.at(i);
+    int node = 0;
+    for (QChar c : pattern) {
+      char16_t folded = fold(c);
+      int next = m_edges.value(edgeKey(node, folded), -1);
+      if (next < 0) {
+        next = int(m_nodes.size());
+        Node created;
+        created.depth = m_nodes[node].depth + 1;
+        m_nodes.append(created);
+        children.append({});
+        children[node].append({folded, next});
+        m_edges.insert(edgeKey(node, folded), next);
+        if (node == 0 && folded < 128)
+          m_rootAscii[folded] = next;
+      }
+      node = next;
+    }
+    if (node != 0 && m_nodes[node].output < 0)
+      m_nodes[node].output = i; // The first of duplicate patterns wins
+    m_maxLength = qMax(m_maxLength, int(pattern.size()));
+  }
+
+  // Failure links, shallow nodes first so their links are ready
+  QVector<int> queue;
+  queue.reserve(m_nodes.size());
+  for (const auto &edge : std::as_const(children[0]))
+    queue.append(edge.second); // fail = 0 for depth 1
+  for (int head = 0; head < queue.size(); ++head) {
+    int node = queue[head];
+    for (const auto &edge : std::as_const(children[node])) {
+      int fail = m_nodes[node].fail;
+      while (fail != 0 && child(fail, edge.first) < 0)
+        fail = m_nodes[fail].fail;
+      int target = child(fail, edge.first);
+      Node &next = m_nodes[edge.second];
+      next.fail = target >= 0 ? target : 0;
+      const Node &failNode = m_nodes[next.fail];
+      next.next = failNode.output >= 0 ? next.fail : failNode.next;
+      queue.append(edge.second);
+    }
+  }
+}
+
+int AhoCorasick::child(int node, char16_t c) const {
+  if (node == 0 && c < 128)
+    return m_rootAscii[c] ? m_rootAscii[c] : -1;
+  return m_edges.value(edgeKey(node, c), -1);
+}
+
+char16_t AhoCorasick::fold(QChar c) const {
+  return (m_options & CaseInsensitive) ? c.toCaseFolded().unicode()
+                                       : c.unicode();
+}
+
+bool AhoCorasick::isWholeWord(QStringView text, int start, int end) const {
+  if (!(m_options & WholeWords))
+    return true;
+  return (start == 0 || !isWordChar(text[start - 1])) &&
+         (end == text.size() || !isWordChar(text[end]));
+}
+
+void AhoCorasick::collect(QStringView text, int node, int end,
+                          QVector<Match> &out) const {
+  int at = m_nodes[node].output >= 0 ? node : m_nodes[node].next;
+  for (; at > 0; at = m_nodes[at].next) {
+    const Node &hit = m_nodes[at];
+    int start = end - hit.depth;
+    if (isWholeWord(text, start, end))
+      out.append({start, hit.depth, hit.output});
+  }
+}
+
+QVector<AhoCorasick::Match> AhoCorasick::findAll(QStringView text) const {
+  QVector<Match> candidates;
+  if (m_maxLength == 0)
+    return candidates;
+
+  int state = 0;
+  for (int i = 0; i < text.size(); ++i) {
+    char16_t c = fold(text[i]);
+    while (state != 0 && child(state, c) < 0)
+      state = m_nodes[state].fail;
+    state = qMax(child(state, c), 0);
+    if (state != 0)
+      collect(text, state, i + 1, candidates);
+  }
+
+  // Leftmost, then longest, skipping anything overlapping a kept match
+  std::stable_sort(candidates.begin(), candidates.end(),
+                   [](const Match &a, const Match &b) {
+                     return a.start != b.start ? a.start < b.start
+                                               : a.length > b.length;
+                   });
+  QVector<Match> matches;
+  int keptEnd = 0;
+  for (const Match &match : std::as_const(candidates)) {
+    if (match.start >= keptEnd) {
+      matches.append(match);
+      keptEnd = match.start + match.length;
+    }
+  }
+  return matches;
+}
+
+bool AhoCorasick::find(QStringView text, Match *match, int from) const {
+  if (m_maxLength == 0)
+    return false;
+
+  QVector<Match> candidates;
+  Match best = {-1, 0, -1};
+  int state = 0;
+  for (int i = qMax(from, 0); i < text.size(); ++i) {
+    char16_t c = fold(text[i]);
+    while (state != 0 && child(state, c) < 0)
+      state = m_nodes[state].fail;
+    state = qMax(child(state, c), 0);
+    if (state == 0)
+      continue;
+
+    candidates.clear();
+    collect(text, state, i + 1, candidates);
+    for (const Match &candidate : std::as_const(candidates)) {
+      if (candidate.start < from)
+        continue;
+      if (!match)
+        return true; // Any match will do
+      if (best.start < 0 || candidate.start < best.start ||
+          (candidate.start == best.start && candidate.length > best.length))
+        best = candidate;
+    }
+
+    // Nothing further on can start earlier or be longer from there
+    if (best.start >= 0 && i + 1 >= best.start + m_maxLength)
+      break;
+  }
+
+  if (best.start < 0)
+    return false;
+  *match = best;
+  return true;
+}
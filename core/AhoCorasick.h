@@ -0,0 +1,75 @@
+#ifndef LINNOTE_AHOCORASICK_H
+#define LINNOTE_AHOCORASICK_H
+
+#include <QHash>
+#include <QString>
+#include <QStringList>
+#include <QStringView>
+#include <QVector>
+
+/**
+ * @brief Finds any of a fixed set of words in one pass over the text
+ *
+ * An Aho-Corasick automaton: built once from the word list, then each scan
+ * is linear in the text no matter how many words there are. It replaces
+ * "\b(USD|EUR|...)\b" style alternation regexes.
+ *
+ * Matches are leftmost-longest and don't overlap, like a regex alternation
+ * that lists longer words first.
+ */
+class AhoCorasick {
+public:
+  enum Option {
+    NoOptions = 0x0,
+    CaseInsensitive = 0x1, // Simple case folding on both sides
+    WholeWords = 0x2       // No letter, digit or '_' right before or after
+  };
+  Q_DECLARE_FLAGS(Options, Option)
+
+  struct Match {
+    int start;
+    int length;
+    int pattern; // Index into patterns()
+  };
+
+  explicit AhoCorasick(const QStringList &patterns = QStringList(),
+                       Options options = NoOptions);
+
+  const QStringList &patterns() const { return m_patterns; }
+  Options options() const { return m_options; }
+  bool isEmpty() const { return m_patterns.isEmpty(); }
+
+  // All matches in @p text, in order
+  QVector<Match> findAll(QStringView text) const;
+
+  // The first match starting at or after @p from
+  bool find(QStringView text, Match *match = nullptr, int from = 0) const;
+
+  bool contains(QStringView text) const { return find(text); }
+
+private:
+  struct Node {
+    int fail = 0;
+    int output = -1; // Longest pattern ending here, or -1
+    int next = -1;   // Nearest node on the fail chain with an output
+    int depth = 0;
+  };
+
+  int child(int node, char16_t c) const;
+  char16_t fold(QChar c) const;
+  bool isWholeWord(QStringView text, int start, int end) const;
+
+  // Candidate matches ending at @p end (exclusive) into @p out
+  void collect(QStringView text, int node, int end, QVector<Match> &out) const;
+
+  QStringList m_patterns;
+  Options m_options;
+  QVector<Node> m_nodes;       // m_nodes[0] is the root
+  QHash<quint64, int> m_edges; // (node << 16 | char) -> child
+  int m_rootAscii[128];        // Root transitions for ASCII, 0 if none
+  int m_maxLength = 0;
+};
+
+Q_DECLARE_OPERATORS_FOR_FLAGS(AhoCorasick::Options)
+
+#endif // LINNOTE_AHOCORASICK_H
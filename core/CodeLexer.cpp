@@ -0,0 +1,296 @@
+#include "CodeLexer.h"
+
+namespace {
+
+bool isIdentifierStart(QChar c) { return c.isLetter() || c == '_'; }
+
+bool isIdentifierChar(QChar c) { return c.isLetterOrNumber() || c == '_'; }
+
+bool isDigit(QChar c) { return c >= '0' && c <= '9'; }
+
+bool isHexDigit(QChar c) {
+  return isDigit(c) || (c >= 'a' && c <= 'f') || (c >= 'A' && c <= 'F');
+}
+
+int skipSpaces(QStringView line, int i) {
+  while (i < line.size() && line[i].isSpace())
+    ++i;
+  return i;
+}
+
+} // namespace
+
+CodeLexer::Table::Table(const Grammar &grammar) : grammar(grammar) {
+  // Keys view the strings owned by grammar, which stays unmodified
+  words.reserve(this->grammar.keywords.size() + this->grammar.types.size());
+  for (const QString &word : std::as_const(this->grammar.types))
+    words.insert(QStringView(word), Type);
+  for (const QString &word : std::as_const(this->grammar.keywords))
+    words.insert(QStringView(word), Keyword);
+}
+
+CodeLexer::CodeLexer(const Grammar &grammar) { setGrammar(grammar); }
+
+CodeLexer::CodeLexer(const QSharedPointer<const Table> &table) {
+  setTable(table);
+}
+
+void CodeLexer::setGrammar(const Grammar &grammar) {
+  m_table = compile(grammar);
+}
+
+void CodeLexer::setTable(const QSharedPointer<const Table> &table) {
+  m_table = table ? table : compile(generic());
+}
+
+QSharedPointer<const CodeLexer::Table>
+CodeLexer::compile(const Grammar &grammar) {
+  return QSharedPointer<const Table>(new Table(grammar));
+}
+
+int CodeLexer::tokenize(QStringView line, QVector<Token> &tokens,
+                        int state) const {
+  tokens.clear();
+  const int n = int(line.size());
+  int i = 0;
+
+  if (state > Normal) {
+    // Finish what the previous line left open
+    int end = findClose(line, 0, state);
+    Kind kind = state == InBlockComment ? Comment : String;
+    if (end < 0) {
+      if (n > 0)
+        tokens.append({0, n, kind});
+      return state;
+    }
+    if (end > 0)
+      tokens.append({0, end, kind});
+    i = end;
+  } else {
+    if (grammar().shebang && line.startsWith(QLatin1String("#!"))) {
+      tokens.append({0, n, Preprocessor});
+      return Normal;
+    }
+
+    if (grammar().preprocessor) {
+      int hash = skipSpaces(line, 0);
+      if (hash + 1 < n && line[hash] == '#' && line[hash + 1].isLetter()) {
+        // The whole line, then strings and comments inside it on top
+        tokens.append({hash, n - hash, Preprocessor});
+        i = hash + 1;
+        while (i < n && isIdentifierChar(line[i]))
+          ++i;
+      }
+    }
+  }
+
+  const QString &blockStart = grammar().blockCommentStart;
+
+  while (i < n) {
+    QChar c = line[i];
+
+    if (!blockStart.isEmpty() && c == blockStart.front() &&
+        line.mid(i).startsWith(blockStart)) {
+      int end = findClose(line, i + int(blockStart.size()), InBlockComment);
+      if (end < 0) {
+        tokens.append({i, n - i, Comment});
+        return InBlockComment;
+      }
+      tokens.append({i, end - i, Comment});
+      i = end;
+      continue;
+    }
+
+    bool comment = false;
+    for (const QString &marker : grammar().lineComments) {
+      if (c == marker.front() && line.mid(i).startsWith(marker)) {
+        comment = true;
+        break;
+      }
+    }
+    if (comment) {
+      tokens.append({i, n - i, Comment});
+      return Normal;
+    }
+
+    if (grammar().tripleQuotes && (c == '"' || c == '\'') && i + 2 < n &&
+        line[i + 1] == c && line[i + 2] == c) {
+      int triple = c == '"' ? InTripleDouble : InTripleSingle;
+      int end = findClose(line, i + 3, triple);
+      if (end < 0) {
+        tokens.append({i, n - i, String});
+        return triple;
+      }
+      tokens.append({i, end - i, String});
+      i = end;
+      continue;
+    }
+
+    if (grammar().quotes.contains(c)) {
+      int end = findQuote(line, i + 1, c);
+      if (end < 0) {
+        // Unterminated: to the end of the line, and beyond if allowed
+        tokens.append({i, n - i, String});
+        int quote = int(grammar().multiLineQuotes.indexOf(c));
+        return quote >= 0 && quote < MaxMultiLineQuotes ? InTemplate + quote
+                                                        : Normal;
+      }
+      Kind kind = String;
+      if (grammar().objectKeys) {
+        int next = skipSpaces(line, end);
+        if (next < n && line[next] == ':')
+          kind = Key;
+      }
+      tokens.append({i, end - i, kind});
+      i = end;
+      continue;
+    }
+
+    if (grammar().variables && c == '$' && i + 1 < n) {
+      int end = i + 1;
+      if (line[end] == '{') {
+        int close = int(line.indexOf(QLatin1Char('}'), end));
+        end = close < 0 ? n : close + 1;
+      } else if (isIdentifierStart(line[end])) {
+        while (end < n && isIdentifierChar(line[end]))
+          ++end;
+      } else if (isDigit(line[end]) ||
+                 QStringView(u"#?@*$!-").contains(line[end])) {
+        ++end; // $1, $?, $#, ...
+      }
+      if (end > i + 1) {
+        tokens.append({i, end - i, Variable});
+        i = end;
+        continue;
+      }
+    }
+
+    if (isDigit(c) && (i == 0 || !isIdentifierChar(line[i - 1]))) {
+      int end = scanNumber(line, i);
+      if (end < n && isIdentifierChar(line[end])) {
+        // "123abc" is not a number; skip the whole word
+        while (end < n && isIdentifierChar(line[end]))
+          ++end;
+      } else {
+        tokens.append({i, end - i, Number});
+      }
+      i = end;
+      continue;
+    }
+
+    if (isIdentifierStart(c)) {
+      int end = i + 1;
+      while (end < n && isIdentifierChar(line[end]))
+        ++end;
+
+      auto word = m_table->words.constFind(line.mid(i, end - i));
+      if (word != m_table->words.constEnd()) {
+        tokens.append({i, end - i, *word});
+      } else if (grammar().functionCalls) {
+        int next = skipSpaces(line, end);
+        if (next < n && line[next] == '(')
+          tokens.append({i, end - i, Function});
+      }
+      i = end;
+      continue;
+    }
+
+    ++i;
+  }
+  return Normal;
+}
+
+// End of the construct @p state stands for, or -1 if the line doesn't close it.
+// A state this grammar can't produce (the language changed) closes at once.
+int CodeLexer::findClose(QStringView line, int from, int state) const {
+  if (state >= InTemplate) {
+    // The quote that opened it, by its place in multiLineQuotes
+    int quote = state - InTemplate;
+    if (quote >= grammar().multiLineQuotes.size())
+      return from;
+    return findQuote(line, from, grammar().multiLineQuotes[quote]);
+  }
+
+  QStringView close;
+  switch (state) {
+  case InBlockComment:
+    close = grammar().blockCommentEnd;
+    break;
+  case InTripleDouble:
+    close = grammar().tripleQuotes ? QStringView(u"\"\"\"") : QStringView();
+    break;
+  case InTripleSingle:
+    close = grammar().tripleQuotes ? QStringView(u"'''") : QStringView();
+    break;
+  default:
+    return from;
+  }
+  if (close.isEmpty())
+    return from;
+
+  int at = int(line.indexOf(close, from));
+  return at < 0 ? -1 : at + int(close.size());
+}
+
+// Index after the closing @p quote, skipping backslash escapes; -1 if none
+int CodeLexer::findQuote(QStringView line, int from, QChar quote) {
+  const int n = int(line.size());
+  int i = from;
+  while (i < n) {
+    if (line[i] == '\\') {
+      i += 2;
+      continue;
+    }
+    if (line[i] == quote)
+      return i + 1;
+    ++i;
+  }
+  return -1;
+}
+
+int CodeLexer::scanNumber(QStringView line, int start) const {
+  const int n = int(line.size());
+  int i = start;
+
+  if (line[i] == '0' && i + 1 < n &&
+      (line[i + 1] == 'x' || line[i + 1] == 'X')) {
+    i += 2;
+    while (i < n && (isHexDigit(line[i]) || line[i] == '_'))
+      ++i;
+  } else {
+    while (i < n && (isDigit(line[i]) || line[i] == '_'))
+      ++i;
+    if (i < n && line[i] == '.') {
+      ++i;
+      while (i < n && isDigit(line[i]))
+        ++i;
+    }
+    if (i < n && (line[i] == 'e' || line[i] == 'E')) {
+      int exponent = i + 1;
+      if (exponent < n && (line[exponent] == '+' || line[exponent] == '-'))
+        ++exponent;
+      if (exponent < n && isDigit(line[exponent])) {
+        i = exponent;
+        while (i < n && isDigit(line[i]))
+          ++i;
+      }
+    }
+  }
+
+  while (i < n && grammar().numberSuffixes.contains(line[i]))
+    ++i;
+  return i;
+}
+
+CodeLexer::Grammar CodeLexer::generic() {
+  Grammar g;
+  g.name = "generic";
+  g.keywords = {"if",    "else", "for",      "while", "return",
+                "class", "def",  "function", "const", "let",
+                "var",   "int",  "void",     "true",  "false"};
+  g.lineComments = {"//", "#"};
+  g.blockCommentStart = "/*";
+  g.blockCommentEnd = "*/";
+  g.quotes = "\"'";
+  return g;
+}
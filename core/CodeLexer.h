@@ -0,0 +1,125 @@
+#ifndef LINNOTE_CODELEXER_H
+#define LINNOTE_CODELEXER_H
+
+#include <QHash>
+#include <QSharedPointer>
+#include <QString>
+#include <QStringList>
+#include <QStringView>
+#include <QVector>
+
+/**
+ * @brief Single-pass tokenizer for code highlighting
+ *
+ * A language is plain data (Grammar, read from a grammar file by
+ * GrammarRegistry). compile() turns it into a Table once: word lists go
+ * into one hash, shared by every lexer for that language. A hand-written
+ * scanner finds strings, numbers, comments and identifiers in one
+ * left-to-right pass over the line. Only tokens that get a color are
+ * reported; everything else is plain text.
+ *
+ * Block comments and multi-line strings carry over to the next line as a
+ * State, which the highlighter stores as the block state.
+ */
+class CodeLexer {
+public:
+  enum Kind : quint8 {
+    Keyword,
+    Type,
+    Function,
+    String,
+    Number,
+    Comment,
+    Preprocessor,
+    Variable, // $name in shells
+    Key,      // "key": in JSON
+    KindCount
+  };
+
+  // Where a line ends; passed in when tokenizing the next line
+  enum State {
+    Normal = 0,
+    InBlockComment,
+    InTripleDouble, // Python """
+    InTripleSingle, // Python '''
+    InTemplate      // JavaScript `template`; see MaxMultiLineQuotes
+  };
+
+  // A string left open by the i-th of Grammar::multiLineQuotes ends the
+  // line in state InTemplate + i, so the next line looks for its quote.
+  // Any State fits in 3 bits.
+  static constexpr int MaxMultiLineQuotes = 4;
+
+  struct Token {
+    int start;
+    int length;
+    Kind kind;
+  };
+
+  struct Grammar {
+    QString name;
+    QStringList keywords;
+    QStringList types;
+    QStringList lineComments; // e.g. "//", "#"
+    QString blockCommentStart; // e.g. "/*"
+    QString blockCommentEnd;   // e.g. "*/"
+    QString quotes;            // Characters that open a string
+    QString multiLineQuotes;   // Of those, the ones whose strings span lines
+    QString numberSuffixes;   // e.g. "fFlLuU" for C/C++
+    bool functionCalls = false; // name( is a function
+    bool preprocessor = false;  // #directive lines (C/C++)
+    bool shebang = false;       // #! lines
+    bool variables = false;     // $name, ${name}, $1, $?
+    bool objectKeys = false;    // A string followed by ':' is a key
+    bool tripleQuotes = false;  // """ and ''' strings span lines
+  };
+
+  // A Grammar ready for lookups; immutable, so lexers can share one
+  struct Table {
+    explicit Table(const Grammar &grammar);
+
+    const Grammar grammar;
+    QHash<QStringView, Kind> words; // Views into grammar's lists
+
+  private:
+    Q_DISABLE_COPY(Table)
+  };
+
+  static QSharedPointer<const Table> compile(const Grammar &grammar);
+
+  explicit CodeLexer(const Grammar &grammar = Grammar());
+  explicit CodeLexer(const QSharedPointer<const Table> &table);
+
+  // Compiles @p grammar for this lexer alone
+  void setGrammar(const Grammar &grammar);
+
+  // Shares a compiled table; null means generic()
+  void setTable(const QSharedPointer<const Table> &table);
+
+  const Grammar &grammar() const { return m_table->grammar; }
+
+  /**
+   * @brief Tokenize one line; @p tokens is cleared first
+   * @param state The State the previous line ended in
+   * @return The State this line ends in
+   *
+   * Tokens come in order and don't overlap, except that a preprocessor
+   * line is reported as a whole first, followed by the tokens inside it.
+   */
+  int tokenize(QStringView line, QVector<Token> &tokens,
+               int state = Normal) const;
+
+  // Fallback for code in a language without a grammar file
+  static Grammar generic();
+
+private:
+  Q_DISABLE_COPY(CodeLexer)
+
+  int findClose(QStringView line, int from, int state) const;
+  static int findQuote(QStringView line, int from, QChar quote);
+  int scanNumber(QStringView line, int start) const;
+
+  QSharedPointer<const Table> m_table;
+};
+
+#endif // LINNOTE_CODELEXER_H
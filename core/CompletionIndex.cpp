@@ -0,0 +1,187 @@
+#include "CompletionIndex.h"
+#include <algorithm>
+
+namespace {
+
+// Each touch() weighs this much more than the one before, so about 35 uses
+// back count half as much as the latest
+constexpr double WeightGrowth = 1.02;
+
+// Scores are scaled down together before they get near overflow
+constexpr double MaxWeight = 1e100;
+
+quint64 edgeKey(int node, char16_t c) { return (quint64(node) << 16) | c; }
+
+char16_t fold(QChar c) { return c.toCaseFolded().unicode(); }
+
+} // namespace
+
+CompletionIndex::CompletionIndex() {
+  m_nodes.append(Node());
+  m_children.append({});
+}
+
+bool CompletionIndex::insert(const QString &word, Kind kind) {
+  if (word.isEmpty() || find(word) >= 0)
+    return false;
+
+  int node = 0;
+  for (QChar c : word) {
+    char16_t folded = fold(c);
+    int next = child(node, folded);
+    if (next < 0) {
+      next = int(m_nodes.size());
+      Node created;
+      created.parent = node;
+      m_nodes.append(created);
+      m_children.append({});
+      m_children[node].append(next);
+      m_edges.insert(edgeKey(node, folded), next);
+    }
+    node = next;
+  }
+
+  int entry;
+  if (!m_freeEntries.isEmpty()) {
+    entry = m_freeEntries.takeLast();
+  } else {
+    entry = int(m_entries.size());
+    m_entries.append(Entry());
+  }
+  m_entries[entry] = {word, kind, 0, node};
+  m_nodes[node].entry = entry;
+  ++m_size;
+  promote(entry);
+  return true;
+}
+
+bool CompletionIndex::remove(QStringView word) {
+  int entry = find(word);
+  if (entry < 0)
+    return false;
+
+  // Nodes stay behind for the next word with this prefix
+  m_nodes[m_entries[entry].node].entry = -1;
+  demote(entry);
+  m_entries[entry] = Entry();
+  m_freeEntries.append(entry);
+  --m_size;
+  return true;
+}
+
+bool CompletionIndex::contains(QStringView word) const {
+  return find(word) >= 0;
+}
+
+void CompletionIndex::touch(QStringView word) {
+  int entry = find(word);
+  if (entry < 0)
+    return;
+
+  m_entries[entry].score += m_weight;
+  m_weight *= WeightGrowth;
+  if (m_weight > MaxWeight) {
+    // The same factor for all keeps the order, and so the nodes' lists
+    for (Entry &each : m_entries)
+      each.score /= MaxWeight;
+    m_weight /= MaxWeight;
+  }
+  promote(entry);
+}
+
+QStringList CompletionIndex::complete(QStringView prefix, int limit) const {
+  QStringList words;
+  int node = 0;
+  for (QChar c : prefix) {
+    node = child(node, fold(c));
+    if (node < 0)
+      return words;
+  }
+
+  limit = qMin(limit, TopCount);
+  for (int entry : m_nodes[node].top) {
+    if (words.size() >= limit)
+      break;
+    if (m_entries[entry].word.size() > prefix.size())
+      words.append(m_entries[entry].word);
+  }
+  return words;
+}
+
+QString CompletionIndex::best(QStringView prefix) const {
+  QStringList words = complete(prefix, 1);
+  return words.isEmpty() ? QString() : words.first();
+}
+
+int CompletionIndex::find(QStringView word) const {
+  if (word.isEmpty())
+    return -1;
+  int node = 0;
+  for (QChar c : word) {
+    node = child(node, fold(c));
+    if (node < 0)
+      return -1;
+  }
+  return m_nodes[node].entry;
+}
+
+int CompletionIndex::child(int node, char16_t c) const {
+  return m_edges.value(edgeKey(node, c), -1);
+}
+
+bool CompletionIndex::ranksBefore(int a, int b) const {
+  const Entry &first = m_entries[a];
+  const Entry &second = m_entries[b];
+  if (first.score != second.score)
+    return first.score > second.score;
+  if (first.kind != second.kind)
+    return first.kind < second.kind;
+  if (first.word.size() != second.word.size())
+    return first.word.size() < second.word.size();
+  return first.word < second.word;
+}
+
+void CompletionIndex::promote(int entry) {
+  // Only this entry ranks higher than before, so each list on its path
+  // either has it move up or take it in place of its last
+  for (int node = m_entries[entry].node; node >= 0;
+       node = m_nodes[node].parent) {
+    auto &top = m_nodes[node].top;
+    auto it = std::find(top.begin(), top.end(), entry);
+    if (it != top.end()) {
+      top.erase(it);
+    } else if (top.size() == KeptCount) {
+      if (!ranksBefore(entry, top.last()))
+        return; // Nor does it make any list further up
+      top.removeLast();
+    }
+    auto at = std::find_if(top.begin(), top.end(), [&](int other) {
+      return ranksBefore(entry, other);
+    });
+    top.insert(at, entry);
+  }
+}
+
+void CompletionIndex::demote(int entry) {
+  // Lists that had it are made up again from the node's own word and its
+  // children's lists, which are complete since they come first
+  int node = m_entries[entry].node;
+  while (node >= 0) {
+    auto &top = m_nodes[node].top;
+    if (!top.contains(entry))
+      return;
+
+    QVector<int> candidates;
+    if (m_nodes[node].entry >= 0)
+      candidates.append(m_nodes[node].entry);
+    for (int next : std::as_const(m_children[node]))
+      candidates.append(m_nodes[next].top.begin(), m_nodes[next].top.end());
+    std::sort(candidates.begin(), candidates.end(),
+              [this](int a, int b) { return ranksBefore(a, b); });
+
+    top.clear();
+    for (int i = 0; i < candidates.size() && i < KeptCount; ++i)
+      top.append(candidates[i]);
+    node = m_nodes[node].parent;
+  }
+}
@@ -0,0 +1,83 @@
+#ifndef LINNOTE_COMPLETIONINDEX_H
+#define LINNOTE_COMPLETIONINDEX_H
+
+#include <QHash>
+#include <QString>
+#include <QStringList>
+#include <QStringView>
+#include <QVarLengthArray>
+#include <QVector>
+
+/**
+ * @brief Case-insensitive prefix lookup of words to complete, best first
+ *
+ * A trie over the folded words. Each node keeps the KeptCount best ranked
+ * words below it, one more than the TopCount a lookup returns: the word
+ * ending at the node may be among them and is no completion of its own
+ * prefix. So a lookup is a walk down the prefix and nothing more, however
+ * many words there are.
+ *
+ * Words rank by use: touch() adds a weight that grows a little with every
+ * call, so recent uses count for more than old ones and frequent ones add
+ * up. Only the touched word moves, so keeping the nodes' lists up to date
+ * is a walk up its path. Unused words rank by kind, then shorter first.
+ */
+class CompletionIndex {
+public:
+  // In order of preference between words that weren't used yet
+  enum Kind { Variable, Function, Unit, Currency, Command };
+
+  static constexpr int TopCount = 4; // Most completions per prefix
+
+  CompletionIndex();
+
+  // False if the word is already in, in any case or kind
+  bool insert(const QString &word, Kind kind);
+  bool remove(QStringView word);
+  bool contains(QStringView word) const;
+  int size() const { return m_size; }
+
+  // Records a use of @p word, e.g. defined again or completed to
+  void touch(QStringView word);
+
+  // The best words starting with @p prefix and longer than it, best
+  // first; at most @p limit, and never more than TopCount
+  QStringList complete(QStringView prefix, int limit = TopCount) const;
+
+  // complete(prefix, 1), or an empty string
+  QString best(QStringView prefix) const;
+
+private:
+  struct Entry {
+    QString word;
+    Kind kind = Variable;
+    double score = 0;
+    int node = -1; // -1 once removed
+  };
+
+  // One more than TopCount, as the prefix itself may be among them and
+  // is no completion of itself
+  static constexpr int KeptCount = TopCount + 1;
+
+  struct Node {
+    int parent = -1;
+    int entry = -1;                      // Word ending here, or -1
+    QVarLengthArray<int, KeptCount> top; // Best entries below, best first
+  };
+
+  int find(QStringView word) const;
+  int child(int node, char16_t c) const;
+  bool ranksBefore(int a, int b) const;
+  void promote(int entry); // After insert or a higher score
+  void demote(int entry);  // Before it goes away
+
+  QVector<Node> m_nodes;            // m_nodes[0] is the root
+  QHash<quint64, int> m_edges;      // (node << 16 | char) -> child
+  QVector<QVector<int>> m_children; // For demote(); parallel to m_nodes
+  QVector<Entry> m_entries;
+  QVector<int> m_freeEntries;
+  double m_weight = 1; // Added by the next touch()
+  int m_size = 0;
+};
+
+#endif // LINNOTE_COMPLETIONINDEX_H
@@ -1,15 +1,21 @@
 #include "CurrencyConverter.h"
+#include "RateFetchScheduler.h"
+#include "RateHistory.h"
 #include "Settings.h"
 #include <QDebug>
+#include <QDateTime>
 #include <QDir>
 #include <QFile>
+#include <QFileInfo>
 #include <QJsonArray>
 #include <QJsonDocument>
 #include <QJsonObject>
 #include <QNetworkReply>
-#include <QRegularExpression>
+#include <QReadLocker>
 #include <QStandardPaths>
-#include <QTimer>
+#include <QWriteLocker>
+#include <algorithm>
+#include <iterator>
 
 CurrencyConverter *CurrencyConverter::instance() {
   static CurrencyConverter instance;
@@ -18,12 +24,43 @@ CurrencyConverter *CurrencyConverter::instance() {
 
 CurrencyConverter::CurrencyConverter(QObject *parent)
     : QObject(parent), m_networkManager(new QNetworkAccessManager(this)),
-      m_baseCurrency("USD"), m_provider("frankfurter"), m_ratesLoaded(false) {
+      m_scheduler(nullptr), m_history(nullptr), m_backfillDays(0),
+      m_baseCurrency("USD"), m_provider("frankfurter"), m_targetId(-1),
+      m_ratesLoaded(false) {
   // Frankfurter.dev is free and doesn't require API key
   m_apiKey = "";
 
+  // Read by the Math sheet worker, so it must not call into Settings
+  m_targetCurrency = Settings::instance()->baseCurrency().toUpper();
+  connect(Settings::instance(), &Settings::settingsChanged, this, [this]() {
+    {
+      QWriteLocker locker(&m_ratesLock);
+      m_targetCurrency = Settings::instance()->baseCurrency().toUpper();
+      m_targetId = currencyId(m_targetCurrency);
+    }
+    configureSources(); // Crypto API key may have changed
+  });
+
+  // One batched request per provider, at most once per refresh interval
+  m_scheduler = new RateFetchScheduler(m_networkManager, this);
+  m_scheduler->setIntervalMinutes(
+      Settings::instance()->refreshIntervalMinutes());
+  connect(Settings::instance(), &Settings::refreshIntervalChanged, m_scheduler,
+          &RateFetchScheduler::setIntervalMinutes);
+  connect(m_scheduler, &RateFetchScheduler::fetched, this,
+          &CurrencyConverter::onRatesFetched);
+  connect(m_scheduler, &RateFetchScheduler::notModified, this,
+          &CurrencyConverter::onRatesNotModified);
+  connect(m_scheduler, &RateFetchScheduler::failed, this,
+          &CurrencyConverter::onRatesFetchFailed);
+  configureSources();
+
+  // Also restores ETags and fetch times, so a restart doesn't refetch
   loadCachedRates();
 
+  m_history = new RateHistory(
+      QFileInfo(cachePath()).absolutePath() + "/rate_history.bin");
+
   // If no cached rates, use fallback hardcoded rates
   if (m_rates.isEmpty()) {
     // Fiat currencies (approximate rates to USD)
@@ -74,149 +111,496 @@ CurrencyConverter::CurrencyConverter(QObject *parent)
     m_ratesLoaded = true;
   }
 
-  // Auto-refresh rates on startup (1 second delay to let app initialize)
-  QTimer::singleShot(1000, this, &CurrencyConverter::refreshRates);
+  QWriteLocker locker(&m_ratesLock);
+  rebuildRateMatrix();
 }
 
-void CurrencyConverter::setApiKey(const QString &key) { m_apiKey = key; }
+CurrencyConverter::~CurrencyConverter() { delete m_history; }
+
+void CurrencyConverter::setApiKey(const QString &key) {
+  m_apiKey = key;
+  configureSources();
+}
 
 void CurrencyConverter::setProvider(const QString &provider) {
   m_provider = provider;
+  configureSources();
 }
 
-double CurrencyConverter::convert(double amount, const QString &from,
-                                  const QString &to) {
-  QString fromUpper = from.toUpper();
-  QString toUpper = to.toUpper();
+namespace {
+
+// Currency symbols, recognized before or after the amount
+struct CurrencySymbol {
+  char16_t symbol;
+  const char *code;
+};
+const CurrencySymbol CurrencySymbols[] = {
+    {u'$', "USD"}, {u'€', "EUR"}, {u'₺', "TRY"}, {u'£', "GBP"},
+    {u'¥', "JPY"}, {u'₽', "RUB"}, {u'₿', "BTC"}, {u'Ξ', "ETH"}};
+constexpr int SymbolCount = int(std::size(CurrencySymbols));
+
+int symbolIndex(QChar c) {
+  for (int i = 0; i < SymbolCount; ++i) {
+    if (c.unicode() == CurrencySymbols[i].symbol)
+      return i;
+  }
+  return -1;
+}
 
-  if (!m_rates.contains(fromUpper) || !m_rates.contains(toUpper)) {
-    qDebug() << "CurrencyConverter: Unknown currency" << fromUpper << "or"
-             << toUpper;
-    return -1;
+bool isAsciiLetter(QChar c) {
+  char16_t u = c.unicode();
+  return (u >= 'A' && u <= 'Z') || (u >= 'a' && u <= 'z');
+}
+
+bool isAsciiDigit(QChar c) { return c.unicode() >= '0' && c.unicode() <= '9'; }
+
+bool isAsciiWordChar(QChar c) {
+  return isAsciiLetter(c) || isAsciiDigit(c) || c == '_';
+}
+
+// Two to five letters, case folded, packed base 27; 0 if not a code
+quint32 packCode(QStringView code) {
+  if (code.size() < 2 || code.size() > 5)
+    return 0;
+  quint32 key = 0;
+  for (QChar c : code) {
+    if (!isAsciiLetter(c))
+      return 0;
+    key = key * 27 + ((c.unicode() | 0x20) - 'a' + 1);
   }
+  return key;
+}
 
-  // Convert through base currency (USD)
-  double fromRate = m_rates[fromUpper];
-  double toRate = m_rates[toUpper];
+bool isWord(QStringView token, const char *word) {
+  return token.compare(QLatin1String(word), Qt::CaseInsensitive) == 0;
+}
 
-  // amount in FROM -> USD -> TO
-  double inBase = amount / fromRate; // to USD
-  double result = inBase * toRate;   // to target
+// Rates are doubles from the API; round the cross rate once, then keep
+// the multiplication exact
+Decimal applyCrossRate(const Decimal &amount, double rate, bool same) {
+  Decimal crossRate = same ? Decimal(1, 12) : Decimal::fromDouble(rate, 12);
+  return (amount * crossRate).rescaled(amount.scale());
+}
 
-  return result;
+} // namespace
+
+void CurrencyConverter::rebuildRateMatrix() {
+  m_currencyIds.clear();
+  m_currencyCodes.clear();
+
+  QVector<double> rates;
+  rates.reserve(m_rates.size());
+  for (auto it = m_rates.constBegin(); it != m_rates.constEnd(); ++it) {
+    quint32 key = packCode(it.key());
+    if (!key || !(it.value() > 0) || m_currencyIds.contains(key))
+      continue;
+    m_currencyIds.insert(key, m_currencyCodes.size());
+    m_currencyCodes.append(it.key().toUpper());
+    rates.append(it.value());
+  }
+
+  // Rates are per USD, so FROM -> TO is rate[TO] / rate[FROM]
+  const int count = m_currencyCodes.size();
+  m_crossRates.resize(qsizetype(count) * count);
+  for (int from = 0; from < count; ++from) {
+    for (int to = 0; to < count; ++to) {
+      m_crossRates[qsizetype(from) * count + to] =
+          from == to ? 1.0 : rates[to] / rates[from];
+    }
+  }
+
+  // What mentionsCurrency() looks for: three to five letter codes
+  QStringList matchable;
+  for (const QString &code : std::as_const(m_currencyCodes)) {
+    if (code.size() >= 3)
+      matchable.append(code);
+  }
+  m_codeMatcher = AhoCorasick(matchable, AhoCorasick::CaseInsensitive);
+
+  m_symbolIds.resize(SymbolCount);
+  for (int i = 0; i < SymbolCount; ++i) {
+    m_symbolIds[i] = currencyId(QString::fromLatin1(CurrencySymbols[i].code));
+  }
+  m_targetId = currencyId(m_targetCurrency);
 }
 
-bool CurrencyConverter::parseAndConvert(const QString &expression,
-                                        double &result, QString &fromCurrency,
-                                        QString &toCurrency) {
-  // Currency symbol mapping
-  static const QMap<QString, QString> symbolToCode = {
-      {"$", "USD"}, {"€", "EUR"}, {"₺", "TRY"}, {"£", "GBP"},
-      {"¥", "JPY"}, {"₽", "RUB"}, {"₿", "BTC"}, {"Ξ", "ETH"}};
-
-  QString expr = expression.trimmed();
-
-  // Replace symbols with codes for easier parsing
-  for (auto it = symbolToCode.constBegin(); it != symbolToCode.constEnd();
-       ++it) {
-    expr.replace(it.key(), it.value());
-  }
-
-  // Pattern 1: "100 USD to TRY" or "100USD TRY" or "100 usd -> try"
-  // Support 2-5 char symbols for crypto (BTC, ETH, USDT, MATIC, etc)
-  static QRegularExpression fullPattern(
-      R"((\d+(?:[.,]\d+)?)\s*([A-Za-z]{2,5})\s*(?:to|->|=>|>)?\s*([A-Za-z]{2,5}))",
-      QRegularExpression::CaseInsensitiveOption);
-
-  // Pattern 2: "100 USD" (no target - use base currency)
-  static QRegularExpression shortPattern(
-      R"((\d+(?:[.,]\d+)?)\s*([A-Za-z]{2,5})$)",
-      QRegularExpression::CaseInsensitiveOption);
-
-  QRegularExpressionMatch match = fullPattern.match(expr);
-  if (match.hasMatch()) {
-    QString amountStr = match.captured(1).replace(',', '.');
-    fromCurrency = match.captured(2).toUpper();
-    toCurrency = match.captured(3).toUpper();
-
-    bool ok;
-    double amount = amountStr.toDouble(&ok);
-    if (!ok)
-      return false;
-
-    double converted = convert(amount, fromCurrency, toCurrency);
-    if (converted < 0)
-      return false;
-
-    result = converted;
+int CurrencyConverter::currencyId(QStringView code) const {
+  quint32 key = packCode(code);
+  return key ? m_currencyIds.value(key, -1) : -1;
+}
+
+bool CurrencyConverter::crossRate(int from, int to, const QDate &date,
+                                  double &rate) const {
+  if (!date.isValid()) {
+    rate = m_crossRates[qsizetype(from) * m_currencyCodes.size() + to];
     return true;
   }
 
-  // Try short pattern: "100 USD" -> convert to base currency
-  match = shortPattern.match(expr);
-  if (match.hasMatch()) {
-    QString amountStr = match.captured(1).replace(',', '.');
-    fromCurrency = match.captured(2).toUpper();
-    toCurrency = Settings::instance()->baseCurrency().toUpper();
+  // Historical: never fall back to today's rates
+  double fromRate, toRate;
+  if (!m_history->rateOn(m_currencyCodes[from], date, fromRate) ||
+      !m_history->rateOn(m_currencyCodes[to], date, toRate))
+    return false;
+  rate = from == to ? 1.0 : toRate / fromRate;
+  return true;
+}
+
+double CurrencyConverter::convert(double amount, const QString &from,
+                                  const QString &to, const QDate &date) {
+  QReadLocker locker(&m_ratesLock);
+  int fromId = currencyId(from);
+  int toId = currencyId(to);
+
+  double rate;
+  if (fromId < 0 || toId < 0 || !crossRate(fromId, toId, date, rate)) {
+    qDebug() << "CurrencyConverter: No rate for" << from << "or" << to
+             << date;
+    return -1;
+  }
+  return amount * rate;
+}
 
-    // Don't convert if from and to are the same
-    if (fromCurrency == toCurrency)
-      return false;
+Decimal CurrencyConverter::convertDecimal(const Decimal &amount,
+                                          const QString &from,
+                                          const QString &to, bool *ok,
+                                          const QDate &date) {
+  if (ok)
+    *ok = false;
+
+  QReadLocker locker(&m_ratesLock);
+  int fromId = currencyId(from);
+  int toId = currencyId(to);
+
+  double rate;
+  if (fromId < 0 || toId < 0 || !crossRate(fromId, toId, date, rate)) {
+    qDebug() << "CurrencyConverter: No rate for" << from << "or" << to
+             << date;
+    return Decimal();
+  }
 
-    bool ok;
-    double amount = amountStr.toDouble(&ok);
-    if (!ok)
-      return false;
+  Decimal result = applyCrossRate(amount, rate, fromId == toId);
+  if (ok)
+    *ok = result.isValid();
+  return result;
+}
 
-    double converted = convert(amount, fromCurrency, toCurrency);
-    if (converted < 0)
-      return false;
+bool CurrencyConverter::scanExpression(QStringView text,
+                                       Expression &expr) const {
+  const qsizetype n = text.size();
+
+  auto skipSpaces = [&](qsizetype &p) {
+    while (p < n && text[p].isSpace())
+      ++p;
+  };
+
+  // Letters from p; the run must not continue into more letters
+  auto wordAt = [&](qsizetype p) {
+    qsizetype end = p;
+    while (end < n && isAsciiLetter(text[end]))
+      ++end;
+    return text.mid(p, end - p);
+  };
+
+  // A symbol or a known code at p; advances p past it
+  auto currencyAt = [&](qsizetype &p) {
+    if (p >= n)
+      return -1;
+    int symbol = symbolIndex(text[p]);
+    if (symbol >= 0) {
+      ++p;
+      return m_symbolIds[symbol];
+    }
+    QStringView word = wordAt(p);
+    int id = currencyId(word);
+    if (id >= 0)
+      p += word.size();
+    return id;
+  };
+
+  // Each amount in the line is tried once, left to right:
+  // [symbol] amount [symbol | code] [to | in | as | -> | => | >]
+  // [symbol | code] [@yyyy-MM-dd]
+  for (qsizetype start = 0; start < n; ++start) {
+    qsizetype p = start;
+    int prefix = -1;
+    if (symbolIndex(text[p]) >= 0) {
+      prefix = currencyAt(p);
+      skipSpaces(p);
+    }
+    if (p >= n || !isAsciiDigit(text[p]))
+      continue;
+
+    // Amount: digits with an optional '.' or ',' fraction
+    qsizetype amountStart = p;
+    while (p < n && isAsciiDigit(text[p]))
+      ++p;
+    if (p + 1 < n && (text[p] == '.' || text[p] == ',') &&
+        isAsciiDigit(text[p + 1])) {
+      p++;
+      while (p < n && isAsciiDigit(text[p]))
+        ++p;
+    }
+    QStringView amount = text.mid(amountStart, p - amountStart);
+    qsizetype amountEnd = p;
+
+    // Source: the prefix symbol, or a symbol or code after the amount
+    skipSpaces(p);
+    int from = prefix;
+    if (from < 0)
+      from = currencyAt(p);
+    if (from < 0) {
+      start = amountEnd - 1; // Next attempt after this number
+      continue;
+    }
 
-    result = converted;
+    // Separator and target
+    skipSpaces(p);
+    qsizetype afterSource = p;
+    bool separator = false;
+    if (p + 1 < n && (text[p] == '-' || text[p] == '=') &&
+        text[p + 1] == '>') {
+      p += 2;
+      separator = true;
+    } else if (p < n && text[p] == '>') {
+      p++;
+      separator = true;
+    } else {
+      QStringView word = wordAt(p);
+      if (isWord(word, "to") || isWord(word, "in") || isWord(word, "as")) {
+        p += word.size();
+        separator = true;
+      }
+    }
+    skipSpaces(p);
+    int to = currencyAt(p);
+    if (to < 0 && separator) {
+      start = amountEnd - 1;
+      continue;
+    }
+    if (to < 0)
+      p = afterSource;
+
+    // Optional date
+    skipSpaces(p);
+    QDate date;
+    if (p < n && text[p] == '@') {
+      ++p;
+      skipSpaces(p);
+      QStringView digits = text.mid(p, 10);
+      bool ok = digits.size() == 10 && digits[4] == '-' && digits[7] == '-';
+      int year = ok ? digits.mid(0, 4).toInt(&ok) : 0;
+      int month = ok ? digits.mid(5, 2).toInt(&ok) : 0;
+      int day = ok ? digits.mid(8, 2).toInt(&ok) : 0;
+      date = QDate(year, month, day);
+      if (!ok || !date.isValid())
+        return false;
+      p += 10;
+      skipSpaces(p);
+    }
+
+    if (to < 0) {
+      // "100 USD": into the base currency, only at the end of the line and
+      // only if that is a different currency
+      if (p < n || m_targetId < 0 || m_targetId == from) {
+        start = amountEnd - 1;
+        continue;
+      }
+      to = m_targetId;
+    }
+
+    expr.amount = amount;
+    expr.from = from;
+    expr.to = to;
+    expr.date = date;
     return true;
   }
+  return false;
+}
+
+bool CurrencyConverter::scanAndRate(const QString &expression,
+                                    QString &amount, QString &fromCurrency,
+                                    QString &toCurrency, double &rate) const {
+  QReadLocker locker(&m_ratesLock);
+  Expression expr;
+  if (!scanExpression(expression, expr))
+    return false;
+
+  amount = expr.amount.toString().replace(',', '.');
+  fromCurrency = m_currencyCodes[expr.from];
+  toCurrency = m_currencyCodes[expr.to];
+  return crossRate(expr.from, expr.to, expr.date, rate);
+}
+
+bool CurrencyConverter::parseAndConvert(const QString &expression,
+                                        double &result, QString &fromCurrency,
+                                        QString &toCurrency) {
+  QString amountStr;
+  double rate;
+  if (!scanAndRate(expression, amountStr, fromCurrency, toCurrency, rate))
+    return false;
+
+  bool ok;
+  double amount = amountStr.toDouble(&ok);
+  if (!ok)
+    return false;
+
+  result = amount * rate;
+  return true;
+}
+
+bool CurrencyConverter::parseAndConvertDecimal(const QString &expression,
+                                               int scale, Decimal &result,
+                                               QString &fromCurrency,
+                                               QString &toCurrency) {
+  QString amountStr;
+  double rate;
+  if (!scanAndRate(expression, amountStr, fromCurrency, toCurrency, rate))
+    return false;
+
+  bool ok;
+  Decimal amount = Decimal::fromString(amountStr, scale, &ok);
+  if (!ok)
+    return false;
+
+  Decimal converted =
+      applyCrossRate(amount, rate, fromCurrency == toCurrency);
+  if (!converted.isValid())
+    return false;
+
+  result = converted;
+  return true;
+}
+
+bool CurrencyConverter::mentionsCurrency(const QString &text) const {
+  for (const CurrencySymbol &symbol : CurrencySymbols) {
+    if (text.contains(QChar(symbol.symbol)))
+      return true;
+  }
 
+  // "100 usd" / "100USD" or an upper-case code anywhere, in one pass
+  QReadLocker locker(&m_ratesLock);
+  for (const AhoCorasick::Match &match : m_codeMatcher.findAll(text)) {
+    int end = match.start + match.length;
+    if (end < text.size() && isAsciiWordChar(text[end]))
+      continue;
+
+    int before = match.start - 1;
+    while (before >= 0 && text[before].isSpace())
+      --before;
+    if (before >= 0 && isAsciiDigit(text[before]))
+      return true;
+
+    if (match.start > 0 && isAsciiWordChar(text[match.start - 1]))
+      continue;
+    QStringView code = QStringView(text).mid(match.start, match.length);
+    if (std::all_of(code.begin(), code.end(),
+                    [](QChar c) { return c.isUpper(); }))
+      return true;
+  }
   return false;
 }
 
 void CurrencyConverter::refreshRates() {
-  // Frankfurter.dev doesn't require API key
-  if (m_provider != "frankfurter" && m_apiKey.isEmpty()) {
+  configureSources();
+
+  if (buildApiUrl().isEmpty()) {
+    emit error("Unknown provider: " + m_provider);
+  } else if (m_provider != "frankfurter" && m_apiKey.isEmpty()) {
+    // Frankfurter.dev doesn't require API key
     qDebug() << "CurrencyConverter: No API key set, using cached rates";
-    // Still fetch crypto rates (CoinGecko is free)
-    refreshCryptoRates();
-    return;
   }
 
+  // Manual refresh skips the interval, but still sends validators
+  m_scheduler->refresh(true);
+}
+
+void CurrencyConverter::refreshRatesIfStale() { m_scheduler->refresh(false); }
+
+// Crypto symbols and their CoinGecko IDs
+static const QList<QPair<QString, QString>> &cryptoCoins() {
+  static const QList<QPair<QString, QString>> coins = {
+      {"BTC", "bitcoin"},     {"ETH", "ethereum"},     {"USDT", "tether"},
+      {"USDC", "usd-coin"},   {"BNB", "binancecoin"},  {"XRP", "ripple"},
+      {"ADA", "cardano"},     {"DOGE", "dogecoin"},    {"SOL", "solana"},
+      {"TRX", "tron"},        {"DOT", "polkadot"},     {"LTC", "litecoin"},
+      {"MATIC", "matic-network"}};
+  return coins;
+}
+
+void CurrencyConverter::configureSources() {
+  // Fiat: one request to the selected provider
   QString url = buildApiUrl();
-  if (url.isEmpty()) {
-    emit error("Unknown provider: " + m_provider);
-    refreshCryptoRates(); // Still try crypto
-    return;
-  }
+  if (url.isEmpty() || (m_provider != "frankfurter" && m_apiKey.isEmpty())) {
+    m_scheduler->removeEndpoint("fiat");
+  } else {
+    QNetworkRequest request{QUrl(url)};
 
-  QNetworkRequest request(url);
+    // CoinAPI requires API key in header
+    if (m_provider == "coinapi") {
+      request.setRawHeader("X-CoinAPI-Key", m_apiKey.toUtf8());
+    }
+    m_scheduler->setEndpoint("fiat", request);
+  }
 
-  // CoinAPI requires API key in header
-  if (m_provider == "coinapi") {
-    request.setRawHeader("X-CoinAPI-Key", m_apiKey.toUtf8());
+  // Crypto: all symbols in one request; CoinGecko is the fallback when a
+  // FreeCryptoAPI key is set, the only source otherwise
+  QStringList symbols;
+  QStringList coinIds;
+  for (const auto &coin : cryptoCoins()) {
+    symbols << coin.first;
+    coinIds << coin.second;
   }
 
-  QNetworkReply *reply = m_networkManager->get(request);
+  QNetworkRequest coinGecko{
+      QUrl(QString("https://api.coingecko.com/api/v3/simple/"
+                   "price?ids=%1&vs_currencies=usd")
+               .arg(coinIds.join(',')))};
+  coinGecko.setRawHeader("Accept", "application/json");
 
-  connect(reply, &QNetworkReply::finished, this, [this, reply]() {
-    reply->deleteLater();
+  QString cryptoApiKey = Settings::instance()->cryptoApiKey();
+  m_scheduler->setEndpoint("coingecko", coinGecko, cryptoApiKey.isEmpty());
 
-    if (reply->error() != QNetworkReply::NoError) {
-      qDebug() << "CurrencyConverter: Network error" << reply->errorString();
-      emit error(reply->errorString());
-    } else {
-      parseApiResponse(reply->readAll());
-    }
+  if (cryptoApiKey.isEmpty()) {
+    m_scheduler->removeEndpoint("freecryptoapi");
+  } else {
+    QNetworkRequest freeCrypto{
+        QUrl(QString("https://api.freecryptoapi.com/v1/getData?symbol=%1")
+                 .arg(symbols.join('+')))};
+    freeCrypto.setRawHeader("Accept", "application/json");
+    freeCrypto.setRawHeader("Authorization",
+                            QString("Bearer %1").arg(cryptoApiKey).toUtf8());
+    m_scheduler->setEndpoint("freecryptoapi", freeCrypto);
+  }
+}
 
-    // Always fetch crypto rates alongside fiat rates
-    refreshCryptoRates();
-  });
+void CurrencyConverter::onRatesFetched(const QString &source,
+                                       const QByteArray &body) {
+  if (source == "fiat") {
+    parseApiResponse(body);
+  } else if (source == "freecryptoapi") {
+    // Symbols FreeCryptoAPI doesn't list come from CoinGecko
+    if (!parseFreeCryptoResponse(body))
+      m_scheduler->fetch("coingecko");
+  } else if (source == "coingecko") {
+    parseCoinGeckoResponse(body);
+  }
+}
+
+void CurrencyConverter::onRatesNotModified(const QString &source) {
+  // Rates are still current; remember when we checked
+  saveCachedRates();
+  if (source == "fiat")
+    emit ratesUpdated();
+}
+
+void CurrencyConverter::onRatesFetchFailed(const QString &source,
+                                           const QString &message) {
+  qDebug() << "CurrencyConverter:" << source << "failed:" << message;
+  if (source == "fiat") {
+    emit error(message);
+  } else if (source == "freecryptoapi") {
+    m_scheduler->fetch("coingecko");
+  }
 }
 
 QString CurrencyConverter::buildApiUrl() const {
@@ -307,13 +691,23 @@ void CurrencyConverter::parseApiResponse(const QByteArray &data) {
     return;
   }
 
-  m_rates.clear();
-  m_rates["USD"] = 1.0; // Base
+  QMap<QString, double> fetched;
+  {
+    // Merge, so crypto rates from the other sources survive
+    QWriteLocker locker(&m_ratesLock);
+    m_rates["USD"] = 1.0; // Base
 
-  for (auto it = rates.begin(); it != rates.end(); ++it) {
-    m_rates[it.key()] = it.value().toDouble();
+    for (auto it = rates.begin(); it != rates.end(); ++it) {
+      m_rates[it.key()] = it.value().toDouble();
+      fetched[it.key()] = it.value().toDouble();
+    }
+    rebuildRateMatrix();
   }
 
+  // Frankfurter and Fixer say which day the rates are for
+  QDate day = QDate::fromString(json["date"].toString(), Qt::ISODate);
+  recordHistory(day.isValid() ? day : QDate::currentDate(), fetched);
+
   m_ratesLoaded = true;
   saveCachedRates();
 
@@ -322,6 +716,80 @@ void CurrencyConverter::parseApiResponse(const QByteArray &data) {
   emit ratesUpdated();
 }
 
+void CurrencyConverter::recordHistory(const QDate &day,
+                                      const QMap<QString, double> &rates) {
+  QString error;
+  if (!m_history->merge({{day, rates}}, &error))
+    qDebug() << "CurrencyConverter: Couldn't record history:" << error;
+}
+
+RateHistory *CurrencyConverter::history() const { return m_history; }
+
+int CurrencyConverter::importHistoryCsv(const QString &path, QString *error) {
+  int days = m_history->importCsv(path, error);
+  if (days > 0)
+    emit historyUpdated(days);
+  return days;
+}
+
+void CurrencyConverter::backfillHistory(const QDate &from, const QDate &to) {
+  if (!from.isValid() || !to.isValid() || from > to)
+    return;
+
+  bool idle = m_backfillQueue.isEmpty();
+  if (idle)
+    m_backfillDays = 0;
+
+  // Long ranges come back thinned out, so ask for a year at a time
+  for (QDate start = from; start <= to; start = start.addYears(1)) {
+    m_backfillQueue.append({start, qMin(start.addYears(1).addDays(-1), to)});
+  }
+  if (idle)
+    fetchNextHistoryChunk();
+}
+
+void CurrencyConverter::fetchNextHistoryChunk() {
+  if (m_backfillQueue.isEmpty()) {
+    qDebug() << "CurrencyConverter: Backfilled" << m_backfillDays << "days";
+    emit historyUpdated(m_backfillDays);
+    emit backfillFinished(m_backfillDays);
+    return;
+  }
+
+  QPair<QDate, QDate> range = m_backfillQueue.first();
+  QNetworkRequest request{
+      QUrl(QString("https://api.frankfurter.dev/v1/%1..%2?base=USD")
+               .arg(range.first.toString(Qt::ISODate),
+                    range.second.toString(Qt::ISODate)))};
+  request.setTransferTimeout(30000);
+
+  QNetworkReply *reply = m_networkManager->get(request);
+  connect(reply, &QNetworkReply::finished, this, [this, reply]() {
+    reply->deleteLater();
+
+    RateHistory::Series series;
+    QString message;
+    if (reply->error() != QNetworkReply::NoError) {
+      message = reply->errorString();
+    } else if (!RateHistory::parseTimeSeries(reply->readAll(), series)) {
+      message = "No rates found in history response";
+    } else if (!m_history->merge(series, &message)) {
+      message = "Couldn't save rate history: " + message;
+    }
+
+    if (!message.isEmpty()) {
+      m_backfillQueue.clear();
+      emit backfillFailed(message);
+      emit error(message);
+      return;
+    }
+
+    m_backfillDays += series.size();
+    m_backfillQueue.removeFirst();
+    fetchNextHistoryChunk();
+  });
+}
+
 bool CurrencyConverter::hasRates() const {
   return m_ratesLoaded && !m_rates.isEmpty();
 }
@@ -348,10 +816,17 @@ void CurrencyConverter::loadCachedRates() {
   m_baseCurrency = json["base"].toString("USD");
 
   QJsonObject rates = json["rates"].toObject();
-  for (auto it = rates.begin(); it != rates.end(); ++it) {
-    m_rates[it.key()] = it.value().toDouble();
+  {
+    QWriteLocker locker(&m_ratesLock);
+    for (auto it = rates.begin(); it != rates.end(); ++it) {
+      m_rates[it.key()] = it.value().toDouble();
+    }
+    rebuildRateMatrix();
   }
 
+  if (!rates.isEmpty())
+    m_scheduler->restoreState(json["sources"].toObject());
+
   m_ratesLoaded = true;
   qDebug() << "CurrencyConverter: Loaded" << m_rates.size() << "cached rates";
 }
@@ -372,6 +847,7 @@ void CurrencyConverter::saveCachedRates() {
     rates[it.key()] = it.value();
   }
   json["rates"] = rates;
+  json["sources"] = m_scheduler->saveState();
 
   file.write(QJsonDocument(json).toJson());
   file.close();
@@ -386,170 +862,66 @@ QString CurrencyConverter::cachePath() const {
   }
   return dataPath + "/currency_rates.json";
 }
-void CurrencyConverter::refreshCryptoRates() {
-  // Get crypto API key from settings
-  QString cryptoApiKey = Settings::instance()->cryptoApiKey();
-
-  // FreeCryptoAPI only supports single symbol per request
-  static const QStringList cryptoSymbols = {"BTC", "ETH", "USDT", "USDC", "BNB",
-                                            "XRP", "ADA", "DOGE", "SOL",  "TRX",
-                                            "DOT", "LTC", "MATIC"};
-
-  if (!cryptoApiKey.isEmpty()) {
-    // Try FreeCryptoAPI first for each symbol
-    for (const QString &symbol : cryptoSymbols) {
-      QString url =
-          QString("https://api.freecryptoapi.com/v1/getData?symbol=%1")
-              .arg(symbol);
-
-      QNetworkRequest request(url);
-      request.setRawHeader("Accept", "application/json");
-      request.setRawHeader("Authorization",
-                           QString("Bearer %1").arg(cryptoApiKey).toUtf8());
-
-      QNetworkReply *reply = m_networkManager->get(request);
-
-      connect(reply, &QNetworkReply::finished, this, [this, reply, symbol]() {
-        reply->deleteLater();
-
-        if (reply->error() != QNetworkReply::NoError) {
-          fetchCoinGeckoRate(symbol); // Fallback to CoinGecko
-          return;
-        }
-
-        QJsonDocument doc = QJsonDocument::fromJson(reply->readAll());
-        if (!doc.isObject()) {
-          fetchCoinGeckoRate(symbol);
-          return;
-        }
+bool CurrencyConverter::parseFreeCryptoResponse(const QByteArray &data) {
+  QJsonDocument doc = QJsonDocument::fromJson(data);
+  if (!doc.isObject())
+    return false;
 
-        QJsonObject json = doc.object();
-
-        if (json["status"].toString() == "success" &&
-            json.contains("symbols") && json["symbols"].isArray()) {
-          QJsonArray symbols = json["symbols"].toArray();
-          if (!symbols.isEmpty()) {
-            QJsonObject coinData = symbols[0].toObject();
-            double usdPrice = coinData["last"].toString().toDouble();
-            if (usdPrice > 0) {
-              m_rates[symbol] = 1.0 / usdPrice;
-              qDebug() << "CurrencyConverter:" << symbol << "=" << usdPrice
-                       << "USD (FreeCryptoAPI)";
-              saveCachedRates();
-              emit ratesUpdated();
-              return;
-            }
-          }
-        }
-        // FreeCryptoAPI doesn't have this symbol, try CoinGecko
-        fetchCoinGeckoRate(symbol);
-      });
-    }
-  } else {
-    // No FreeCryptoAPI key, use CoinGecko for all
-    fetchAllCoinGeckoRates();
+  QJsonObject json = doc.object();
+  if (json["status"].toString() != "success" || !json["symbols"].isArray())
+    return false;
+
+  QMap<QString, double> usdPrices;
+  const QJsonArray symbols = json["symbols"].toArray();
+  for (const QJsonValue &value : symbols) {
+    QJsonObject coinData = value.toObject();
+    QString symbol = coinData["symbol"].toString().toUpper();
+    double usdPrice = coinData["last"].toVariant().toDouble();
+    if (!symbol.isEmpty() && usdPrice > 0)
+      usdPrices[symbol] = usdPrice;
   }
-}
 
-void CurrencyConverter::fetchCoinGeckoRate(const QString &symbol) {
-  // Map symbol to CoinGecko ID
-  static const QMap<QString, QString> symbolToId = {
-      {"BTC", "bitcoin"},        {"ETH", "ethereum"},    {"USDT", "tether"},
-      {"USDC", "usd-coin"},      {"BNB", "binancecoin"}, {"XRP", "ripple"},
-      {"ADA", "cardano"},        {"DOGE", "dogecoin"},   {"SOL", "solana"},
-      {"TRX", "tron"},           {"DOT", "polkadot"},    {"LTC", "litecoin"},
-      {"MATIC", "matic-network"}};
+  storeCryptoPrices(usdPrices, "FreeCryptoAPI");
+  return usdPrices.size() >= cryptoCoins().size();
+}
 
-  if (!symbolToId.contains(symbol))
+void CurrencyConverter::parseCoinGeckoResponse(const QByteArray &data) {
+  QJsonDocument doc = QJsonDocument::fromJson(data);
+  if (!doc.isObject())
     return;
 
-  QString coinId = symbolToId[symbol];
-  QString url = QString("https://api.coingecko.com/api/v3/simple/"
-                        "price?ids=%1&vs_currencies=usd")
-                    .arg(coinId);
-
-  QNetworkRequest request(url);
-  request.setRawHeader("Accept", "application/json");
-
-  QNetworkReply *reply = m_networkManager->get(request);
-
-  connect(reply, &QNetworkReply::finished, this,
-          [this, reply, symbol, coinId]() {
-            reply->deleteLater();
-
-            if (reply->error() != QNetworkReply::NoError)
-              return;
-
-            QJsonDocument doc = QJsonDocument::fromJson(reply->readAll());
-            if (!doc.isObject())
-              return;
-
-            QJsonObject json = doc.object();
-            if (json.contains(coinId)) {
-              QJsonObject coinData = json[coinId].toObject();
-              if (coinData.contains("usd")) {
-                double usdPrice = coinData["usd"].toDouble();
-                if (usdPrice > 0) {
-                  m_rates[symbol] = 1.0 / usdPrice;
-                  qDebug() << "CurrencyConverter:" << symbol << "=" << usdPrice
-                           << "USD (CoinGecko fallback)";
-                  saveCachedRates();
-                  emit ratesUpdated();
-                }
-              }
-            }
-          });
-}
-
-void CurrencyConverter::fetchAllCoinGeckoRates() {
-  QString url = "https://api.coingecko.com/api/v3/simple/price?"
-                "ids=bitcoin,ethereum,tether,usd-coin,binancecoin,ripple,"
-                "cardano,dogecoin,solana,tron,polkadot,litecoin,matic-network"
-                "&vs_currencies=usd";
-
-  QNetworkRequest request(url);
-  request.setRawHeader("Accept", "application/json");
-
-  QNetworkReply *reply = m_networkManager->get(request);
-
-  connect(reply, &QNetworkReply::finished, this, [this, reply]() {
-    reply->deleteLater();
+  QJsonObject json = doc.object();
+  QMap<QString, double> usdPrices;
+  for (const auto &coin : cryptoCoins()) {
+    QJsonObject coinData = json[coin.second].toObject();
+    double usdPrice = coinData["usd"].toDouble();
+    if (usdPrice > 0)
+      usdPrices[coin.first] = usdPrice;
+  }
 
-    if (reply->error() != QNetworkReply::NoError)
-      return;
+  storeCryptoPrices(usdPrices, "CoinGecko");
+}
 
-    QJsonDocument doc = QJsonDocument::fromJson(reply->readAll());
-    if (!doc.isObject())
-      return;
+void CurrencyConverter::storeCryptoPrices(const QMap<QString, double> &usdPrices,
+                                          const QString &source) {
+  if (usdPrices.isEmpty())
+    return;
 
-    QJsonObject json = doc.object();
-
-    static const QMap<QString, QString> idToSymbol = {
-        {"bitcoin", "BTC"},        {"ethereum", "ETH"},    {"tether", "USDT"},
-        {"usd-coin", "USDC"},      {"binancecoin", "BNB"}, {"ripple", "XRP"},
-        {"cardano", "ADA"},        {"dogecoin", "DOGE"},   {"solana", "SOL"},
-        {"tron", "TRX"},           {"polkadot", "DOT"},    {"litecoin", "LTC"},
-        {"matic-network", "MATIC"}};
-
-    int updated = 0;
-    for (auto it = idToSymbol.constBegin(); it != idToSymbol.constEnd(); ++it) {
-      if (json.contains(it.key())) {
-        QJsonObject coinData = json[it.key()].toObject();
-        if (coinData.contains("usd")) {
-          double usdPrice = coinData["usd"].toDouble();
-          if (usdPrice > 0) {
-            m_rates[it.value()] = 1.0 / usdPrice;
-            updated++;
-          }
-        }
-      }
+  {
+    QWriteLocker locker(&m_ratesLock);
+    for (auto it = usdPrices.constBegin(); it != usdPrices.constEnd(); ++it) {
+      m_rates[it.key()] = 1.0 / it.value();
     }
+    rebuildRateMatrix();
+  }
 
-    if (updated > 0) {
-      qDebug() << "CurrencyConverter: Updated" << updated
-               << "crypto rates (CoinGecko)";
-      saveCachedRates();
-      emit ratesUpdated();
-    }
-  });
+  QMap<QString, double> perUsd;
+  for (auto it = usdPrices.constBegin(); it != usdPrices.constEnd(); ++it)
+    perUsd[it.key()] = 1.0 / it.value();
+  recordHistory(QDateTime::currentDateTimeUtc().date(), perUsd);
+
+  qDebug() << "CurrencyConverter: Updated" << usdPrices.size()
+           << "crypto rates (" << source << ")";
+  saveCachedRates();
+  emit ratesUpdated();
 }
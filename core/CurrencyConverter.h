@@ -1,22 +1,41 @@
 #ifndef LINNOTE_CURRENCYCONVERTER_H
 #define LINNOTE_CURRENCYCONVERTER_H
 
+#include "AhoCorasick.h"
+#include "Decimal.h"
+#include <QDate>
+#include <QHash>
+#include <QList>
 #include <QMap>
 #include <QNetworkAccessManager>
 #include <QObject>
+#include <QReadWriteLock>
 #include <QString>
+#include <QStringView>
+#include <QVector>
+
+class RateFetchScheduler;
+class RateHistory;
 
 /**
  * @brief Currency converter with API integration
  *
  * Uses exchangerate.host or similar free API
- * Caches rates for offline use
+ * Caches rates for offline use. Fetching is left to a RateFetchScheduler:
+ * one batched request per provider, once per refresh interval.
+ *
+ * Conversions may be called from the Math sheet worker thread; rates are
+ * only written on the GUI thread, under m_ratesLock.
+ *
+ * Every fetch is also recorded in a RateHistory, which answers
+ * date-qualified conversions ("100 USD to EUR @2026-03-01").
  */
 class CurrencyConverter : public QObject {
   Q_OBJECT
 
 public:
   static CurrencyConverter *instance();
+  ~CurrencyConverter() override;
 
   /**
    * @brief Set API key (if using paid API)
@@ -33,12 +52,28 @@ public:
    * @param amount The amount to convert
    * @param from Source currency code (e.g., "USD")
    * @param to Target currency code (e.g., "TRY")
+   * @param date Use the rates of this day instead of the current ones
    * @return Converted amount, or -1 if conversion failed
    */
-  double convert(double amount, const QString &from, const QString &to);
+  double convert(double amount, const QString &from, const QString &to,
+                 const QDate &date = QDate());
+
+  /**
+   * @brief Exact variant of convert() for Decimal mode
+   *
+   * The cross rate is rounded to 12 places and the result is rounded to
+   * the scale of @p amount, so totals of converted lines add up exactly.
+   */
+  Decimal convertDecimal(const Decimal &amount, const QString &from,
+                         const QString &to, bool *ok = nullptr,
+                         const QDate &date = QDate());
 
   /**
    * @brief Parse a currency expression like "100 USD to TRY"
+   *
+   * A trailing "@yyyy-MM-dd" converts with that day's rates from the
+   * history; the conversion fails if the history has none.
+   *
    * @param expression The expression to parse
    * @param result Output: the converted amount
    * @return true if parsing and conversion succeeded
@@ -47,10 +82,48 @@ public:
                        QString &fromCurrency, QString &toCurrency);
 
   /**
-   * @brief Refresh exchange rates from API
+   * @brief Decimal-mode variant of parseAndConvert()
+   * @param scale Digits after the point for the parsed amount and result
+   */
+  bool parseAndConvertDecimal(const QString &expression, int scale,
+                              Decimal &result, QString &fromCurrency,
+                              QString &toCurrency);
+
+  /**
+   * @brief Check if text contains a currency symbol or a known code
+   *
+   * Codes count when written in upper case or right after a number, so
+   * plain words such as "all" or "dot" don't match.
+   */
+  bool mentionsCurrency(const QString &text) const;
+
+  /**
+   * @brief Refresh exchange rates from API now (manual refresh)
    */
   void refreshRates();
 
+  /**
+   * @brief Refresh only sources whose refresh interval has passed
+   */
+  void refreshRatesIfStale();
+
+  /**
+   * @brief Download daily fiat rates for [from, to] into the history
+   *
+   * Always from Frankfurter (ECB reference rates, no key needed), one
+   * request per year of the range. Emits backfillFinished() and
+   * historyUpdated() when done, or backfillFailed() and error().
+   */
+  void backfillHistory(const QDate &from, const QDate &to);
+
+  /**
+   * @brief Import daily rates from a CSV file into the history
+   * @return Number of days imported, or -1 (see RateHistory::parseCsv)
+   */
+  int importHistoryCsv(const QString &path, QString *error = nullptr);
+
+  RateHistory *history() const;
+
   /**
    * @brief Check if rates are available
    */
@@ -63,24 +136,67 @@ public:
 
 signals:
   void ratesUpdated();
+  void historyUpdated(int days);
+  void backfillFinished(int days);
+  void backfillFailed(const QString &message);
   void error(const QString &message);
 
 private:
   explicit CurrencyConverter(QObject *parent = nullptr);
+
+  // A scanned "100 USD to EUR @date"; IDs index m_currencyCodes
+  struct Expression {
+    QStringView amount;
+    int from = -1;
+    int to = -1;
+    QDate date;
+  };
+
+  // These expect m_ratesLock to be held
+  bool scanExpression(QStringView text, Expression &expr) const;
+  int currencyId(QStringView code) const;
+  bool crossRate(int from, int to, const QDate &date, double &rate) const;
+  void rebuildRateMatrix();
+
+  bool scanAndRate(const QString &expression, QString &amount,
+                   QString &fromCurrency, QString &toCurrency,
+                   double &rate) const;
+  void recordHistory(const QDate &day, const QMap<QString, double> &rates);
+  void fetchNextHistoryChunk();
   void loadCachedRates();
   void saveCachedRates();
   QString cachePath() const;
   QString buildApiUrl() const;
   void parseApiResponse(const QByteArray &data);
-  void refreshCryptoRates(); // FreeCryptoAPI + CoinGecko fallback
-  void fetchCoinGeckoRate(const QString &symbol);
-  void fetchAllCoinGeckoRates();
+  void configureSources(); // Fiat provider, FreeCryptoAPI, CoinGecko
+  void onRatesFetched(const QString &source, const QByteArray &body);
+  void onRatesNotModified(const QString &source);
+  void onRatesFetchFailed(const QString &source, const QString &message);
+  bool parseFreeCryptoResponse(const QByteArray &data); // false if incomplete
+  void parseCoinGeckoResponse(const QByteArray &data);
+  void storeCryptoPrices(const QMap<QString, double> &usdPrices,
+                         const QString &source);
 
   QNetworkAccessManager *m_networkManager;
+  RateFetchScheduler *m_scheduler;
+  RateHistory *m_history;
+  QList<QPair<QDate, QDate>> m_backfillQueue; // Pending yearly requests
+  int m_backfillDays;
   QString m_apiKey;
   QString m_provider;
   QString m_baseCurrency;
   QMap<QString, double> m_rates; // Rates relative to base currency
+  QString m_targetCurrency;      // Settings base currency, for "100 USD"
+
+  // Built from m_rates by rebuildRateMatrix() whenever they change, so a
+  // conversion is a hash of the packed code plus one array read
+  QHash<quint32, int> m_currencyIds; // Packed code -> currency ID
+  QStringList m_currencyCodes;       // Currency ID -> code
+  QVector<double> m_crossRates;      // [from * count + to]
+  QVector<int> m_symbolIds;          // Currency symbol -> currency ID
+  AhoCorasick m_codeMatcher;         // Codes of 3-5 letters, any case
+  int m_targetId;
+  mutable QReadWriteLock m_ratesLock;
   bool m_ratesLoaded;
 };
 
@@ -0,0 +1,290 @@
+#include "Decimal.h"
+#include <QLocale>
+#include <QtMath>
+
+namespace {
+
+using Raw = __int128;
+using URaw = unsigned __int128;
+
+// 10^38 is the largest power of ten that fits in a signed 128-bit integer
+constexpr int MaxPow10 = 38;
+
+struct Pow10Table {
+  Raw values[MaxPow10 + 1];
+
+  constexpr Pow10Table() : values() {
+    Raw v = 1;
+    for (int i = 0; i <= MaxPow10; ++i) {
+      values[i] = v;
+      if (i < MaxPow10)
+        v *= 10;
+    }
+  }
+};
+
+constexpr Pow10Table kPow10;
+
+int clampScale(int scale) { return qBound(0, scale, Decimal::MaxScale); }
+
+// Integer division rounding half away from zero
+Raw divideRounded(Raw num, Raw den) {
+  Raw q = num / den;
+  Raw r = num % den;
+  Raw absR = r < 0 ? -r : r;
+  Raw absDen = den < 0 ? -den : den;
+  if (absR >= absDen - absR) {
+    q += ((num < 0) != (den < 0)) ? -1 : 1;
+  }
+  return q;
+}
+
+bool scaleUp(Raw value, int digits, Raw &out) {
+  if (digits > MaxPow10) {
+    out = 0;
+    return value == 0;
+  }
+  return !__builtin_mul_overflow(value, kPow10.values[digits], &out);
+}
+
+} // namespace
+
+Decimal::Decimal() : m_raw(0), m_scale(DefaultScale), m_valid(true) {}
+
+Decimal::Decimal(qint64 integer, int scale)
+    : m_raw(0), m_scale(clampScale(scale)), m_valid(true) {
+  m_raw = static_cast<Raw>(integer) * kPow10.values[m_scale];
+}
+
+Decimal::Decimal(Raw raw, int scale, bool valid)
+    : m_raw(raw), m_scale(scale), m_valid(valid) {}
+
+Decimal Decimal::invalid() { return Decimal(0, DefaultScale, false); }
+
+Decimal Decimal::fromString(const QString &text, int scale, bool *ok) {
+  if (ok)
+    *ok = false;
+  scale = clampScale(scale);
+
+  const QString s = text.trimmed();
+  int pos = 0;
+  bool negative = false;
+  if (pos < s.length() && (s[pos] == '-' || s[pos] == '+')) {
+    negative = s[pos] == '-';
+    pos++;
+  }
+
+  // Collect every digit into one mantissa and remember how many of them
+  // were after the decimal point
+  Raw mantissa = 0;
+  int fractionDigits = 0;
+  int digitCount = 0;
+  bool seenPoint = false;
+  for (; pos < s.length(); ++pos) {
+    QChar ch = s[pos];
+    if (ch.isDigit()) {
+      if (__builtin_mul_overflow(mantissa, 10, &mantissa) ||
+          __builtin_add_overflow(mantissa, ch.digitValue(), &mantissa)) {
+        return invalid();
+      }
+      if (seenPoint)
+        fractionDigits++;
+      digitCount++;
+    } else if (ch == '.' && !seenPoint) {
+      seenPoint = true;
+    } else {
+      break;
+    }
+  }
+
+  if (digitCount == 0)
+    return invalid();
+
+  // Optional scientific exponent (1e3, 2.5e-2)
+  int exponent = 0;
+  if (pos < s.length() && (s[pos] == 'e' || s[pos] == 'E')) {
+    pos++;
+    bool expNegative = false;
+    if (pos < s.length() && (s[pos] == '-' || s[pos] == '+')) {
+      expNegative = s[pos] == '-';
+      pos++;
+    }
+    int expDigits = 0;
+    while (pos < s.length() && s[pos].isDigit()) {
+      exponent = qMin(exponent * 10 + s[pos].digitValue(), 1000);
+      pos++;
+      expDigits++;
+    }
+    if (expDigits == 0)
+      return invalid();
+    if (expNegative)
+      exponent = -exponent;
+  }
+
+  if (pos != s.length())
+    return invalid();
+
+  // mantissa * 10^(exponent - fractionDigits), expressed at target scale
+  Raw raw = 0;
+  int shift = scale + exponent - fractionDigits;
+  if (shift >= 0) {
+    if (!scaleUp(mantissa, shift, raw))
+      return invalid();
+  } else if (-shift <= MaxPow10) {
+    raw = divideRounded(mantissa, kPow10.values[-shift]);
+  }
+
+  if (ok)
+    *ok = true;
+  return Decimal(negative ? -raw : raw, scale, true);
+}
+
+Decimal Decimal::fromDouble(double value, int scale) {
+  if (!qIsFinite(value))
+    return invalid();
+  return fromString(QString::number(value, 'g', QLocale::FloatingPointShortest),
+                    scale);
+}
+
+bool Decimal::isInteger() const {
+  return m_valid && m_raw % kPow10.values[m_scale] == 0;
+}
+
+Decimal Decimal::rescaled(int scale) const {
+  if (!m_valid)
+    return invalid();
+  scale = clampScale(scale);
+  if (scale == m_scale)
+    return *this;
+
+  if (scale > m_scale) {
+    Raw raw;
+    if (!scaleUp(m_raw, scale - m_scale, raw))
+      return invalid();
+    return Decimal(raw, scale, true);
+  }
+  return Decimal(divideRounded(m_raw, kPow10.values[m_scale - scale]), scale,
+                 true);
+}
+
+double Decimal::toDouble() const {
+  if (!m_valid)
+    return qQNaN();
+  return static_cast<double>(static_cast<long double>(m_raw) /
+                             static_cast<long double>(kPow10.values[m_scale]));
+}
+
+QString Decimal::toString() const {
+  if (!m_valid)
+    return QString();
+
+  URaw magnitude = m_raw < 0 ? -static_cast<URaw>(m_raw) : m_raw;
+
+  // Digits in reverse order, padded so there is always a leading integer digit
+  char buffer[64];
+  int len = 0;
+  while (magnitude > 0 || len <= m_scale) {
+    buffer[len++] = static_cast<char>('0' + static_cast<int>(magnitude % 10));
+    magnitude /= 10;
+  }
+
+  QString result;
+  result.reserve(len + 2);
+  if (m_raw < 0)
+    result += '-';
+  for (int i = len - 1; i >= 0; --i) {
+    result += QLatin1Char(buffer[i]);
+    if (i == m_scale && m_scale > 0)
+      result += '.';
+  }
+  return result;
+}
+
+Decimal Decimal::operator-() const {
+  if (!m_valid)
+    return invalid();
+  return Decimal(-m_raw, m_scale, true);
+}
+
+Decimal Decimal::operator+(const Decimal &other) const {
+  int scale = qMax(m_scale, other.m_scale);
+  Decimal a = rescaled(scale);
+  Decimal b = other.rescaled(scale);
+  Raw sum;
+  if (!a.m_valid || !b.m_valid ||
+      __builtin_add_overflow(a.m_raw, b.m_raw, &sum)) {
+    return invalid();
+  }
+  return Decimal(sum, scale, true);
+}
+
+Decimal Decimal::operator-(const Decimal &other) const {
+  return *this + (-other);
+}
+
+Decimal Decimal::operator*(const Decimal &other) const {
+  if (!m_valid || !other.m_valid)
+    return invalid();
+
+  // Exact product has scale m_scale + other.m_scale, round back down
+  Raw product;
+  if (__builtin_mul_overflow(m_raw, other.m_raw, &product))
+    return invalid();
+
+  int scale = qMax(m_scale, other.m_scale);
+  int extra = m_scale + other.m_scale - scale;
+  return Decimal(divideRounded(product, kPow10.values[extra]), scale, true);
+}
+
+Decimal Decimal::operator/(const Decimal &other) const {
+  if (!m_valid || !other.m_valid || other.m_raw == 0)
+    return invalid();
+
+  int scale = qMax(m_scale, other.m_scale);
+  Raw numerator;
+  if (!scaleUp(m_raw, scale - m_scale + other.m_scale, numerator))
+    return invalid();
+  return Decimal(divideRounded(numerator, other.m_raw), scale, true);
+}
+
+Decimal Decimal::operator%(const Decimal &other) const {
+  int scale = qMax(m_scale, other.m_scale);
+  Decimal a = rescaled(scale);
+  Decimal b = other.rescaled(scale);
+  if (!a.m_valid || !b.m_valid || b.m_raw == 0)
+    return invalid();
+  // Sign follows the dividend, like std::fmod
+  return Decimal(a.m_raw % b.m_raw, scale, true);
+}
+
+Decimal &Decimal::operator+=(const Decimal &other) {
+  *this = *this + other;
+  return *this;
+}
+
+Decimal &Decimal::operator-=(const Decimal &other) {
+  *this = *this - other;
+  return *this;
+}
+
+bool Decimal::operator==(const Decimal &other) const {
+  if (!m_valid || !other.m_valid)
+    return false;
+  int scale = qMax(m_scale, other.m_scale);
+  Decimal a = rescaled(scale);
+  Decimal b = other.rescaled(scale);
+  if (!a.m_valid || !b.m_valid)
+    return false;
+  return a.m_raw == b.m_raw;
+}
+
+bool Decimal::operator<(const Decimal &other) const {
+  if (!m_valid || !other.m_valid)
+    return false;
+  int scale = qMax(m_scale, other.m_scale);
+  Decimal a = rescaled(scale);
+  Decimal b = other.rescaled(scale);
+  if (!a.m_valid || !b.m_valid)
+    return toDouble() < other.toDouble();
+  return a.m_raw < b.m_raw;
+}
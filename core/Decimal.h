@@ -0,0 +1,81 @@
+#ifndef LINNOTE_DECIMAL_H
+#define LINNOTE_DECIMAL_H
+
+#include <QString>
+
+/**
+ * @brief Fixed-point decimal number for exact money arithmetic
+ *
+ * Stores a signed 128-bit integer mantissa together with a decimal scale
+ * (digits after the point), so 12.30 at scale 4 is kept as 123000.
+ * Addition, subtraction and comparison are exact; multiplication and
+ * division round half away from zero to the larger operand scale.
+ *
+ * Overflow and division by zero produce an invalid value instead of
+ * wrapping. Any operation involving an invalid value stays invalid.
+ */
+class Decimal {
+public:
+  static constexpr int DefaultScale = 4;
+  static constexpr int MaxScale = 18;
+
+  Decimal();
+  Decimal(qint64 integer, int scale = DefaultScale);
+
+  /**
+   * @brief Parse "123", "-4.56" or "1.5e3" and round to the given scale
+   * @param ok Set to true if the text is a valid number that fits
+   */
+  static Decimal fromString(const QString &text, int scale = DefaultScale,
+                            bool *ok = nullptr);
+
+  /**
+   * @brief Convert a double by rounding its shortest decimal form
+   */
+  static Decimal fromDouble(double value, int scale = DefaultScale);
+
+  bool isValid() const { return m_valid; }
+  bool isZero() const { return m_valid && m_raw == 0; }
+  bool isNegative() const { return m_valid && m_raw < 0; }
+  bool isInteger() const;
+  int scale() const { return m_scale; }
+
+  /**
+   * @brief Same value rounded (or padded) to a different scale
+   */
+  Decimal rescaled(int scale) const;
+
+  double toDouble() const;
+
+  /**
+   * @brief Format with exactly scale() digits after the point
+   */
+  QString toString() const;
+
+  Decimal operator-() const;
+  Decimal operator+(const Decimal &other) const;
+  Decimal operator-(const Decimal &other) const;
+  Decimal operator*(const Decimal &other) const;
+  Decimal operator/(const Decimal &other) const;
+  Decimal operator%(const Decimal &other) const;
+
+  Decimal &operator+=(const Decimal &other);
+  Decimal &operator-=(const Decimal &other);
+
+  bool operator==(const Decimal &other) const;
+  bool operator!=(const Decimal &other) const { return !(*this == other); }
+  bool operator<(const Decimal &other) const;
+  bool operator>(const Decimal &other) const { return other < *this; }
+
+private:
+  using Raw = __int128;
+
+  Decimal(Raw raw, int scale, bool valid);
+  static Decimal invalid();
+
+  Raw m_raw;
+  int m_scale;
+  bool m_valid;
+};
+
+#endif // LINNOTE_DECIMAL_H
@@ -0,0 +1,213 @@
+#include "GrammarRegistry.h"
+#include <QDebug>
+#include <QDir>
+#include <QFile>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QStandardPaths>
+
+namespace {
+
+// Names come from fence info strings too, so never let one leave the
+// grammar directories
+bool isValidName(const QString &name) {
+  if (name.isEmpty())
+    return false;
+  for (QChar c : name) {
+    if (!c.isLetterOrNumber() && c != '_' && c != '-' && c != '+' && c != '#')
+      return false;
+  }
+  return true;
+}
+
+bool readList(const QJsonObject &json, const QString &key, QStringList *list,
+              QString *error) {
+  QJsonValue value = json.value(key);
+  if (value.isUndefined())
+    return true;
+  if (!value.isArray()) {
+    *error = QString("\"%1\" must be an array of strings").arg(key);
+    return false;
+  }
+  const QJsonArray array = value.toArray();
+  for (const QJsonValue &item : array) {
+    if (!item.isString()) {
+      *error = QString("\"%1\" must be an array of strings").arg(key);
+      return false;
+    }
+    list->append(item.toString());
+  }
+  return true;
+}
+
+void addLowerCase(QStringList *words) {
+  const int count = int(words->size());
+  for (int i = 0; i < count; ++i) {
+    QString lower = words->at(i).toLower();
+    if (lower != words->at(i))
+      words->append(lower);
+  }
+}
+
+} // namespace
+
+GrammarRegistry *GrammarRegistry::instance() {
+  static GrammarRegistry instance({userGrammarPath(), ":/grammars"});
+  return &instance;
+}
+
+GrammarRegistry::GrammarRegistry(const QStringList &searchPaths)
+    : m_searchPaths(searchPaths) {}
+
+QString GrammarRegistry::userGrammarPath() {
+  QString dataPath =
+      QStandardPaths::writableLocation(QStandardPaths::AppDataLocation);
+  if (dataPath.isEmpty())
+    return QString();
+  return dataPath + "/grammars";
+}
+
+QStringList GrammarRegistry::languages() const {
+  QStringList names;
+  for (const QString &path : m_searchPaths) {
+    if (path.isEmpty())
+      continue;
+    const QFileInfoList files =
+        QDir(path).entryInfoList({"*.json"}, QDir::Files | QDir::Readable);
+    for (const QFileInfo &file : files) {
+      QString name = file.completeBaseName().toLower();
+      if (isValidName(name) && !names.contains(name))
+        names.append(name);
+    }
+  }
+  names.sort();
+  return names;
+}
+
+bool GrammarRegistry::contains(const QString &name) const {
+  QString key = name.toLower();
+  if (!isValidName(key))
+    return false;
+  for (const QString &path : m_searchPaths) {
+    if (!path.isEmpty() && QFile::exists(path + "/" + key + ".json"))
+      return true;
+  }
+  return false;
+}
+
+QSharedPointer<const CodeLexer::Table>
+GrammarRegistry::table(const QString &name) {
+  QString key = name.toLower();
+  auto it = m_tables.constFind(key);
+  if (it != m_tables.constEnd())
+    return *it;
+
+  // Unknown names are remembered too, so asking again costs a lookup
+  QSharedPointer<const CodeLexer::Table> table = load(key);
+  m_tables.insert(key, table);
+  return table;
+}
+
+QSharedPointer<const CodeLexer::Table> GrammarRegistry::generic() {
+  if (!m_generic)
+    m_generic = CodeLexer::compile(CodeLexer::generic());
+  return m_generic;
+}
+
+void GrammarRegistry::reload() { m_tables.clear(); }
+
+QSharedPointer<const CodeLexer::Table>
+GrammarRegistry::load(const QString &name) const {
+  if (!isValidName(name))
+    return {};
+
+  for (const QString &path : m_searchPaths) {
+    if (path.isEmpty())
+      continue;
+    QFile file(path + "/" + name + ".json");
+    if (!file.exists())
+      continue;
+
+    CodeLexer::Grammar grammar;
+    QString error;
+    if (!file.open(QIODevice::ReadOnly))
+      error = file.errorString();
+    else if (parse(file.readAll(), &grammar, &error))
+      return CodeLexer::compile(grammar);
+    qWarning() << "GrammarRegistry: Skipping" << file.fileName() << "-"
+               << error;
+  }
+  return {};
+}
+
+bool GrammarRegistry::parse(const QByteArray &data,
+                            CodeLexer::Grammar *grammar, QString *error) {
+  QString message;
+  if (!error)
+    error = &message;
+
+  QJsonParseError parseError;
+  QJsonDocument doc = QJsonDocument::fromJson(data, &parseError);
+  if (parseError.error != QJsonParseError::NoError) {
+    *error = parseError.errorString();
+    return false;
+  }
+  if (!doc.isObject()) {
+    *error = "Not a JSON object";
+    return false;
+  }
+
+  QJsonObject json = doc.object();
+  CodeLexer::Grammar result;
+  result.name = json.value("name").toString();
+  if (result.name.isEmpty()) {
+    *error = "\"name\" is missing";
+    return false;
+  }
+
+  if (!readList(json, "keywords", &result.keywords, error) ||
+      !readList(json, "types", &result.types, error) ||
+      !readList(json, "lineComments", &result.lineComments, error))
+    return false;
+  if (result.lineComments.contains(QString())) {
+    *error = "\"lineComments\" must not contain an empty marker";
+    return false;
+  }
+
+  QStringList blockComment;
+  if (!readList(json, "blockComment", &blockComment, error))
+    return false;
+  if (!blockComment.isEmpty()) {
+    if (blockComment.size() != 2 || blockComment[0].isEmpty() ||
+        blockComment[1].isEmpty()) {
+      *error = "\"blockComment\" must be a start and an end";
+      return false;
+    }
+    result.blockCommentStart = blockComment[0];
+    result.blockCommentEnd = blockComment[1];
+  }
+
+  result.quotes = json.value("quotes").toString();
+  result.multiLineQuotes = json.value("multiLineQuotes").toString();
+  if (result.multiLineQuotes.size() > CodeLexer::MaxMultiLineQuotes) {
+    *error = QString("\"multiLineQuotes\" has more than %1 characters")
+                 .arg(CodeLexer::MaxMultiLineQuotes);
+    return false;
+  }
+  result.numberSuffixes = json.value("numberSuffixes").toString();
+  result.functionCalls = json.value("functionCalls").toBool();
+  result.preprocessor = json.value("preprocessor").toBool();
+  result.shebang = json.value("shebang").toBool();
+  result.variables = json.value("variables").toBool();
+  result.objectKeys = json.value("objectKeys").toBool();
+  result.tripleQuotes = json.value("tripleQuotes").toBool();
+
+  if (json.value("caseInsensitive").toBool()) {
+    addLowerCase(&result.keywords);
+    addLowerCase(&result.types);
+  }
+
+  *grammar = result;
+  return true;
+}
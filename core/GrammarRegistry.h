@@ -0,0 +1,83 @@
+#ifndef LINNOTE_GRAMMARREGISTRY_H
+#define LINNOTE_GRAMMARREGISTRY_H
+
+#include "CodeLexer.h"
+#include <QByteArray>
+#include <QHash>
+#include <QSharedPointer>
+#include <QString>
+#include <QStringList>
+
+/**
+ * @brief Grammar files by language name, compiled on first use
+ *
+ * Languages are JSON files named after the language, e.g. "rust.json",
+ * shipped as resources under :/grammars and overridable (or extended) by
+ * files of the same name in the user's grammar directory. Nothing is read
+ * until a language is first asked for, so startup cost doesn't grow with
+ * the number of grammars. Each language is parsed and compiled once and
+ * the table is shared by every lexer that uses it.
+ *
+ * A grammar file mirrors CodeLexer::Grammar:
+ * @code
+ * {
+ *   "name": "sql",
+ *   "keywords": ["SELECT", "FROM"],
+ *   "types": ["INT", "TEXT"],
+ *   "lineComments": ["--"],
+ *   "quotes": "'\"",
+ *   "caseInsensitive": true,
+ *   "functionCalls": true
+ * }
+ * @endcode
+ * "blockComment" is a [start, end] pair. Strings opened by one of the
+ * "multiLineQuotes" (up to CodeLexer::MaxMultiLineQuotes of the "quotes")
+ * may span lines. "caseInsensitive" adds lower case spellings of the
+ * keywords and types. A user file that doesn't parse is skipped in favor
+ * of the shipped one.
+ *
+ * Used from the GUI thread only.
+ */
+class GrammarRegistry {
+public:
+  static GrammarRegistry *instance();
+
+  // Directories searched in order; earlier ones override later ones
+  explicit GrammarRegistry(const QStringList &searchPaths);
+
+  // Where users put their own grammar files
+  static QString userGrammarPath();
+
+  // Names of all languages with a grammar file
+  QStringList languages() const;
+  bool contains(const QString &name) const;
+
+  /**
+   * @brief The compiled grammar for @p name, loading it if needed
+   *
+   * Null if there is no such language or its file doesn't parse; see
+   * generic() for a fallback.
+   */
+  QSharedPointer<const CodeLexer::Table> table(const QString &name);
+
+  // CodeLexer::generic(), compiled
+  QSharedPointer<const CodeLexer::Table> generic();
+
+  // Forget what was loaded, so changed files are read again
+  void reload();
+
+  // Read a grammar file; false with @p error set if it isn't one
+  static bool parse(const QByteArray &data, CodeLexer::Grammar *grammar,
+                    QString *error = nullptr);
+
+private:
+  Q_DISABLE_COPY(GrammarRegistry)
+
+  QSharedPointer<const CodeLexer::Table> load(const QString &name) const;
+
+  QStringList m_searchPaths;
+  QHash<QString, QSharedPointer<const CodeLexer::Table>> m_tables; // Or null
+  QSharedPointer<const CodeLexer::Table> m_generic;
+};
+
+#endif // LINNOTE_GRAMMARREGISTRY_H
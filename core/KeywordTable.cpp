@@ -0,0 +1,67 @@
+#include "KeywordTable.h"
+#include <QVarLengthArray>
+
+namespace {
+
+// Simple per-character case folding; the same on both sides of a lookup
+QString fold(QStringView word) {
+  QString folded(word.size(), Qt::Uninitialized);
+  for (qsizetype i = 0; i < word.size(); ++i)
+    folded[i] = word[i].toLower();
+  return folded;
+}
+
+} // namespace
+
+KeywordTable::KeywordTable(const QMap<QString, QString> &aliases, int version)
+    : m_version(version) {
+  const QStringList &keywords = builtins();
+  m_names.reserve(keywords.size() + aliases.size());
+  for (const QString &keyword : keywords)
+    m_names << keyword;
+
+  // Aliases of built-in keywords only; an alias shadows a keyword of the
+  // same name, as it did when aliases were resolved first
+  QList<int> targets;
+  for (auto it = aliases.constBegin(); it != aliases.constEnd(); ++it) {
+    QString alias = fold(QStringView(it.value()).trimmed());
+    int target = int(keywords.indexOf(it.key().toLower()));
+    if (alias.isEmpty() || target < 0)
+      continue;
+    m_names << alias;
+    targets << target;
+  }
+
+  // m_names doesn't change from here on, so views into it stay valid
+  m_index.reserve(m_names.size());
+  for (int i = 0; i < m_names.size(); ++i) {
+    int target = i < keywords.size() ? i : targets[i - int(keywords.size())];
+    m_index.insert(QStringView(m_names.at(i)), target);
+    m_maxLength = qMax(m_maxLength, int(m_names.at(i).size()));
+  }
+}
+
+const QStringList &KeywordTable::builtins() {
+  static const QStringList keywords = {
+      "list",  "checklist", "calc",  "sum",      "avg",
+      "count", "code",      "paste", "timer",    "plain",
+      "text",  "settings",  "ocr",   "markdown", "md"};
+  return keywords;
+}
+
+int KeywordTable::indexOf(QStringView word) const {
+  if (word.startsWith(QLatin1Char('/')))
+    word = word.mid(1);
+  if (word.isEmpty() || word.size() > m_maxLength)
+    return -1;
+
+  QVarLengthArray<QChar, 32> folded(word.size());
+  for (qsizetype i = 0; i < word.size(); ++i)
+    folded[i] = word[i].toLower();
+  return m_index.value(QStringView(folded.constData(), folded.size()), -1);
+}
+
+QString KeywordTable::resolve(QStringView word) const {
+  int index = indexOf(word);
+  return index < 0 ? QString() : builtins().at(index);
+}
@@ -0,0 +1,51 @@
+#ifndef LINNOTE_KEYWORDTABLE_H
+#define LINNOTE_KEYWORDTABLE_H
+
+#include <QHash>
+#include <QMap>
+#include <QString>
+#include <QStringList>
+#include <QStringView>
+
+/**
+ * @brief Immutable lookup of command keywords and their user aliases
+ *
+ * Built once per change of the aliases (see Settings::keywordTable()) and
+ * shared by the highlighters, the keyword tutorial and slash commands.
+ * Lookups are case-insensitive hash hits that don't allocate.
+ */
+class KeywordTable {
+public:
+  /**
+   * @param aliases Original keyword -> alias, as stored in Settings
+   * @param version Bumped by Settings on every change of the aliases
+   */
+  explicit KeywordTable(const QMap<QString, QString> &aliases = {},
+                        int version = 0);
+
+  // Built-in keywords, lower case
+  static const QStringList &builtins();
+
+  int version() const { return m_version; }
+
+  /**
+   * @brief Index into builtins() of the keyword @p word stands for
+   *
+   * @p word is a keyword or an alias of one, in any case, with an optional
+   * leading '/'. Surrounding whitespace is not trimmed. Returns -1 if none.
+   */
+  int indexOf(QStringView word) const;
+
+  // The built-in keyword @p word stands for, or an empty string
+  QString resolve(QStringView word) const;
+
+private:
+  Q_DISABLE_COPY(KeywordTable)
+
+  QStringList m_names;             // Folded keywords and aliases
+  QHash<QStringView, int> m_index; // Views into m_names
+  int m_maxLength = 0;
+  int m_version;
+};
+
+#endif // LINNOTE_KEYWORDTABLE_H
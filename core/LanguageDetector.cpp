@@ -0,0 +1,457 @@
+#include "LanguageDetector.h"
+#include <QHash>
+#include <QStringList>
+#include <QVarLengthArray>
+#include <QVector>
+#include <algorithm>
+
+namespace {
+
+using Language = LanguageDetector::Language;
+
+struct Feature {
+  const char *key;
+  Language language;
+  int weight;
+};
+
+// Words, "#directives", operators and line shapes. Line shapes start with a
+// space so they never collide with something read from the text.
+const Feature features[] = {
+    // Python
+    {"def", LanguageDetector::Python, 3},
+    {"elif", LanguageDetector::Python, 4},
+    {"self", LanguageDetector::Python, 2},
+    {"None", LanguageDetector::Python, 2},
+    {"True", LanguageDetector::Python, 1},
+    {"False", LanguageDetector::Python, 1},
+    {"import", LanguageDetector::Python, 1},
+    {"from", LanguageDetector::Python, 1},
+    {"print", LanguageDetector::Python, 1},
+    {"lambda", LanguageDetector::Python, 2},
+    {"__init__", LanguageDetector::Python, 4},
+    {"__name__", LanguageDetector::Python, 4},
+    {"pass", LanguageDetector::Python, 1},
+    {"except", LanguageDetector::Python, 3},
+    {"nonlocal", LanguageDetector::Python, 4},
+    {" ends :", LanguageDetector::Python, 1},
+
+    // JavaScript / TypeScript
+    {"function", LanguageDetector::JavaScript, 2},
+    {"const", LanguageDetector::JavaScript, 1},
+    {"let", LanguageDetector::JavaScript, 1},
+    {"var", LanguageDetector::JavaScript, 1},
+    {"console", LanguageDetector::JavaScript, 3},
+    {"document", LanguageDetector::JavaScript, 2},
+    {"window", LanguageDetector::JavaScript, 2},
+    {"require", LanguageDetector::JavaScript, 2},
+    {"undefined", LanguageDetector::JavaScript, 3},
+    {"async", LanguageDetector::JavaScript, 1},
+    {"await", LanguageDetector::JavaScript, 1},
+    {"typeof", LanguageDetector::JavaScript, 3},
+    {"export", LanguageDetector::JavaScript, 1},
+    {"=>", LanguageDetector::JavaScript, 3},
+    {"===", LanguageDetector::JavaScript, 4},
+    {"!==", LanguageDetector::JavaScript, 4},
+    {" ends ;", LanguageDetector::JavaScript, 1},
+    {" ends {", LanguageDetector::JavaScript, 1},
+
+    // C / C++
+    {"#include", LanguageDetector::Cpp, 5},
+    {"#define", LanguageDetector::Cpp, 4},
+    {"#ifndef", LanguageDetector::Cpp, 4},
+    {"#pragma", LanguageDetector::Cpp, 4},
+    {"std", LanguageDetector::Cpp, 3},
+    {"nullptr", LanguageDetector::Cpp, 4},
+    {"template", LanguageDetector::Cpp, 3},
+    {"typename", LanguageDetector::Cpp, 3},
+    {"namespace", LanguageDetector::Cpp, 3},
+    {"virtual", LanguageDetector::Cpp, 3},
+    {"cout", LanguageDetector::Cpp, 3},
+    {"printf", LanguageDetector::Cpp, 2},
+    {"const", LanguageDetector::Cpp, 1},
+    {"void", LanguageDetector::Cpp, 1},
+    {"int", LanguageDetector::Cpp, 1},
+    {"auto", LanguageDetector::Cpp, 1},
+    {"struct", LanguageDetector::Cpp, 1},
+    {"this", LanguageDetector::Cpp, 1},
+    {"::", LanguageDetector::Cpp, 2},
+    {"->", LanguageDetector::Cpp, 1},
+    {" ends ;", LanguageDetector::Cpp, 1},
+    {" ends {", LanguageDetector::Cpp, 1},
+
+    // Bash
+    {"echo", LanguageDetector::Bash, 3},
+    {"fi", LanguageDetector::Bash, 4},
+    {"esac", LanguageDetector::Bash, 5},
+    {"then", LanguageDetector::Bash, 2},
+    {"done", LanguageDetector::Bash, 2},
+    {"sudo", LanguageDetector::Bash, 3},
+    {"export", LanguageDetector::Bash, 1},
+    {"local", LanguageDetector::Bash, 1},
+    {"$(", LanguageDetector::Bash, 2},
+    {"${", LanguageDetector::Bash, 2},
+    {"&&", LanguageDetector::Bash, 1},
+
+    // JSON
+    {" \"key\":", LanguageDetector::Json, 2},
+    {"null", LanguageDetector::Json, 1},
+
+    // Rust
+    {"fn", LanguageDetector::Rust, 4},
+    {"mut", LanguageDetector::Rust, 4},
+    {"impl", LanguageDetector::Rust, 4},
+    {"crate", LanguageDetector::Rust, 4},
+    {"pub", LanguageDetector::Rust, 2},
+    {"let", LanguageDetector::Rust, 1},
+    {"match", LanguageDetector::Rust, 2},
+    {"use", LanguageDetector::Rust, 1},
+    {"struct", LanguageDetector::Rust, 1},
+    {"enum", LanguageDetector::Rust, 1},
+    {"Vec", LanguageDetector::Rust, 2},
+    {"Some", LanguageDetector::Rust, 2},
+    {"Ok", LanguageDetector::Rust, 1},
+    {"unwrap", LanguageDetector::Rust, 4},
+    {"println!", LanguageDetector::Rust, 5},
+    {"String", LanguageDetector::Rust, 1},
+    {"self", LanguageDetector::Rust, 1},
+    {"::", LanguageDetector::Rust, 1},
+    {"->", LanguageDetector::Rust, 1},
+    {" ends ;", LanguageDetector::Rust, 1},
+    {" ends {", LanguageDetector::Rust, 1},
+
+    // Go
+    {"func", LanguageDetector::Go, 4},
+    {"package", LanguageDetector::Go, 2},
+    {"chan", LanguageDetector::Go, 4},
+    {"defer", LanguageDetector::Go, 4},
+    {"fmt", LanguageDetector::Go, 4},
+    {"nil", LanguageDetector::Go, 3},
+    {"range", LanguageDetector::Go, 2},
+    {"go", LanguageDetector::Go, 1},
+    {"struct", LanguageDetector::Go, 1},
+    {"interface", LanguageDetector::Go, 1},
+    {":=", LanguageDetector::Go, 4},
+    {" ends {", LanguageDetector::Go, 1},
+
+    // SQL, matched in upper or lower case
+    {"SELECT", LanguageDetector::Sql, 3},
+    {"FROM", LanguageDetector::Sql, 2},
+    {"WHERE", LanguageDetector::Sql, 3},
+    {"INSERT", LanguageDetector::Sql, 3},
+    {"INTO", LanguageDetector::Sql, 2},
+    {"UPDATE", LanguageDetector::Sql, 2},
+    {"DELETE", LanguageDetector::Sql, 2},
+    {"CREATE", LanguageDetector::Sql, 2},
+    {"TABLE", LanguageDetector::Sql, 3},
+    {"JOIN", LanguageDetector::Sql, 3},
+    {"VALUES", LanguageDetector::Sql, 3},
+    {"GROUP", LanguageDetector::Sql, 1},
+    {"ORDER", LanguageDetector::Sql, 1},
+    {"BY", LanguageDetector::Sql, 1},
+    {"PRIMARY", LanguageDetector::Sql, 3},
+    {"VARCHAR", LanguageDetector::Sql, 4},
+    {"NULL", LanguageDetector::Sql, 1},
+    {" ends ;", LanguageDetector::Sql, 1},
+
+    // YAML
+    {" ---", LanguageDetector::Yaml, 3},
+    {" - item", LanguageDetector::Yaml, 1},
+    {" key: value", LanguageDetector::Yaml, 2},
+    {" key:", LanguageDetector::Yaml, 1},
+    {" \"key\":", LanguageDetector::Yaml, 1},
+
+    // TOML
+    {" [table]", LanguageDetector::Toml, 3},
+    {" [[table]]", LanguageDetector::Toml, 4},
+    {" key = value", LanguageDetector::Toml, 1},
+
+    // Java
+    {"System", LanguageDetector::Java, 4},
+    {"public", LanguageDetector::Java, 2},
+    {"private", LanguageDetector::Java, 1},
+    {"static", LanguageDetector::Java, 1},
+    {"void", LanguageDetector::Java, 1},
+    {"String", LanguageDetector::Java, 2},
+    {"extends", LanguageDetector::Java, 2},
+    {"implements", LanguageDetector::Java, 4},
+    {"throws", LanguageDetector::Java, 4},
+    {"boolean", LanguageDetector::Java, 3},
+    {"final", LanguageDetector::Java, 2},
+    {"package", LanguageDetector::Java, 1},
+    {"import", LanguageDetector::Java, 1},
+    {"@Override", LanguageDetector::Java, 5},
+    {"this", LanguageDetector::Java, 1},
+    {" ends ;", LanguageDetector::Java, 1},
+    {" ends {", LanguageDetector::Java, 1},
+};
+
+constexpr int FeatureCount = int(sizeof(features) / sizeof(features[0]));
+
+// A repeated feature stops counting after this many hits, so one word
+// used all over the text can't outvote everything else
+constexpr int MaxHits = 5;
+
+// Below this total nothing is recognizable
+constexpr int MinScore = 4;
+
+// Feature key -> indices into features[]; one key can count for several
+// languages
+struct FeatureIndex {
+  QStringList keys; // Owns what the hash's views point into
+  QHash<QStringView, QVector<int>> index;
+
+  FeatureIndex() {
+    keys.reserve(FeatureCount * 2);
+    for (const Feature &feature : features) {
+      keys << QString::fromLatin1(feature.key);
+      if (feature.language == LanguageDetector::Sql)
+        keys << keys.last().toLower();
+    }
+    int key = 0;
+    for (int i = 0; i < FeatureCount; ++i) {
+      index[QStringView(keys[key++])].append(i);
+      if (features[i].language == LanguageDetector::Sql)
+        index[QStringView(keys[key++])].append(i);
+    }
+  }
+};
+
+const QHash<QStringView, QVector<int>> &featureIndex() {
+  static const FeatureIndex table;
+  return table.index;
+}
+
+bool isWordStart(QChar c) { return c.isLetter() || c == '_'; }
+bool isWordChar(QChar c) { return c.isLetterOrNumber() || c == '_'; }
+
+// "name" or "some-name.sub" at the start of @p line; returns its length
+int keyLength(QStringView line) {
+  if (line.isEmpty() || !isWordStart(line[0]))
+    return 0;
+  int i = 1;
+  while (i < line.size() && (isWordChar(line[i]) || line[i] == '-' ||
+                             line[i] == '.'))
+    ++i;
+  return i;
+}
+
+class Scorer {
+public:
+  Scorer() : m_index(featureIndex()), m_hits(FeatureCount) {
+    std::fill(m_hits.begin(), m_hits.end(), 0);
+  }
+
+  // Returns false if @p key is not a feature
+  bool count(QStringView key) {
+    auto it = m_index.constFind(key);
+    if (it == m_index.cend())
+      return false;
+    for (int i : *it) {
+      if (m_hits[i] < MaxHits) {
+        ++m_hits[i];
+        m_scores[features[i].language] += features[i].weight;
+      }
+    }
+    return true;
+  }
+
+  void add(Language language, int weight) { m_scores[language] += weight; }
+
+  LanguageDetector::Result result() const {
+    LanguageDetector::Result result;
+    int best = 0;
+    int runnerUp = 0;
+    for (int i = 1; i < LanguageDetector::LanguageCount; ++i) {
+      if (m_scores[i] > best) {
+        runnerUp = best;
+        best = m_scores[i];
+        result.language = Language(i);
+      } else if (m_scores[i] > runnerUp) {
+        runnerUp = m_scores[i];
+      }
+    }
+    if (best < MinScore)
+      return LanguageDetector::Result();
+    result.confidence = double(best) / (best + runnerUp);
+    return result;
+  }
+
+private:
+  const QHash<QStringView, QVector<int>> &m_index;
+  QVarLengthArray<quint8, 256> m_hits;
+  int m_scores[LanguageDetector::LanguageCount] = {};
+};
+
+void scoreShebang(QStringView line, Scorer &scorer) {
+  if (line.contains(u"python"))
+    scorer.add(LanguageDetector::Python, 20);
+  else if (line.contains(u"node") || line.contains(u"deno"))
+    scorer.add(LanguageDetector::JavaScript, 20);
+  else if (line.endsWith(u"sh") || line.contains(u"bash"))
+    scorer.add(LanguageDetector::Bash, 20);
+}
+
+// What the line looks like as a whole
+void scoreLineShape(QStringView line, Scorer &scorer) {
+  if (line == u"---") {
+    scorer.count(u" ---");
+    return;
+  }
+  if (line.startsWith(u"- ")) {
+    scorer.count(u" - item");
+    return;
+  }
+
+  QChar last = line.back();
+  if (line.front() == '[' && last == ']') {
+    bool array = line.startsWith(u"[[") && line.endsWith(u"]]");
+    QStringView name = line.mid(array ? 2 : 1, line.size() - (array ? 4 : 2));
+    if (keyLength(name) == name.size()) {
+      scorer.count(array ? u" [[table]]" : u" [table]");
+      return;
+    }
+  }
+
+  int key = keyLength(line);
+  if (key > 0 && key < line.size()) {
+    QStringView rest = line.mid(key);
+    if (rest == u":") {
+      scorer.count(u" key:");
+    } else if (rest.startsWith(u": ") && last != ',' && last != ';' &&
+               !rest.contains('(') && !rest.contains('{')) {
+      scorer.count(u" key: value");
+    } else {
+      rest = rest.trimmed();
+      if (rest.startsWith('=') && !rest.startsWith(u"==") && last != ';') {
+        QStringView value = rest.mid(1).trimmed();
+        if (!value.isEmpty() &&
+            (value[0] == '"' || value[0] == '\'' || value[0] == '[' ||
+             value[0].isDigit() || value == u"true" || value == u"false"))
+          scorer.count(u" key = value");
+      }
+    }
+  }
+
+  if (last == ':')
+    scorer.count(u" ends :");
+  else if (last == ';')
+    scorer.count(u" ends ;");
+  else if (last == '{')
+    scorer.count(u" ends {");
+}
+
+void scoreTokens(QStringView line, Scorer &scorer) {
+  int i = 0;
+  while (i < line.size()) {
+    QChar c = line[i];
+
+    // Double-quoted strings are skipped; "key": is a feature of its own
+    if (c == '"') {
+      int end = i + 1;
+      while (end < line.size() && line[end] != '"')
+        end += line[end] == '\\' ? 2 : 1;
+      i = qMin(end + 1, int(line.size()));
+      int next = i;
+      while (next < line.size() && line[next] == ' ')
+        ++next;
+      if (next < line.size() && line[next] == ':')
+        scorer.count(u" \"key\":");
+      continue;
+    }
+
+    // Words, with a leading '#' or '@' or a trailing '!' where that's
+    // part of the feature (#include, @Override, println!)
+    bool prefixed = (c == '#' || c == '@') && i + 1 < line.size() &&
+                    isWordStart(line[i + 1]);
+    if (prefixed || isWordStart(c)) {
+      int start = i;
+      i += prefixed ? 2 : 1;
+      while (i < line.size() && isWordChar(line[i]))
+        ++i;
+      if (!(i < line.size() && line[i] == '!' &&
+            scorer.count(line.mid(start, i + 1 - start))))
+        scorer.count(line.mid(start, i - start));
+      continue;
+    }
+
+    // Operators, longest first
+    if (!c.isSpace() && !c.isLetterOrNumber()) {
+      if (i + 3 <= line.size() && scorer.count(line.mid(i, 3))) {
+        i += 3;
+        continue;
+      }
+      if (i + 2 <= line.size() && scorer.count(line.mid(i, 2))) {
+        i += 2;
+        continue;
+      }
+    }
+    ++i;
+  }
+}
+
+} // namespace
+
+LanguageDetector::Result LanguageDetector::detect(QStringView text) {
+  text = text.left(WindowChars);
+  Scorer scorer;
+
+  QStringView trimmed = text.trimmed();
+  if (trimmed.startsWith('{') || trimmed.startsWith('['))
+    scorer.add(Json, 2);
+
+  qsizetype start = 0;
+  while (start < text.size()) {
+    qsizetype end = text.indexOf('\n', start);
+    if (end < 0)
+      end = text.size();
+    QStringView line = text.mid(start, end - start).trimmed();
+    if (start == 0 && line.startsWith(u"#!"))
+      scoreShebang(line, scorer);
+    else if (!line.isEmpty()) {
+      scoreLineShape(line, scorer);
+      scoreTokens(line, scorer);
+    }
+    start = end + 1;
+  }
+  return scorer.result();
+}
+
+LanguageDetector::Result LanguageDetector::update(QStringView text) {
+  QStringView window = text.left(WindowChars);
+  if (m_valid && window == m_window)
+    return m_result;
+  m_window = window.toString();
+  m_result = detect(window);
+  m_valid = true;
+  return m_result;
+}
+
+QString LanguageDetector::name(Language language) {
+  switch (language) {
+  case Python:
+    return "python";
+  case JavaScript:
+    return "javascript";
+  case Cpp:
+    return "cpp";
+  case Bash:
+    return "bash";
+  case Json:
+    return "json";
+  case Rust:
+    return "rust";
+  case Go:
+    return "go";
+  case Sql:
+    return "sql";
+  case Yaml:
+    return "yaml";
+  case Toml:
+    return "toml";
+  case Java:
+    return "java";
+  default:
+    return QString();
+  }
+}
@@ -0,0 +1,62 @@
+#ifndef LINNOTE_LANGUAGEDETECTOR_H
+#define LINNOTE_LANGUAGEDETECTOR_H
+
+#include <QString>
+#include <QStringView>
+
+/**
+ * @brief Guesses the programming language of a piece of code
+ *
+ * A token-frequency classifier: one pass over the first WindowChars of the
+ * text counts weighted features per language (keywords, operators like
+ * "::" or ":=", line shapes like "[section]" or "key: value"), each
+ * feature counting at most a few times. The best total wins; the
+ * confidence is its share of the best two totals, so 0.5 is a tie.
+ *
+ * Reading only a bounded prefix keeps multi-MB pastes as cheap as small
+ * ones; update() skips the work entirely while that prefix is unchanged.
+ */
+class LanguageDetector {
+public:
+  enum Language {
+    Unknown,
+    Python,
+    JavaScript,
+    Cpp,
+    Bash,
+    Json,
+    Rust,
+    Go,
+    Sql,
+    Yaml,
+    Toml,
+    Java,
+    LanguageCount
+  };
+
+  struct Result {
+    Language language = Unknown;
+    double confidence = 0.0; // 0.5..1 when recognized, else 0
+  };
+
+  static constexpr int WindowChars = 4096;
+
+  // Below this, callers should keep their current language
+  static constexpr double MinConfidence = 0.6;
+
+  // Classify the start of @p text
+  static Result detect(QStringView text);
+
+  // detect(), unless the first WindowChars are the same as last time
+  Result update(QStringView text);
+  Result result() const { return m_result; }
+
+  static QString name(Language language);
+
+private:
+  QString m_window; // What m_result was computed from
+  Result m_result;
+  bool m_valid = false;
+};
+
+#endif // LINNOTE_LANGUAGEDETECTOR_H
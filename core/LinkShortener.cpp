@@ -0,0 +1,152 @@
+#include "LinkShortener.h"
+#include <QCoreApplication>
+#include <QDebug>
+#include <QDir>
+#include <QFile>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QNetworkReply>
+#include <QStandardPaths>
+
+LinkShortener *LinkShortener::instance() {
+  static LinkShortener instance;
+  return &instance;
+}
+
+LinkShortener::LinkShortener(QObject *parent)
+    : QObject(parent), m_manager(new QNetworkAccessManager(this)) {
+  // Results come in bursts; write them out once it settles
+  m_saveTimer.setSingleShot(true);
+  m_saveTimer.setInterval(SaveDelayMs);
+  connect(&m_saveTimer, &QTimer::timeout, this, &LinkShortener::saveCache);
+  // Flush a pending save while Qt is still up: the instance is a static,
+  // destroyed after the application is gone
+  if (QCoreApplication *app = QCoreApplication::instance()) {
+    connect(app, &QCoreApplication::aboutToQuit, this, [this]() {
+      if (m_saveTimer.isActive()) {
+        m_saveTimer.stop();
+        saveCache();
+      }
+    });
+  }
+  loadCache();
+}
+
+QString LinkShortener::cacheKey(const QString &url,
+                                UrlShortener::Service service) {
+  return UrlShortener::serviceToString(service) + ' ' + url;
+}
+
+QString LinkShortener::cached(const QString &url,
+                              UrlShortener::Service service) const {
+  return m_cache.value(cacheKey(url, service));
+}
+
+void LinkShortener::shorten(const QString &url,
+                            UrlShortener::Service service) {
+  QString shortUrl = cached(url, service);
+  if (!shortUrl.isEmpty()) {
+    // Answered later like any other, so callers can track the URL first
+    QMetaObject::invokeMethod(
+        this, [this, url, shortUrl]() { emit shortened(url, shortUrl); },
+        Qt::QueuedConnection);
+    return;
+  }
+
+  QString key = cacheKey(url, service);
+  if (m_pending.contains(key)) {
+    return;
+  }
+  m_pending.insert(key);
+  m_queue.enqueue({url, service});
+  startRequests();
+}
+
+void LinkShortener::startRequests() {
+  while (m_inFlight < MaxInFlight && !m_queue.isEmpty()) {
+    Request request = m_queue.dequeue();
+    QNetworkReply *reply = m_manager->get(
+        QNetworkRequest(UrlShortener::apiUrl(request.url, request.service)));
+    ++m_inFlight;
+
+    connect(reply, &QNetworkReply::finished, this, [this, reply, request]() {
+      reply->deleteLater();
+      --m_inFlight;
+
+      QString key = cacheKey(request.url, request.service);
+      m_pending.remove(key);
+      QString message;
+      QString shortUrl = UrlShortener::readReply(reply, &message);
+      if (shortUrl.isEmpty()) {
+        emit failed(request.url, message);
+      } else {
+        remember(key, shortUrl);
+        emit shortened(request.url, shortUrl);
+      }
+      startRequests();
+    });
+  }
+}
+
+void LinkShortener::remember(const QString &key, const QString &shortUrl) {
+  if (!m_cache.contains(key)) {
+    m_cacheOrder.append(key);
+  }
+  m_cache.insert(key, shortUrl);
+  while (m_cacheOrder.size() > MaxCached) {
+    m_cache.remove(m_cacheOrder.takeFirst());
+  }
+  m_saveTimer.start();
+}
+
+void LinkShortener::loadCache() {
+  QFile file(cachePath());
+  if (!file.exists() || !file.open(QIODevice::ReadOnly)) {
+    return;
+  }
+
+  QJsonDocument doc = QJsonDocument::fromJson(file.readAll());
+  file.close();
+
+  // Pairs of key and short URL, oldest first
+  const QJsonArray links = doc.object()["links"].toArray();
+  for (const QJsonValue &link : links) {
+    QJsonArray pair = link.toArray();
+    QString key = pair.at(0).toString();
+    QString shortUrl = pair.at(1).toString();
+    if (!key.isEmpty() && !shortUrl.isEmpty() && !m_cache.contains(key)) {
+      m_cache.insert(key, shortUrl);
+      m_cacheOrder.append(key);
+    }
+  }
+
+  qDebug() << "LinkShortener: Loaded" << m_cache.size() << "cached links";
+}
+
+void LinkShortener::saveCache() {
+  QFile file(cachePath());
+  if (!file.open(QIODevice::WriteOnly)) {
+    return;
+  }
+
+  QJsonArray links;
+  for (const QString &key : std::as_const(m_cacheOrder)) {
+    links.append(QJsonArray{key, m_cache.value(key)});
+  }
+  QJsonObject json;
+  json["links"] = links;
+
+  file.write(QJsonDocument(json).toJson(QJsonDocument::Compact));
+  file.close();
+}
+
+QString LinkShortener::cachePath() const {
+  QString dataPath =
+      QStandardPaths::writableLocation(QStandardPaths::AppDataLocation);
+  QDir dir(dataPath);
+  if (!dir.exists()) {
+    dir.mkpath(".");
+  }
+  return dataPath + "/short_links.json";
+}
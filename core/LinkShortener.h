@@ -0,0 +1,64 @@
+#ifndef LINNOTE_LINKSHORTENER_H
+#define LINNOTE_LINKSHORTENER_H
+
+#include "UrlShortener.h"
+#include <QHash>
+#include <QNetworkAccessManager>
+#include <QObject>
+#include <QQueue>
+#include <QSet>
+#include <QStringList>
+#include <QTimer>
+
+/**
+ * @brief Shortens many URLs at once, remembering the results
+ *
+ * Short URLs are cached on disk (short_links.json), so a link pasted
+ * again needs no request. A URL asked for while its request is queued or
+ * running is requested once; at most MaxInFlight requests run at a time.
+ * Every shorten() call is answered by shortened() or failed() for its URL.
+ */
+class LinkShortener : public QObject {
+  Q_OBJECT
+
+public:
+  static constexpr int MaxInFlight = 4;
+  static constexpr int MaxCached = 5000; // The oldest go first
+  static constexpr int SaveDelayMs = 2000;
+
+  static LinkShortener *instance();
+
+  // Empty if @p url wasn't shortened with @p service before
+  QString cached(const QString &url, UrlShortener::Service service) const;
+
+  void shorten(const QString &url, UrlShortener::Service service);
+
+signals:
+  void shortened(const QString &url, const QString &shortUrl);
+  void failed(const QString &url, const QString &message);
+
+private:
+  explicit LinkShortener(QObject *parent = nullptr);
+
+  struct Request {
+    QString url;
+    UrlShortener::Service service;
+  };
+
+  static QString cacheKey(const QString &url, UrlShortener::Service service);
+  void startRequests();
+  void remember(const QString &key, const QString &shortUrl);
+  void loadCache();
+  void saveCache();
+  QString cachePath() const;
+
+  QNetworkAccessManager *m_manager;
+  QQueue<Request> m_queue;
+  QSet<QString> m_pending; // Keys queued or in flight
+  int m_inFlight = 0;
+  QHash<QString, QString> m_cache; // Key -> short URL
+  QStringList m_cacheOrder;        // Keys, oldest first
+  QTimer m_saveTimer;
+};
+
+#endif // LINNOTE_LINKSHORTENER_H
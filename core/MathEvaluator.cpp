@@ -1,9 +1,67 @@
 #include "MathEvaluator.h"
+#include "AhoCorasick.h"
 #include <QDebug>
 #include <QRegularExpression>
 #include <QtMath>
 
-MathEvaluator::MathEvaluator() {}
+namespace {
+
+// Single-argument math functions shared by the double and decimal parsers
+bool applyMathFunction(const QString &funcName, double arg, double &result) {
+  if (funcName == "sqrt") {
+    result = std::sqrt(arg);
+  } else if (funcName == "sin") {
+    result = std::sin(arg);
+  } else if (funcName == "cos") {
+    result = std::cos(arg);
+  } else if (funcName == "tan") {
+    result = std::tan(arg);
+  } else if (funcName == "asin") {
+    result = std::asin(arg);
+  } else if (funcName == "acos") {
+    result = std::acos(arg);
+  } else if (funcName == "atan") {
+    result = std::atan(arg);
+  } else if (funcName == "log" || funcName == "log10") {
+    result = std::log10(arg);
+  } else if (funcName == "ln") {
+    result = std::log(arg);
+  } else if (funcName == "exp") {
+    result = std::exp(arg);
+  } else if (funcName == "ceil") {
+    result = std::ceil(arg);
+  } else if (funcName == "floor") {
+    result = std::floor(arg);
+  } else if (funcName == "round") {
+    result = std::round(arg);
+  } else if (funcName == "abs") {
+    result = std::abs(arg);
+  } else {
+    return false;
+  }
+  return true;
+}
+
+bool isAggregateFunction(const QString &funcName) {
+  return funcName == "sum" || funcName == "avg" || funcName == "average" ||
+         funcName == "min" || funcName == "max" || funcName == "count";
+}
+
+// Arithmetic that differs between the two number types
+bool isZero(double value) { return value == 0; }
+bool isZero(const Decimal &value) { return value.isZero(); }
+
+bool isValid(double) { return true; } // inf and nan are results too
+bool isValid(const Decimal &value) { return value.isValid(); }
+
+double modulo(double a, double b) { return std::fmod(a, b); }
+Decimal modulo(const Decimal &a, const Decimal &b) { return a % b; }
+
+} // namespace
+
+MathEvaluator::MathEvaluator()
+    : m_numberMode(NumberMode::Double), m_decimalScale(Decimal::DefaultScale) {
+}
 
 bool MathEvaluator::isMathExpression(const QString &line) const {
   QString trimmed = line.trimmed();
@@ -25,11 +83,14 @@ bool MathEvaluator::isMathExpression(const QString &line) const {
   }
 
   // Check for function calls like sqrt(16), sin(0), etc.
-  static QRegularExpression funcPattern(
-      R"(\b(sqrt|sin|cos|tan|asin|acos|atan|log|log10|ln|exp|ceil|floor|round|abs|sum|avg|average|min|max|count)\s*\()",
-      QRegularExpression::CaseInsensitiveOption);
-  if (funcPattern.match(trimmed).hasMatch()) {
-    return true;
+  static const AhoCorasick functions(
+      functionNames(), AhoCorasick::CaseInsensitive | AhoCorasick::WholeWords);
+  for (const AhoCorasick::Match &match : functions.findAll(trimmed)) {
+    int next = match.start + match.length;
+    while (next < trimmed.size() && trimmed[next].isSpace())
+      ++next;
+    if (next < trimmed.size() && trimmed[next] == '(')
+      return true;
   }
 
   // Check for common math patterns
@@ -45,471 +106,499 @@ bool MathEvaluator::isMathExpression(const QString &line) const {
   return hasOperator.match(trimmed).hasMatch();
 }
 
-double MathEvaluator::evaluate(const QString &expression, bool *ok) {
-  QString expr = expression.trimmed();
+// ============================================================================
+// Parser
+// ============================================================================
+
+/**
+ * Recursive descent over one line, in double or Decimal. The grammar is
+ * shared; the members specialized per number type below supply literals,
+ * powers, functions and the evaluator state the sheet builds up.
+ */
+template <typename Number> class MathEvaluator::Parser {
+public:
+  Parser(MathEvaluator &eval, const QString &expression)
+      : m_eval(eval), m_expr(expression.trimmed()) {}
+
+  // An assignment, a bare aggregate or an expression
+  Number statement(bool *ok);
+
+private:
+  Number expression();
+  Number term();
+  Number factor();
+  Number number();
+  Number call(const QString &funcName);
+  Number aggregate(const QString &funcName,
+                   const QList<Number> &values) const;
+  void skipWhitespace();
+
+  Number integer(qint64 value) const;
+  Number literal(const QString &text, bool *ok) const;
+  Number power(const Number &base, const Number &exponent) const;
+  bool function(const QString &funcName, const Number &arg,
+                Number &result) const;
+  bool variable(const QString &name, Number &value) const;
+  void assign(const QString &name, const Number &value);
+  QList<Number> &values();
+
+  MathEvaluator &m_eval;
+  QString m_expr;
+  int m_pos = 0;
+  bool m_ok = true;
+};
+
+template <typename Number>
+Number MathEvaluator::Parser<Number>::statement(bool *ok) {
   if (ok)
     *ok = false;
 
-  // Check for variable assignment: x = 10 OR name: value format
+  // Variable assignment: x = 10 OR name: value
   static QRegularExpression assignment(R"(^([a-zA-Z_]\w*)\s*[:=]\s*(.+)$)");
-  QRegularExpressionMatch match = assignment.match(expr);
-
-  if (match.hasMatch()) {
-    QString varName = match.captured(1);
-    QString valueExpr = match.captured(2);
-
-    bool evalOk = false;
-    double value = evaluate(valueExpr, &evalOk);
-
-    if (evalOk) {
-      m_variables[varName] = value;
-      m_values.append(value);
-      if (ok)
-        *ok = true;
-      return value;
-    }
-    return 0;
+  QStringList names;
+  QRegularExpressionMatch match = assignment.match(m_expr);
+  while (match.hasMatch()) {
+    names.append(match.captured(1));
+    m_expr = match.captured(2).trimmed();
+    match = assignment.match(m_expr);
   }
 
-  // Check for special functions
-  if (expr.toLower() == "sum()" || expr.toLower() == "sum") {
-    double sum = 0;
-    for (double v : m_values)
-      sum += v;
-    if (ok)
-      *ok = true;
-    return sum;
-  }
+  // Bare aggregates over the sheet: sum, avg(), count ...
+  QString lower = m_expr.toLower();
+  if (lower.endsWith("()"))
+    lower.chop(2);
+  bool aggregated = isAggregateFunction(lower);
 
-  if (expr.toLower() == "avg()" || expr.toLower() == "avg" ||
-      expr.toLower() == "average()" || expr.toLower() == "average") {
-    if (m_values.isEmpty()) {
-      if (ok)
-        *ok = true;
-      return 0;
-    }
-    double sum = 0;
-    for (double v : m_values)
-      sum += v;
-    if (ok)
-      *ok = true;
-    return sum / m_values.size();
-  }
-
-  if (expr.toLower() == "min()" || expr.toLower() == "min") {
-    if (m_values.isEmpty()) {
-      if (ok)
-        *ok = true;
-      return 0;
-    }
-    double minVal = m_values.first();
-    for (double v : m_values)
-      if (v < minVal)
-        minVal = v;
-    if (ok)
-      *ok = true;
-    return minVal;
-  }
-
-  if (expr.toLower() == "max()" || expr.toLower() == "max") {
-    if (m_values.isEmpty()) {
-      if (ok)
-        *ok = true;
-      return 0;
-    }
-    double maxVal = m_values.first();
-    for (double v : m_values)
-      if (v > maxVal)
-        maxVal = v;
-    if (ok)
-      *ok = true;
-    return maxVal;
-  }
-
-  if (expr.toLower() == "count()" || expr.toLower() == "count") {
-    if (ok)
-      *ok = true;
-    return m_values.size();
+  Number result{};
+  if (aggregated) {
+    result = aggregate(lower, values());
+  } else {
+    result = expression();
+    if (!m_ok || !isValid(result))
+      return Number();
   }
 
-  // Parse regular expression
-  int pos = 0;
-  double result = parseExpression(expr, pos, ok);
-
-  // Store the result
-  if (ok && *ok) {
-    m_values.append(result);
-  }
+  // Aggregates themselves don't count towards later ones, assignments do
+  if (!aggregated || !names.isEmpty())
+    values().append(result);
+  for (const QString &name : std::as_const(names))
+    assign(name, result);
 
+  if (ok)
+    *ok = true;
   return result;
 }
 
-void MathEvaluator::setVariable(const QString &name, double value) {
-  m_variables[name] = value;
-}
-
-QList<double> MathEvaluator::allValues() const { return m_values; }
-
-void MathEvaluator::clear() {
-  m_variables.clear();
-  m_values.clear();
-}
-
-QStringList MathEvaluator::getVariables() const { return m_variables.keys(); }
+template <typename Number>
+Number MathEvaluator::Parser<Number>::expression() {
+  Number result = term();
+  skipWhitespace();
 
-double MathEvaluator::parseExpression(const QString &expr, int &pos, bool *ok) {
-  double result = parseTerm(expr, pos, ok);
-  if (ok && !*ok)
-    return 0;
-
-  skipWhitespace(expr, pos);
-
-  while (pos < expr.length()) {
-    QChar ch = expr[pos];
-    if (ch == '+') {
-      pos++;
-      double term = parseTerm(expr, pos, ok);
-      if (ok && !*ok)
-        return 0;
-      result += term;
-    } else if (ch == '-') {
-      pos++;
-      double term = parseTerm(expr, pos, ok);
-      if (ok && !*ok)
-        return 0;
-      result -= term;
-    } else {
+  while (m_ok && m_pos < m_expr.length()) {
+    QChar ch = m_expr[m_pos];
+    if (ch != '+' && ch != '-')
       break;
-    }
-    skipWhitespace(expr, pos);
+    m_pos++;
+    Number right = term();
+    result = (ch == '+') ? result + right : result - right;
+    skipWhitespace();
   }
 
-  return result;
+  return m_ok ? result : Number();
 }
 
-double MathEvaluator::parseTerm(const QString &expr, int &pos, bool *ok) {
-  double result = parseFactor(expr, pos, ok);
-  if (ok && !*ok)
-    return 0;
+template <typename Number> Number MathEvaluator::Parser<Number>::term() {
+  Number result = factor();
+  skipWhitespace();
 
-  skipWhitespace(expr, pos);
+  while (m_ok && m_pos < m_expr.length()) {
+    QChar ch = m_expr[m_pos];
+    if (ch != '*' && ch != '/' && ch != '%')
+      break;
+    m_pos++;
+    Number right = factor();
+    if (!m_ok)
+      break;
 
-  while (pos < expr.length()) {
-    QChar ch = expr[pos];
     if (ch == '*') {
-      pos++;
-      double factor = parseFactor(expr, pos, ok);
-      if (ok && !*ok)
-        return 0;
-      result *= factor;
-    } else if (ch == '/') {
-      pos++;
-      double factor = parseFactor(expr, pos, ok);
-      if (ok && !*ok)
-        return 0;
-      if (factor != 0) {
-        result /= factor;
-      } else {
-        if (ok)
-          *ok = false;
-        return 0;
-      }
-    } else if (ch == '%') {
-      pos++;
-      double factor = parseFactor(expr, pos, ok);
-      if (ok && !*ok)
-        return 0;
-      if (factor != 0) {
-        result = std::fmod(result, factor);
-      } else {
-        if (ok)
-          *ok = false;
-        return 0;
-      }
+      result = result * right;
+    } else if (isZero(right)) {
+      m_ok = false;
     } else {
-      break;
+      result = (ch == '/') ? result / right : modulo(result, right);
     }
-    skipWhitespace(expr, pos);
+    skipWhitespace();
   }
 
-  return result;
+  return m_ok ? result : Number();
 }
 
-double MathEvaluator::parseFactor(const QString &expr, int &pos, bool *ok) {
-  skipWhitespace(expr, pos);
-
-  double result = 0;
-  bool negative = false;
+template <typename Number> Number MathEvaluator::Parser<Number>::factor() {
+  skipWhitespace();
 
   // Handle unary minus
-  if (pos < expr.length() && expr[pos] == '-') {
+  bool negative = false;
+  if (m_pos < m_expr.length() && m_expr[m_pos] == '-') {
     negative = true;
-    pos++;
-    skipWhitespace(expr, pos);
+    m_pos++;
+    skipWhitespace();
   }
 
-  if (pos < expr.length() && expr[pos] == '(') {
-    pos++; // skip '('
-    result = parseExpression(expr, pos, ok);
-    if (ok && !*ok)
-      return 0;
-    skipWhitespace(expr, pos);
-    if (pos < expr.length() && expr[pos] == ')') {
-      pos++; // skip ')'
+  Number result{};
+  if (m_pos < m_expr.length() && m_expr[m_pos] == '(') {
+    m_pos++; // skip '('
+    result = expression();
+    skipWhitespace();
+    if (m_pos < m_expr.length() && m_expr[m_pos] == ')') {
+      m_pos++; // skip ')'
     }
   } else {
-    result = parseNumber(expr, pos, ok);
+    result = number();
   }
+  if (!m_ok)
+    return Number();
 
   // Handle power operator (^ or **)
-  skipWhitespace(expr, pos);
-  if (pos < expr.length() && expr[pos] == '^') {
-    pos++;
-    double exponent = parseFactor(expr, pos, ok);
-    if (ok && !*ok)
-      return 0;
-    result = std::pow(result, exponent);
-  } else if (pos + 1 < expr.length() && expr[pos] == '*' &&
-             expr[pos + 1] == '*') {
-    pos += 2; // Skip '**'
-    double exponent = parseFactor(expr, pos, ok);
-    if (ok && !*ok)
-      return 0;
-    result = std::pow(result, exponent);
+  skipWhitespace();
+  bool hasPower = false;
+  if (m_pos < m_expr.length() && m_expr[m_pos] == '^') {
+    m_pos++;
+    hasPower = true;
+  } else if (m_pos + 1 < m_expr.length() && m_expr[m_pos] == '*' &&
+             m_expr[m_pos + 1] == '*') {
+    m_pos += 2; // Skip '**'
+    hasPower = true;
+  }
+
+  if (hasPower) {
+    Number exponent = factor();
+    if (!m_ok)
+      return Number();
+    result = power(result, exponent);
   }
 
   return negative ? -result : result;
 }
 
-double MathEvaluator::parseNumber(const QString &expr, int &pos, bool *ok) {
-  skipWhitespace(expr, pos);
+template <typename Number> Number MathEvaluator::Parser<Number>::number() {
+  skipWhitespace();
 
   // Check for function or variable name
-  if (pos < expr.length() && (expr[pos].isLetter() || expr[pos] == '_')) {
+  if (m_pos < m_expr.length() &&
+      (m_expr[m_pos].isLetter() || m_expr[m_pos] == '_')) {
     QString name;
-    while (pos < expr.length() &&
-           (expr[pos].isLetterOrNumber() || expr[pos] == '_')) {
-      name += expr[pos];
-      pos++;
+    while (m_pos < m_expr.length() &&
+           (m_expr[m_pos].isLetterOrNumber() || m_expr[m_pos] == '_')) {
+      name += m_expr[m_pos];
+      m_pos++;
     }
 
-    skipWhitespace(expr, pos);
+    skipWhitespace();
 
     // Check if it's a function call (has parentheses)
-    if (pos < expr.length() && expr[pos] == '(') {
-      pos++; // skip '('
-
-      QString funcName = name.toLower();
-
-      // Check for multi-argument functions: sum, avg, min, max, count
-      if (funcName == "sum" || funcName == "avg" || funcName == "average" ||
-          funcName == "min" || funcName == "max" || funcName == "count") {
-        QList<double> args;
-        skipWhitespace(expr, pos);
-
-        // Parse comma-separated arguments
-        while (pos < expr.length() && expr[pos] != ')') {
-          double arg = parseExpression(expr, pos, ok);
-          if (ok && !*ok)
-            return 0;
-          args.append(arg);
-          skipWhitespace(expr, pos);
-          if (pos < expr.length() && expr[pos] == ',') {
-            pos++; // skip ','
-            skipWhitespace(expr, pos);
-          }
-        }
-
-        skipWhitespace(expr, pos);
-        if (pos < expr.length() && expr[pos] == ')') {
-          pos++; // skip ')'
-        }
-
-        if (ok)
-          *ok = true;
-
-        if (args.isEmpty()) {
-          // No arguments - use stored values
-          if (funcName == "sum") {
-            double sum = 0;
-            for (double v : m_values)
-              sum += v;
-            return sum;
-          } else if (funcName == "avg" || funcName == "average") {
-            if (m_values.isEmpty())
-              return 0;
-            double sum = 0;
-            for (double v : m_values)
-              sum += v;
-            return sum / m_values.size();
-          } else if (funcName == "min") {
-            if (m_values.isEmpty())
-              return 0;
-            double minVal = m_values.first();
-            for (double v : m_values)
-              if (v < minVal)
-                minVal = v;
-            return minVal;
-          } else if (funcName == "max") {
-            if (m_values.isEmpty())
-              return 0;
-            double maxVal = m_values.first();
-            for (double v : m_values)
-              if (v > maxVal)
-                maxVal = v;
-            return maxVal;
-          } else if (funcName == "count") {
-            return m_values.size();
-          }
-        } else {
-          // Use provided arguments
-          if (funcName == "sum") {
-            double sum = 0;
-            for (double v : args)
-              sum += v;
-            return sum;
-          } else if (funcName == "avg" || funcName == "average") {
-            double sum = 0;
-            for (double v : args)
-              sum += v;
-            return sum / args.size();
-          } else if (funcName == "min") {
-            double minVal = args.first();
-            for (double v : args)
-              if (v < minVal)
-                minVal = v;
-            return minVal;
-          } else if (funcName == "max") {
-            double maxVal = args.first();
-            for (double v : args)
-              if (v > maxVal)
-                maxVal = v;
-            return maxVal;
-          } else if (funcName == "count") {
-            return args.size();
-          }
-        }
-      }
-
-      // Single-argument functions
-      double arg = parseExpression(expr, pos, ok);
-      if (ok && !*ok)
-        return 0;
-      skipWhitespace(expr, pos);
-      if (pos < expr.length() && expr[pos] == ')') {
-        pos++; // skip ')'
-      }
-
-      if (ok)
-        *ok = true;
-
-      // Mathematical functions
-      if (funcName == "sqrt") {
-        return std::sqrt(arg);
-      } else if (funcName == "sin") {
-        return std::sin(arg);
-      } else if (funcName == "cos") {
-        return std::cos(arg);
-      } else if (funcName == "tan") {
-        return std::tan(arg);
-      } else if (funcName == "asin") {
-        return std::asin(arg);
-      } else if (funcName == "acos") {
-        return std::acos(arg);
-      } else if (funcName == "atan") {
-        return std::atan(arg);
-      } else if (funcName == "log" || funcName == "log10") {
-        return std::log10(arg);
-      } else if (funcName == "ln") {
-        return std::log(arg);
-      } else if (funcName == "exp") {
-        return std::exp(arg);
-      } else if (funcName == "ceil") {
-        return std::ceil(arg);
-      } else if (funcName == "floor") {
-        return std::floor(arg);
-      } else if (funcName == "round") {
-        return std::round(arg);
-      } else if (funcName == "abs") {
-        return std::abs(arg);
-      } else {
-        // Unknown function
-        if (ok)
-          *ok = false;
-        return 0;
-      }
+    if (m_pos < m_expr.length() && m_expr[m_pos] == '(') {
+      m_pos++; // skip '('
+      return call(name.toLower());
     }
 
     // It's a variable
-    if (m_variables.contains(name)) {
-      if (ok)
-        *ok = true;
-      return m_variables[name];
-    } else {
-      // Unknown variable
-      if (ok)
-        *ok = false;
-      return 0;
-    }
+    Number value;
+    if (!variable(name, value))
+      m_ok = false;
+    return value;
   }
 
   // Parse number - only use dot as decimal, comma is argument separator
-  QString numStr;
-  while (pos < expr.length() && (expr[pos].isDigit() || expr[pos] == '.')) {
-    numStr += expr[pos];
-    pos++;
+  int start = m_pos;
+  while (m_pos < m_expr.length() &&
+         (m_expr[m_pos].isDigit() || m_expr[m_pos] == '.')) {
+    m_pos++;
   }
 
   // Handle scientific notation (e.g., 1e3, 2.5e-2)
-  if (pos < expr.length() && (expr[pos] == 'e' || expr[pos] == 'E')) {
-    numStr += expr[pos];
-    pos++;
-    // Handle optional sign
-    if (pos < expr.length() && (expr[pos] == '+' || expr[pos] == '-')) {
-      numStr += expr[pos];
-      pos++;
+  if (m_pos > start && m_pos < m_expr.length() &&
+      (m_expr[m_pos] == 'e' || m_expr[m_pos] == 'E')) {
+    m_pos++;
+    if (m_pos < m_expr.length() &&
+        (m_expr[m_pos] == '+' || m_expr[m_pos] == '-')) {
+      m_pos++;
     }
-    // Parse exponent digits
-    while (pos < expr.length() && expr[pos].isDigit()) {
-      numStr += expr[pos];
-      pos++;
+    while (m_pos < m_expr.length() && m_expr[m_pos].isDigit()) {
+      m_pos++;
     }
   }
 
-  if (numStr.isEmpty()) {
-    if (ok)
-      *ok = false;
-    return 0;
-  }
-
   bool parseOk = false;
-  double value = numStr.toDouble(&parseOk);
-  if (ok)
-    *ok = parseOk;
+  Number value{};
+  if (m_pos > start)
+    value = literal(m_expr.mid(start, m_pos - start), &parseOk);
+  if (!parseOk) {
+    m_ok = false;
+    return Number();
+  }
 
   // Handle percentage postfix (e.g., 50% becomes 0.5)
   // But NOT if followed by a digit (that's modulo: 10%3)
-  skipWhitespace(expr, pos);
-  if (pos < expr.length() && expr[pos] == '%') {
-    // Check if next char after % is a digit - if so, it's modulo, not
-    // percentage
-    int nextPos = pos + 1;
-    while (nextPos < expr.length() && expr[nextPos].isSpace()) {
+  skipWhitespace();
+  if (m_pos < m_expr.length() && m_expr[m_pos] == '%') {
+    int nextPos = m_pos + 1;
+    while (nextPos < m_expr.length() && m_expr[nextPos].isSpace()) {
       nextPos++;
     }
-    if (nextPos >= expr.length() || !expr[nextPos].isDigit()) {
-      // It's percentage postfix
-      pos++;
-      value /= 100.0;
+    if (nextPos >= m_expr.length() || !m_expr[nextPos].isDigit()) {
+      m_pos++;
+      value = value / integer(100);
     }
-    // Otherwise leave % for parseTerm to handle as modulo
   }
 
   return value;
 }
 
-void MathEvaluator::skipWhitespace(const QString &expr, int &pos) {
-  while (pos < expr.length() && expr[pos].isSpace()) {
-    pos++;
+template <typename Number>
+Number MathEvaluator::Parser<Number>::call(const QString &funcName) {
+  // Multi-argument functions: sum, avg, min, max, count
+  if (isAggregateFunction(funcName)) {
+    QList<Number> args;
+    skipWhitespace();
+
+    // Parse comma-separated arguments
+    while (m_ok && m_pos < m_expr.length() && m_expr[m_pos] != ')') {
+      args.append(expression());
+      skipWhitespace();
+      if (m_pos < m_expr.length() && m_expr[m_pos] == ',') {
+        m_pos++; // skip ','
+        skipWhitespace();
+      }
+    }
+    if (!m_ok)
+      return Number();
+    if (m_pos < m_expr.length() && m_expr[m_pos] == ')') {
+      m_pos++; // skip ')'
+    }
+
+    // No arguments - use stored values
+    return aggregate(funcName, args.isEmpty() ? values() : args);
   }
+
+  // Single-argument functions
+  Number arg = expression();
+  if (!m_ok)
+    return Number();
+  skipWhitespace();
+  if (m_pos < m_expr.length() && m_expr[m_pos] == ')') {
+    m_pos++; // skip ')'
+  }
+
+  Number result{};
+  if (!function(funcName, arg, result))
+    m_ok = false; // Unknown function
+  return result;
+}
+
+template <typename Number>
+Number
+MathEvaluator::Parser<Number>::aggregate(const QString &funcName,
+                                         const QList<Number> &values) const {
+  if (funcName == "count")
+    return integer(values.size());
+  if (values.isEmpty())
+    return integer(0);
+
+  if (funcName == "min" || funcName == "max") {
+    Number best = values.first();
+    for (const Number &v : values) {
+      if (funcName == "min" ? v < best : v > best)
+        best = v;
+    }
+    return best;
+  }
+
+  Number total = integer(0);
+  for (const Number &v : values)
+    total += v;
+
+  if (funcName == "avg" || funcName == "average")
+    return total / integer(values.size());
+  return total;
+}
+
+template <typename Number>
+void MathEvaluator::Parser<Number>::skipWhitespace() {
+  while (m_pos < m_expr.length() && m_expr[m_pos].isSpace()) {
+    m_pos++;
+  }
+}
+
+// ---- double ----
+
+template <>
+double MathEvaluator::Parser<double>::integer(qint64 value) const {
+  return double(value);
+}
+
+template <>
+double MathEvaluator::Parser<double>::literal(const QString &text,
+                                              bool *ok) const {
+  return text.toDouble(ok);
+}
+
+template <>
+double MathEvaluator::Parser<double>::power(const double &base,
+                                            const double &exponent) const {
+  return std::pow(base, exponent);
+}
+
+template <>
+bool MathEvaluator::Parser<double>::function(const QString &funcName,
+                                             const double &arg,
+                                             double &result) const {
+  return applyMathFunction(funcName, arg, result);
+}
+
+template <>
+bool MathEvaluator::Parser<double>::variable(const QString &name,
+                                             double &value) const {
+  auto it = m_eval.m_variables.constFind(name);
+  if (it == m_eval.m_variables.constEnd())
+    return false;
+  value = it.value();
+  return true;
+}
+
+template <>
+void MathEvaluator::Parser<double>::assign(const QString &name,
+                                           const double &value) {
+  m_eval.m_variables[name] = value;
+}
+
+template <> QList<double> &MathEvaluator::Parser<double>::values() {
+  return m_eval.m_values;
+}
+
+// ---- Decimal ----
+
+template <>
+Decimal MathEvaluator::Parser<Decimal>::integer(qint64 value) const {
+  return Decimal(value, m_eval.m_decimalScale);
+}
+
+template <>
+Decimal MathEvaluator::Parser<Decimal>::literal(const QString &text,
+                                                bool *ok) const {
+  return Decimal::fromString(text, m_eval.m_decimalScale, ok);
+}
+
+template <>
+Decimal MathEvaluator::Parser<Decimal>::power(const Decimal &base,
+                                              const Decimal &exponent) const {
+  // Small integer powers stay exact, everything else goes through double
+  double e = exponent.toDouble();
+  if (exponent.isInteger() && std::abs(e) <= 64) {
+    Decimal power = integer(1);
+    for (int i = 0; i < static_cast<int>(std::abs(e)); ++i)
+      power = power * base;
+    return e < 0 ? integer(1) / power : power;
+  }
+  return Decimal::fromDouble(std::pow(base.toDouble(), e),
+                             m_eval.m_decimalScale);
+}
+
+template <>
+bool MathEvaluator::Parser<Decimal>::function(const QString &funcName,
+                                              const Decimal &arg,
+                                              Decimal &result) const {
+  // Rounding and abs are exact in decimal
+  if (funcName == "abs") {
+    result = arg.isNegative() ? -arg : arg;
+    return true;
+  }
+  if (funcName == "round" || funcName == "floor" || funcName == "ceil") {
+    Decimal rounded = arg.rescaled(0);
+    if (funcName == "floor" && rounded > arg)
+      rounded = rounded - Decimal(1, 0);
+    else if (funcName == "ceil" && rounded < arg)
+      rounded = rounded + Decimal(1, 0);
+    result = rounded.rescaled(m_eval.m_decimalScale);
+    return true;
+  }
+
+  double value = 0;
+  if (!applyMathFunction(funcName, arg.toDouble(), value))
+    return false;
+  result = Decimal::fromDouble(value, m_eval.m_decimalScale);
+  return result.isValid();
+}
+
+template <>
+bool MathEvaluator::Parser<Decimal>::variable(const QString &name,
+                                              Decimal &value) const {
+  // Values assigned in double mode are converted
+  auto it = m_eval.m_decimalVariables.constFind(name);
+  if (it != m_eval.m_decimalVariables.constEnd()) {
+    value = it.value();
+    return true;
+  }
+  auto fallback = m_eval.m_variables.constFind(name);
+  if (fallback == m_eval.m_variables.constEnd())
+    return false;
+  value = Decimal::fromDouble(fallback.value(), m_eval.m_decimalScale);
+  return true;
+}
+
+template <>
+void MathEvaluator::Parser<Decimal>::assign(const QString &name,
+                                            const Decimal &value) {
+  m_eval.m_decimalVariables[name] = value;
+  m_eval.m_variables[name] = value.toDouble();
+}
+
+template <> QList<Decimal> &MathEvaluator::Parser<Decimal>::values() {
+  return m_eval.m_decimalValues;
+}
+
+// ============================================================================
+// MathEvaluator
+// ============================================================================
+
+double MathEvaluator::evaluate(const QString &expression, bool *ok) {
+  return Parser<double>(*this, expression).statement(ok);
+}
+
+Decimal MathEvaluator::evaluateDecimal(const QString &expression, bool *ok) {
+  return Parser<Decimal>(*this, expression).statement(ok);
+}
+
+void MathEvaluator::setVariable(const QString &name, double value) {
+  m_variables[name] = value;
+}
+
+QList<double> MathEvaluator::allValues() const { return m_values; }
+
+void MathEvaluator::clear() {
+  m_variables.clear();
+  m_values.clear();
+  m_decimalVariables.clear();
+  m_decimalValues.clear();
+}
+
+MathEvaluator::NumberMode MathEvaluator::numberMode() const {
+  return m_numberMode;
+}
+
+void MathEvaluator::setNumberMode(NumberMode mode) { m_numberMode = mode; }
+
+int MathEvaluator::decimalScale() const { return m_decimalScale; }
+
+void MathEvaluator::setDecimalScale(int scale) {
+  m_decimalScale = qBound(0, scale, Decimal::MaxScale);
+}
+
+QStringList MathEvaluator::getVariables() const { return m_variables.keys(); }
+
+const QStringList &MathEvaluator::functionNames() {
+  static const QStringList names = {
+      "sqrt", "sin", "cos", "tan", "asin", "acos", "atan",
+      "log", "log10", "ln", "exp", "ceil", "floor", "round",
+      "abs", "sum", "avg", "average", "min", "max", "count"};
+  return names;
 }
@@ -1,6 +1,7 @@
 #ifndef LINNOTE_MATHEVALUATOR_H
 #define LINNOTE_MATHEVALUATOR_H
 
+#include "Decimal.h"
 #include <QMap>
 #include <QString>
 #include <QStringList>
@@ -14,9 +15,14 @@
  * - Parentheses: ( )
  * - Variables: x = 10 or name: 100, then x * 2
  * - Functions: sum(), avg(), min(), max()
+ *
+ * Two number modes: Double (default) and Decimal, which evaluates with
+ * exact fixed-point arithmetic for money sheets (see evaluateDecimal()).
  */
 class MathEvaluator {
 public:
+  enum class NumberMode { Double, Decimal };
+
   MathEvaluator();
 
   /**
@@ -27,6 +33,26 @@ public:
    */
   double evaluate(const QString &expression, bool *ok = nullptr);
 
+  /**
+   * @brief Evaluate with exact fixed-point arithmetic at decimalScale()
+   *
+   * Same syntax as evaluate(). Transcendental functions (sqrt, sin, ...)
+   * and non-integer powers are computed in double and rounded back.
+   */
+  Decimal evaluateDecimal(const QString &expression, bool *ok = nullptr);
+
+  /**
+   * @brief Number mode the caller should use for the current sheet
+   */
+  NumberMode numberMode() const;
+  void setNumberMode(NumberMode mode);
+
+  /**
+   * @brief Digits after the decimal point in Decimal mode (0-18)
+   */
+  int decimalScale() const;
+  void setDecimalScale(int scale);
+
   /**
    * @brief Check if a line contains a math expression
    */
@@ -52,15 +78,23 @@ public:
    */
   QStringList getVariables() const;
 
+  /**
+   * @brief Names of the functions expressions can call, lower case
+   */
+  static const QStringList &functionNames();
+
 private:
-  double parseExpression(const QString &expr, int &pos, bool *ok);
-  double parseTerm(const QString &expr, int &pos, bool *ok);
-  double parseFactor(const QString &expr, int &pos, bool *ok);
-  double parseNumber(const QString &expr, int &pos, bool *ok);
-  void skipWhitespace(const QString &expr, int &pos);
+  // The expression grammar, written once for double and Decimal
+  template <typename Number> class Parser;
 
   QMap<QString, double> m_variables;
   QList<double> m_values;
+
+  // Decimal mode keeps its own exact copies; assignments update both maps
+  NumberMode m_numberMode;
+  int m_decimalScale;
+  QMap<QString, Decimal> m_decimalVariables;
+  QList<Decimal> m_decimalValues;
 };
 
 #endif // LINNOTE_MATHEVALUATOR_H
@@ -0,0 +1,122 @@
+#include "MathSheetWorker.h"
+#include "CurrencyConverter.h"
+#include "UnitConverter.h"
+#include <QRegularExpression>
+
+MathSheetWorker::MathSheetWorker(QObject *parent)
+    : QObject(parent), m_latestVersion(0) {}
+
+void MathSheetWorker::supersede(int version) {
+  m_latestVersion.storeRelease(version);
+}
+
+bool MathSheetWorker::isStale(int version) const {
+  return m_latestVersion.loadAcquire() != version;
+}
+
+void MathSheetWorker::selectNumberMode(MathEvaluator &eval,
+                                       const QString &sheet,
+                                       int decimalScale) {
+  // Money sheets use exact decimal arithmetic so sums of cents don't drift
+  bool money = CurrencyConverter::instance()->mentionsCurrency(sheet);
+  eval.setNumberMode(money ? MathEvaluator::NumberMode::Decimal
+                           : MathEvaluator::NumberMode::Double);
+  eval.setDecimalScale(decimalScale);
+}
+
+QString MathSheetWorker::evaluateLine(MathEvaluator &eval,
+                                      const QString &expression) {
+  QString trimmed = expression.trimmed();
+  if (trimmed.isEmpty())
+    return QString();
+
+  // Try unit conversion first (e.g., "5 km to mile")
+  if (UnitConverter::instance()->isConversion(trimmed)) {
+    QString unitResult = UnitConverter::instance()->convert(trimmed);
+    if (!unitResult.isEmpty()) {
+      return unitResult;
+    }
+  }
+
+  // Try currency conversion (e.g., "100 USD to EUR"), exact in decimal mode
+  CurrencyConverter *converter = CurrencyConverter::instance();
+  QString fromCur, toCur;
+  bool decimal = eval.numberMode() == MathEvaluator::NumberMode::Decimal;
+
+  if (decimal) {
+    Decimal result;
+    if (converter->parseAndConvertDecimal(trimmed, eval.decimalScale(), result,
+                                          fromCur, toCur)) {
+      return QString("%1 %2").arg(result.rescaled(2).toString(), toCur);
+    }
+  } else {
+    double result;
+    if (converter->parseAndConvert(trimmed, result, fromCur, toCur)) {
+      return QString("%1 %2").arg(result, 0, 'f', 2).arg(toCur);
+    }
+  }
+
+  // Try math evaluation
+  bool ok;
+  if (decimal) {
+    Decimal result = eval.evaluateDecimal(trimmed, &ok);
+    if (!ok)
+      return QString();
+    return result.isInteger() ? result.rescaled(0).toString()
+                              : result.toString();
+  }
+
+  double result = eval.evaluate(trimmed, &ok);
+  if (!ok)
+    return QString();
+  // Format nicely
+  if (result == static_cast<int>(result))
+    return QString::number(static_cast<int>(result));
+  return QString::number(result, 'f', 4);
+}
+
+void MathSheetWorker::evaluate(int version, int baseVersion,
+                               const QString &text, int decimalScale) {
+  if (isStale(version))
+    return;
+
+  // Fresh evaluator per run: variables follow the sheet top to bottom
+  MathEvaluator eval;
+  selectNumberMode(eval, text, decimalScale);
+
+  static QRegularExpression resultPattern(R"(=\s*[\d.,]+\s*$)");
+
+  const QStringList lines = text.split('\n');
+  QStringList results;
+  results.reserve(lines.size());
+
+  for (const QString &line : lines) {
+    // A newer keystroke arrived; its run redoes the sheet
+    if (isStale(version))
+      return;
+
+    QString trimmed = line.trimmed();
+    if (trimmed.isEmpty() || trimmed == "---" ||
+        resultPattern.match(trimmed).hasMatch()) {
+      results.append(QString());
+      continue;
+    }
+    results.append(evaluateLine(eval, trimmed));
+  }
+
+  if (isStale(version))
+    return;
+
+  // Differences only against what the caller actually shows
+  bool full = baseVersion < 0 || baseVersion != m_lastVersion;
+  QMap<int, QString> changed;
+  for (int i = 0; i < results.size(); ++i) {
+    if (full || i >= m_lastResults.size() || m_lastResults[i] != results[i]) {
+      changed.insert(i, results[i]);
+    }
+  }
+  m_lastResults = results;
+  m_lastVersion = version;
+
+  emit evaluated(version, results.size(), changed, eval);
+}
@@ -0,0 +1,68 @@
+#ifndef LINNOTE_MATHSHEETWORKER_H
+#define LINNOTE_MATHSHEETWORKER_H
+
+#include "MathEvaluator.h"
+#include <QAtomicInt>
+#include <QMap>
+#include <QObject>
+#include <QString>
+
+/**
+ * @brief Evaluates whole Math sheets off the GUI thread
+ *
+ * Lives in a worker thread (see ModeHelper). Every request carries a
+ * version number; supersede() marks the newest one so an older run stops
+ * between lines instead of finishing work nobody will look at.
+ *
+ * Each request names the run its caller last applied. If that is the run
+ * this worker completed last, only lines whose result differs from it are
+ * reported; otherwise (the caller dropped or cleared results) every line
+ * is. The evaluator state (variables, values, number mode) the sheet
+ * produced comes along.
+ */
+class MathSheetWorker : public QObject {
+  Q_OBJECT
+
+public:
+  explicit MathSheetWorker(QObject *parent = nullptr);
+
+  /**
+   * @brief Mark @p version as the newest request (thread-safe)
+   *
+   * Runs with any other version are abandoned. Pass -1 to cancel all work.
+   */
+  void supersede(int version);
+
+  /**
+   * @brief Pick Double or Decimal mode for a sheet (decimal if it has money)
+   */
+  static void selectNumberMode(MathEvaluator &eval, const QString &sheet,
+                               int decimalScale);
+
+  /**
+   * @brief Evaluate one expression: unit, then currency, then plain math
+   * @return Formatted result, or empty if the line is not a calculation
+   */
+  static QString evaluateLine(MathEvaluator &eval, const QString &expression);
+
+public slots:
+  /**
+   * @param baseVersion Run whose results the caller shows, -1 for none
+   */
+  void evaluate(int version, int baseVersion, const QString &text,
+                int decimalScale);
+
+signals:
+  void evaluated(int version, int lineCount,
+                 const QMap<int, QString> &changedLines,
+                 const MathEvaluator &state);
+
+private:
+  bool isStale(int version) const;
+
+  QAtomicInt m_latestVersion;
+  QStringList m_lastResults; // Results of the last completed run
+  int m_lastVersion = -1;    // Its version
+};
+
+#endif // LINNOTE_MATHSHEETWORKER_H
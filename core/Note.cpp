@@ -1,4 +1,5 @@
 #include "Note.h"
+#include "AhoCorasick.h"
 #include <QJsonObject>
 #include <QRegularExpression>
 
@@ -54,7 +55,8 @@ QString Note::smartTitle() const {
     return m_created.toString("ddd hh:mm");
   }
 
-  QString text = m_content.trimmed();
+  // Only the start of the note, so titles stay cheap for large notes
+  QString text = leadingContent(TitleChars).trimmed();
 
   // Check for mode-specific prefixes
   if (text.startsWith("- [")) {
@@ -75,11 +77,17 @@ QString Note::smartTitle() const {
   }
 
   // Check for currency patterns
-  static QRegularExpression currencyPattern(
-      R"(\d+\s*(USD|EUR|TRY|GBP|JPY|CAD|AUD|CHF|CNY|ALL|BTC|ETH|USDT|USDC|XRP|BNB|SOL|ADA|DOGE|TRX))",
-      QRegularExpression::CaseInsensitiveOption);
-  if (currencyPattern.match(text).hasMatch()) {
-    return QString("💰 Currency");
+  static const AhoCorasick currencyCodes(
+      {"USD", "EUR", "TRY", "GBP", "JPY", "CAD", "AUD", "CHF", "CNY", "ALL",
+       "BTC", "ETH", "USDT", "USDC", "XRP", "BNB", "SOL", "ADA", "DOGE", "TRX"},
+      AhoCorasick::CaseInsensitive);
+  for (const AhoCorasick::Match &match : currencyCodes.findAll(text)) {
+    // An amount right before the code, as in "100 USD"
+    int before = match.start - 1;
+    while (before >= 0 && text[before].isSpace())
+      --before;
+    if (before >= 0 && text[before].isDigit())
+      return QString("💰 Currency");
   }
 
   // Extract first meaningful line (up to 20 chars)
@@ -121,16 +129,36 @@ void Note::setMode(NoteMode mode) {
   }
 }
 
-QString Note::content() const { return m_content; }
+QString Note::content() const { return m_content.toString(); }
+
+QString Note::leadingContent(int maxChars) const {
+  return m_content.mid(0, maxChars);
+}
 
 void Note::setContent(const QString &content) {
-  if (m_content != content) {
-    m_content = content;
+  if (!m_content.equals(content)) {
+    m_content = PieceTable(content);
+    ++m_revision;
     m_modified = QDateTime::currentDateTime();
     m_dirty = true;
   }
 }
 
+bool Note::applyEdit(int position, int removed, QStringView added) {
+  if (position < 0 || removed < 0 || position > m_content.size() - removed)
+    return false;
+
+  // Format-only changes report the same text back
+  if (removed == added.size() && m_content.mid(position, removed) == added)
+    return true;
+
+  m_content.replace(position, removed, added);
+  ++m_revision;
+  m_modified = QDateTime::currentDateTime();
+  m_dirty = true;
+  return true;
+}
+
 QDateTime Note::created() const { return m_created; }
 
 QDateTime Note::modified() const { return m_modified; }
@@ -182,7 +210,7 @@ QJsonObject Note::toJson() const {
   QJsonObject json;
   json["id"] = m_id;
   json["title"] = m_title;
-  json["content"] = m_content;
+  json["content"] = content();
   json["mode"] = noteModeToString(m_mode);
   json["created"] = m_created.toString(Qt::ISODate);
   json["modified"] = m_modified.toString(Qt::ISODate);
@@ -197,7 +225,7 @@ Note Note::fromJson(const QJsonObject &json) {
   Note note;
   note.m_id = json["id"].toString();
   note.m_title = json["title"].toString();
-  note.m_content = json["content"].toString();
+  note.m_content = PieceTable(json["content"].toString());
   note.m_mode = stringToNoteMode(json["mode"].toString());
   note.m_created =
       QDateTime::fromString(json["created"].toString(), Qt::ISODate);
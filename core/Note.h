@@ -2,9 +2,11 @@
 #define LINNOTE_NOTE_H
 
 #include "NoteMode.h"
+#include "PieceTable.h"
 #include <QDateTime>
 #include <QJsonObject>
 #include <QString>
+#include <QStringView>
 #include <QUuid>
 
 /**
@@ -13,7 +15,7 @@
  * Holds the content of a single note with:
  * - Unique ID (UUID)
  * - Title (smart auto-generated if empty)
- * - Content
+ * - Content, as a PieceTable so edits don't copy the whole text
  * - Timestamps
  * - JSON serialization
  */
@@ -30,6 +32,7 @@ public:
 
   // Smart title (auto-generated from content if title is empty)
   QString smartTitle() const;
+  static constexpr int TitleChars = 4096; // How much content titles read
 
   // Mode
   NoteMode mode() const;
@@ -37,8 +40,20 @@ public:
 
   // Content access
   QString content() const;
+  QString leadingContent(int maxChars) const;
   void setContent(const QString &content);
 
+  // O(1) copy that later edits don't affect, for save, search or export
+  PieceTable contentSnapshot() const { return m_content; }
+
+  // Changes with every content change, so caches can tell they're current
+  quint64 revision() const { return m_revision; }
+
+  // Replaces @p removed characters at @p position with @p added, as
+  // reported by QTextDocument::contentsChange. Returns false, leaving the
+  // content alone, if the range is outside the content.
+  bool applyEdit(int position, int removed, QStringView added);
+
   // Timestamps
   QDateTime created() const;
   QDateTime modified() const;
@@ -71,7 +86,8 @@ public:
 private:
   QString m_id;
   QString m_title;
-  QString m_content;
+  PieceTable m_content;
+  quint64 m_revision = 0;
   NoteMode m_mode;
   QDateTime m_created;
   QDateTime m_modified;
@@ -54,6 +54,16 @@ void NoteManager::setNoteContentAt(int index, const QString &content) {
   }
 }
 
+bool NoteManager::applyNoteEditAt(int index, int position, int removed,
+                                  QStringView added) {
+  if (index < 0 || index >= m_notes.size() || m_notes[index].isLocked())
+    return false;
+  if (!m_notes[index].applyEdit(position, removed, added))
+    return false;
+  emit noteContentChanged(m_notes[index].id());
+  return true;
+}
+
 Note NoteManager::currentNote() const { return noteAt(m_currentIndex); }
 
 int NoteManager::currentIndex() const { return m_currentIndex; }
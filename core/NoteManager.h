@@ -32,6 +32,10 @@ public:
   int indexOfNote(const QString &id) const;
   QString noteContentAt(int index) const;
   void setNoteContentAt(int index, const QString &content);
+  // Applies one editor change in place; false if the note is locked or the
+  // change doesn't fit its content, so the caller should resend it whole
+  bool applyNoteEditAt(int index, int position, int removed,
+                       QStringView added);
 
   // Current note
   Note currentNote() const;
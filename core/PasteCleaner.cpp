@@ -0,0 +1,193 @@
+#include "PasteCleaner.h"
+#include <limits>
+
+namespace {
+
+bool isWordChar(QChar c) { return c.isLetterOrNumber() || c == '_'; }
+
+qsizetype skipSpaces(QStringView line, qsizetype i) {
+  while (i < line.size() && line[i].isSpace())
+    ++i;
+  return i;
+}
+
+// Length of a "1. " or "12) " prefix, 0 if there is none
+qsizetype numberPrefix(QStringView line) {
+  qsizetype i = skipSpaces(line, 0);
+  qsizetype digits = i;
+  while (i < line.size() && line[i] >= '0' && line[i] <= '9')
+    ++i;
+  if (i == digits || i >= line.size() || (line[i] != '.' && line[i] != ')'))
+    return 0;
+  return skipSpaces(line, i + 1);
+}
+
+// Length of a "- " or "• " prefix, 0 if there is none
+qsizetype bulletPrefix(QStringView line) {
+  static const QString bullets = QStringLiteral("-*•◦▪▸►→");
+  qsizetype i = skipSpaces(line, 0);
+  if (i >= line.size() || !bullets.contains(line[i]))
+    return 0;
+  return skipSpaces(line, i + 1);
+}
+
+// Length of a "## " prefix, 0 if there is none
+qsizetype headingPrefix(QStringView line) {
+  qsizetype i = 0;
+  while (i < line.size() && i < 6 && line[i] == '#')
+    ++i;
+  return i == 0 ? 0 : skipSpaces(line, i);
+}
+
+bool isRun(QStringView text, qsizetype i, QChar marker, int count) {
+  if (i + count > text.size())
+    return false;
+  for (int k = 0; k < count; ++k) {
+    if (text[i + k] != marker)
+      return false;
+  }
+  return true;
+}
+
+// "**x**" -> "x" (count 2) or "`x`" -> "x" (count 1), x without the marker
+QString unwrap(const QString &text, QChar marker, int count) {
+  qsizetype i = text.indexOf(marker);
+  if (i < 0)
+    return text;
+
+  QString out;
+  out.reserve(text.size());
+  out.append(QStringView(text).left(i));
+  qsizetype close = -1; // Next marker after an opening run
+  while (i < text.size()) {
+    if (isRun(text, i, marker, count)) {
+      if (close < i + count) {
+        close = text.indexOf(marker, i + count);
+        if (close < 0)
+          close = text.size();
+      }
+      if (close > i + count && isRun(text, close, marker, count)) {
+        out.append(QStringView(text).mid(i + count, close - i - count));
+        i = close + count;
+        continue;
+      }
+    }
+    out.append(text[i++]);
+  }
+  return out;
+}
+
+// "_x_" -> "x" where the underscores aren't inside a word
+QString unwrapUnderscores(const QString &text) {
+  qsizetype i = text.indexOf('_');
+  if (i < 0)
+    return text;
+
+  QString out;
+  out.reserve(text.size());
+  out.append(QStringView(text).left(i));
+  while (i < text.size()) {
+    if (text[i] == '_' && (i == 0 || !isWordChar(text[i - 1]))) {
+      qsizetype close = text.indexOf('_', i + 1);
+      if (close > i + 1 &&
+          (close + 1 == text.size() || !isWordChar(text[close + 1]))) {
+        out.append(QStringView(text).mid(i + 1, close - i - 1));
+        i = close + 1;
+        continue;
+      }
+    }
+    out.append(text[i++]);
+  }
+  return out;
+}
+
+// "[x](url)" -> "x"
+QString unwrapLinks(const QString &text) {
+  qsizetype i = text.indexOf('[');
+  if (i < 0)
+    return text;
+
+  QString out;
+  out.reserve(text.size());
+  out.append(QStringView(text).left(i));
+  qsizetype bracket = -1; // Next ']' and ')' searched for, kept while ahead
+  qsizetype paren = -1;
+  while (i < text.size()) {
+    if (text[i] == '[') {
+      if (bracket <= i) {
+        bracket = text.indexOf(']', i + 1);
+        if (bracket < 0)
+          bracket = text.size();
+      }
+      qsizetype open = bracket + 1;
+      if (bracket > i + 1 && open < text.size() && text[open] == '(') {
+        if (paren <= open) {
+          paren = text.indexOf(')', open + 1);
+          if (paren < 0)
+            paren = text.size();
+        }
+        if (paren > open + 1 && paren < text.size()) {
+          out.append(QStringView(text).mid(i + 1, bracket - i - 1));
+          i = paren + 1;
+          continue;
+        }
+      }
+    }
+    out.append(text[i++]);
+  }
+  return out;
+}
+
+} // namespace
+
+PasteCleaner::PasteCleaner(const Options &options) : m_options(options) {}
+
+QString PasteCleaner::clean(QStringView text) {
+  m_position = 0;
+  m_wroteLine = false;
+  return next(text, std::numeric_limits<qsizetype>::max());
+}
+
+QString PasteCleaner::next(QStringView text, qsizetype minChars) {
+  QString out;
+  while (m_position <= text.size() && out.size() < minChars) {
+    qsizetype end = text.indexOf(QLatin1Char('\n'), m_position);
+    if (end < 0)
+      end = text.size();
+
+    // Lines are joined with '\n' as they were, minus the dropped ones
+    qsizetype mark = out.size();
+    if (m_wroteLine)
+      out.append(QLatin1Char('\n'));
+    if (cleanLine(text.mid(m_position, end - m_position), out))
+      m_wroteLine = true;
+    else
+      out.truncate(mark);
+    m_position = end + 1;
+  }
+  return out;
+}
+
+bool PasteCleaner::cleanLine(QStringView line, QString &out) const {
+  if (m_options.removeEmptyLines && line.trimmed().isEmpty())
+    return false;
+  if (m_options.trimLines)
+    line = line.trimmed();
+  if (m_options.removeNumbers)
+    line = line.mid(numberPrefix(line));
+  if (m_options.removeBullets)
+    line = line.mid(bulletPrefix(line));
+  if (!m_options.removeMarkdown) {
+    out.append(line);
+    return true;
+  }
+
+  // One pass per construct, bold first as it may hold the others
+  QString text = line.toString();
+  text = unwrap(text, '*', 2);
+  text = unwrapUnderscores(text);
+  text = unwrap(text, '`', 1);
+  text = unwrapLinks(text);
+  out.append(QStringView(text).mid(headingPrefix(text)));
+  return true;
+}
@@ -0,0 +1,55 @@
+#ifndef LINNOTE_PASTECLEANER_H
+#define LINNOTE_PASTECLEANER_H
+
+#include <QString>
+#include <QStringView>
+
+/**
+ * @brief Paste cleanup (Settings > Paste) in one walk over the text
+ *
+ * Cleans line by line without splitting the text up front or running
+ * regular expressions: list numbers and bullets are prefix checks, and
+ * each Markdown construct is one scan over the line. A cleaner can go
+ * through a large paste a piece at a time with next(), e.g. on a worker
+ * thread; clean() does all of it at once.
+ */
+class PasteCleaner {
+public:
+  struct Options {
+    bool trimLines = false;        // Leading and trailing spaces and tabs
+    bool removeNumbers = false;    // "1. " and "2) "
+    bool removeBullets = false;    // "- ", "* ", "• " and the like
+    bool removeMarkdown = false;   // **bold**, _italic_, `code`, [links](),
+                                   // # headings
+    bool removeEmptyLines = false; // Blank once trimmed
+
+    bool any() const {
+      return trimLines || removeNumbers || removeBullets || removeMarkdown ||
+             removeEmptyLines;
+    }
+  };
+
+  explicit PasteCleaner(const Options &options = Options());
+
+  QString clean(QStringView text);
+
+  /**
+   * @brief The next cleaned lines of @p text
+   *
+   * Whole lines from position() on, until at least @p minChars were
+   * produced or the text ends. Pass the same text every time.
+   */
+  QString next(QStringView text, qsizetype minChars);
+
+  qsizetype position() const { return m_position; } // Into the text
+  bool atEnd(QStringView text) const { return m_position > text.size(); }
+
+private:
+  bool cleanLine(QStringView line, QString &out) const;
+
+  Options m_options;
+  qsizetype m_position = 0;
+  bool m_wroteLine = false; // Later lines get a '\n' first
+};
+
+#endif // LINNOTE_PASTECLEANER_H
@@ -0,0 +1,264 @@
+#include "PieceTable.h"
+#include <utility>
+
+struct PieceTable::Node {
+  NodePtr left; // Both null for a piece
+  NodePtr right;
+  QString buffer; // A piece's text is buffer.mid(offset, size)
+  qsizetype offset = 0;
+  qsizetype size = 0;
+  int height = 0; // 0 for a piece
+
+  bool isPiece() const { return !left; }
+  QStringView text() const { return QStringView(buffer).mid(offset, size); }
+};
+
+namespace {
+
+using Node = PieceTable::Node;
+using NodePtr = PieceTable::NodePtr;
+
+NodePtr piece(const QString &buffer, qsizetype offset, qsizetype size) {
+  auto node = QSharedPointer<Node>::create();
+  node->buffer = buffer;
+  node->offset = offset;
+  node->size = size;
+  return node;
+}
+
+NodePtr concat(const NodePtr &left, const NodePtr &right) {
+  auto node = QSharedPointer<Node>::create();
+  node->left = left;
+  node->right = right;
+  node->size = left->size + right->size;
+  node->height = qMax(left->height, right->height) + 1;
+  return node;
+}
+
+// concat() for subtrees whose heights differ by at most two, rotating the
+// taller side as an AVL tree would
+NodePtr balance(const NodePtr &left, const NodePtr &right) {
+  if (left->height > right->height + 1) {
+    if (left->left->height >= left->right->height)
+      return concat(left->left, concat(left->right, right));
+    const NodePtr &inner = left->right;
+    return concat(concat(left->left, inner->left),
+                  concat(inner->right, right));
+  }
+  if (right->height > left->height + 1) {
+    if (right->right->height >= right->left->height)
+      return concat(concat(left, right->left), right->right);
+    const NodePtr &inner = right->left;
+    return concat(concat(left, inner->left),
+                  concat(inner->right, right->right));
+  }
+  return concat(left, right);
+}
+
+// Both texts in order; O(height difference)
+NodePtr join(const NodePtr &left, const NodePtr &right) {
+  if (!left)
+    return right;
+  if (!right)
+    return left;
+  if (left->height > right->height + 1)
+    return balance(left->left, join(left->right, right));
+  if (right->height > left->height + 1)
+    return balance(join(left, right->left), right->right);
+  return concat(left, right);
+}
+
+// The first @p position characters and the rest; O(log n)
+std::pair<NodePtr, NodePtr> split(const NodePtr &node, qsizetype position) {
+  if (!node || position <= 0)
+    return {NodePtr(), node};
+  if (position >= node->size)
+    return {node, NodePtr()};
+  if (node->isPiece()) {
+    return {piece(node->buffer, node->offset, position),
+            piece(node->buffer, node->offset + position,
+                  node->size - position)};
+  }
+
+  qsizetype leftSize = node->left->size;
+  if (position < leftSize) {
+    auto [first, rest] = split(node->left, position);
+    return {first, join(rest, node->right)};
+  }
+  auto [first, rest] = split(node->right, position - leftSize);
+  return {join(node->left, first), rest};
+}
+
+// A balanced tree of pieces of @p buffer, none longer than MaxPiece
+NodePtr build(const QString &buffer, qsizetype offset, qsizetype size) {
+  if (size <= 0)
+    return NodePtr();
+  if (size <= PieceTable::MaxPiece)
+    return piece(buffer, offset, size);
+  qsizetype half = size / 2;
+  return concat(build(buffer, offset, half),
+                build(buffer, offset + half, size - half));
+}
+
+const Node *firstPiece(const Node *node) {
+  while (!node->isPiece())
+    node = node->left.data();
+  return node;
+}
+
+const Node *lastPiece(const Node *node) {
+  while (!node->isPiece())
+    node = node->right.data();
+  return node;
+}
+
+// join(), merging the pieces either side of the seam while they are short,
+// so typing doesn't leave a piece per keystroke
+NodePtr joinMerged(const NodePtr &left, const NodePtr &right) {
+  if (!left || !right)
+    return join(left, right);
+  const Node *last = lastPiece(left.data());
+  const Node *first = firstPiece(right.data());
+  if (last->size + first->size > PieceTable::MaxPiece)
+    return join(left, right);
+
+  QString buffer;
+  buffer.reserve(last->size + first->size);
+  buffer.append(last->text());
+  buffer.append(first->text());
+  NodePtr merged = piece(buffer, 0, buffer.size());
+  return join(join(split(left, left->size - last->size).first, merged),
+              split(right, first->size).second);
+}
+
+// Calls @p visit with each piece's text in order until it returns false
+template <typename Visit> bool visitPieces(const Node *node, Visit &visit) {
+  if (!node)
+    return true;
+  if (node->isPiece())
+    return visit(node->text());
+  return visitPieces(node->left.data(), visit) &&
+         visitPieces(node->right.data(), visit);
+}
+
+void appendRange(const Node *node, qsizetype position, qsizetype count,
+                 QString &out) {
+  if (count <= 0)
+    return;
+  if (node->isPiece()) {
+    out.append(node->text().mid(position, count));
+    return;
+  }
+
+  qsizetype leftSize = node->left->size;
+  if (position < leftSize) {
+    qsizetype inLeft = qMin(count, leftSize - position);
+    appendRange(node->left.data(), position, inLeft, out);
+    appendRange(node->right.data(), 0, count - inLeft, out);
+  } else {
+    appendRange(node->right.data(), position - leftSize, count, out);
+  }
+}
+
+} // namespace
+
+PieceTable::PieceTable(const QString &text)
+    : m_root(build(text, 0, text.size())) {}
+
+qsizetype PieceTable::size() const { return m_root ? m_root->size : 0; }
+
+void PieceTable::insert(qsizetype position, QStringView text) {
+  if (text.isEmpty())
+    return;
+  position = qBound(qsizetype(0), position, size());
+  QString buffer = text.toString();
+  auto [left, right] = split(m_root, position);
+  m_root = joinMerged(joinMerged(left, build(buffer, 0, buffer.size())),
+                      right);
+}
+
+void PieceTable::remove(qsizetype position, qsizetype count) {
+  position = qBound(qsizetype(0), position, size());
+  count = qBound(qsizetype(0), count, size() - position);
+  if (count == 0)
+    return;
+  auto [left, rest] = split(m_root, position);
+  m_root = joinMerged(left, split(rest, count).second);
+}
+
+void PieceTable::replace(qsizetype position, qsizetype count,
+                         QStringView text) {
+  position = qBound(qsizetype(0), position, size());
+  remove(position, count);
+  insert(position, text);
+}
+
+QChar PieceTable::at(qsizetype position) const {
+  const Node *node = m_root.data();
+  if (!node || position < 0 || position >= node->size)
+    return QChar();
+  while (!node->isPiece()) {
+    if (position < node->left->size) {
+      node = node->left.data();
+    } else {
+      position -= node->left->size;
+      node = node->right.data();
+    }
+  }
+  return node->text()[position];
+}
+
+QString PieceTable::mid(qsizetype position, qsizetype count) const {
+  position = qBound(qsizetype(0), position, size());
+  if (count < 0 || count > size() - position)
+    count = size() - position;
+
+  QString out;
+  if (count > 0) {
+    out.reserve(count);
+    appendRange(m_root.data(), position, count, out);
+  }
+  return out;
+}
+
+QString PieceTable::toString() const {
+  if (!m_root)
+    return QString();
+
+  // Text that wasn't edited is still its buffer, piece after piece; share it
+  const QString &buffer = firstPiece(m_root.data())->buffer;
+  if (buffer.size() == size()) {
+    const QChar *next = buffer.constData();
+    auto contiguous = [&next](QStringView chunk) {
+      if (chunk.data() != next)
+        return false;
+      next += chunk.size();
+      return true;
+    };
+    if (visitPieces(m_root.data(), contiguous))
+      return buffer;
+  }
+  return mid(0);
+}
+
+QVector<QStringView> PieceTable::chunks() const {
+  QVector<QStringView> chunks;
+  auto collect = [&chunks](QStringView text) {
+    chunks.append(text);
+    return true;
+  };
+  visitPieces(m_root.data(), collect);
+  return chunks;
+}
+
+bool PieceTable::equals(QStringView text) const {
+  if (text.size() != size())
+    return false;
+  qsizetype offset = 0;
+  auto compare = [&text, &offset](QStringView chunk) {
+    bool same = text.mid(offset, chunk.size()) == chunk;
+    offset += chunk.size();
+    return same;
+  };
+  return visitPieces(m_root.data(), compare);
+}
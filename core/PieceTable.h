@@ -0,0 +1,56 @@
+#ifndef LINNOTE_PIECETABLE_H
+#define LINNOTE_PIECETABLE_H
+
+#include <QSharedPointer>
+#include <QString>
+#include <QStringView>
+#include <QVector>
+
+/**
+ * @brief Text stored as pieces in a balanced tree
+ *
+ * Each piece is a range of an immutable QString: text loaded from storage
+ * stays in its one buffer, split into pieces, and typed text goes into
+ * small buffers of its own. The pieces are the leaves of a height-balanced
+ * tree, so insert and remove are O(log n) plus at most MaxPiece characters
+ * copied, whatever the size of the text.
+ *
+ * Nodes are never modified, only replaced along the edited path, so a copy
+ * is an O(1) snapshot that stays valid while the original is edited and
+ * can be read from another thread.
+ */
+class PieceTable {
+public:
+  // Typed text is merged into neighbouring pieces up to this length
+  static constexpr qsizetype MaxPiece = 1024;
+
+  PieceTable() = default;
+  explicit PieceTable(const QString &text);
+
+  qsizetype size() const;
+  bool isEmpty() const { return size() == 0; }
+
+  // Positions are clamped to the text
+  void insert(qsizetype position, QStringView text);
+  void remove(qsizetype position, qsizetype count);
+  void replace(qsizetype position, qsizetype count, QStringView text);
+
+  QChar at(qsizetype position) const;
+  QString mid(qsizetype position, qsizetype count = -1) const;
+  QString toString() const;
+
+  // The text in order, as views into the pieces; valid while this table
+  // or a copy of it is alive
+  QVector<QStringView> chunks() const;
+
+  bool equals(QStringView text) const;
+
+  // Tree node, defined in PieceTable.cpp
+  struct Node;
+  using NodePtr = QSharedPointer<const Node>;
+
+private:
+  NodePtr m_root; // Null when empty
+};
+
+#endif // LINNOTE_PIECETABLE_H
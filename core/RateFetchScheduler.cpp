@@ -0,0 +1,225 @@
+#include "RateFetchScheduler.h"
+#include <QDebug>
+#include <QNetworkAccessManager>
+#include <QNetworkReply>
+#include <QRandomGenerator>
+#include <limits>
+
+RateFetchScheduler::RateFetchScheduler(QNetworkAccessManager *manager,
+                                       QObject *parent)
+    : QObject(parent), m_manager(manager), m_intervalMinutes(360),
+      m_backoffBaseMs(30000), m_requestsSent(0) {
+  m_timer.setSingleShot(true);
+  connect(&m_timer, &QTimer::timeout, this, &RateFetchScheduler::onTimeout);
+}
+
+void RateFetchScheduler::setEndpoint(const QString &name,
+                                     const QNetworkRequest &request,
+                                     bool periodic) {
+  Endpoint &endpoint = m_endpoints[name];
+  if (endpoint.request.url() != request.url()) {
+    // Different provider or query: old validators don't apply
+    endpoint.etag.clear();
+    endpoint.lastModified.clear();
+    endpoint.lastSuccess = QDateTime();
+    endpoint.retryAt = QDateTime();
+    endpoint.failures = 0;
+  }
+  endpoint.request = request;
+  endpoint.periodic = periodic;
+  schedule();
+}
+
+void RateFetchScheduler::removeEndpoint(const QString &name) {
+  auto it = m_endpoints.find(name);
+  if (it == m_endpoints.end())
+    return;
+  if (it->reply) {
+    it->reply->disconnect(this);
+    it->reply->abort();
+    it->reply->deleteLater();
+  }
+  m_endpoints.erase(it);
+  schedule();
+}
+
+bool RateFetchScheduler::hasEndpoint(const QString &name) const {
+  return m_endpoints.contains(name);
+}
+
+void RateFetchScheduler::setIntervalMinutes(int minutes) {
+  m_intervalMinutes = qMax(1, minutes);
+  schedule();
+}
+
+int RateFetchScheduler::intervalMinutes() const { return m_intervalMinutes; }
+
+void RateFetchScheduler::setBackoffBase(int msecs) {
+  m_backoffBaseMs = qMax(1, msecs);
+}
+
+void RateFetchScheduler::refresh(bool force) {
+  for (auto it = m_endpoints.begin(); it != m_endpoints.end(); ++it) {
+    if (it->periodic)
+      fetch(it.key(), force);
+  }
+  schedule();
+}
+
+void RateFetchScheduler::fetch(const QString &name, bool force) {
+  auto it = m_endpoints.find(name);
+  if (it == m_endpoints.end() || it->reply)
+    return; // Unknown, or already in flight
+
+  QDateTime due = dueAt(*it);
+  if (!force && due.isValid() && due > QDateTime::currentDateTimeUtc())
+    return;
+
+  start(name, *it);
+}
+
+QDateTime RateFetchScheduler::nextFetch(const QString &name) const {
+  auto it = m_endpoints.constFind(name);
+  return it == m_endpoints.constEnd() ? QDateTime() : dueAt(*it);
+}
+
+int RateFetchScheduler::failureCount(const QString &name) const {
+  return m_endpoints.value(name).failures;
+}
+
+int RateFetchScheduler::requestsSent() const { return m_requestsSent; }
+
+QJsonObject RateFetchScheduler::saveState() const {
+  QJsonObject state;
+  for (auto it = m_endpoints.constBegin(); it != m_endpoints.constEnd(); ++it) {
+    QJsonObject entry;
+    entry["url"] = it->request.url().toString();
+    entry["etag"] = QString::fromLatin1(it->etag);
+    entry["lastModified"] = QString::fromLatin1(it->lastModified);
+    entry["fetchedAt"] = it->lastSuccess.toString(Qt::ISODate);
+    state[it.key()] = entry;
+  }
+  return state;
+}
+
+void RateFetchScheduler::restoreState(const QJsonObject &state) {
+  for (auto it = state.constBegin(); it != state.constEnd(); ++it) {
+    QJsonObject entry = it.value().toObject();
+
+    // Only for endpoints registered with the same URL as last time
+    auto endpoint = m_endpoints.find(it.key());
+    if (endpoint == m_endpoints.end() || endpoint->reply ||
+        endpoint->request.url().toString() != entry["url"].toString())
+      continue;
+
+    endpoint->etag = entry["etag"].toString().toLatin1();
+    endpoint->lastModified = entry["lastModified"].toString().toLatin1();
+    endpoint->lastSuccess =
+        QDateTime::fromString(entry["fetchedAt"].toString(), Qt::ISODate);
+  }
+  schedule();
+}
+
+void RateFetchScheduler::onTimeout() { refresh(false); }
+
+void RateFetchScheduler::start(const QString &name, Endpoint &endpoint) {
+  QNetworkRequest request = endpoint.request;
+  request.setAttribute(QNetworkRequest::CacheLoadControlAttribute,
+                       QNetworkRequest::AlwaysNetwork);
+  request.setTransferTimeout(15000);
+  if (!endpoint.etag.isEmpty())
+    request.setRawHeader("If-None-Match", endpoint.etag);
+  if (!endpoint.lastModified.isEmpty())
+    request.setRawHeader("If-Modified-Since", endpoint.lastModified);
+
+  m_requestsSent++;
+  QNetworkReply *reply = m_manager->get(request);
+  endpoint.reply = reply;
+  connect(reply, &QNetworkReply::finished, this,
+          [this, name, reply]() { onFinished(name, reply); });
+}
+
+void RateFetchScheduler::onFinished(const QString &name,
+                                    QNetworkReply *reply) {
+  reply->deleteLater();
+
+  auto it = m_endpoints.find(name);
+  if (it == m_endpoints.end() || it->reply != reply)
+    return;
+  Endpoint &endpoint = *it;
+  endpoint.reply = nullptr;
+
+  int status =
+      reply->attribute(QNetworkRequest::HttpStatusCodeAttribute).toInt();
+
+  if (reply->error() == QNetworkReply::NoError &&
+      (status == 200 || status == 304)) {
+    endpoint.failures = 0;
+    endpoint.retryAt = QDateTime();
+    endpoint.lastSuccess = QDateTime::currentDateTimeUtc();
+
+    if (status == 304) {
+      schedule();
+      emit notModified(name);
+      return;
+    }
+
+    QByteArray etag = reply->rawHeader("ETag");
+    QByteArray lastModified = reply->rawHeader("Last-Modified");
+    endpoint.etag = etag;
+    endpoint.lastModified = lastModified;
+    QByteArray body = reply->readAll();
+    schedule();
+    emit fetched(name, body);
+    return;
+  }
+
+  endpoint.failures++;
+  qint64 delay = backoffDelay(endpoint.failures);
+  endpoint.retryAt = QDateTime::currentDateTimeUtc().addMSecs(delay);
+  qDebug() << "RateFetchScheduler:" << name << "failed" << endpoint.failures
+           << "time(s), retry in" << delay / 1000 << "s";
+
+  QString message = reply->error() != QNetworkReply::NoError
+                        ? reply->errorString()
+                        : QString("HTTP %1").arg(status);
+  schedule();
+  emit failed(name, message);
+}
+
+QDateTime RateFetchScheduler::dueAt(const Endpoint &endpoint) const {
+  if (endpoint.failures > 0 && endpoint.retryAt.isValid())
+    return endpoint.retryAt;
+  if (!endpoint.lastSuccess.isValid())
+    return QDateTime();
+  return endpoint.lastSuccess.addSecs(qint64(m_intervalMinutes) * 60);
+}
+
+qint64 RateFetchScheduler::backoffDelay(int failures) const {
+  qint64 delay = qint64(m_backoffBaseMs) << qMin(failures - 1, 20);
+  delay = qMin(delay, qint64(m_intervalMinutes) * 60 * 1000);
+
+  // Equal jitter: half fixed, half random, so clients don't retry in step
+  qint64 half = delay / 2;
+  return half + QRandomGenerator::global()->bounded(half + 1);
+}
+
+void RateFetchScheduler::schedule() {
+  QDateTime now = QDateTime::currentDateTimeUtc();
+  qint64 wait = -1;
+
+  for (auto it = m_endpoints.constBegin(); it != m_endpoints.constEnd(); ++it) {
+    if (!it->periodic || it->reply)
+      continue;
+    QDateTime due = dueAt(*it);
+    qint64 ms = due.isValid() ? qMax<qint64>(0, now.msecsTo(due)) : 0;
+    if (wait < 0 || ms < wait)
+      wait = ms;
+  }
+
+  if (wait < 0) {
+    m_timer.stop();
+    return;
+  }
+  m_timer.start(int(qMin<qint64>(wait, std::numeric_limits<int>::max())));
+}
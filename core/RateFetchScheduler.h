@@ -0,0 +1,115 @@
+#ifndef LINNOTE_RATEFETCHSCHEDULER_H
+#define LINNOTE_RATEFETCHSCHEDULER_H
+
+#include <QDateTime>
+#include <QJsonObject>
+#include <QMap>
+#include <QNetworkRequest>
+#include <QObject>
+#include <QTimer>
+
+class QNetworkAccessManager;
+class QNetworkReply;
+
+/**
+ * @brief Decides when exchange rate endpoints are fetched
+ *
+ * Each endpoint is one batched request to one provider. The scheduler
+ * fetches it once per refresh interval and sends conditional requests
+ * (If-None-Match / If-Modified-Since), so unchanged rates cost a 304.
+ * Failures are retried with jittered exponential backoff, capped at the
+ * interval. At most one request per endpoint is in flight.
+ */
+class RateFetchScheduler : public QObject {
+  Q_OBJECT
+
+public:
+  explicit RateFetchScheduler(QNetworkAccessManager *manager,
+                              QObject *parent = nullptr);
+
+  /**
+   * @brief Register or update an endpoint
+   * @param periodic Fetch automatically each interval; otherwise only
+   *                 when fetch() is called (used for fallbacks)
+   *
+   * Changing the URL forgets validators, so the next fetch is due at once.
+   */
+  void setEndpoint(const QString &name, const QNetworkRequest &request,
+                   bool periodic = true);
+  void removeEndpoint(const QString &name);
+  bool hasEndpoint(const QString &name) const;
+
+  void setIntervalMinutes(int minutes);
+  int intervalMinutes() const;
+
+  /**
+   * @brief First retry delay after a failure; doubles with each failure
+   */
+  void setBackoffBase(int msecs);
+
+  /**
+   * @brief Fetch every periodic endpoint that is due
+   * @param force Ignore the interval and backoff (manual refresh)
+   */
+  void refresh(bool force = false);
+
+  /**
+   * @brief Fetch one endpoint if it is due (or always, with @p force)
+   */
+  void fetch(const QString &name, bool force = false);
+
+  /**
+   * @brief When the endpoint is next due; invalid means now
+   */
+  QDateTime nextFetch(const QString &name) const;
+  int failureCount(const QString &name) const;
+
+  /**
+   * @brief HTTP requests sent since construction
+   */
+  int requestsSent() const;
+
+  /**
+   * @brief Validators and fetch times, stored next to the cached rates
+   *
+   * Restore after registering endpoints; entries whose URL changed are
+   * ignored.
+   */
+  QJsonObject saveState() const;
+  void restoreState(const QJsonObject &state);
+
+signals:
+  void fetched(const QString &name, const QByteArray &body);
+  void notModified(const QString &name);
+  void failed(const QString &name, const QString &message);
+
+private slots:
+  void onTimeout();
+
+private:
+  struct Endpoint {
+    QNetworkRequest request;
+    bool periodic = true;
+    QByteArray etag;
+    QByteArray lastModified;
+    QDateTime lastSuccess; // Last 200 or 304
+    QDateTime retryAt;     // Set while backing off
+    int failures = 0;
+    QNetworkReply *reply = nullptr;
+  };
+
+  void start(const QString &name, Endpoint &endpoint);
+  void onFinished(const QString &name, QNetworkReply *reply);
+  QDateTime dueAt(const Endpoint &endpoint) const;
+  qint64 backoffDelay(int failures) const;
+  void schedule();
+
+  QNetworkAccessManager *m_manager;
+  QMap<QString, Endpoint> m_endpoints;
+  QTimer m_timer;
+  int m_intervalMinutes;
+  int m_backoffBaseMs;
+  int m_requestsSent;
+};
+
+#endif // LINNOTE_RATEFETCHSCHEDULER_H
@@ -0,0 +1,677 @@
+#include "RateHistory.h"
+#include <QDebug>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QMutexLocker>
+#include <QReadLocker>
+#include <QSaveFile>
+#include <QWriteLocker>
+#include <QtEndian>
+#include <cmath>
+#include <cstring>
+
+namespace {
+
+// File layout (little endian):
+//   header     "LNRH", version, block size, currency count, day count, 0
+//   codes      currency count x 8 bytes, NUL padded
+//   digits     currency count x 1 byte, decimal places of the fixed point
+//              (not in version 1, which uses MaxDigits throughout)
+//   days       day count x qint32 Julian day, ascending
+//   index      currency count x block count x quint32 offset into blocks
+//   blocks     per currency, per block: qint64 anchor, then zig-zag varint
+//              deltas for the remaining days of the block
+const char Magic[4] = {'L', 'N', 'R', 'H'};
+constexpr quint32 Version = 2;
+constexpr int BlockSize = 32;
+constexpr int HeaderSize = 24;
+constexpr int CodeSize = 8;
+
+// Fixed point: rate * 10^digits, per currency. Digits are MaxDigits (so
+// crypto rates keep 7-8 significant digits) unless the currency's largest
+// rate needs fewer to stay below MaxFixed. 0 means "no rate that day".
+constexpr int MaxDigits = 12;
+constexpr double MaxFixed = 9.2e18; // Below the qint64 limit
+
+double power10(int digits) { return std::pow(10.0, digits); }
+
+qint64 toFixed(double rate, int digits) {
+  double scaled = rate * power10(digits);
+  if (!(scaled >= 0.5) || !(scaled < MaxFixed))
+    return 0;
+  return qint64(std::llround(scaled));
+}
+
+double fromFixed(qint64 fixed, int digits) {
+  return double(fixed) / power10(digits);
+}
+
+// Most decimal places @p maxRate fits with; -1 if not even whole units
+int digitsFor(double maxRate) {
+  int digits = MaxDigits;
+  while (digits >= 0 && !(maxRate * power10(digits) < MaxFixed))
+    --digits;
+  return digits;
+}
+
+// Whether @p rate can be stored at all, in a currency of its own
+bool isStorable(double rate) {
+  return digitsFor(rate) >= 0 && rate * power10(MaxDigits) >= 0.5;
+}
+
+quint64 zigzag(qint64 value) {
+  return (quint64(value) << 1) ^ quint64(value >> 63);
+}
+
+qint64 unzigzag(quint64 value) {
+  return qint64(value >> 1) ^ -qint64(value & 1);
+}
+
+void appendVarint(QByteArray &out, quint64 value) {
+  while (value >= 0x80) {
+    out.append(char(value | 0x80));
+    value >>= 7;
+  }
+  out.append(char(value));
+}
+
+bool readVarint(const uchar *&p, const uchar *end, quint64 &value) {
+  value = 0;
+  for (int shift = 0; shift < 64 && p < end; shift += 7) {
+    uchar byte = *p++;
+    value |= quint64(byte & 0x7f) << shift;
+    if (!(byte & 0x80))
+      return true;
+  }
+  return false;
+}
+
+template <typename T> void appendLE(QByteArray &out, T value) {
+  char bytes[sizeof(T)];
+  qToLittleEndian<T>(value, bytes);
+  out.append(bytes, sizeof(T));
+}
+
+bool isCurrencyCode(const QString &code) {
+  if (code.size() < 2 || code.size() > CodeSize)
+    return false;
+  for (QChar c : code) {
+    if (!(c >= 'A' && c <= 'Z') && !(c >= '0' && c <= '9'))
+      return false;
+  }
+  return true;
+}
+
+} // namespace
+
+RateHistory::RateHistory(const QString &path) : m_path(path) { openMapped(); }
+
+RateHistory::~RateHistory() { unmap(); }
+
+QString RateHistory::path() const { return m_path; }
+
+bool RateHistory::isEmpty() const {
+  QReadLocker locker(&m_lock);
+  return m_dayCount == 0;
+}
+
+int RateHistory::dayCount() const {
+  QReadLocker locker(&m_lock);
+  return int(m_dayCount);
+}
+
+QDate RateHistory::firstDate() const {
+  QReadLocker locker(&m_lock);
+  return m_dayCount ? QDate::fromJulianDay(dayAt(0)) : QDate();
+}
+
+QDate RateHistory::lastDate() const {
+  QReadLocker locker(&m_lock);
+  return m_dayCount ? QDate::fromJulianDay(dayAt(int(m_dayCount) - 1))
+                    : QDate();
+}
+
+QStringList RateHistory::currencies() const {
+  QReadLocker locker(&m_lock);
+  return m_codes;
+}
+
+bool RateHistory::rateOn(const QString &code, const QDate &date, double &rate,
+                         QDate *effectiveDate) const {
+  if (!date.isValid())
+    return false;
+
+  QString upper = code.toUpper();
+  if (upper == "USD") {
+    // The base: never stored
+    rate = 1.0;
+    if (effectiveDate)
+      *effectiveDate = date;
+    return true;
+  }
+
+  QReadLocker locker(&m_lock);
+  int column = m_columns.value(upper, -1);
+  if (column < 0)
+    return false;
+
+  qint32 julianDay = qint32(date.toJulianDay());
+  for (int index = dayIndexAtOrBefore(julianDay);
+       index >= 0 && julianDay - dayAt(index) <= MaxGapDays; --index) {
+    qint64 fixed;
+    if (valueAt(column, index, fixed) && fixed > 0) {
+      rate = fromFixed(fixed, m_digits[column]);
+      if (effectiveDate)
+        *effectiveDate = QDate::fromJulianDay(dayAt(index));
+      return true;
+    }
+  }
+  return false;
+}
+
+RateHistory::Series RateHistory::read(const QDate &from,
+                                      const QDate &to) const {
+  QReadLocker locker(&m_lock);
+  if (m_dayCount == 0)
+    return Series();
+
+  int first = 0;
+  int last = int(m_dayCount) - 1;
+  if (from.isValid()) {
+    first = dayIndexAtOrBefore(qint32(from.toJulianDay()) - 1) + 1;
+  }
+  if (to.isValid()) {
+    last = dayIndexAtOrBefore(qint32(to.toJulianDay()));
+  }
+  return decode(first, last);
+}
+
+RateHistory::Series RateHistory::decode(int firstIndex, int lastIndex) const {
+  Series series;
+  if (firstIndex > lastIndex)
+    return series;
+
+  for (int column = 0; column < m_codes.size(); ++column) {
+    const QString &code = m_codes[column];
+    const int digits = m_digits[column];
+
+    // Walk the column block by block; within a block deltas are sequential
+    qint64 value = 0;
+    const uchar *p = nullptr;
+    const uchar *end = m_blocks + m_blocksSize;
+    for (int index = firstIndex - firstIndex % BlockSize; index <= lastIndex;
+         ++index) {
+      if (index % BlockSize == 0) {
+        quint32 offset = blockOffset(column, index / BlockSize);
+        if (qint64(offset) + 8 > m_blocksSize)
+          break;
+        p = m_blocks + offset;
+        value = qFromLittleEndian<qint64>(p);
+        p += 8;
+      } else {
+        quint64 delta;
+        if (!readVarint(p, end, delta))
+          break;
+        value = qint64(quint64(value) + quint64(unzigzag(delta)));
+      }
+
+      if (index >= firstIndex && value > 0) {
+        series[QDate::fromJulianDay(dayAt(index))][code] =
+            fromFixed(value, digits);
+      }
+    }
+  }
+  return series;
+}
+
+bool RateHistory::merge(const Series &days, QString *error) {
+  // Merges run one at a time and only they change the mapping, so the new
+  // file is built from it without a lock. Lookups wait only while it is
+  // swapped in.
+  QMutexLocker merging(&m_mergeMutex);
+
+  // Rates too large or too small to store are reported, not dropped
+  // silently: 0 would read as "no rate"
+  Series incoming;
+  QStringList unstorable;
+  for (auto day = days.constBegin(); day != days.constEnd(); ++day) {
+    if (!day.key().isValid())
+      continue;
+    for (auto it = day->constBegin(); it != day->constEnd(); ++it) {
+      QString code = it.key().toUpper();
+      double rate = it.value();
+      if (code == "USD" || !isCurrencyCode(code) || !(rate > 0))
+        continue;
+      if (isStorable(rate)) {
+        incoming[day.key()][code] = rate;
+      } else {
+        unstorable << QString("%1 %2 on %3")
+                          .arg(rate)
+                          .arg(code, day.key().toString(Qt::ISODate));
+      }
+    }
+  }
+  auto reportUnstorable = [&]() {
+    if (unstorable.isEmpty())
+      return true;
+    if (error)
+      *error = "Rates out of range, not stored: " + unstorable.join(", ");
+    return false;
+  };
+
+  // Usually the days are at the end, e.g. a fetch's rates for today. Then
+  // only the last block of each column is encoded again.
+  const int tailStart =
+      m_dayCount ? int((m_dayCount - 1) / BlockSize) * BlockSize : 0;
+  const bool tailOnly = !incoming.isEmpty() && fitsTail(incoming, tailStart);
+  const int firstIndex = tailOnly ? tailStart : 0;
+
+  Series merged =
+      m_dayCount ? decode(firstIndex, int(m_dayCount) - 1) : Series();
+  if (!applyRates(merged, incoming))
+    return reportUnstorable(); // Rewriting costs a pass; nothing changed
+
+  QStringList codes;
+  QByteArray digits;
+  if (tailOnly) {
+    codes = m_codes;
+    for (int columnDigits : std::as_const(m_digits))
+      digits.append(char(columnDigits));
+  } else {
+    // As many decimal places as each currency's largest rate leaves room
+    QHash<QString, double> maxRates;
+    for (const DayRates &rates : std::as_const(merged)) {
+      for (auto it = rates.constBegin(); it != rates.constEnd(); ++it) {
+        double &max = maxRates[it.key()];
+        max = qMax(max, it.value());
+      }
+    }
+    codes = maxRates.keys();
+    codes.sort();
+    for (const QString &code : std::as_const(codes))
+      digits.append(char(digitsFor(maxRates.value(code))));
+  }
+
+  const quint32 dayCount = quint32(firstIndex + merged.size());
+  const quint32 blockCount = (dayCount + BlockSize - 1) / BlockSize;
+  const int tailBlock = firstIndex / BlockSize;
+
+  QByteArray dayColumn;
+  dayColumn.append(reinterpret_cast<const char *>(m_days), 4 * firstIndex);
+  for (auto it = merged.constBegin(); it != merged.constEnd(); ++it)
+    appendLE<qint32>(dayColumn, qint32(it.key().toJulianDay()));
+
+  QByteArray index;
+  QByteArray blocks;
+  index.reserve(int(4 * codes.size() * blockCount));
+  for (int column = 0; column < codes.size(); ++column) {
+    // Blocks before the tail are copied byte for byte
+    if (tailBlock > 0) {
+      quint32 from = blockOffset(column, 0);
+      for (int block = 0; block < tailBlock; ++block) {
+        appendLE<quint32>(index, blockOffset(column, block) - from +
+                                     quint32(blocks.size()));
+      }
+      blocks.append(reinterpret_cast<const char *>(m_blocks + from),
+                    blockOffset(column, tailBlock) - from);
+    }
+
+    const QString &code = codes[column];
+    qint64 previous = 0;
+    int position = firstIndex;
+    for (auto it = merged.constBegin(); it != merged.constEnd();
+         ++it, ++position) {
+      auto rate = it->constFind(code);
+      qint64 value =
+          rate == it->constEnd() ? 0 : toFixed(*rate, digits[column]);
+      if (rate != it->constEnd() && value == 0) {
+        // Only if the currency's rates span more than MaxFixed
+        unstorable << QString("%1 %2 on %3")
+                          .arg(*rate)
+                          .arg(code, it.key().toString(Qt::ISODate));
+      }
+      if (position % BlockSize == 0) {
+        appendLE<quint32>(index, quint32(blocks.size()));
+        appendLE<qint64>(blocks, value);
+      } else {
+        appendVarint(blocks, zigzag(qint64(quint64(value) - quint64(previous))));
+      }
+      previous = value;
+    }
+  }
+
+  QByteArray out;
+  out.append(Magic, 4);
+  appendLE<quint32>(out, Version);
+  appendLE<quint32>(out, BlockSize);
+  appendLE<quint32>(out, quint32(codes.size()));
+  appendLE<quint32>(out, dayCount);
+  appendLE<quint32>(out, 0);
+  for (const QString &code : std::as_const(codes)) {
+    QByteArray name = code.toLatin1().leftJustified(CodeSize, '\0');
+    out.append(name);
+  }
+  out.append(digits);
+  out.append(dayColumn);
+  out.append(index);
+  out.append(blocks);
+
+  QSaveFile file(m_path);
+  if (!file.open(QIODevice::WriteOnly) || file.write(out) != out.size() ||
+      !file.commit()) {
+    if (error)
+      *error = file.errorString();
+    return false;
+  }
+
+  QWriteLocker locker(&m_lock);
+  unmap();
+  openMapped();
+  return reportUnstorable();
+}
+
+bool RateHistory::fitsTail(const Series &days, int tailStart) const {
+  // Days from the last block on, in currencies the file has, at the
+  // decimal places it has for them
+  if (m_dayCount == 0 || days.firstKey().toJulianDay() < dayAt(tailStart))
+    return false;
+  for (const DayRates &rates : days) {
+    for (auto it = rates.constBegin(); it != rates.constEnd(); ++it) {
+      int column = m_columns.value(it.key(), -1);
+      if (column < 0 || toFixed(it.value(), m_digits[column]) == 0)
+        return false;
+    }
+  }
+
+  // The blocks to copy must be within the file
+  const int tailBlock = tailStart / BlockSize;
+  for (int column = 0; column < m_codes.size(); ++column) {
+    quint32 from = blockOffset(column, 0);
+    quint32 to = blockOffset(column, tailBlock);
+    if (to < from || qint64(to) > m_blocksSize)
+      return false;
+  }
+  return true;
+}
+
+bool RateHistory::applyRates(Series &series, const Series &rates) const {
+  bool changed = false;
+  for (auto day = rates.constBegin(); day != rates.constEnd(); ++day) {
+    DayRates &stored = series[day.key()];
+    for (auto it = day->constBegin(); it != day->constEnd(); ++it) {
+      // Equal once stored: compare at the decimal places the file keeps
+      int column = m_columns.value(it.key(), -1);
+      int digits = column < 0 ? MaxDigits : m_digits[column];
+      auto existing = stored.constFind(it.key());
+      if (existing != stored.constEnd() &&
+          toFixed(*existing, digits) == toFixed(it.value(), digits))
+        continue;
+      stored[it.key()] = it.value();
+      changed = true;
+    }
+  }
+  return changed;
+}
+
+int RateHistory::importCsv(const QString &csvPath, QString *error) {
+  QFile file(csvPath);
+  if (!file.open(QIODevice::ReadOnly)) {
+    if (error)
+      *error = file.errorString();
+    return -1;
+  }
+
+  Series series;
+  if (!parseCsv(file.readAll(), series, QStringLiteral("USD"), error))
+    return -1;
+  if (!merge(series, error))
+    return -1;
+  return series.size();
+}
+
+bool RateHistory::parseCsv(const QByteArray &data, Series &out,
+                           const QString &base, QString *error) {
+  QString fileBase = base.toUpper();
+  QStringList header;
+  bool longForm = false;
+  Series parsed;
+
+  const QList<QByteArray> lines = data.split('\n');
+  for (const QByteArray &raw : lines) {
+    QString line = QString::fromUtf8(raw).trimmed();
+    if (line.isEmpty())
+      continue;
+    if (line.startsWith('#')) {
+      QString comment = line.mid(1).trimmed();
+      if (comment.startsWith("base:", Qt::CaseInsensitive))
+        fileBase = comment.mid(5).trimmed().toUpper();
+      continue;
+    }
+
+    QStringList fields = line.remove('"').split(',');
+    for (QString &field : fields)
+      field = field.trimmed();
+
+    if (header.isEmpty()) {
+      if (fields.size() < 2 ||
+          fields[0].compare(QLatin1String("date"), Qt::CaseInsensitive)) {
+        if (error)
+          *error = QStringLiteral("First column must be \"date\"");
+        return false;
+      }
+      header = fields;
+      longForm =
+          fields.size() == 3 &&
+          !fields[1].compare(QLatin1String("currency"), Qt::CaseInsensitive) &&
+          !fields[2].compare(QLatin1String("rate"), Qt::CaseInsensitive);
+      continue;
+    }
+
+    QDate date = QDate::fromString(fields[0], Qt::ISODate);
+    if (!date.isValid())
+      continue;
+
+    bool ok;
+    if (longForm) {
+      if (fields.size() < 3)
+        continue;
+      double rate = fields[2].toDouble(&ok);
+      QString code = fields[1].toUpper();
+      if (ok && rate > 0 && isCurrencyCode(code))
+        parsed[date][code] = rate;
+      continue;
+    }
+
+    for (int i = 1; i < fields.size() && i < header.size(); ++i) {
+      double rate = fields[i].toDouble(&ok); // "N/A" and blanks skip
+      QString code = header[i].toUpper();
+      if (ok && rate > 0 && isCurrencyCode(code))
+        parsed[date][code] = rate;
+    }
+  }
+
+  rebase(parsed, fileBase);
+  if (parsed.isEmpty()) {
+    if (error)
+      *error = QStringLiteral("No rates found");
+    return false;
+  }
+
+  for (auto it = parsed.constBegin(); it != parsed.constEnd(); ++it) {
+    DayRates &day = out[it.key()];
+    for (auto rate = it->constBegin(); rate != it->constEnd(); ++rate)
+      day[rate.key()] = rate.value();
+  }
+  return true;
+}
+
+bool RateHistory::parseTimeSeries(const QByteArray &json, Series &out) {
+  QJsonDocument doc = QJsonDocument::fromJson(json);
+  if (!doc.isObject())
+    return false;
+
+  QJsonObject root = doc.object();
+  QJsonObject rates = root["rates"].toObject();
+
+  Series parsed;
+  for (auto day = rates.constBegin(); day != rates.constEnd(); ++day) {
+    QDate date = QDate::fromString(day.key(), Qt::ISODate);
+    if (!date.isValid())
+      continue;
+    QJsonObject values = day.value().toObject();
+    for (auto it = values.constBegin(); it != values.constEnd(); ++it) {
+      double rate = it.value().toDouble();
+      if (rate > 0)
+        parsed[date][it.key().toUpper()] = rate;
+    }
+  }
+
+  rebase(parsed, root["base"].toString("USD").toUpper());
+  for (auto it = parsed.constBegin(); it != parsed.constEnd(); ++it)
+    out[it.key()] = it.value();
+  return !parsed.isEmpty();
+}
+
+void RateHistory::rebase(Series &series, const QString &base) {
+  if (base == "USD")
+    return;
+
+  // Per-base rates become per-USD through that day's USD rate
+  for (auto day = series.begin(); day != series.end();) {
+    double usd = day->value("USD");
+    if (!(usd > 0)) {
+      day = series.erase(day);
+      continue;
+    }
+    DayRates perUsd;
+    for (auto it = day->constBegin(); it != day->constEnd(); ++it) {
+      if (it.key() != "USD")
+        perUsd[it.key()] = it.value() / usd;
+    }
+    perUsd[base] = 1.0 / usd;
+    *day = perUsd;
+    ++day;
+  }
+}
+
+bool RateHistory::openMapped() {
+  m_file.setFileName(m_path);
+  if (!m_file.exists() || !m_file.open(QIODevice::ReadOnly))
+    return false;
+
+  m_mapSize = m_file.size();
+  m_map = m_mapSize >= HeaderSize ? m_file.map(0, m_mapSize) : nullptr;
+  if (!m_map) {
+    unmap();
+    return false;
+  }
+
+  const uchar *p = m_map;
+  quint32 version = qFromLittleEndian<quint32>(p + 4);
+  bool hasDigits = version >= 2;
+  quint32 blockSize = qFromLittleEndian<quint32>(p + 8);
+  quint32 currencyCount = qFromLittleEndian<quint32>(p + 12);
+  quint32 dayCount = qFromLittleEndian<quint32>(p + 16);
+  quint32 blockCount = (quint64(dayCount) + BlockSize - 1) / BlockSize;
+
+  qint64 codesStart = HeaderSize;
+  qint64 digitsStart = codesStart + qint64(currencyCount) * CodeSize;
+  qint64 daysStart = digitsStart + (hasDigits ? qint64(currencyCount) : 0);
+  qint64 indexStart = daysStart + qint64(dayCount) * 4;
+  qint64 blocksStart = indexStart + qint64(currencyCount) * blockCount * 4;
+
+  if (memcmp(p, Magic, 4) != 0 || version < 1 || version > Version ||
+      blockSize != BlockSize || blocksStart > m_mapSize) {
+    qWarning() << "RateHistory: Ignoring unreadable" << m_path;
+    unmap();
+    return false;
+  }
+
+  m_dayCount = dayCount;
+  m_blockCount = blockCount;
+  m_days = m_map + daysStart;
+  m_blockIndex = m_map + indexStart;
+  m_blocks = m_map + blocksStart;
+  m_blocksSize = m_mapSize - blocksStart;
+
+  // Binary search relies on ascending days
+  for (quint32 i = 1; i < dayCount; ++i) {
+    if (dayAt(int(i)) <= dayAt(int(i) - 1)) {
+      qWarning() << "RateHistory: Days out of order in" << m_path;
+      unmap();
+      return false;
+    }
+  }
+
+  for (quint32 i = 0; i < currencyCount; ++i) {
+    const char *name = reinterpret_cast<const char *>(m_map + codesStart +
+                                                      qint64(i) * CodeSize);
+    QString code = QString::fromLatin1(name, int(qstrnlen(name, CodeSize)));
+    int digits = hasDigits ? int(m_map[digitsStart + i]) : MaxDigits;
+    if (digits > MaxDigits) {
+      qWarning() << "RateHistory: Ignoring unreadable" << m_path;
+      unmap();
+      return false;
+    }
+    m_columns.insert(code, int(i));
+    m_codes.append(code);
+    m_digits.append(digits);
+  }
+  return true;
+}
+
+void RateHistory::unmap() {
+  if (m_map)
+    m_file.unmap(const_cast<uchar *>(m_map));
+  m_file.close();
+  m_map = nullptr;
+  m_mapSize = 0;
+  m_dayCount = 0;
+  m_blockCount = 0;
+  m_days = m_blockIndex = m_blocks = nullptr;
+  m_blocksSize = 0;
+  m_columns.clear();
+  m_codes.clear();
+  m_digits.clear();
+}
+
+int RateHistory::dayIndexAtOrBefore(qint32 julianDay) const {
+  int low = 0;
+  int high = int(m_dayCount);
+  while (low < high) {
+    int mid = low + (high - low) / 2;
+    if (dayAt(mid) <= julianDay)
+      low = mid + 1;
+    else
+      high = mid;
+  }
+  return low - 1;
+}
+
+qint32 RateHistory::dayAt(int index) const {
+  return qFromLittleEndian<qint32>(m_days + 4 * qint64(index));
+}
+
+quint32 RateHistory::blockOffset(int column, int block) const {
+  return qFromLittleEndian<quint32>(
+      m_blockIndex + 4 * (quint64(column) * m_blockCount + quint32(block)));
+}
+
+bool RateHistory::valueAt(int column, int dayIndex, qint64 &fixed) const {
+  quint32 offset = blockOffset(column, dayIndex / BlockSize);
+  if (qint64(offset) + 8 > m_blocksSize)
+    return false;
+
+  const uchar *p = m_blocks + offset;
+  const uchar *end = m_blocks + m_blocksSize;
+  qint64 value = qFromLittleEndian<qint64>(p);
+  p += 8;
+  for (int steps = dayIndex % BlockSize; steps > 0; --steps) {
+    quint64 delta;
+    if (!readVarint(p, end, delta))
+      return false;
+    value = qint64(quint64(value) + quint64(unzigzag(delta)));
+  }
+  fixed = value;
+  return true;
+}
@@ -0,0 +1,128 @@
+#ifndef LINNOTE_RATEHISTORY_H
+#define LINNOTE_RATEHISTORY_H
+
+#include <QDate>
+#include <QFile>
+#include <QHash>
+#include <QMap>
+#include <QMutex>
+#include <QReadWriteLock>
+#include <QString>
+#include <QStringList>
+#include <QVector>
+
+/**
+ * @brief On-disk store of daily exchange rates, for "100 USD to EUR @date"
+ *
+ * One file, memory-mapped read-only. It is columnar: a sorted column of
+ * days, then one column of rates per currency. Rates are fixed-point, in
+ * 1e-12 units per USD unless a currency's largest rate needs a coarser
+ * unit, and delta-encoded as zig-zag varints in blocks of 32 days, each
+ * block starting from an absolute anchor, so a lookup is a binary search
+ * over the days plus at most 31 varint steps.
+ *
+ * merge() writes a new file. Days merged at the end, like each fetch's
+ * rates, re-encode only the last block of each currency; the others are
+ * copied as they are. Lookups may run on the Math sheet worker thread
+ * while the GUI thread merges, and wait only while the new file is
+ * swapped in.
+ */
+class RateHistory {
+public:
+  using DayRates = QMap<QString, double>; // Currency -> units per USD
+  using Series = QMap<QDate, DayRates>;
+
+  // Weekends and holidays have no rates; use the last day before them
+  static constexpr int MaxGapDays = 7;
+
+  explicit RateHistory(const QString &path);
+  ~RateHistory();
+
+  RateHistory(const RateHistory &) = delete;
+  RateHistory &operator=(const RateHistory &) = delete;
+
+  QString path() const;
+  bool isEmpty() const;
+  int dayCount() const;
+  QDate firstDate() const;
+  QDate lastDate() const;
+  QStringList currencies() const;
+
+  /**
+   * @brief Rate in effect on @p date (units of @p code per USD)
+   * @param effectiveDate Output: the stored day the rate comes from
+   * @return false if no day within MaxGapDays before @p date has a rate
+   */
+  bool rateOn(const QString &code, const QDate &date, double &rate,
+              QDate *effectiveDate = nullptr) const;
+
+  /**
+   * @brief Decode the stored days in [from, to] (open if invalid)
+   */
+  Series read(const QDate &from = QDate(), const QDate &to = QDate()) const;
+
+  /**
+   * @brief Add or overwrite days and rewrite the file
+   * @return false if the file couldn't be written, or if some rates were
+   *         out of range (the others are still merged); see @p error
+   */
+  bool merge(const Series &days, QString *error = nullptr);
+
+  /**
+   * @brief Import a CSV file and merge it
+   * @return Number of days imported, or -1 on error
+   *
+   * See parseCsv() for the accepted layouts.
+   */
+  int importCsv(const QString &csvPath, QString *error = nullptr);
+
+  /**
+   * @brief Parse daily rates from CSV
+   *
+   * Either wide ("date,EUR,GBP,...", one row per day) or long
+   * ("date,currency,rate", one row per rate). Dates are ISO (yyyy-MM-dd).
+   * Rates are per @p base unless the file has a "# base: XXX" line; they
+   * are stored per USD, so non-USD files need a USD rate on each day.
+   */
+  static bool parseCsv(const QByteArray &data, Series &out,
+                       const QString &base = QStringLiteral("USD"),
+                       QString *error = nullptr);
+
+  /**
+   * @brief Parse a Frankfurter time series ({"base":..,"rates":{date:{..}}})
+   */
+  static bool parseTimeSeries(const QByteArray &json, Series &out);
+
+private:
+  bool openMapped();
+  void unmap();
+  Series decode(int firstIndex, int lastIndex) const;
+  int dayIndexAtOrBefore(qint32 julianDay) const;
+  qint32 dayAt(int index) const;
+  quint32 blockOffset(int column, int block) const;
+  bool valueAt(int column, int dayIndex, qint64 &fixed) const;
+  static void rebase(Series &series, const QString &base);
+  bool fitsTail(const Series &days, int tailStart) const;
+  bool applyRates(Series &series, const Series &rates) const; // If changed
+
+  QString m_path;
+  QFile m_file;
+  const uchar *m_map = nullptr;
+  qint64 m_mapSize = 0;
+
+  // Views into the mapping, set by openMapped()
+  quint32 m_dayCount = 0;
+  quint32 m_blockCount = 0;
+  const uchar *m_days = nullptr;
+  const uchar *m_blockIndex = nullptr;
+  const uchar *m_blocks = nullptr;
+  qint64 m_blocksSize = 0;
+  QHash<QString, int> m_columns;
+  QStringList m_codes;
+  QVector<int> m_digits; // Decimal places of each column's fixed point
+
+  mutable QReadWriteLock m_lock; // Held to write only to swap files
+  QMutex m_mergeMutex;           // One merge at a time
+};
+
+#endif // LINNOTE_RATEHISTORY_H
@@ -1,4 +1,5 @@
 #include "Settings.h"
+#include "KeywordTable.h"
 #include "integration/DesktopHelper.h"
 #include "storage/SqliteStorage.h"
 #include "version.h"
@@ -26,7 +27,7 @@ Settings *Settings::instance() {
 }
 
 Settings::Settings(QObject *parent)
-    : QObject(parent), m_autoMathEnabled(true),
+    : QObject(parent), m_autoMathEnabled(true), m_decimalScale(4),
       m_currencyConversionEnabled(true), m_baseCurrency("USD"),
       m_currencyApiKey(""), m_cryptoApiKey("gz2pvqoerci2x921124g"),
       m_currencyProvider("frankfurter"),
@@ -63,6 +64,16 @@ void Settings::setAutoMathEnabled(bool enabled) {
   }
 }
 
+int Settings::decimalScale() const { return m_decimalScale; }
+
+void Settings::setDecimalScale(int scale) {
+  if (m_decimalScale != scale) {
+    m_decimalScale = scale;
+    save();
+    emit settingsChanged();
+  }
+}
+
 bool Settings::currencyConversionEnabled() const {
   return m_currencyConversionEnabled;
 }
@@ -433,6 +444,7 @@ void Settings::save() {
   // Build JSON object with all settings
   QJsonObject json;
   json["autoMathEnabled"] = m_autoMathEnabled;
+  json["decimalScale"] = m_decimalScale;
   json["currencyConversionEnabled"] = m_currencyConversionEnabled;
   json["baseCurrency"] = m_baseCurrency;
   json["currencyApiKey"] = m_currencyApiKey;
@@ -548,6 +560,7 @@ void Settings::load() {
 
   // Apply settings from JSON object (defaults if empty)
   m_autoMathEnabled = json["autoMathEnabled"].toBool(true);
+  m_decimalScale = json["decimalScale"].toInt(4);
   m_currencyConversionEnabled = json["currencyConversionEnabled"].toBool(true);
   m_baseCurrency = json["baseCurrency"].toString("USD");
   m_currencyApiKey = json["currencyApiKey"].toString("");
@@ -619,6 +632,7 @@ void Settings::load() {
     for (auto it = aliasesObj.constBegin(); it != aliasesObj.constEnd(); ++it) {
       m_keywordAliases[it.key()] = it.value().toString();
     }
+    ++m_keywordAliasesVersion;
   }
 
   // Load shortcuts (merge with defaults)
@@ -921,6 +935,14 @@ QMap<QString, QString> Settings::keywordAliases() const {
   return m_keywordAliases;
 }
 
+QSharedPointer<const KeywordTable> Settings::keywordTable() const {
+  // Readers keep the snapshot they got; a rebuild only replaces ours
+  if (!m_keywordTable || m_keywordTable->version() != m_keywordAliasesVersion)
+    m_keywordTable.reset(
+        new KeywordTable(m_keywordAliases, m_keywordAliasesVersion));
+  return m_keywordTable;
+}
+
 void Settings::setKeywordAlias(const QString &original, const QString &alias) {
   qDebug() << "Settings::setKeywordAlias" << original << "->" << alias;
   if (alias.isEmpty()) {
@@ -928,6 +950,7 @@ void Settings::setKeywordAlias(const QString &original, const QString &alias) {
   } else {
     m_keywordAliases[original] = alias;
   }
+  ++m_keywordAliasesVersion;
   qDebug() << "Settings: aliases now:" << m_keywordAliases;
   save();
   emit settingsChanged();
@@ -936,6 +959,7 @@ void Settings::setKeywordAlias(const QString &original, const QString &alias) {
 void Settings::setKeywordAliases(const QMap<QString, QString> &aliases) {
   if (m_keywordAliases != aliases) {
     m_keywordAliases = aliases;
+    ++m_keywordAliasesVersion;
     save();
     emit settingsChanged();
   }
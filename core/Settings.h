@@ -6,9 +6,12 @@
 #include <QMap>
 #include <QObject>
 #include <QPoint>
+#include <QSharedPointer>
 #include <QSize>
 #include <QString>
 
+class KeywordTable;
+
 /**
  * @brief Application settings manager
  *
@@ -40,6 +43,10 @@ public:
   bool autoMathEnabled() const;
   void setAutoMathEnabled(bool enabled);
 
+  // Digits after the point when a sheet switches to exact (decimal) math
+  int decimalScale() const;
+  void setDecimalScale(int scale);
+
   // Currency settings
   bool currencyConversionEnabled() const;
   void setCurrencyConversionEnabled(bool enabled);
@@ -222,6 +229,8 @@ public:
   QMap<QString, QString> keywordAliases() const;
   void setKeywordAlias(const QString &original, const QString &alias);
   void setKeywordAliases(const QMap<QString, QString> &aliases);
+  // Keywords plus aliases, rebuilt only after the aliases change
+  QSharedPointer<const KeywordTable> keywordTable() const;
 
   // Persistence
   void save();
@@ -240,6 +249,7 @@ private:
   void updateKdeGlobalShortcut(const QString &hotkey);
 
   bool m_autoMathEnabled;
+  int m_decimalScale;
   bool m_currencyConversionEnabled;
   QString m_baseCurrency;
   QString m_currencyApiKey;
@@ -331,6 +341,8 @@ private:
 
   // Keyword aliases
   QMap<QString, QString> m_keywordAliases;
+  int m_keywordAliasesVersion = 0; // Bumped on every change
+  mutable QSharedPointer<const KeywordTable> m_keywordTable;
 
   // Onboarding tour
   bool m_onboardingCompleted;
@@ -1,25 +1,14 @@
 #include "SlashCommand.h"
 #include "NoteManager.h"
+#include "KeywordTable.h"
 #include "NoteMode.h"
 #include "Settings.h"
 #include <QDebug>
 
 // Helper: resolve custom alias to original keyword
 static QString resolveAlias(const QString &input) {
-  Settings *s = Settings::instance();
-  QMap<QString, QString> aliases = s->keywordAliases();
-
-  qDebug() << "SlashCommand: resolveAlias input:" << input
-           << "aliases:" << aliases;
-
-  // Check if input matches any alias, return original keyword
-  for (auto it = aliases.constBegin(); it != aliases.constEnd(); ++it) {
-    if (!it.value().isEmpty() && it.value().toLower() == input.toLower()) {
-      qDebug() << "SlashCommand: Found alias" << input << "->" << it.key();
-      return it.key(); // Return original keyword
-    }
-  }
-  return input; // No alias found, return as-is
+  QString keyword = Settings::instance()->keywordTable()->resolve(input);
+  return keyword.isEmpty() ? input : keyword; // No match, return as-is
 }
 
 SlashCommand::SlashCommand(NoteManager *manager, QObject *parent)
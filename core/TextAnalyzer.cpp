@@ -1,51 +1,374 @@
 #include "TextAnalyzer.h"
-#include <QRegularExpression>
+#include <QtAlgorithms>
 #include <QtMath>
+#include <array>
 
-TextAnalyzer::TextAnalyzer() {}
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
 
-QList<double> TextAnalyzer::extractNumbers(const QString &text) const {
-  QList<double> numbers;
-
-  // Match numbers with optional currency symbols and thousand separators
-  // Patterns: $25, €10, 3.14, -5, 1,000.50, 25.00, - 5 (minus with space)
-  QRegularExpression regex(
-      R"([\$€£¥]?\s*(-\s*\d{1,3}(?:,\d{3})*(?:\.\d+)?|-\s*\d+(?:\.\d+)?|\d{1,3}(?:,\d{3})*(?:\.\d+)?|\d+(?:\.\d+)?))");
-  QRegularExpressionMatchIterator it = regex.globalMatch(text);
-  while (it.hasNext()) {
-    QRegularExpressionMatch match = it.next();
-    QString numStr = match.captured(1);
-    // Remove thousand separators and any internal spaces (for "- 5" format)
-    numStr.remove(',');
-    numStr.remove(' ');
-    bool ok;
-    double val = numStr.toDouble(&ok);
-    if (ok) {
-      numbers.append(val);
+namespace {
+
+constexpr int BlockChars = 16;
+
+// Character classes, one bit each
+enum Class : quint16 {
+  Space = 1 << 0,
+  Newline = 1 << 1,
+  WordChar = 1 << 2, // Letters, digits and '_'
+  Letter = 1 << 3,
+  Vowel = 1 << 4, // a e i o u y, either case
+  Digit = 1 << 5, // ASCII only
+  Minus = 1 << 6,
+  Punct = 1 << 7, // . ! ?
+  Currency = 1 << 8,
+};
+
+constexpr std::array<quint16, 128> asciiClasses() {
+  std::array<quint16, 128> classes{};
+  for (int c = 0; c < 128; ++c) {
+    quint16 bits = 0;
+    int lower = c | 0x20;
+    if (c == ' ' || (c >= '\t' && c <= '\r'))
+      bits |= Space;
+    if (c == '\n')
+      bits |= Newline;
+    if (lower >= 'a' && lower <= 'z')
+      bits |= WordChar | Letter;
+    if (lower == 'a' || lower == 'e' || lower == 'i' || lower == 'o' ||
+        lower == 'u' || lower == 'y')
+      bits |= Vowel;
+    if (c >= '0' && c <= '9')
+      bits |= WordChar | Digit;
+    if (c == '_')
+      bits |= WordChar;
+    if (c == '-')
+      bits |= Minus;
+    if (c == '.' || c == '!' || c == '?')
+      bits |= Punct;
+    if (c == '$')
+      bits |= Currency;
+    classes[c] = bits;
+  }
+  return classes;
+}
+
+constexpr std::array<quint16, 128> AsciiClasses = asciiClasses();
+
+quint16 classOf(char16_t u) {
+  if (u < 128) {
+    return AsciiClasses[u];
+  }
+  QChar c(u);
+  quint16 bits = 0;
+  if (c.isSpace())
+    bits |= Space;
+  if (c.isLetter())
+    bits |= WordChar | Letter;
+  else if (c.isNumber())
+    bits |= WordChar;
+  if (u == 0x0130) // İ lower-cases to i
+    bits |= Vowel;
+  if (u == 0x20AC || u == 0x00A3 || u == 0x00A5) // € £ ¥
+    bits |= Currency;
+  return bits;
+}
+
+bool isDigit(QChar c) { return c.unicode() >= '0' && c.unicode() <= '9'; }
+
+// Per class, a bit for each character of a block
+struct Masks {
+  quint32 space = 0;
+  quint32 newline = 0;
+  quint32 word = 0;
+  quint32 letter = 0;
+  quint32 vowel = 0;
+  quint32 digit = 0;
+  quint32 minus = 0;
+  quint32 punct = 0;
+  quint32 currency = 0;
+};
+
+Masks classify(const QChar *chars, int length) {
+  Masks m;
+  for (int k = 0; k < length; ++k) {
+    quint16 bits = classOf(chars[k].unicode());
+    m.space |= quint32(bool(bits & Space)) << k;
+    m.newline |= quint32(bool(bits & Newline)) << k;
+    m.word |= quint32(bool(bits & WordChar)) << k;
+    m.letter |= quint32(bool(bits & Letter)) << k;
+    m.vowel |= quint32(bool(bits & Vowel)) << k;
+    m.digit |= quint32(bool(bits & Digit)) << k;
+    m.minus |= quint32(bool(bits & Minus)) << k;
+    m.punct |= quint32(bool(bits & Punct)) << k;
+    m.currency |= quint32(bool(bits & Currency)) << k;
+  }
+  return m;
+}
+
+#if defined(__SSE2__)
+// Same as classify() for a full block; false if it isn't all ASCII
+bool classifyAscii(const QChar *chars, Masks &m) {
+  const __m128i low = _mm_loadu_si128(reinterpret_cast<const __m128i *>(chars));
+  const __m128i high =
+      _mm_loadu_si128(reinterpret_cast<const __m128i *>(chars + 8));
+  const __m128i nonAscii =
+      _mm_and_si128(_mm_or_si128(low, high), _mm_set1_epi16(short(0xFF80)));
+  if (_mm_movemask_epi8(_mm_cmpeq_epi16(nonAscii, _mm_setzero_si128())) !=
+      0xFFFF) {
+    return false;
+  }
+
+  // Below 0x80, so packing to bytes loses nothing
+  const __m128i c = _mm_packus_epi16(low, high);
+  const __m128i lower = _mm_or_si128(c, _mm_set1_epi8(0x20));
+  auto is = [](__m128i v, char x) {
+    return _mm_cmpeq_epi8(v, _mm_set1_epi8(x));
+  };
+  auto in = [](__m128i v, char first, char last) {
+    return _mm_and_si128(_mm_cmpgt_epi8(v, _mm_set1_epi8(char(first - 1))),
+                         _mm_cmplt_epi8(v, _mm_set1_epi8(char(last + 1))));
+  };
+  auto bits = [](__m128i v) { return quint32(_mm_movemask_epi8(v)); };
+
+  m.space = bits(_mm_or_si128(is(c, ' '), in(c, '\t', '\r')));
+  m.newline = bits(is(c, '\n'));
+  m.letter = bits(in(lower, 'a', 'z'));
+  m.digit = bits(in(c, '0', '9'));
+  m.word = m.letter | m.digit | bits(is(c, '_'));
+  m.vowel = bits(_mm_or_si128(
+      _mm_or_si128(_mm_or_si128(is(lower, 'a'), is(lower, 'e')),
+                   _mm_or_si128(is(lower, 'i'), is(lower, 'o'))),
+      _mm_or_si128(is(lower, 'u'), is(lower, 'y'))));
+  m.minus = bits(is(c, '-'));
+  m.punct = bits(
+      _mm_or_si128(_mm_or_si128(is(c, '.'), is(c, '!')), is(c, '?')));
+  m.currency = bits(is(c, '$'));
+  return true;
+}
+#endif
+
+// Walks the text block by block, carrying what spans blocks
+class Scanner {
+public:
+  Scanner(QStringView text, TextAnalyzer::Scan &scan)
+      : m_text(text), m_scan(scan) {}
+
+  void run();
+
+private:
+  void block(const Masks &m, qsizetype base, int length);
+  void finishWord();
+  void number(qsizetype at);
+  qsizetype skipDigits(qsizetype at) const;
+
+  QStringView m_text;
+  TextAnalyzer::Scan &m_scan;
+  QByteArray m_digits; // Of the number being parsed
+
+  bool m_lineHasText = false;
+  bool m_inPunct = false;
+  bool m_inWord = false;
+  bool m_wordLetters = false; // The word has no digits or '_'
+  bool m_prevVowel = false;
+  bool m_wordEndsWithE = false;
+  int m_wordSyllables = 0;
+  qsizetype m_numberEnd = 0; // Numbers don't start inside another
+};
+
+void Scanner::run() {
+  const QChar *chars = m_text.data();
+  const qsizetype size = m_text.size();
+  for (qsizetype i = 0; i < size; i += BlockChars) {
+    int length = int(qMin<qsizetype>(BlockChars, size - i));
+    Masks m;
+#if defined(__SSE2__)
+    if (length < BlockChars || !classifyAscii(chars + i, m))
+      m = classify(chars + i, length);
+#else
+    m = classify(chars + i, length);
+#endif
+    block(m, i, length);
+  }
+
+  if (m_inWord) {
+    finishWord();
+  }
+  if (m_lineHasText) {
+    ++m_scan.items;
+  }
+}
+
+void Scanner::block(const Masks &m, qsizetype base, int length) {
+  const quint32 all = (1u << length) - 1;
+  const quint32 text = ~m.space & all;
+  m_scan.characters += qPopulationCount(text);
+  m_scan.hasCurrency = m_scan.hasCurrency || m.currency;
+
+  // Runs of . ! ?, one may continue from the last block
+  m_scan.sentences +=
+      qPopulationCount(m.punct & ~((m.punct << 1) | quint32(m_inPunct)));
+  m_inPunct = m.punct >> (length - 1) & 1;
+
+  // Lines with anything but whitespace
+  quint32 newlines = m.newline;
+  int lineStart = 0;
+  while (newlines) {
+    int end = qCountTrailingZeroBits(newlines);
+    quint32 line = (1u << end) - (1u << lineStart);
+    if (m_lineHasText || (text & line)) {
+      ++m_scan.items;
+    }
+    m_lineHasText = false;
+    lineStart = end + 1;
+    newlines &= newlines - 1;
+  }
+  if (text >> lineStart) {
+    m_lineHasText = true;
+  }
+
+  // Runs of word characters, one may continue from the last block
+  if (m_inWord && !(m.word & 1)) {
+    finishWord();
+  }
+  quint32 runs = m.word;
+  while (runs) {
+    int start = qCountTrailingZeroBits(runs);
+    int end = start + qCountTrailingZeroBits(~(runs >> start));
+    quint32 run = (1u << end) - (1u << start);
+    if (!m_inWord) {
+      m_inWord = true;
+      m_wordLetters = true;
+      m_prevVowel = false;
+      m_wordSyllables = 0;
+    }
+    if (run & ~m.letter) {
+      m_wordLetters = false;
+    }
+
+    // Syllables: runs of vowels
+    quint32 vowels = m.vowel & run;
+    m_wordSyllables += qPopulationCount(
+        vowels & ~((vowels << 1) | (quint32(m_prevVowel) << start)));
+    m_prevVowel = vowels >> (end - 1) & 1;
+    m_wordEndsWithE = (m_text[base + end - 1].unicode() | 0x20) == 'e';
+
+    if (end < length) {
+      finishWord();
     }
+    runs &= ~run;
   }
 
-  return numbers;
+  // Numbers start at a digit or a minus
+  quint32 starts = m.digit | m.minus;
+  while (starts) {
+    qsizetype at = base + qCountTrailingZeroBits(starts);
+    if (at >= m_numberEnd) {
+      number(at);
+    }
+    starts &= starts - 1;
+  }
 }
 
-double TextAnalyzer::sum(const QString &text) const {
-  QList<double> nums = extractNumbers(text);
+void Scanner::finishWord() {
+  m_inWord = false;
+  if (!m_wordLetters) {
+    return;
+  }
+
+  // Handle silent e at end
+  int syllables = m_wordSyllables;
+  if (m_wordEndsWithE && syllables > 1) {
+    --syllables;
+  }
+  ++m_scan.words;
+  m_scan.syllables += qMax(1, syllables);
+}
+
+qsizetype Scanner::skipDigits(qsizetype at) const {
+  while (at < m_text.size() && isDigit(m_text[at])) {
+    ++at;
+  }
+  return at;
+}
+
+void Scanner::number(qsizetype at) {
+  const qsizetype size = m_text.size();
+  qsizetype i = at;
+  bool negative = false;
+  if (m_text[i] == u'-') {
+    // "-5" or "- 5"
+    ++i;
+    while (i < size && m_text[i].isSpace()) {
+      ++i;
+    }
+    if (i == size || !isDigit(m_text[i])) {
+      return;
+    }
+    negative = true;
+  }
+
+  // 1,000,000 groups after up to three digits
+  qsizetype digits = i;
+  i = skipDigits(i);
+  if (i - digits <= 3) {
+    while (i + 3 < size && m_text[i] == u',' && isDigit(m_text[i + 1]) &&
+           isDigit(m_text[i + 2]) && isDigit(m_text[i + 3])) {
+      i += 4;
+    }
+  }
+  if (i + 1 < size && m_text[i] == u'.' && isDigit(m_text[i + 1])) {
+    i = skipDigits(i + 1);
+  }
+  m_numberEnd = i;
+
+  m_digits.resize(0);
+  if (negative) {
+    m_digits.append('-');
+  }
+  for (qsizetype k = digits; k < i; ++k) {
+    if (m_text[k] != u',') {
+      m_digits.append(char(m_text[k].unicode()));
+    }
+  }
+  bool ok;
+  double value = m_digits.toDouble(&ok);
+  if (ok) {
+    m_scan.numbers.append(value);
+  }
+}
+
+double total(const QList<double> &numbers) {
   double total = 0;
-  for (double n : nums) {
+  for (double n : numbers) {
     total += n;
   }
   return total;
 }
 
+} // namespace
+
+TextAnalyzer::TextAnalyzer() {}
+
+TextAnalyzer::Scan TextAnalyzer::scan(QStringView text) const {
+  Scan scan;
+  Scanner(text, scan).run();
+  return scan;
+}
+
+QList<double> TextAnalyzer::extractNumbers(const QString &text) const {
+  return scan(text).numbers;
+}
+
+double TextAnalyzer::sum(const QString &text) const {
+  return total(extractNumbers(text));
+}
+
 double TextAnalyzer::avg(const QString &text) const {
   QList<double> nums = extractNumbers(text);
   if (nums.isEmpty())
     return 0;
-  double total = 0;
-  for (double n : nums) {
-    total += n;
-  }
-  return total / nums.size();
+  return total(nums) / nums.size();
 }
 
 double TextAnalyzer::min(const QString &text) const {
@@ -72,64 +395,13 @@ double TextAnalyzer::max(const QString &text) const {
   return maxVal;
 }
 
-int TextAnalyzer::countSyllables(const QString &word) const {
-  QString w = word.toLower();
-  int count = 0;
-  bool prevVowel = false;
-
-  for (int i = 0; i < w.length(); i++) {
-    QChar c = w[i];
-    bool isVowel =
-        (c == 'a' || c == 'e' || c == 'i' || c == 'o' || c == 'u' || c == 'y');
-    if (isVowel && !prevVowel) {
-      count++;
-    }
-    prevVowel = isVowel;
-  }
-
-  // Handle silent e at end
-  if (w.endsWith('e') && count > 1) {
-    count--;
-  }
-
-  return qMax(1, count);
-}
-
 TextAnalyzer::TextStats TextAnalyzer::analyze(const QString &text) const {
-  TextStats stats = {0, 0, 0, 0, 0.0, 0.0};
-
-  // Items: non-empty lines
-  QStringList lines = text.split('\n');
-  for (const QString &line : lines) {
-    if (!line.trimmed().isEmpty()) {
-      stats.items++;
-    }
-  }
-
-  // Words
-  QRegularExpression wordRegex(R"(\b[a-zA-ZğüşöçıİĞÜŞÖÇ]+\b)");
-  QRegularExpressionMatchIterator wordIt = wordRegex.globalMatch(text);
-  int totalSyllables = 0;
-  while (wordIt.hasNext()) {
-    QRegularExpressionMatch match = wordIt.next();
-    stats.words++;
-    totalSyllables += countSyllables(match.captured());
-  }
-
-  // Characters (excluding whitespace)
-  for (const QChar &c : text) {
-    if (!c.isSpace()) {
-      stats.characters++;
-    }
-  }
+  return stats(scan(text));
+}
 
-  // Sentences (count . ! ?)
-  QRegularExpression sentenceRegex(R"([.!?]+)");
-  QRegularExpressionMatchIterator sentIt = sentenceRegex.globalMatch(text);
-  while (sentIt.hasNext()) {
-    sentIt.next();
-    stats.sentences++;
-  }
+TextAnalyzer::TextStats TextAnalyzer::stats(const Scan &scan) {
+  TextStats stats = {scan.items, scan.words, scan.characters,
+                     scan.sentences, 0.0, 0.0};
   if (stats.sentences == 0 && stats.words > 0) {
     stats.sentences = 1;
   }
@@ -138,7 +410,7 @@ TextAnalyzer::TextStats TextAnalyzer::analyze(const QString &text) const {
   // 206.835 - 1.015*(words/sentences) - 84.6*(syllables/words)
   if (stats.words > 0 && stats.sentences > 0) {
     double avgWordsPerSentence = (double)stats.words / stats.sentences;
-    double avgSyllablesPerWord = (double)totalSyllables / stats.words;
+    double avgSyllablesPerWord = (double)scan.syllables / stats.words;
     stats.fleschReadingEase =
         206.835 - 1.015 * avgWordsPerSentence - 84.6 * avgSyllablesPerWord;
     stats.fleschReadingEase = qBound(0.0, stats.fleschReadingEase, 100.0);
@@ -154,38 +426,41 @@ TextAnalyzer::TextStats TextAnalyzer::analyze(const QString &text) const {
 }
 
 QString TextAnalyzer::formatSum(const QString &text) const {
-  QList<double> nums = extractNumbers(text);
-  if (nums.isEmpty()) {
+  return formatSum(scan(text));
+}
+
+QString TextAnalyzer::formatSum(const Scan &scan) {
+  if (scan.numbers.isEmpty()) {
     return "\nTotal: 0";
   }
-  double total = sum(text);
-  // Check if original text had currency symbols
-  bool hasCurrency = text.contains('$') || text.contains(QChar(0x20AC)) ||
-                     text.contains(QChar(0x00A3)) ||
-                     text.contains(QChar(0x00A5));
-  if (hasCurrency) {
-    return QString("\nTotal: $%1").arg(total, 0, 'f', 2);
+  double sum = total(scan.numbers);
+  if (scan.hasCurrency) {
+    return QString("\nTotal: $%1").arg(sum, 0, 'f', 2);
   }
-  return QString("\nTotal: %1").arg(total, 0, 'f', 2);
+  return QString("\nTotal: %1").arg(sum, 0, 'f', 2);
 }
 
 QString TextAnalyzer::formatAvg(const QString &text) const {
-  QList<double> nums = extractNumbers(text);
-  if (nums.isEmpty()) {
+  return formatAvg(scan(text));
+}
+
+QString TextAnalyzer::formatAvg(const Scan &scan) {
+  if (scan.numbers.isEmpty()) {
     return "\nAvg: 0";
   }
-  double average = avg(text);
-  bool hasCurrency = text.contains('$') || text.contains(QChar(0x20AC)) ||
-                     text.contains(QChar(0x00A3)) ||
-                     text.contains(QChar(0x00A5));
-  if (hasCurrency) {
+  double average = total(scan.numbers) / scan.numbers.size();
+  if (scan.hasCurrency) {
     return QString("\nAvg: $%1").arg(average, 0, 'f', 2);
   }
   return QString("\nAvg: %1").arg(average, 0, 'f', 2);
 }
 
 QString TextAnalyzer::formatCount(const QString &text) const {
-  TextStats s = analyze(text);
+  return formatCount(scan(text));
+}
+
+QString TextAnalyzer::formatCount(const Scan &scan) {
+  TextStats s = stats(scan);
 
   QString result;
   result += QString("\nItems: %1").arg(s.items);
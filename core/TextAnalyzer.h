@@ -3,6 +3,7 @@
 
 #include <QList>
 #include <QString>
+#include <QStringView>
 
 /**
  * @brief Text analysis utilities for sum, avg, count commands
@@ -10,11 +11,30 @@
  * Extracts numbers from text (supports $, €, decimals)
  * Calculates text statistics (words, chars, sentences)
  * Computes readability scores
+ *
+ * Everything comes from one walk over the text, scan(). Runs of ASCII
+ * are classified 16 characters at a time with SSE2 where available.
  */
 class TextAnalyzer {
 public:
   TextAnalyzer();
 
+  // What one walk over the text finds
+  struct Scan {
+    QList<double> numbers;
+    int items = 0;      // non-empty lines
+    int words = 0;      // runs of letters only
+    int syllables = 0;  // of those words
+    int characters = 0; // excluding whitespace
+    int sentences = 0;  // runs of . ! ?
+    bool hasCurrency = false; // $, €, £ or ¥ anywhere
+  };
+
+  /**
+   * @brief Numbers and statistics of @p text, e.g. a selection
+   */
+  Scan scan(QStringView text) const;
+
   /**
    * @brief Extract all numbers from text
    * Supports: $25, €10, 3.14, -5, 1,000.50
@@ -55,24 +75,25 @@ public:
    * @brief Compute text statistics
    */
   TextStats analyze(const QString &text) const;
+  static TextStats stats(const Scan &scan);
 
   /**
    * @brief Format sum result for display
    */
   QString formatSum(const QString &text) const;
+  static QString formatSum(const Scan &scan);
 
   /**
    * @brief Format avg result for display
    */
   QString formatAvg(const QString &text) const;
+  static QString formatAvg(const Scan &scan);
 
   /**
    * @brief Format count result for display
    */
   QString formatCount(const QString &text) const;
-
-private:
-  int countSyllables(const QString &word) const;
+  static QString formatCount(const Scan &scan);
 };
 
 #endif // LINNOTE_TEXTANALYZER_H
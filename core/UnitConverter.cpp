@@ -1,334 +1,757 @@
 #include "UnitConverter.h"
-#include <QRegularExpression>
 #include <QtMath>
 
-UnitConverter *UnitConverter::s_instance = nullptr;
+namespace {
 
-UnitConverter *UnitConverter::instance() {
-  if (!s_instance) {
-    s_instance = new UnitConverter();
+// ===== Dimensions =====
+
+// Exponents of the base quantities: meter, kilogram, second, kelvin, byte
+struct Dimension {
+  qint8 length;
+  qint8 mass;
+  qint8 time;
+  qint8 temperature;
+  qint8 data;
+
+  constexpr Dimension operator+(const Dimension &o) const {
+    return {qint8(length + o.length), qint8(mass + o.mass),
+            qint8(time + o.time), qint8(temperature + o.temperature),
+            qint8(data + o.data)};
+  }
+  constexpr Dimension operator-(const Dimension &o) const {
+    return {qint8(length - o.length), qint8(mass - o.mass),
+            qint8(time - o.time), qint8(temperature - o.temperature),
+            qint8(data - o.data)};
   }
-  return s_instance;
+  constexpr Dimension operator*(int power) const {
+    return {qint8(length * power), qint8(mass * power), qint8(time * power),
+            qint8(temperature * power), qint8(data * power)};
+  }
+  constexpr bool operator==(const Dimension &o) const {
+    return length == o.length && mass == o.mass && time == o.time &&
+           temperature == o.temperature && data == o.data;
+  }
+  constexpr bool operator!=(const Dimension &o) const { return !(*this == o); }
+};
+
+constexpr Dimension None{0, 0, 0, 0, 0};
+constexpr Dimension Length{1, 0, 0, 0, 0};
+constexpr Dimension Mass{0, 1, 0, 0, 0};
+constexpr Dimension Time{0, 0, 1, 0, 0};
+constexpr Dimension Temperature{0, 0, 0, 1, 0};
+constexpr Dimension Data{0, 0, 0, 0, 1};
+constexpr Dimension Area = Length * 2;
+constexpr Dimension Volume = Length * 3;
+constexpr Dimension Speed = Length - Time;
+constexpr Dimension Force = Mass + Length - Time * 2;
+constexpr Dimension Energy = Force + Length;
+constexpr Dimension Power = Energy - Time;
+constexpr Dimension Pressure = Force - Area;
+constexpr Dimension DataRate = Data - Time;
+
+// ===== Unit table =====
+
+struct UnitSpec {
+  const char16_t *alias; // Lower case; lookups fold ASCII case
+  const char *canonical;
+  const char *category;
+  double factor; // Base units per unit
+  double offset; // Added before scaling (Celsius, Fahrenheit)
+  Dimension dim;
+};
+
+// Factors are exact definitions where one exists (1 mile = 1609.344 m)
+constexpr UnitSpec kUnits[] = {
+    // ===== LENGTH (base: meter) =====
+    {u"mm", "millimeter", "length", 0.001, 0, Length},
+    {u"millimeter", "millimeter", "length", 0.001, 0, Length},
+    {u"millimeters", "millimeter", "length", 0.001, 0, Length},
+    {u"cm", "centimeter", "length", 0.01, 0, Length},
+    {u"centimeter", "centimeter", "length", 0.01, 0, Length},
+    {u"centimeters", "centimeter", "length", 0.01, 0, Length},
+    {u"m", "meter", "length", 1.0, 0, Length},
+    {u"meter", "meter", "length", 1.0, 0, Length},
+    {u"meters", "meter", "length", 1.0, 0, Length},
+    {u"km", "kilometer", "length", 1000.0, 0, Length},
+    {u"kilometer", "kilometer", "length", 1000.0, 0, Length},
+    {u"kilometers", "kilometer", "length", 1000.0, 0, Length},
+    {u"inch", "inch", "length", 0.0254, 0, Length},
+    {u"inches", "inch", "length", 0.0254, 0, Length},
+    {u"in", "inch", "length", 0.0254, 0, Length},
+    {u"foot", "foot", "length", 0.3048, 0, Length},
+    {u"feet", "foot", "length", 0.3048, 0, Length},
+    {u"ft", "foot", "length", 0.3048, 0, Length},
+    {u"yard", "yard", "length", 0.9144, 0, Length},
+    {u"yards", "yard", "length", 0.9144, 0, Length},
+    {u"yd", "yard", "length", 0.9144, 0, Length},
+    {u"mile", "mile", "length", 1609.344, 0, Length},
+    {u"miles", "mile", "length", 1609.344, 0, Length},
+    {u"mi", "mile", "length", 1609.344, 0, Length},
+    {u"nm", "nautical mile", "length", 1852.0, 0, Length},
+    {u"nauticalmile", "nautical mile", "length", 1852.0, 0, Length},
+
+    // ===== MASS (base: kilogram) =====
+    {u"mg", "milligram", "mass", 0.000001, 0, Mass},
+    {u"milligram", "milligram", "mass", 0.000001, 0, Mass},
+    {u"milligrams", "milligram", "mass", 0.000001, 0, Mass},
+    {u"g", "gram", "mass", 0.001, 0, Mass},
+    {u"gram", "gram", "mass", 0.001, 0, Mass},
+    {u"grams", "gram", "mass", 0.001, 0, Mass},
+    {u"kg", "kilogram", "mass", 1.0, 0, Mass},
+    {u"kilogram", "kilogram", "mass", 1.0, 0, Mass},
+    {u"kilograms", "kilogram", "mass", 1.0, 0, Mass},
+    {u"ton", "metric ton", "mass", 1000.0, 0, Mass},
+    {u"tons", "metric ton", "mass", 1000.0, 0, Mass},
+    {u"tonne", "metric ton", "mass", 1000.0, 0, Mass},
+    {u"oz", "ounce", "mass", 0.028349523125, 0, Mass},
+    {u"ounce", "ounce", "mass", 0.028349523125, 0, Mass},
+    {u"ounces", "ounce", "mass", 0.028349523125, 0, Mass},
+    {u"lb", "pound", "mass", 0.45359237, 0, Mass},
+    {u"lbs", "pound", "mass", 0.45359237, 0, Mass},
+    {u"pound", "pound", "mass", 0.45359237, 0, Mass},
+    {u"pounds", "pound", "mass", 0.45359237, 0, Mass},
+    {u"stone", "stone", "mass", 6.35029318, 0, Mass},
+    {u"stones", "stone", "mass", 6.35029318, 0, Mass},
+
+    // ===== TEMPERATURE (base: kelvin) =====
+    {u"c", "celsius", "temperature", 1.0, 273.15, Temperature},
+    {u"celsius", "celsius", "temperature", 1.0, 273.15, Temperature},
+    {u"°c", "celsius", "temperature", 1.0, 273.15, Temperature},
+    {u"f", "fahrenheit", "temperature", 5.0 / 9.0, 459.67, Temperature},
+    {u"fahrenheit", "fahrenheit", "temperature", 5.0 / 9.0, 459.67,
+     Temperature},
+    {u"°f", "fahrenheit", "temperature", 5.0 / 9.0, 459.67, Temperature},
+    {u"k", "kelvin", "temperature", 1.0, 0, Temperature},
+    {u"kelvin", "kelvin", "temperature", 1.0, 0, Temperature},
+
+    // ===== COMPUTING STORAGE (base: byte) =====
+    {u"bit", "bit", "storage", 0.125, 0, Data},
+    {u"bits", "bit", "storage", 0.125, 0, Data},
+    {u"byte", "byte", "storage", 1.0, 0, Data},
+    {u"bytes", "byte", "storage", 1.0, 0, Data},
+    {u"b", "byte", "storage", 1.0, 0, Data},
+    {u"kb", "kilobyte", "storage", 1024.0, 0, Data},
+    {u"kilobyte", "kilobyte", "storage", 1024.0, 0, Data},
+    {u"kilobytes", "kilobyte", "storage", 1024.0, 0, Data},
+    {u"mb", "megabyte", "storage", 1048576.0, 0, Data},
+    {u"megabyte", "megabyte", "storage", 1048576.0, 0, Data},
+    {u"megabytes", "megabyte", "storage", 1048576.0, 0, Data},
+    {u"gb", "gigabyte", "storage", 1073741824.0, 0, Data},
+    {u"gigabyte", "gigabyte", "storage", 1073741824.0, 0, Data},
+    {u"gigabytes", "gigabyte", "storage", 1073741824.0, 0, Data},
+    {u"tb", "terabyte", "storage", 1099511627776.0, 0, Data},
+    {u"terabyte", "terabyte", "storage", 1099511627776.0, 0, Data},
+    {u"terabytes", "terabyte", "storage", 1099511627776.0, 0, Data},
+    {u"pb", "petabyte", "storage", 1125899906842624.0, 0, Data},
+    {u"petabyte", "petabyte", "storage", 1125899906842624.0, 0, Data},
+    {u"petabytes", "petabyte", "storage", 1125899906842624.0, 0, Data},
+
+    // ===== DATA RATE (base: byte per second, decimal prefixes) =====
+    {u"bps", "bits per second", "data rate", 0.125, 0, DataRate},
+    {u"kbps", "kilobits per second", "data rate", 125.0, 0, DataRate},
+    {u"mbps", "megabits per second", "data rate", 125000.0, 0, DataRate},
+    {u"gbps", "gigabits per second", "data rate", 125000000.0, 0, DataRate},
+
+    // ===== VOLUME (base: cubic meter) =====
+    {u"ml", "milliliter", "volume", 0.000001, 0, Volume},
+    {u"milliliter", "milliliter", "volume", 0.000001, 0, Volume},
+    {u"milliliters", "milliliter", "volume", 0.000001, 0, Volume},
+    {u"l", "liter", "volume", 0.001, 0, Volume},
+    {u"liter", "liter", "volume", 0.001, 0, Volume},
+    {u"liters", "liter", "volume", 0.001, 0, Volume},
+    {u"litre", "liter", "volume", 0.001, 0, Volume},
+    {u"litres", "liter", "volume", 0.001, 0, Volume},
+    {u"gal", "gallon", "volume", 0.003785411784, 0, Volume},
+    {u"gallon", "gallon", "volume", 0.003785411784, 0, Volume},
+    {u"gallons", "gallon", "volume", 0.003785411784, 0, Volume},
+    {u"quart", "quart", "volume", 0.000946352946, 0, Volume},
+    {u"quarts", "quart", "volume", 0.000946352946, 0, Volume},
+    {u"qt", "quart", "volume", 0.000946352946, 0, Volume},
+    {u"cup", "cup", "volume", 0.0002365882365, 0, Volume},
+    {u"cups", "cup", "volume", 0.0002365882365, 0, Volume},
+    {u"pint", "pint", "volume", 0.000473176473, 0, Volume},
+    {u"pints", "pint", "volume", 0.000473176473, 0, Volume},
+    {u"pt", "pint", "volume", 0.000473176473, 0, Volume},
+    {u"floz", "fluid ounce", "volume", 0.0000295735295625, 0, Volume},
+    {u"fl oz", "fluid ounce", "volume", 0.0000295735295625, 0, Volume},
+
+    // ===== AREA (base: square meter) =====
+    {u"sqm", "square meter", "area", 1.0, 0, Area},
+    {u"m2", "square meter", "area", 1.0, 0, Area},
+    {u"m²", "square meter", "area", 1.0, 0, Area},
+    {u"sqkm", "square kilometer", "area", 1000000.0, 0, Area},
+    {u"km2", "square kilometer", "area", 1000000.0, 0, Area},
+    {u"km²", "square kilometer", "area", 1000000.0, 0, Area},
+    {u"sqft", "square foot", "area", 0.09290304, 0, Area},
+    {u"ft2", "square foot", "area", 0.09290304, 0, Area},
+    {u"ft²", "square foot", "area", 0.09290304, 0, Area},
+    {u"acre", "acre", "area", 4046.8564224, 0, Area},
+    {u"acres", "acre", "area", 4046.8564224, 0, Area},
+    {u"hectare", "hectare", "area", 10000.0, 0, Area},
+    {u"hectares", "hectare", "area", 10000.0, 0, Area},
+    {u"ha", "hectare", "area", 10000.0, 0, Area},
+
+    // ===== SPEED (base: m/s) =====
+    {u"mps", "meters per second", "speed", 1.0, 0, Speed},
+    {u"kmh", "kilometers per hour", "speed", 1000.0 / 3600.0, 0, Speed},
+    {u"kph", "kilometers per hour", "speed", 1000.0 / 3600.0, 0, Speed},
+    {u"mph", "miles per hour", "speed", 0.44704, 0, Speed},
+    {u"knot", "knot", "speed", 1852.0 / 3600.0, 0, Speed},
+    {u"knots", "knot", "speed", 1852.0 / 3600.0, 0, Speed},
+    {u"mach", "mach", "speed", 343.0, 0, Speed},
+
+    // ===== TIME (base: second) =====
+    {u"ms", "millisecond", "time", 0.001, 0, Time},
+    {u"millisecond", "millisecond", "time", 0.001, 0, Time},
+    {u"milliseconds", "millisecond", "time", 0.001, 0, Time},
+    {u"s", "second", "time", 1.0, 0, Time},
+    {u"sec", "second", "time", 1.0, 0, Time},
+    {u"second", "second", "time", 1.0, 0, Time},
+    {u"seconds", "second", "time", 1.0, 0, Time},
+    {u"min", "minute", "time", 60.0, 0, Time},
+    {u"minute", "minute", "time", 60.0, 0, Time},
+    {u"minutes", "minute", "time", 60.0, 0, Time},
+    {u"h", "hour", "time", 3600.0, 0, Time},
+    {u"hour", "hour", "time", 3600.0, 0, Time},
+    {u"hours", "hour", "time", 3600.0, 0, Time},
+    {u"hr", "hour", "time", 3600.0, 0, Time},
+    {u"day", "day", "time", 86400.0, 0, Time},
+    {u"days", "day", "time", 86400.0, 0, Time},
+    {u"week", "week", "time", 604800.0, 0, Time},
+    {u"weeks", "week", "time", 604800.0, 0, Time},
+    {u"month", "month", "time", 2629746.0, 0, Time}, // Average month
+    {u"months", "month", "time", 2629746.0, 0, Time},
+    {u"year", "year", "time", 31556952.0, 0, Time}, // Average year
+    {u"years", "year", "time", 31556952.0, 0, Time},
+    {u"yr", "year", "time", 31556952.0, 0, Time},
+
+    // ===== ENERGY (base: joule) =====
+    {u"j", "joule", "energy", 1.0, 0, Energy},
+    {u"joule", "joule", "energy", 1.0, 0, Energy},
+    {u"joules", "joule", "energy", 1.0, 0, Energy},
+    {u"kj", "kilojoule", "energy", 1000.0, 0, Energy},
+    {u"cal", "calorie", "energy", 4.184, 0, Energy},
+    {u"kcal", "kilocalorie", "energy", 4184.0, 0, Energy},
+    {u"wh", "watt hour", "energy", 3600.0, 0, Energy},
+    {u"kwh", "kilowatt hour", "energy", 3600000.0, 0, Energy},
+
+    // ===== POWER (base: watt) =====
+    {u"w", "watt", "power", 1.0, 0, Power},
+    {u"watt", "watt", "power", 1.0, 0, Power},
+    {u"watts", "watt", "power", 1.0, 0, Power},
+    {u"kw", "kilowatt", "power", 1000.0, 0, Power},
+    {u"hp", "horsepower", "power", 745.69987158227022, 0, Power},
+
+    // ===== FORCE AND PRESSURE (base: newton, pascal) =====
+    {u"n", "newton", "force", 1.0, 0, Force},
+    {u"newton", "newton", "force", 1.0, 0, Force},
+    {u"newtons", "newton", "force", 1.0, 0, Force},
+    {u"pa", "pascal", "pressure", 1.0, 0, Pressure},
+    {u"kpa", "kilopascal", "pressure", 1000.0, 0, Pressure},
+    {u"bar", "bar", "pressure", 100000.0, 0, Pressure},
+    {u"psi", "psi", "pressure", 6894.757293168, 0, Pressure},
+    {u"atm", "atmosphere", "pressure", 101325.0, 0, Pressure},
+};
+
+constexpr int kUnitCount = sizeof(kUnits) / sizeof(kUnits[0]);
+
+// ===== Perfect hash over aliases =====
+
+constexpr char16_t foldCase(char16_t ch) {
+  return (ch >= u'A' && ch <= u'Z') ? char16_t(ch + (u'a' - u'A')) : ch;
 }
 
-UnitConverter::UnitConverter() { initUnits(); }
-
-void UnitConverter::initUnits() {
-  // ===== LENGTH (base: meter) =====
-  QMap<QString, UnitDef> length;
-  length["mm"] = {"millimeter", 0.001, 1000, false, 0};
-  length["millimeter"] = {"millimeter", 0.001, 1000, false, 0};
-  length["millimeters"] = {"millimeter", 0.001, 1000, false, 0};
-  length["cm"] = {"centimeter", 0.01, 100, false, 0};
-  length["centimeter"] = {"centimeter", 0.01, 100, false, 0};
-  length["centimeters"] = {"centimeter", 0.01, 100, false, 0};
-  length["m"] = {"meter", 1.0, 1.0, false, 0};
-  length["meter"] = {"meter", 1.0, 1.0, false, 0};
-  length["meters"] = {"meter", 1.0, 1.0, false, 0};
-  length["km"] = {"kilometer", 1000.0, 0.001, false, 0};
-  length["kilometer"] = {"kilometer", 1000.0, 0.001, false, 0};
-  length["kilometers"] = {"kilometer", 1000.0, 0.001, false, 0};
-  length["inch"] = {"inch", 0.0254, 39.3701, false, 0};
-  length["inches"] = {"inch", 0.0254, 39.3701, false, 0};
-  length["in"] = {"inch", 0.0254, 39.3701, false, 0};
-  length["foot"] = {"foot", 0.3048, 3.28084, false, 0};
-  length["feet"] = {"foot", 0.3048, 3.28084, false, 0};
-  length["ft"] = {"foot", 0.3048, 3.28084, false, 0};
-  length["yard"] = {"yard", 0.9144, 1.09361, false, 0};
-  length["yards"] = {"yard", 0.9144, 1.09361, false, 0};
-  length["yd"] = {"yard", 0.9144, 1.09361, false, 0};
-  length["mile"] = {"mile", 1609.34, 0.000621371, false, 0};
-  length["miles"] = {"mile", 1609.34, 0.000621371, false, 0};
-  length["mi"] = {"mile", 1609.34, 0.000621371, false, 0};
-  length["nm"] = {"nautical mile", 1852.0, 0.000539957, false, 0};
-  length["nauticalmile"] = {"nautical mile", 1852.0, 0.000539957, false, 0};
-  m_units["length"] = length;
-
-  // ===== MASS (base: kilogram) =====
-  QMap<QString, UnitDef> mass;
-  mass["mg"] = {"milligram", 0.000001, 1000000, false, 0};
-  mass["milligram"] = {"milligram", 0.000001, 1000000, false, 0};
-  mass["milligrams"] = {"milligram", 0.000001, 1000000, false, 0};
-  mass["g"] = {"gram", 0.001, 1000, false, 0};
-  mass["gram"] = {"gram", 0.001, 1000, false, 0};
-  mass["grams"] = {"gram", 0.001, 1000, false, 0};
-  mass["kg"] = {"kilogram", 1.0, 1.0, false, 0};
-  mass["kilogram"] = {"kilogram", 1.0, 1.0, false, 0};
-  mass["kilograms"] = {"kilogram", 1.0, 1.0, false, 0};
-  mass["ton"] = {"metric ton", 1000.0, 0.001, false, 0};
-  mass["tons"] = {"metric ton", 1000.0, 0.001, false, 0};
-  mass["tonne"] = {"metric ton", 1000.0, 0.001, false, 0};
-  mass["oz"] = {"ounce", 0.0283495, 35.274, false, 0};
-  mass["ounce"] = {"ounce", 0.0283495, 35.274, false, 0};
-  mass["ounces"] = {"ounce", 0.0283495, 35.274, false, 0};
-  mass["lb"] = {"pound", 0.453592, 2.20462, false, 0};
-  mass["lbs"] = {"pound", 0.453592, 2.20462, false, 0};
-  mass["pound"] = {"pound", 0.453592, 2.20462, false, 0};
-  mass["pounds"] = {"pound", 0.453592, 2.20462, false, 0};
-  mass["stone"] = {"stone", 6.35029, 0.157473, false, 0};
-  mass["stones"] = {"stone", 6.35029, 0.157473, false, 0};
-  m_units["mass"] = mass;
-
-  // ===== TEMPERATURE (base: kelvin) =====
-  QMap<QString, UnitDef> temp;
-  temp["c"] = {"celsius", 0, 0, true, 273.15};
-  temp["celsius"] = {"celsius", 0, 0, true, 273.15};
-  temp["°c"] = {"celsius", 0, 0, true, 273.15};
-  temp["f"] = {"fahrenheit", 0, 0, true, 0}; // Special handling
-  temp["fahrenheit"] = {"fahrenheit", 0, 0, true, 0};
-  temp["°f"] = {"fahrenheit", 0, 0, true, 0};
-  temp["k"] = {"kelvin", 1, 1, false, 0};
-  temp["kelvin"] = {"kelvin", 1, 1, false, 0};
-  m_units["temperature"] = temp;
-
-  // ===== COMPUTING STORAGE (base: byte) =====
-  QMap<QString, UnitDef> storage;
-  storage["bit"] = {"bit", 0.125, 8, false, 0};
-  storage["bits"] = {"bit", 0.125, 8, false, 0};
-  storage["byte"] = {"byte", 1.0, 1.0, false, 0};
-  storage["bytes"] = {"byte", 1.0, 1.0, false, 0};
-  storage["b"] = {"byte", 1.0, 1.0, false, 0};
-  storage["kb"] = {"kilobyte", 1024.0, 1.0 / 1024.0, false, 0};
-  storage["kilobyte"] = {"kilobyte", 1024.0, 1.0 / 1024.0, false, 0};
-  storage["kilobytes"] = {"kilobyte", 1024.0, 1.0 / 1024.0, false, 0};
-  storage["mb"] = {"megabyte", 1048576.0, 1.0 / 1048576.0, false, 0};
-  storage["megabyte"] = {"megabyte", 1048576.0, 1.0 / 1048576.0, false, 0};
-  storage["megabytes"] = {"megabyte", 1048576.0, 1.0 / 1048576.0, false, 0};
-  storage["gb"] = {"gigabyte", 1073741824.0, 1.0 / 1073741824.0, false, 0};
-  storage["gigabyte"] = {"gigabyte", 1073741824.0, 1.0 / 1073741824.0, false,
-                         0};
-  storage["gigabytes"] = {"gigabyte", 1073741824.0, 1.0 / 1073741824.0, false,
-                          0};
-  storage["tb"] = {"terabyte", 1099511627776.0, 1.0 / 1099511627776.0, false,
-                   0};
-  storage["terabyte"] = {"terabyte", 1099511627776.0, 1.0 / 1099511627776.0,
-                         false, 0};
-  storage["terabytes"] = {"terabyte", 1099511627776.0, 1.0 / 1099511627776.0,
-                          false, 0};
-  storage["pb"] = {"petabyte", 1125899906842624.0, 1.0 / 1125899906842624.0,
-                   false, 0};
-  storage["petabyte"] = {"petabyte", 1125899906842624.0,
-                         1.0 / 1125899906842624.0, false, 0};
-  storage["petabytes"] = {"petabyte", 1125899906842624.0,
-                          1.0 / 1125899906842624.0, false, 0};
-  m_units["storage"] = storage;
-
-  // ===== VOLUME (base: liter) =====
-  QMap<QString, UnitDef> volume;
-  volume["ml"] = {"milliliter", 0.001, 1000, false, 0};
-  volume["milliliter"] = {"milliliter", 0.001, 1000, false, 0};
-  volume["milliliters"] = {"milliliter", 0.001, 1000, false, 0};
-  volume["l"] = {"liter", 1.0, 1.0, false, 0};
-  volume["liter"] = {"liter", 1.0, 1.0, false, 0};
-  volume["liters"] = {"liter", 1.0, 1.0, false, 0};
-  volume["litre"] = {"liter", 1.0, 1.0, false, 0};
-  volume["litres"] = {"liter", 1.0, 1.0, false, 0};
-  volume["gal"] = {"gallon", 3.78541, 0.264172, false, 0};
-  volume["gallon"] = {"gallon", 3.78541, 0.264172, false, 0};
-  volume["gallons"] = {"gallon", 3.78541, 0.264172, false, 0};
-  volume["cup"] = {"cup", 0.236588, 4.22675, false, 0};
-  volume["cups"] = {"cup", 0.236588, 4.22675, false, 0};
-  volume["pint"] = {"pint", 0.473176, 2.11338, false, 0};
-  volume["pints"] = {"pint", 0.473176, 2.11338, false, 0};
-  volume["pt"] = {"pint", 0.473176, 2.11338, false, 0};
-  volume["floz"] = {"fluid ounce", 0.0295735, 33.814, false, 0};
-  volume["fl oz"] = {"fluid ounce", 0.0295735, 33.814, false, 0};
-  m_units["volume"] = volume;
-
-  // ===== AREA (base: square meter) =====
-  QMap<QString, UnitDef> area;
-  area["sqm"] = {"square meter", 1.0, 1.0, false, 0};
-  area["m2"] = {"square meter", 1.0, 1.0, false, 0};
-  area["m²"] = {"square meter", 1.0, 1.0, false, 0};
-  area["sqkm"] = {"square kilometer", 1000000.0, 0.000001, false, 0};
-  area["km2"] = {"square kilometer", 1000000.0, 0.000001, false, 0};
-  area["km²"] = {"square kilometer", 1000000.0, 0.000001, false, 0};
-  area["sqft"] = {"square foot", 0.092903, 10.7639, false, 0};
-  area["ft2"] = {"square foot", 0.092903, 10.7639, false, 0};
-  area["ft²"] = {"square foot", 0.092903, 10.7639, false, 0};
-  area["acre"] = {"acre", 4046.86, 0.000247105, false, 0};
-  area["acres"] = {"acre", 4046.86, 0.000247105, false, 0};
-  area["hectare"] = {"hectare", 10000.0, 0.0001, false, 0};
-  area["hectares"] = {"hectare", 10000.0, 0.0001, false, 0};
-  area["ha"] = {"hectare", 10000.0, 0.0001, false, 0};
-  m_units["area"] = area;
-
-  // ===== SPEED (base: m/s) =====
-  QMap<QString, UnitDef> speed;
-  speed["m/s"] = {"meters per second", 1.0, 1.0, false, 0};
-  speed["mps"] = {"meters per second", 1.0, 1.0, false, 0};
-  speed["km/h"] = {"kilometers per hour", 0.277778, 3.6, false, 0};
-  speed["kmh"] = {"kilometers per hour", 0.277778, 3.6, false, 0};
-  speed["kph"] = {"kilometers per hour", 0.277778, 3.6, false, 0};
-  speed["mph"] = {"miles per hour", 0.44704, 2.23694, false, 0};
-  speed["knot"] = {"knot", 0.514444, 1.94384, false, 0};
-  speed["knots"] = {"knot", 0.514444, 1.94384, false, 0};
-  speed["mach"] = {"mach", 343.0, 0.00291545, false, 0};
-  m_units["speed"] = speed;
-
-  // ===== TIME (base: second) =====
-  QMap<QString, UnitDef> time;
-  time["ms"] = {"millisecond", 0.001, 1000, false, 0};
-  time["millisecond"] = {"millisecond", 0.001, 1000, false, 0};
-  time["milliseconds"] = {"millisecond", 0.001, 1000, false, 0};
-  time["s"] = {"second", 1.0, 1.0, false, 0};
-  time["sec"] = {"second", 1.0, 1.0, false, 0};
-  time["second"] = {"second", 1.0, 1.0, false, 0};
-  time["seconds"] = {"second", 1.0, 1.0, false, 0};
-  time["min"] = {"minute", 60.0, 1.0 / 60.0, false, 0};
-  time["minute"] = {"minute", 60.0, 1.0 / 60.0, false, 0};
-  time["minutes"] = {"minute", 60.0, 1.0 / 60.0, false, 0};
-  time["hour"] = {"hour", 3600.0, 1.0 / 3600.0, false, 0};
-  time["hours"] = {"hour", 3600.0, 1.0 / 3600.0, false, 0};
-  time["hr"] = {"hour", 3600.0, 1.0 / 3600.0, false, 0};
-  time["day"] = {"day", 86400.0, 1.0 / 86400.0, false, 0};
-  time["days"] = {"day", 86400.0, 1.0 / 86400.0, false, 0};
-  time["week"] = {"week", 604800.0, 1.0 / 604800.0, false, 0};
-  time["weeks"] = {"week", 604800.0, 1.0 / 604800.0, false, 0};
-  time["month"] = {"month", 2629746.0, 1.0 / 2629746.0, false,
-                   0}; // Average month
-  time["months"] = {"month", 2629746.0, 1.0 / 2629746.0, false, 0};
-  time["year"] = {"year", 31556952.0, 1.0 / 31556952.0, false,
-                  0}; // Average year
-  time["years"] = {"year", 31556952.0, 1.0 / 31556952.0, false, 0};
-  time["yr"] = {"year", 31556952.0, 1.0 / 31556952.0, false, 0};
-  m_units["time"] = time;
-
-  // Build alias->category map
-  for (auto it = m_units.constBegin(); it != m_units.constEnd(); ++it) {
-    QString category = it.key();
-    for (auto uit = it.value().constBegin(); uit != it.value().constEnd();
-         ++uit) {
-      m_aliasToCategory[uit.key().toLower()] = category;
-    }
+constexpr int aliasLength(const char16_t *s) {
+  int len = 0;
+  while (s[len])
+    ++len;
+  return len;
+}
+
+constexpr quint32 hashAlias(const char16_t *s, int len, quint32 seed) {
+  quint32 h = 2166136261u ^ (seed * 0x9E3779B1u);
+  for (int i = 0; i < len; ++i) {
+    h ^= foldCase(s[i]);
+    h *= 16777619u;
   }
+  // Final mix so nearby seeds give unrelated slots
+  h ^= h >> 15;
+  h *= 0x85EBCA6Bu;
+  h ^= h >> 13;
+  return h;
 }
 
-bool UnitConverter::isConversion(const QString &line) const {
-  ParsedConversion parsed = parse(line);
-  return parsed.valid;
+constexpr int kBucketCount = 128;
+constexpr int kSlotCount = 512; // Power of two, at least twice kUnitCount
+static_assert(kSlotCount >= 2 * kUnitCount, "alias table too full");
+
+// Hash-and-displace table built by the compiler: each alias lands in its own
+// slot, so a lookup is two hashes and one string compare
+struct AliasTable {
+  quint16 displacement[kBucketCount];
+  qint16 slots[kSlotCount];
+  bool complete;
+
+  constexpr AliasTable() : displacement(), slots(), complete(true) {
+    for (int i = 0; i < kSlotCount; ++i)
+      slots[i] = -1;
+
+    // Group unit indices by first-level bucket (counting sort)
+    int bucketOf[kUnitCount] = {};
+    int bucketStart[kBucketCount + 1] = {};
+    for (int k = 0; k < kUnitCount; ++k) {
+      const char16_t *alias = kUnits[k].alias;
+      bucketOf[k] = hashAlias(alias, aliasLength(alias), 0) % kBucketCount;
+      bucketStart[bucketOf[k] + 1]++;
+    }
+    for (int b = 0; b < kBucketCount; ++b)
+      bucketStart[b + 1] += bucketStart[b];
+    int members[kUnitCount] = {};
+    int fill[kBucketCount] = {};
+    for (int k = 0; k < kUnitCount; ++k)
+      members[bucketStart[bucketOf[k]] + fill[bucketOf[k]]++] = k;
+
+    // Place the largest buckets first while the table is still empty
+    bool placedBucket[kBucketCount] = {};
+    for (int pass = 0; pass < kBucketCount; ++pass) {
+      int bucket = -1;
+      int size = 0;
+      for (int b = 0; b < kBucketCount; ++b) {
+        int bSize = bucketStart[b + 1] - bucketStart[b];
+        if (!placedBucket[b] && (bucket < 0 || bSize > size)) {
+          bucket = b;
+          size = bSize;
+        }
+      }
+      placedBucket[bucket] = true;
+      if (size == 0)
+        break;
+
+      bool found = false;
+      for (quint32 seed = 1; seed < 0xFFFF && !found; ++seed) {
+        int chosen[kUnitCount] = {};
+        bool fits = true;
+        for (int i = 0; i < size && fits; ++i) {
+          const char16_t *alias = kUnits[members[bucketStart[bucket] + i]].alias;
+          int slot =
+              hashAlias(alias, aliasLength(alias), seed) & (kSlotCount - 1);
+          if (slots[slot] != -1)
+            fits = false;
+          for (int c = 0; c < i && fits; ++c) {
+            if (chosen[c] == slot)
+              fits = false;
+          }
+          chosen[i] = slot;
+        }
+        if (!fits)
+          continue;
+
+        for (int i = 0; i < size; ++i)
+          slots[chosen[i]] = qint16(members[bucketStart[bucket] + i]);
+        displacement[bucket] = quint16(seed);
+        found = true;
+      }
+      if (!found)
+        complete = false; // Duplicate alias in kUnits
+    }
+  }
+};
+
+constexpr AliasTable kAliasTable;
+static_assert(kAliasTable.complete, "kUnits contains a duplicate alias");
+
+const UnitSpec *lookupUnit(QStringView name) {
+  const char16_t *text = name.utf16();
+  int len = int(name.size());
+  if (len == 0)
+    return nullptr;
+
+  int bucket = hashAlias(text, len, 0) % kBucketCount;
+  quint32 seed = kAliasTable.displacement[bucket];
+  if (seed == 0)
+    return nullptr;
+
+  int index = kAliasTable.slots[hashAlias(text, len, seed) & (kSlotCount - 1)];
+  if (index < 0)
+    return nullptr;
+
+  const UnitSpec &spec = kUnits[index];
+  for (int i = 0; i < len; ++i) {
+    if (spec.alias[i] == 0 || foldCase(text[i]) != spec.alias[i])
+      return nullptr;
+  }
+  return spec.alias[len] == 0 ? &spec : nullptr;
 }
 
-UnitConverter::ParsedConversion
-UnitConverter::parse(const QString &line) const {
-  ParsedConversion result = {0, "", "", false};
-
-  // Pattern: <number> <unit> to <unit>
-  // Also supports: <number><unit> to <unit>, <number> <unit> in <unit>
-  // Unit can include letters, digits (for m2, km2), and special chars (°, ², /)
-  // Pattern supports multi-word units like "fl oz"
-  static QRegularExpression pattern(
-      R"(^\s*(-?[\d.,]+)\s*([a-zA-Z°²/0-9]+(?:\s+[a-zA-Z°²/0-9]+)?)\s+(?:to|in|as)\s+([a-zA-Z°²/0-9]+(?:\s+[a-zA-Z°²/0-9]+)?)\s*$)",
-      QRegularExpression::CaseInsensitiveOption);
-
-  QRegularExpressionMatch match = pattern.match(line.trimmed());
-  if (!match.hasMatch()) {
-    return result;
+// ===== Unit expressions =====
+
+// A parsed side of a conversion: number * factor, in base units
+struct Quantity {
+  double number = 1.0;
+  double factor = 1.0;
+  Dimension dim = None;
+  int unitCount = 0;
+  bool simple = true;          // Only plain units multiplied together
+  bool hasOffsetUnit = false;  // Uses Celsius or Fahrenheit
+  const UnitSpec *unit = nullptr; // Set while it is exactly one plain unit
+
+  void multiply(const Quantity &o) {
+    number *= o.number;
+    factor *= o.factor;
+    dim = dim + o.dim;
+    simple = simple && o.simple;
+    unit = (unitCount + o.unitCount == 1) ? (unit ? unit : o.unit) : nullptr;
+    unitCount += o.unitCount;
+    hasOffsetUnit = hasOffsetUnit || o.hasOffsetUnit;
   }
 
-  QString valueStr = match.captured(1);
-  valueStr.replace(',', '.');
-  bool ok;
-  double value = valueStr.toDouble(&ok);
-  if (!ok) {
-    return result;
+  void divide(const Quantity &o) {
+    number /= o.number;
+    factor /= o.factor;
+    dim = dim - o.dim;
+    simple = simple && o.simple && o.unitCount == 0;
+    unit = o.unitCount == 0 ? unit : nullptr;
+    unitCount += o.unitCount;
+    hasOffsetUnit = hasOffsetUnit || o.hasOffsetUnit;
   }
 
-  QString fromUnit = match.captured(2).toLower();
-  QString toUnit = match.captured(3).toLower();
+  void raise(int power) {
+    number = qPow(number, power);
+    factor = qPow(factor, power);
+    dim = dim * power;
+    if (power != 1 && unitCount > 0) {
+      simple = false;
+      unit = nullptr;
+    }
+  }
 
-  // Check if both units exist
-  if (!m_aliasToCategory.contains(fromUnit) ||
-      !m_aliasToCategory.contains(toUnit)) {
-    return result;
+  // The unit to apply an offset with, if this is "<number> <unit>"
+  const UnitSpec *soleUnit() const {
+    return (simple && unitCount == 1) ? unit : nullptr;
+  }
+};
+
+/**
+ * Recursive descent over one side of a conversion:
+ *   expression := term (('*' | '/') term)*
+ *   term       := factor+            (juxtaposition binds tighter: 3 GB / 20 s)
+ *   factor     := ['-'] number | unit [power] | '(' expression ')' [power]
+ */
+class UnitExpressionParser {
+public:
+  UnitExpressionParser(QStringView text, bool allowNumbers)
+      : m_text(text), m_pos(0), m_allowNumbers(allowNumbers) {}
+
+  bool parse(Quantity &out) {
+    if (!parseExpression(out))
+      return false;
+    skipSpaces();
+    return m_pos == m_text.size() && out.unitCount > 0;
   }
 
-  // Check if both units are in the same category
-  if (m_aliasToCategory[fromUnit] != m_aliasToCategory[toUnit]) {
-    return result;
+private:
+  bool parseExpression(Quantity &out) {
+    if (!parseTerm(out))
+      return false;
+    while (true) {
+      skipSpaces();
+      if (atEnd())
+        return true;
+      QChar op = m_text[m_pos];
+      if (op != '*' && op != '/')
+        return true;
+      m_pos++;
+      Quantity rhs;
+      if (!parseTerm(rhs))
+        return false;
+      if (op == '*')
+        out.multiply(rhs);
+      else
+        out.divide(rhs);
+    }
   }
 
-  result.value = value;
-  result.fromUnit = fromUnit;
-  result.toUnit = toUnit;
-  result.valid = true;
-  return result;
-}
+  bool parseTerm(Quantity &out) {
+    if (!parseFactor(out))
+      return false;
+    while (true) {
+      skipSpaces();
+      if (atEnd() || !startsFactor(m_text[m_pos]))
+        return true;
+      Quantity next;
+      if (!parseFactor(next))
+        return false;
+      out.multiply(next);
+    }
+  }
 
-QString UnitConverter::convert(const QString &line) const {
-  ParsedConversion parsed = parse(line);
-  if (!parsed.valid) {
-    return QString();
+  bool parseFactor(Quantity &out) {
+    skipSpaces();
+    if (atEnd())
+      return false;
+
+    QChar ch = m_text[m_pos];
+    if (ch == '(') {
+      m_pos++;
+      if (!parseExpression(out))
+        return false;
+      skipSpaces();
+      if (atEnd() || m_text[m_pos] != ')')
+        return false;
+      m_pos++;
+      return parsePower(out);
+    }
+
+    if (ch.isDigit() || ch == '.' || ch == '-')
+      return m_allowNumbers && parseNumber(out);
+
+    return parseUnit(out);
   }
 
-  QString category = m_aliasToCategory[parsed.fromUnit];
-  const QMap<QString, UnitDef> &units = m_units[category];
-  const UnitDef &fromDef = units[parsed.fromUnit];
-  const UnitDef &toDef = units[parsed.toUnit];
+  bool parseNumber(Quantity &out) {
+    bool negative = false;
+    if (m_text[m_pos] == '-') {
+      negative = true;
+      m_pos++;
+    }
+    qsizetype start = m_pos;
+    while (!atEnd() && (m_text[m_pos].isDigit() || m_text[m_pos] == '.' ||
+                        m_text[m_pos] == ','))
+      m_pos++;
+    if (m_pos == start)
+      return false;
+
+    // "1,5" and "1.5" both mean one and a half
+    QString digits = m_text.mid(start, m_pos - start).toString();
+    digits.replace(',', '.');
+    bool ok;
+    double value = digits.toDouble(&ok);
+    if (!ok)
+      return false;
+    out.number = negative ? -value : value;
+    return true;
+  }
 
-  double result;
+  bool parseUnit(Quantity &out) {
+    qsizetype start = m_pos;
+    while (!atEnd() && isUnitChar(m_text[m_pos], m_pos == start))
+      m_pos++;
+    if (m_pos == start)
+      return false;
+    QStringView name = m_text.mid(start, m_pos - start);
+
+    // Two-word aliases such as "fl oz"
+    qsizetype next = m_pos;
+    while (next < m_text.size() && m_text[next].isSpace())
+      next++;
+    if (next > m_pos && next < m_text.size() && isUnitChar(m_text[next], true)) {
+      qsizetype end = next;
+      while (end < m_text.size() && isUnitChar(m_text[end], end == next))
+        end++;
+      QString pair =
+          name.toString() + ' ' + m_text.mid(next, end - next).toString();
+      if (const UnitSpec *spec = lookupUnit(pair)) {
+        m_pos = end;
+        applyUnit(out, spec);
+        return parsePower(out);
+      }
+    }
 
-  // Special handling for temperature
-  if (category == "temperature") {
-    double kelvin;
-    // Convert to Kelvin first
-    if (fromDef.canonical == "celsius") {
-      kelvin = celsiusToKelvin(parsed.value);
-    } else if (fromDef.canonical == "fahrenheit") {
-      kelvin = fahrenheitToKelvin(parsed.value);
-    } else {
-      kelvin = parsed.value; // Already Kelvin
+    if (const UnitSpec *spec = lookupUnit(name)) {
+      applyUnit(out, spec);
+      return parsePower(out);
     }
 
-    // Convert from Kelvin to target
-    if (toDef.canonical == "celsius") {
-      result = kelvinToCelsius(kelvin);
-    } else if (toDef.canonical == "fahrenheit") {
-      result = kelvinToFahrenheit(kelvin);
-    } else {
-      result = kelvin;
+    // Power written as a suffix: cm3, m², s2
+    int power = 0;
+    QChar last = name.back();
+    if (last == QChar(0x00B2))
+      power = 2;
+    else if (last == QChar(0x00B3))
+      power = 3;
+    else if (last.isDigit())
+      power = last.digitValue();
+    if (power < 2 || name.size() < 2)
+      return false;
+
+    const UnitSpec *spec = lookupUnit(name.chopped(1));
+    if (!spec)
+      return false;
+    applyUnit(out, spec);
+    out.raise(power);
+    return parsePower(out);
+  }
+
+  bool parsePower(Quantity &out) {
+    skipSpaces();
+    if (atEnd() || m_text[m_pos] != '^')
+      return true;
+    m_pos++;
+    skipSpaces();
+    bool negative = false;
+    if (!atEnd() && m_text[m_pos] == '-') {
+      negative = true;
+      m_pos++;
     }
-  } else {
-    // Standard conversion: value -> base unit -> target unit
-    double baseValue = parsed.value * fromDef.toBase;
-    result = baseValue * toDef.fromBase;
+    if (atEnd() || !m_text[m_pos].isDigit())
+      return false;
+    int power = m_text[m_pos++].digitValue();
+    out.raise(negative ? -power : power);
+    return true;
+  }
+
+  static void applyUnit(Quantity &out, const UnitSpec *spec) {
+    out.factor = spec->factor;
+    out.dim = spec->dim;
+    out.unitCount = 1;
+    out.unit = spec;
+    out.hasOffsetUnit = spec->offset != 0;
+  }
+
+  static bool isUnitChar(QChar ch, bool first) {
+    if (ch.isLetter() || ch == QChar(0x00B0)) // °
+      return true;
+    return !first && (ch.isDigit() || ch == QChar(0x00B2) ||
+                      ch == QChar(0x00B3)); // ² ³
+  }
+
+  bool startsFactor(QChar ch) const {
+    return ch == '(' || isUnitChar(ch, true) ||
+           (m_allowNumbers && (ch.isDigit() || ch == '.'));
   }
 
-  // Format result nicely
-  QString resultStr;
+  void skipSpaces() {
+    while (!atEnd() && m_text[m_pos].isSpace())
+      m_pos++;
+  }
+
+  bool atEnd() const { return m_pos >= m_text.size(); }
+
+  QStringView m_text;
+  qsizetype m_pos;
+  bool m_allowNumbers;
+};
+
+// "to", "in" or "as" starting at pos
+bool isSeparatorAt(QStringView line, qsizetype pos) {
+  if (pos + 2 > line.size())
+    return false;
+  char16_t a = foldCase(line[pos].unicode());
+  char16_t b = foldCase(line[pos + 1].unicode());
+  return (a == u't' && b == u'o') || (a == u'i' && b == u'n') ||
+         (a == u'a' && b == u's');
+}
+
+QString formatResult(double result) {
   if (qAbs(result) >= 1000000 || (qAbs(result) < 0.001 && result != 0)) {
-    resultStr = QString::number(result, 'g', 6);
-  } else if (result == qFloor(result)) {
-    resultStr = QString::number(static_cast<long long>(result));
-  } else {
-    resultStr = QString::number(result, 'f', 4)
-                    .remove(QRegularExpression("0+$"))
-                    .remove(QRegularExpression("\\.$"));
+    return QString::number(result, 'g', 6);
+  }
+  if (result == qFloor(result)) {
+    return QString::number(static_cast<long long>(result));
   }
 
-  // Add target unit to result (e.g., "1000 meter")
-  return resultStr + " " + toDef.canonical;
+  QString text = QString::number(result, 'f', 4);
+  while (text.endsWith('0'))
+    text.chop(1);
+  if (text.endsWith('.'))
+    text.chop(1);
+  return text;
 }
 
-double UnitConverter::celsiusToKelvin(double c) const { return c + 273.15; }
+} // namespace
 
-double UnitConverter::kelvinToCelsius(double k) const { return k - 273.15; }
+UnitConverter *UnitConverter::instance() {
+  // Function-local static: initialization is thread-safe, the Math sheet
+  // worker may be first to ask
+  static UnitConverter instance;
+  return &instance;
+}
 
-double UnitConverter::fahrenheitToKelvin(double f) const {
-  return (f - 32.0) * 5.0 / 9.0 + 273.15;
+UnitConverter::UnitConverter() {}
+
+bool UnitConverter::isConversion(const QString &line) const {
+  double value;
+  QString unitName;
+  return evaluate(line, value, unitName);
 }
 
-double UnitConverter::kelvinToFahrenheit(double k) const {
-  return (k - 273.15) * 9.0 / 5.0 + 32.0;
+bool UnitConverter::evaluate(const QString &line, double &result,
+                             QString &unitName) const {
+  QStringView text = QStringView(line).trimmed();
+
+  // Must start with the amount: "5 km to mile", "-10 C to F", "3 GB / 20 s..."
+  if (text.isEmpty() || !(text[0].isDigit() || text[0] == '-' || text[0] == '.'))
+    return false;
+
+  // Try each " to " / " in " / " as " from the right, so "10 in to cm" reads
+  // the first "in" as inches
+  const qsizetype sepLength = 2;
+  for (qsizetype pos = text.size() - 3; pos > 0; --pos) {
+    if (!text[pos - 1].isSpace() || !isSeparatorAt(text, pos) ||
+        pos + sepLength >= text.size() || !text[pos + sepLength].isSpace())
+      continue;
+
+    Quantity source;
+    Quantity target;
+    if (!UnitExpressionParser(text.left(pos), true).parse(source) ||
+        !UnitExpressionParser(text.mid(pos + sepLength), false).parse(target))
+      continue;
+    if (source.dim != target.dim)
+      continue;
+
+    // Offset units (C, F) only make sense on their own
+    const UnitSpec *sourceUnit = source.soleUnit();
+    const UnitSpec *targetUnit = target.soleUnit();
+    if ((source.hasOffsetUnit && !sourceUnit) ||
+        (target.hasOffsetUnit && !targetUnit))
+      continue;
+
+    double base = sourceUnit
+                      ? (source.number + sourceUnit->offset) * source.factor
+                      : source.number * source.factor;
+    result = targetUnit ? base / target.factor - targetUnit->offset
+                        : base / target.factor;
+
+    // 32 F to C should read 0, not 5.68e-14
+    if (targetUnit && qAbs(result) < qAbs(targetUnit->offset) * 1e-12)
+      result = 0;
+
+    // Plain target reads "1000 meter", a compound one keeps what was typed
+    unitName = targetUnit ? QString::fromLatin1(targetUnit->canonical)
+                          : text.mid(pos + sepLength).trimmed().toString();
+    return true;
+  }
+  return false;
 }
 
-QStringList UnitConverter::categories() const { return m_units.keys(); }
+QString UnitConverter::convert(const QString &line) const {
+  double result;
+  QString unitName;
+  if (!evaluate(line, result, unitName)) {
+    return QString();
+  }
+
+  // Add target unit to result (e.g., "1000 meter")
+  return formatResult(result) + " " + unitName;
+}
+
+QStringList UnitConverter::categories() const {
+  QStringList result;
+  for (const UnitSpec &spec : kUnits) {
+    QString category = QString::fromLatin1(spec.category);
+    if (!result.contains(category))
+      result.append(category);
+  }
+  return result;
+}
 
 QStringList UnitConverter::unitsInCategory(const QString &category) const {
   // Case-insensitive category lookup
   QString lowerCategory = category.toLower();
-  if (!m_units.contains(lowerCategory)) {
-    return QStringList();
+  QStringList result;
+  for (const UnitSpec &spec : kUnits) {
+    if (lowerCategory == QLatin1String(spec.category))
+      result.append(QString::fromUtf16(spec.alias));
   }
-  return m_units[lowerCategory].keys();
+  return result;
 }
@@ -1,7 +1,6 @@
 #ifndef LINNOTE_UNITCONVERTER_H
 #define LINNOTE_UNITCONVERTER_H
 
-#include <QMap>
 #include <QString>
 #include <QStringList>
 
@@ -13,6 +12,14 @@
  *   100 kg to lb
  *   25 C to F
  *   1 GB to MB
+ *
+ * and compound units built from products, quotients and powers:
+ *   120 km/h to m/s
+ *   3 GB / 20 s to MB/s
+ *   2 kW * 3 h to kWh
+ *
+ * Units live in a compile-time table with SI dimension vectors; the two
+ * sides of a conversion must have the same dimension.
  */
 class UnitConverter {
 public:
@@ -33,38 +40,8 @@ public:
 private:
   UnitConverter();
 
-  void initUnits();
-
-  // Unit definitions: category -> (unit alias -> {canonical name, factor to
-  // base})
-  struct UnitDef {
-    QString canonical; // Canonical name (e.g., "meter")
-    double toBase;     // Multiplication factor to convert TO base unit
-    double fromBase;   // Multiplication factor to convert FROM base unit
-    bool isOffset; // For temperature (needs offset, not just multiplication)
-    double offset; // Offset for temperature conversions
-  };
-
-  QMap<QString, QMap<QString, UnitDef>>
-      m_units;                              // category -> (alias -> UnitDef)
-  QMap<QString, QString> m_aliasToCategory; // alias -> category
-
-  // Temperature conversion helpers
-  double celsiusToKelvin(double c) const;
-  double kelvinToCelsius(double k) const;
-  double fahrenheitToKelvin(double f) const;
-  double kelvinToFahrenheit(double k) const;
-
-  // Parse input like "5 km to mile" -> {5.0, "km", "mile"}
-  struct ParsedConversion {
-    double value;
-    QString fromUnit;
-    QString toUnit;
-    bool valid;
-  };
-  ParsedConversion parse(const QString &line) const;
-
-  static UnitConverter *s_instance;
+  // Parse and convert "<amount> <units> to <units>"
+  bool evaluate(const QString &line, double &result, QString &unitName) const;
 };
 
 #endif // LINNOTE_UNITCONVERTER_H
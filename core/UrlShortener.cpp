@@ -9,6 +9,32 @@ UrlShortener::UrlShortener(QObject *parent)
 void UrlShortener::shortenUrl(const QString &url, Service service) {
   m_originalUrl = url;
 
+  QNetworkRequest request;
+  request.setUrl(apiUrl(url, service));
+  QNetworkReply *reply = m_manager->get(request);
+  connect(reply, &QNetworkReply::finished, this,
+          &UrlShortener::onReplyFinished);
+}
+
+void UrlShortener::onReplyFinished() {
+  QNetworkReply *reply = qobject_cast<QNetworkReply *>(sender());
+  if (!reply) {
+    return;
+  }
+
+  reply->deleteLater();
+
+  QString message;
+  QString shortUrl = readReply(reply, &message);
+  if (shortUrl.isEmpty()) {
+    emit error(message);
+    return;
+  }
+
+  emit shortened(shortUrl);
+}
+
+QUrl UrlShortener::apiUrl(const QString &url, Service service) {
   QString apiUrl;
   switch (service) {
   case IsGd:
@@ -24,35 +50,23 @@ void UrlShortener::shortenUrl(const QString &url, Service service) {
                  .arg(QUrl::toPercentEncoding(url).constData());
     break;
   }
-
-  QNetworkRequest request;
-  request.setUrl(QUrl(apiUrl));
-  QNetworkReply *reply = m_manager->get(request);
-  connect(reply, &QNetworkReply::finished, this,
-          &UrlShortener::onReplyFinished);
+  return QUrl(apiUrl);
 }
 
-void UrlShortener::onReplyFinished() {
-  QNetworkReply *reply = qobject_cast<QNetworkReply *>(sender());
-  if (!reply) {
-    return;
-  }
-
-  reply->deleteLater();
-
+QString UrlShortener::readReply(QNetworkReply *reply, QString *error) {
   if (reply->error() != QNetworkReply::NoError) {
-    emit error(tr("Network error: %1").arg(reply->errorString()));
-    return;
+    *error = tr("Network error: %1").arg(reply->errorString());
+    return QString();
   }
 
   QString shortUrl = QString::fromUtf8(reply->readAll()).trimmed();
 
   if (shortUrl.isEmpty() || !shortUrl.startsWith("http")) {
-    emit error(tr("Invalid response from shortening service"));
-    return;
+    *error = tr("Invalid response from shortening service");
+    return QString();
   }
 
-  emit shortened(shortUrl);
+  return shortUrl;
 }
 
 QString UrlShortener::serviceToString(Service service) {
@@ -4,6 +4,9 @@
 #include <QNetworkAccessManager>
 #include <QObject>
 #include <QString>
+#include <QUrl>
+
+class QNetworkReply;
 
 /**
  * @brief URL shortening service wrapper
@@ -22,6 +25,11 @@ public:
   static QString serviceToString(Service service);
   static Service stringToService(const QString &name);
 
+  // The API request that shortens @p url
+  static QUrl apiUrl(const QString &url, Service service);
+  // The short URL in a finished reply; empty, with @p error set, if none
+  static QString readReply(QNetworkReply *reply, QString *error);
+
 signals:
   void shortened(const QString &shortUrl);
   void error(const QString &message);
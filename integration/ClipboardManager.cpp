@@ -3,14 +3,25 @@
 #include <QClipboard>
 #include <QDebug>
 #include <QMimeData>
+#include <QProcess>
+#include <QStandardPaths>
+#include <utility>
 
 ClipboardManager::ClipboardManager(QObject *parent)
     : QObject(parent), m_clipboard(QApplication::clipboard()),
       m_pollTimer(new QTimer(this)) {
-  // Setup polling timer for AutoPaste (Wayland doesn't reliably emit
-  // dataChanged)
+  if (m_clipboard) {
+    connect(m_clipboard, &QClipboard::dataChanged, this,
+            &ClipboardManager::onDataChanged);
+  }
+
+  // Fallback polling for Wayland, where dataChanged only reaches a focused
+  // window
+  m_pollTimer->setSingleShot(true);
   connect(m_pollTimer, &QTimer::timeout, this,
           &ClipboardManager::pollClipboard);
+  connect(qApp, &QGuiApplication::applicationStateChanged, this,
+          &ClipboardManager::updatePolling);
 }
 
 QString ClipboardManager::getTextOnce() {
@@ -58,12 +69,16 @@ void ClipboardManager::startMonitoring() {
   }
 
   m_isMonitoring = true;
-  m_lastContent = m_clipboard ? m_clipboard->text() : QString();
-
-  // Start polling every 500ms (Wayland compatible)
-  m_pollTimer->start(500);
+  m_lastHash = m_clipboard ? contentHash(m_clipboard->text()) : 0;
+  if (needsBackgroundWatch()) {
+    startWatcher();
+  }
+  updatePolling();
 
-  qDebug() << "ClipboardManager: Started monitoring (polling mode)";
+  qDebug() << "ClipboardManager: Started monitoring"
+           << (m_watcher ? "(wl-paste watch)"
+               : m_pollTimer->isActive() ? "(polling)"
+                                         : "(events)");
 }
 
 void ClipboardManager::stopMonitoring() {
@@ -73,22 +88,142 @@ void ClipboardManager::stopMonitoring() {
 
   m_isMonitoring = false;
   m_pollTimer->stop();
+  m_readAgain = false;
+  for (QProcess *process : {std::exchange(m_watcher, nullptr),
+                            std::exchange(m_reader, nullptr)}) {
+    if (process) {
+      process->kill();
+      process->deleteLater();
+    }
+  }
 
   qDebug() << "ClipboardManager: Stopped monitoring";
 }
 
+quint64 ClipboardManager::contentHash(const QString &text) {
+  // 64 bits on the 64-bit builds we ship; seeded per process
+  return qHash(QStringView(text), QHashSeed::globalSeed());
+}
+
+bool ClipboardManager::needsBackgroundWatch() {
+  return QGuiApplication::platformName().startsWith(QLatin1String("wayland"));
+}
+
+void ClipboardManager::updatePolling() {
+  // Events cover X11 and an active window; the watcher covers the rest
+  // where it runs
+  bool poll = m_isMonitoring && needsBackgroundWatch() && !m_watcher &&
+              QGuiApplication::applicationState() != Qt::ApplicationActive;
+  if (!poll) {
+    m_pollTimer->stop();
+  } else if (!m_pollTimer->isActive()) {
+    m_pollInterval = MinPollMs;
+    m_pollTimer->start(m_pollInterval);
+  }
+}
+
+void ClipboardManager::startWatcher() {
+  QString wlPaste = QStandardPaths::findExecutable("wl-paste");
+  if (m_watcherFailed || wlPaste.isEmpty()) {
+    return;
+  }
+
+  // Runs echo on every change, so each line read is one change. The text
+  // itself is fetched separately.
+  QProcess *watcher = new QProcess(this);
+  m_watcher = watcher;
+  connect(watcher, &QProcess::readyReadStandardOutput, this,
+          [this, watcher]() {
+            watcher->readAllStandardOutput();
+            if (watcher == m_watcher) {
+              readWatchedText();
+            }
+          });
+
+  // Without data-control wl-paste exits right away; poll instead
+  auto ended = [this, watcher]() {
+    if (watcher != m_watcher) {
+      return;
+    }
+    qDebug() << "ClipboardManager: wl-paste watch ended, polling instead";
+    m_watcherFailed = true;
+    m_watcher = nullptr;
+    watcher->deleteLater();
+    updatePolling();
+  };
+  connect(watcher,
+          QOverload<int, QProcess::ExitStatus>::of(&QProcess::finished),
+          this, ended);
+  connect(watcher, &QProcess::errorOccurred, this, ended);
+  watcher->start(wlPaste, {"--type", "text", "--watch", "echo"});
+}
+
+void ClipboardManager::readWatchedText() {
+  if (m_reader) {
+    m_readAgain = true;
+    return;
+  }
+
+  QProcess *reader = new QProcess(this);
+  m_reader = reader;
+  auto ended = [this, reader]() {
+    if (reader != m_reader) {
+      return;
+    }
+    m_reader = nullptr;
+    reader->deleteLater();
+    if (reader->exitStatus() == QProcess::NormalExit &&
+        reader->exitCode() == 0) {
+      deliver(QString::fromUtf8(reader->readAllStandardOutput()));
+    }
+    if (std::exchange(m_readAgain, false) && m_isMonitoring) {
+      readWatchedText();
+    }
+  };
+  connect(reader,
+          QOverload<int, QProcess::ExitStatus>::of(&QProcess::finished),
+          this, ended);
+  connect(reader, &QProcess::errorOccurred, this, ended);
+  reader->start(QStandardPaths::findExecutable("wl-paste"),
+                {"--no-newline", "--type", "text"});
+}
+
+void ClipboardManager::onDataChanged() {
+  if (!m_isMonitoring) {
+    return;
+  }
+
+  const QMimeData *mimeData = m_clipboard->mimeData();
+  if (mimeData && mimeData->hasText()) {
+    deliver(m_clipboard->text());
+  }
+}
+
 void ClipboardManager::pollClipboard() {
   if (!m_isMonitoring || !m_clipboard) {
     return;
   }
 
-  QString newContent = m_clipboard->text();
+  // Back off while nothing changes
+  quint64 lastHash = m_lastHash;
+  deliver(m_clipboard->text());
+  m_pollInterval = m_lastHash != lastHash
+                       ? MinPollMs
+                       : qMin(m_pollInterval * 2, MaxPollMs);
+  m_pollTimer->start(m_pollInterval);
+}
 
+void ClipboardManager::deliver(const QString &text) {
   // Only emit if content actually changed and is not empty
-  if (!newContent.isEmpty() && newContent != m_lastContent) {
-    m_lastContent = newContent;
-    emit contentReceived(newContent);
-    qDebug() << "ClipboardManager: New content received:"
-             << newContent.left(50);
+  if (text.isEmpty()) {
+    return;
+  }
+
+  quint64 hash = contentHash(text);
+  if (hash == m_lastHash) {
+    return;
   }
+  m_lastHash = hash;
+  emit contentReceived(text);
+  qDebug() << "ClipboardManager: New content received:" << text.left(50);
 }
@@ -7,12 +7,19 @@
 #include <QTimer>
 
 class QClipboard;
+class QProcess;
 
 /**
  * @brief Clipboard access manager for Wayland
  *
  * Provides safe clipboard access via Qt's QClipboard.
- * Uses timer-based polling for AutoPaste (Wayland compatible).
+ *
+ * AutoPaste monitoring waits for changes instead of reading the clipboard
+ * on a clock. QClipboard::dataChanged covers X11 and a focused Wayland
+ * window. An unfocused Wayland window hears of changes from
+ * `wl-paste --watch` where the compositor has the data-control protocol,
+ * and falls back to polling otherwise. The poll interval doubles while
+ * nothing changes. Content is compared by a 64-bit hash rather than kept.
  */
 class ClipboardManager : public QObject {
   Q_OBJECT
@@ -69,12 +76,28 @@ public slots:
   void stopMonitoring();
 
 private slots:
+  void onDataChanged();
   void pollClipboard();
 
 private:
+  static constexpr int MinPollMs = 250;  // Right after a change
+  static constexpr int MaxPollMs = 4000; // After a quiet while
+
+  static quint64 contentHash(const QString &text);
+  static bool needsBackgroundWatch();
+  void updatePolling();
+  void startWatcher();
+  void readWatchedText();
+  void deliver(const QString &text);
+
   QClipboard *m_clipboard;
-  QTimer *m_pollTimer;
-  QString m_lastContent;
+  QTimer *m_pollTimer; // Single shot, rescheduled by each poll
+  int m_pollInterval = MinPollMs;
+  QProcess *m_watcher = nullptr;  // wl-paste --watch, while monitoring
+  QProcess *m_reader = nullptr;   // wl-paste reading a watched change
+  bool m_readAgain = false;       // Changed again while being read
+  bool m_watcherFailed = false;   // No data-control, don't retry
+  quint64 m_lastHash = 0;         // Of the last text seen
   bool m_isMonitoring = false;
 };
 
@@ -0,0 +1,284 @@
+#include "ClipboardHistory.h"
+#include <QDebug>
+#include <QDir>
+#include <QSqlError>
+#include <QSqlQuery>
+#include <QStandardPaths>
+
+ClipboardHistory::ClipboardHistory(const QString &path, QObject *parent)
+    : QObject(parent) {
+  QString file = path;
+  if (file.isEmpty()) {
+    QString dataPath =
+        QStandardPaths::writableLocation(QStandardPaths::AppDataLocation);
+    if (dataPath.isEmpty() || !QDir().mkpath(dataPath)) {
+      qWarning() << "ClipboardHistory: No writable data location";
+      return;
+    }
+    file = dataPath + "/clipboard.db";
+  }
+
+  // One connection per file, so tests can open their own
+  m_connectionName = "linnote_clipboard:" + file;
+  m_db = QSqlDatabase::addDatabase("QSQLITE", m_connectionName);
+  m_db.setDatabaseName(file);
+  if (!m_db.open()) {
+    qWarning() << "ClipboardHistory: Could not open database:"
+               << m_db.lastError().text();
+    return;
+  }
+  if (!createTables()) {
+    m_db.close();
+    return;
+  }
+
+  // Losing the last copy to a power cut beats a sync per copy
+  QSqlQuery query(m_db);
+  query.exec("PRAGMA journal_mode = WAL");
+  query.exec("PRAGMA synchronous = NORMAL");
+  if (query.exec("SELECT COUNT(*), COALESCE(SUM(bytes), 0), "
+                 "COALESCE(MAX(used), 0) FROM clipboard_history") &&
+      query.next()) {
+    m_count = query.value(0).toInt();
+    m_bytes = query.value(1).toLongLong();
+    m_lastUse = query.value(2).toLongLong();
+  }
+}
+
+ClipboardHistory::~ClipboardHistory() {
+  if (m_connectionName.isEmpty()) {
+    return;
+  }
+  m_db.close();
+  m_db = QSqlDatabase();
+  QSqlDatabase::removeDatabase(m_connectionName);
+}
+
+bool ClipboardHistory::createTables() {
+  QSqlQuery query(m_db);
+
+  // used orders entries by last use; used_at is its time, for display
+  bool success = query.exec(R"(
+    CREATE TABLE IF NOT EXISTS clipboard_history (
+      id INTEGER PRIMARY KEY,
+      hash INTEGER NOT NULL,
+      size INTEGER NOT NULL,
+      bytes INTEGER NOT NULL,
+      compressed INTEGER NOT NULL,
+      content BLOB NOT NULL,
+      preview TEXT NOT NULL,
+      search TEXT NOT NULL,
+      used INTEGER NOT NULL,
+      used_at INTEGER NOT NULL
+    )
+  )");
+  success = success &&
+            query.exec("CREATE INDEX IF NOT EXISTS clipboard_history_hash "
+                       "ON clipboard_history (hash)") &&
+            query.exec("CREATE INDEX IF NOT EXISTS clipboard_history_used "
+                       "ON clipboard_history (used)");
+
+  if (!success) {
+    qWarning() << "ClipboardHistory: Failed to create tables:"
+               << query.lastError().text();
+  }
+  return success;
+}
+
+quint64 ClipboardHistory::contentHash(QStringView text) {
+  quint64 hash = 14695981039346656037ULL;
+  for (QChar c : text) {
+    hash ^= c.unicode();
+    hash *= 1099511628211ULL;
+  }
+  return hash;
+}
+
+bool ClipboardHistory::add(const QString &text) {
+  if (!isOpen() || text.isEmpty() || text.size() > MaxEntryChars) {
+    return false;
+  }
+
+  qint64 hash = qint64(contentHash(text));
+  qint64 now = QDateTime::currentMSecsSinceEpoch();
+  QSqlQuery query(m_db);
+
+  // Known text: only its use moves up
+  query.prepare("SELECT id FROM clipboard_history "
+                "WHERE hash = :hash AND size = :size");
+  query.bindValue(":hash", hash);
+  query.bindValue(":size", text.size());
+  if (query.exec()) {
+    while (query.next()) {
+      qint64 id = query.value(0).toLongLong();
+      if (this->text(id) != text) {
+        continue;
+      }
+      QSqlQuery touch(m_db);
+      touch.prepare("UPDATE clipboard_history SET used = :used, "
+                    "used_at = :used_at WHERE id = :id");
+      touch.bindValue(":used", ++m_lastUse);
+      touch.bindValue(":used_at", now);
+      touch.bindValue(":id", id);
+      touch.exec();
+      emit changed();
+      return false;
+    }
+  }
+
+  bool compressed = text.size() >= CompressChars;
+  QByteArray content = text.toUtf8();
+  if (compressed) {
+    content = qCompress(content);
+  }
+
+  query.prepare(R"(
+    INSERT INTO clipboard_history (hash, size, bytes, compressed, content,
+                                   preview, search, used, used_at)
+    VALUES (:hash, :size, :bytes, :compressed, :content,
+            :preview, :search, :used, :used_at)
+  )");
+  query.bindValue(":hash", hash);
+  query.bindValue(":size", text.size());
+  query.bindValue(":bytes", content.size());
+  query.bindValue(":compressed", compressed ? 1 : 0);
+  query.bindValue(":content", content);
+  query.bindValue(":preview", text.left(PreviewChars));
+  query.bindValue(":search", text.left(SearchChars).toLower());
+  query.bindValue(":used", ++m_lastUse);
+  query.bindValue(":used_at", now);
+  if (!query.exec()) {
+    qWarning() << "ClipboardHistory: Failed to add entry:"
+               << query.lastError().text();
+    return false;
+  }
+
+  ++m_count;
+  m_bytes += content.size();
+  evict();
+  emit changed();
+  return true;
+}
+
+void ClipboardHistory::evict() {
+  if (m_count <= MaxEntries && m_bytes <= MaxBytes) {
+    return;
+  }
+
+  // Least recently used first, until both caps hold
+  QList<qint64> ids;
+  int count = m_count;
+  qint64 bytes = m_bytes;
+  QSqlQuery query(m_db);
+  query.setForwardOnly(true);
+  if (!query.exec("SELECT id, bytes FROM clipboard_history ORDER BY used")) {
+    return;
+  }
+  while ((count > MaxEntries || bytes > MaxBytes) && query.next()) {
+    ids.append(query.value(0).toLongLong());
+    --count;
+    bytes -= query.value(1).toLongLong();
+  }
+  query.finish();
+
+  m_db.transaction();
+  query.prepare("DELETE FROM clipboard_history WHERE id = :id");
+  for (qint64 id : std::as_const(ids)) {
+    query.bindValue(":id", id);
+    query.exec();
+  }
+  if (m_db.commit()) {
+    m_count = count;
+    m_bytes = bytes;
+  }
+}
+
+QList<ClipboardHistory::Entry>
+ClipboardHistory::search(const QString &query, int limit) const {
+  QList<Entry> entries;
+  if (!isOpen()) {
+    return entries;
+  }
+
+  QSqlQuery select(m_db);
+  select.setForwardOnly(true);
+  select.prepare("SELECT id, preview, size, used_at FROM clipboard_history "
+                 "WHERE instr(search, :query) > 0 ORDER BY used DESC "
+                 "LIMIT :limit");
+  select.bindValue(":query", query.trimmed().toLower());
+  select.bindValue(":limit", limit);
+  if (!select.exec()) {
+    qWarning() << "ClipboardHistory: Search failed:"
+               << select.lastError().text();
+    return entries;
+  }
+
+  while (select.next()) {
+    Entry entry;
+    entry.id = select.value(0).toLongLong();
+    entry.preview = select.value(1).toString();
+    entry.size = select.value(2).toLongLong();
+    entry.usedAt =
+        QDateTime::fromMSecsSinceEpoch(select.value(3).toLongLong());
+    entries.append(entry);
+  }
+  return entries;
+}
+
+QString ClipboardHistory::text(qint64 id) const {
+  if (!isOpen()) {
+    return QString();
+  }
+
+  QSqlQuery query(m_db);
+  query.prepare(
+      "SELECT compressed, content FROM clipboard_history WHERE id = :id");
+  query.bindValue(":id", id);
+  if (!query.exec() || !query.next()) {
+    return QString();
+  }
+
+  QByteArray content = query.value(1).toByteArray();
+  if (query.value(0).toBool()) {
+    content = qUncompress(content);
+  }
+  return QString::fromUtf8(content);
+}
+
+bool ClipboardHistory::remove(qint64 id) {
+  if (!isOpen()) {
+    return false;
+  }
+
+  QSqlQuery query(m_db);
+  query.prepare("SELECT bytes FROM clipboard_history WHERE id = :id");
+  query.bindValue(":id", id);
+  if (!query.exec() || !query.next()) {
+    return false;
+  }
+  qint64 bytes = query.value(0).toLongLong();
+
+  query.prepare("DELETE FROM clipboard_history WHERE id = :id");
+  query.bindValue(":id", id);
+  if (!query.exec()) {
+    return false;
+  }
+
+  --m_count;
+  m_bytes -= bytes;
+  emit changed();
+  return true;
+}
+
+void ClipboardHistory::clear() {
+  if (!isOpen()) {
+    return;
+  }
+
+  QSqlQuery query(m_db);
+  if (query.exec("DELETE FROM clipboard_history")) {
+    m_count = 0;
+    m_bytes = 0;
+    emit changed();
+  }
+}
@@ -0,0 +1,85 @@
+#ifndef LINNOTE_CLIPBOARDHISTORY_H
+#define LINNOTE_CLIPBOARDHISTORY_H
+
+#include <QDateTime>
+#include <QList>
+#include <QObject>
+#include <QSqlDatabase>
+#include <QString>
+
+/**
+ * @brief Bounded history of copied text, kept in SQLite
+ *
+ * Stores in: ~/.local/share/LinNote/clipboard.db
+ *
+ * Copying a text again moves its entry to the front instead of adding
+ * another; entries are found by a hash of their content. Past MaxEntries
+ * or MaxBytes the least recently used entries go. Entries of
+ * CompressChars or more are stored compressed. Each entry keeps the start
+ * of its text lower-cased for search, so searching doesn't decompress.
+ */
+class ClipboardHistory : public QObject {
+  Q_OBJECT
+
+public:
+  static constexpr int MaxEntries = 2000;
+  static constexpr qint64 MaxBytes = 32 * 1024 * 1024; // Stored content
+  static constexpr qsizetype MaxEntryChars = 4 * 1024 * 1024; // Not kept
+  static constexpr qsizetype CompressChars = 4 * 1024;
+  static constexpr qsizetype SearchChars = 16 * 1024; // Searched part
+  static constexpr qsizetype PreviewChars = 200;
+
+  struct Entry {
+    qint64 id = 0;
+    QString preview; // Start of the text
+    qsizetype size = 0;
+    QDateTime usedAt; // Copied last
+  };
+
+  /**
+   * @param path Database file; empty for the default location
+   */
+  explicit ClipboardHistory(const QString &path = QString(),
+                            QObject *parent = nullptr);
+  ~ClipboardHistory() override;
+
+  bool isOpen() const { return m_db.isOpen(); }
+
+  /**
+   * @brief Record a copied text
+   * @return true if it was new, false if it was known or isn't kept
+   */
+  bool add(const QString &text);
+
+  /**
+   * @brief Entries containing @p query, most recently used first
+   *
+   * Case-insensitive; an empty query lists the latest entries.
+   */
+  QList<Entry> search(const QString &query, int limit = 50) const;
+
+  QString text(qint64 id) const; // Empty if there is no such entry
+  bool remove(qint64 id);
+  void clear();
+
+  int count() const { return m_count; }
+  qint64 storedBytes() const { return m_bytes; }
+
+  // FNV-1a over the UTF-16 text; stable across runs, unlike qHash
+  static quint64 contentHash(QStringView text);
+
+signals:
+  void changed();
+
+private:
+  bool createTables();
+  void evict();
+
+  QString m_connectionName;
+  QSqlDatabase m_db;
+  int m_count = 0;
+  qint64 m_bytes = 0;
+  qint64 m_lastUse = 0; // Orders entries by use
+};
+
+#endif // LINNOTE_CLIPBOARDHISTORY_H
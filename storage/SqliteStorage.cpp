@@ -149,9 +149,32 @@ QList<Note> SqliteStorage::load(int &currentIndex) {
   }
 
   // Load notes
-  query.exec(
-      "SELECT id, title, content, mode, password_hash, expires_at, created_at, "
-      "updated_at FROM notes");
+  readNotes([&notes](const Note &note) {
+    notes.append(note);
+    return true;
+  });
+
+  qDebug() << "SqliteStorage: Loaded" << notes.size() << "notes";
+  return notes;
+}
+
+int SqliteStorage::readNotes(const std::function<bool(const Note &)> &visit) {
+  if (!m_initialized) {
+    qWarning() << "SqliteStorage: Database not initialized";
+    return 0;
+  }
+
+  // Forward-only, so rows already read aren't kept by the query
+  QSqlQuery query(m_db);
+  query.setForwardOnly(true);
+  if (!query.exec("SELECT id, title, content, mode, password_hash, "
+                  "expires_at, created_at, updated_at FROM notes")) {
+    qWarning() << "SqliteStorage: Failed to read notes:"
+               << query.lastError().text();
+    return 0;
+  }
+
+  int count = 0;
   while (query.next()) {
     QString id = query.value(0).toString();
     QString title = query.value(1).toString();
@@ -165,11 +188,11 @@ QList<Note> SqliteStorage::load(int &currentIndex) {
       note.setExpiresAt(QDateTime::fromString(expiresStr, Qt::ISODate));
     }
     // created_at and updated_at stored but not used in Note class yet
-    notes.append(note);
+    ++count;
+    if (!visit(note))
+      break;
   }
-
-  qDebug() << "SqliteStorage: Loaded" << notes.size() << "notes";
-  return notes;
+  return count;
 }
 
 bool SqliteStorage::saveNote(const Note &note) {
@@ -6,6 +6,7 @@
 #include <QList>
 #include <QObject>
 #include <QSqlDatabase>
+#include <functional>
 
 /**
  * @brief SQLite-based persistent storage for notes
@@ -35,6 +36,16 @@ public:
    */
   QList<Note> load(int &currentIndex);
 
+  /**
+   * @brief Read notes one row at a time instead of all at once
+   * @param visit Called with each note in turn; return false to stop
+   * @return Number of notes read
+   *
+   * Each note's content keeps the text the driver returned as its pieces,
+   * without another copy.
+   */
+  int readNotes(const std::function<bool(const Note &)> &visit);
+
   /**
    * @brief Save a single note (insert or update)
    */
@@ -0,0 +1,121 @@
+#include "core/AhoCorasick.h"
+#include <QTest>
+
+class TestAhoCorasick : public QObject {
+  Q_OBJECT
+
+private slots:
+  void testFindAll();
+  void testOverlapsAndSuffixes();
+  void testLeftmostLongest();
+  void testCaseInsensitive();
+  void testWholeWords();
+  void testFind();
+  void testEmpty();
+
+  // Performance
+  void benchmarkCurrencyScan();
+};
+
+namespace {
+
+QStringList matched(const AhoCorasick &automaton, QStringView text) {
+  QStringList words;
+  for (const AhoCorasick::Match &match : automaton.findAll(text))
+    words << text.mid(match.start, match.length).toString();
+  return words;
+}
+
+} // namespace
+
+void TestAhoCorasick::testFindAll() {
+  AhoCorasick automaton({"USD", "EUR", "TRY"});
+  QList<AhoCorasick::Match> matches = automaton.findAll(u"100 USD to TRY");
+  QCOMPARE(matches.size(), 2);
+  QCOMPARE(matches[0].start, 4);
+  QCOMPARE(matches[0].length, 3);
+  QCOMPARE(matches[0].pattern, 0);
+  QCOMPARE(matches[1].start, 11);
+  QCOMPARE(matches[1].pattern, 2);
+}
+
+void TestAhoCorasick::testOverlapsAndSuffixes() {
+  // "he" is only reachable through the failure link out of "she"
+  AhoCorasick automaton({"she", "he", "hers"});
+  QCOMPARE(matched(automaton, u"ushers"), QStringList({"she"}));
+  QCOMPARE(matched(automaton, u"uhers"), QStringList({"hers"}));
+  QCOMPARE(matched(automaton, u"the"), QStringList({"he"}));
+}
+
+void TestAhoCorasick::testLeftmostLongest() {
+  AhoCorasick automaton({"USD", "USDT", "SDT"});
+  QCOMPARE(matched(automaton, u"5 USDT"), QStringList({"USDT"}));
+  QCOMPARE(matched(automaton, u"USDUSD"), QStringList({"USD", "USD"}));
+
+  // Duplicates report the first one
+  AhoCorasick duplicates({"log", "LOG", "log"});
+  QCOMPARE(duplicates.findAll(u"log").first().pattern, 0);
+}
+
+void TestAhoCorasick::testCaseInsensitive() {
+  AhoCorasick automaton({"EUR", "döviz"}, AhoCorasick::CaseInsensitive);
+  QCOMPARE(matched(automaton, u"50 eur, DÖVIZ"),
+           QStringList({"eur", "DÖVIZ"}));
+  QVERIFY(!AhoCorasick({"EUR"}).contains(u"eur"));
+}
+
+void TestAhoCorasick::testWholeWords() {
+  AhoCorasick automaton({"calc", "calculator", "log", "log10"},
+                        AhoCorasick::WholeWords);
+  QCOMPARE(matched(automaton, u"calculator"), QStringList({"calculator"}));
+  QCOMPARE(matched(automaton, u"calcs calc_x"), QStringList());
+  QCOMPARE(matched(automaton, u"log10(x) + log(2)"),
+           QStringList({"log10", "log"}));
+  QCOMPARE(matched(automaton, u"(calc)"), QStringList({"calc"}));
+}
+
+void TestAhoCorasick::testFind() {
+  AhoCorasick automaton({"sin", "sinh", "cos"});
+  AhoCorasick::Match match;
+  QVERIFY(automaton.find(u"x + sinh(y) + cos(z)", &match));
+  QCOMPARE(match.start, 4);
+  QCOMPARE(match.length, 4);
+
+  QVERIFY(automaton.find(u"x + sinh(y) + cos(z)", &match, 5));
+  QCOMPARE(match.start, 14);
+  QCOMPARE(match.pattern, 2);
+
+  QVERIFY(!automaton.find(u"tan(x)", &match));
+  QVERIFY(automaton.contains(u"acos"));
+}
+
+void TestAhoCorasick::testEmpty() {
+  AhoCorasick none;
+  QVERIFY(none.isEmpty());
+  QVERIFY(none.findAll(u"anything").isEmpty());
+  QVERIFY(!none.contains(u"anything"));
+
+  AhoCorasick automaton({"", "a"});
+  QCOMPARE(matched(automaton, u"ba"), QStringList({"a"}));
+  QVERIFY(!automaton.contains(u""));
+}
+
+void TestAhoCorasick::benchmarkCurrencyScan() {
+  const QStringList codes = {
+      "USD", "EUR", "TRY", "GBP", "JPY", "CNY",  "RUB",  "AUD",   "CAD", "CHF",
+      "INR", "KRW", "BRL", "MXN", "PLN", "SEK",  "NOK",  "DKK",   "SGD", "HKD",
+      "NZD", "ZAR", "THB", "AED", "SAR", "ALL",  "BTC",  "ETH",   "USDT",
+      "USDC", "XRP", "BNB", "SOL", "ADA", "DOGE", "TRX", "DOT", "MATIC", "LTC"};
+  AhoCorasick automaton(codes,
+                        AhoCorasick::CaseInsensitive | AhoCorasick::WholeWords);
+  QString sheet;
+  for (int i = 0; i < 500; ++i)
+    sheet += QString("rent %1 EUR to usd + fee * 3 = total\n").arg(i);
+
+  int found = 0;
+  QBENCHMARK { found = automaton.findAll(sheet).size(); }
+  QCOMPARE(found, 1000);
+}
+
+QTEST_MAIN(TestAhoCorasick)
+#include "test_ahocorasick.moc"
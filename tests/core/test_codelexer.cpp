@@ -0,0 +1,290 @@
+#include "core/CodeLexer.h"
+#include "core/GrammarRegistry.h"
+#include <QTest>
+
+class TestCodeLexer : public QObject {
+  Q_OBJECT
+
+private slots:
+  // C/C++
+  void testCppKeywordsAndComments();
+  void testKeywordIsNotFunction();
+  void testCommentMarkerInString();
+  void testEscapedQuote();
+  void testPreprocessorLine();
+  void testNumbers();
+  void testBlockComment();
+  void testBlockCommentOnOneLine();
+
+  // Other languages
+  void testPython();
+  void testBashVariables();
+  void testJson();
+  void testSqlEitherCase();
+
+  // State across lines
+  void testPythonTripleQuotes();
+  void testJavaScriptTemplate();
+  void testGoRawString();
+  void testMultiLineQuotes();
+  void testStateFromOtherLanguage();
+
+  // Performance
+  void benchmarkCppFile();
+
+private:
+  static QSharedPointer<const CodeLexer::Table> grammar(const QString &name);
+  static QStringList describe(const CodeLexer &lexer, const QString &line,
+                              int *state = nullptr);
+};
+
+// A shipped grammar file, as the app loads it
+QSharedPointer<const CodeLexer::Table>
+TestCodeLexer::grammar(const QString &name) {
+  static GrammarRegistry shipped({":/grammars"});
+  return shipped.table(name);
+}
+
+// "kind:text" for each token, e.g. "Keyword:int". With @p state, the line
+// starts in *state, which is then set to the state the line ends in.
+QStringList TestCodeLexer::describe(const CodeLexer &lexer,
+                                    const QString &line, int *state) {
+  static const char *names[] = {"Keyword", "Type",         "Function",
+                                "String",  "Number",       "Comment",
+                                "Preprocessor", "Variable", "Key"};
+  QVector<CodeLexer::Token> tokens;
+  int end = lexer.tokenize(line, tokens, state ? *state : CodeLexer::Normal);
+  if (state)
+    *state = end;
+
+  QStringList result;
+  for (const CodeLexer::Token &token : tokens) {
+    result << QString("%1:%2").arg(names[token.kind],
+                                   line.mid(token.start, token.length));
+  }
+  return result;
+}
+
+void TestCodeLexer::testCppKeywordsAndComments() {
+  CodeLexer lexer(grammar("cpp"));
+  QCOMPARE(describe(lexer, "int x = 42; // answer"),
+           QStringList({"Keyword:int", "Number:42", "Comment:// answer"}));
+  QCOMPARE(describe(lexer, "QString name;"), QStringList({"Type:QString"}));
+}
+
+void TestCodeLexer::testKeywordIsNotFunction() {
+  CodeLexer lexer(grammar("cpp"));
+  QCOMPARE(describe(lexer, "if (ready) start();"),
+           QStringList({"Keyword:if", "Function:start"}));
+}
+
+void TestCodeLexer::testCommentMarkerInString() {
+  CodeLexer lexer(grammar("cpp"));
+  QCOMPARE(describe(lexer, "url = \"http://x\";"),
+           QStringList({"String:\"http://x\""}));
+
+  CodeLexer python(grammar("python"));
+  QCOMPARE(describe(python, "tag = '#1'  # note"),
+           QStringList({"String:'#1'", "Comment:# note"}));
+}
+
+void TestCodeLexer::testEscapedQuote() {
+  CodeLexer lexer(grammar("cpp"));
+  QCOMPARE(describe(lexer, "s = \"a\\\"b\" + c;"),
+           QStringList({"String:\"a\\\"b\""}));
+}
+
+void TestCodeLexer::testPreprocessorLine() {
+  CodeLexer lexer(grammar("cpp"));
+  QCOMPARE(describe(lexer, "#include \"foo.h\" // why"),
+           QStringList({"Preprocessor:#include \"foo.h\" // why",
+                        "String:\"foo.h\"", "Comment:// why"}));
+}
+
+void TestCodeLexer::testNumbers() {
+  CodeLexer lexer(grammar("cpp"));
+  QCOMPARE(describe(lexer, "a = 0x1F + 2.5f + 1e-3;"),
+           QStringList({"Number:0x1F", "Number:2.5f", "Number:1e-3"}));
+
+  // Digits inside or before a word are not numbers
+  QCOMPARE(describe(lexer, "x1 = 123abc;"), QStringList());
+}
+
+void TestCodeLexer::testBlockComment() {
+  CodeLexer lexer(grammar("cpp"));
+  int state = CodeLexer::Normal;
+  QCOMPARE(describe(lexer, "int a; /* starts", &state),
+           QStringList({"Keyword:int", "Comment:/* starts"}));
+  QCOMPARE(state, int(CodeLexer::InBlockComment));
+
+  QCOMPARE(describe(lexer, "int \"still\" here", &state),
+           QStringList({"Comment:int \"still\" here"}));
+  QCOMPARE(state, int(CodeLexer::InBlockComment));
+
+  QCOMPARE(describe(lexer, "ends */ return 1;", &state),
+           QStringList({"Comment:ends */", "Keyword:return", "Number:1"}));
+  QCOMPARE(state, int(CodeLexer::Normal));
+}
+
+void TestCodeLexer::testBlockCommentOnOneLine() {
+  CodeLexer lexer(grammar("cpp"));
+  int state = CodeLexer::Normal;
+  QCOMPARE(describe(lexer, "f(/* x */ 2); // done", &state),
+           QStringList({"Function:f", "Comment:/* x */", "Number:2",
+                        "Comment:// done"}));
+  QCOMPARE(state, int(CodeLexer::Normal));
+
+  // Inside a string it's not a comment
+  QCOMPARE(describe(lexer, "s = \"/*\";", &state),
+           QStringList({"String:\"/*\""}));
+  QCOMPARE(state, int(CodeLexer::Normal));
+}
+
+void TestCodeLexer::testPython() {
+  CodeLexer lexer(grammar("python"));
+  QCOMPARE(describe(lexer, "def area(r): return None  # todo"),
+           QStringList({"Keyword:def", "Function:area", "Keyword:return",
+                        "Keyword:None", "Comment:# todo"}));
+}
+
+void TestCodeLexer::testBashVariables() {
+  CodeLexer lexer(grammar("bash"));
+  QCOMPARE(describe(lexer, "echo $HOME ${PATH} $1 $? # done"),
+           QStringList({"Variable:$HOME", "Variable:${PATH}", "Variable:$1",
+                        "Variable:$?", "Comment:# done"}));
+  QCOMPARE(describe(lexer, "#!/bin/bash"),
+           QStringList({"Preprocessor:#!/bin/bash"}));
+}
+
+void TestCodeLexer::testJson() {
+  CodeLexer lexer(grammar("json"));
+  QCOMPARE(describe(lexer, R"({"a": "b", "n": 1.5e3, "ok" : true})"),
+           QStringList({"Key:\"a\"", "String:\"b\"", "Key:\"n\"",
+                        "Number:1.5e3", "Key:\"ok\"", "Keyword:true"}));
+}
+
+void TestCodeLexer::testSqlEitherCase() {
+  CodeLexer lexer(grammar("sql"));
+  QCOMPARE(describe(lexer, "SELECT name FROM users -- all"),
+           QStringList({"Keyword:SELECT", "Keyword:FROM", "Comment:-- all"}));
+  QCOMPARE(describe(lexer, "select 'x' from t"),
+           QStringList({"Keyword:select", "String:'x'", "Keyword:from"}));
+}
+
+void TestCodeLexer::testPythonTripleQuotes() {
+  CodeLexer lexer(grammar("python"));
+  int state = CodeLexer::Normal;
+  QCOMPARE(describe(lexer, "doc = \"\"\"Summary", &state),
+           QStringList({"String:\"\"\"Summary"}));
+  QCOMPARE(state, int(CodeLexer::InTripleDouble));
+
+  // ''' and # don't end or start anything inside """
+  QCOMPARE(describe(lexer, "it's # not a comment '''", &state),
+           QStringList({"String:it's # not a comment '''"}));
+  QCOMPARE(describe(lexer, "\"\"\" if x: pass", &state),
+           QStringList({"String:\"\"\"", "Keyword:if", "Keyword:pass"}));
+  QCOMPARE(state, int(CodeLexer::Normal));
+
+  // Closed on the same line
+  QCOMPARE(describe(lexer, "x = '''a''' or None", &state),
+           QStringList({"String:'''a'''", "Keyword:or", "Keyword:None"}));
+  QCOMPARE(state, int(CodeLexer::Normal));
+
+  // An empty string is not a triple quote
+  QCOMPARE(describe(lexer, "x = \"\"", &state), QStringList({"String:\"\""}));
+  QCOMPARE(state, int(CodeLexer::Normal));
+}
+
+void TestCodeLexer::testJavaScriptTemplate() {
+  CodeLexer lexer(grammar("javascript"));
+  int state = CodeLexer::Normal;
+  QCOMPARE(describe(lexer, "const s = `line one", &state),
+           QStringList({"Keyword:const", "String:`line one"}));
+  QCOMPARE(state, int(CodeLexer::InTemplate));
+
+  QCOMPARE(describe(lexer, "escaped \\` still open", &state),
+           QStringList({"String:escaped \\` still open"}));
+  QCOMPARE(describe(lexer, "two`; return", &state),
+           QStringList({"String:two`", "Keyword:return"}));
+  QCOMPARE(state, int(CodeLexer::Normal));
+
+  // Ordinary quotes still end with the line
+  QCOMPARE(describe(lexer, "x = 'open", &state), QStringList({"String:'open"}));
+  QCOMPARE(state, int(CodeLexer::Normal));
+}
+
+void TestCodeLexer::testGoRawString() {
+  CodeLexer lexer(grammar("go"));
+  int state = CodeLexer::Normal;
+  QCOMPARE(describe(lexer, "q := `SELECT *", &state),
+           QStringList({"String:`SELECT *"}));
+  QCOMPARE(state, int(CodeLexer::InTemplate));
+  QCOMPARE(describe(lexer, "FROM t` // query", &state),
+           QStringList({"String:FROM t`", "Comment:// query"}));
+  QCOMPARE(state, int(CodeLexer::Normal));
+}
+
+void TestCodeLexer::testMultiLineQuotes() {
+  // Any quote may span lines, and only its own kind closes it
+  CodeLexer::Grammar rust;
+  rust.name = "rust";
+  rust.keywords = {"let"};
+  rust.quotes = "\"'`";
+  rust.multiLineQuotes = "`\"";
+  CodeLexer lexer(rust);
+
+  int state = CodeLexer::Normal;
+  QCOMPARE(describe(lexer, "let s = \"one", &state),
+           QStringList({"Keyword:let", "String:\"one"}));
+  QCOMPARE(state, CodeLexer::InTemplate + 1);
+  QCOMPARE(describe(lexer, "a ` and ' inside", &state),
+           QStringList({"String:a ` and ' inside"}));
+  QCOMPARE(state, CodeLexer::InTemplate + 1);
+  QCOMPARE(describe(lexer, "two\"; let", &state),
+           QStringList({"String:two\"", "Keyword:let"}));
+  QCOMPARE(state, int(CodeLexer::Normal));
+
+  QCOMPARE(describe(lexer, "`raw", &state), QStringList({"String:`raw"}));
+  QCOMPARE(state, int(CodeLexer::InTemplate));
+  QCOMPARE(describe(lexer, "\" still` let", &state),
+           QStringList({"String:\" still`", "Keyword:let"}));
+  QCOMPARE(state, int(CodeLexer::Normal));
+
+  // A quote that doesn't span lines ends with its line
+  QCOMPARE(describe(lexer, "'open", &state), QStringList({"String:'open"}));
+  QCOMPARE(state, int(CodeLexer::Normal));
+}
+
+void TestCodeLexer::testStateFromOtherLanguage() {
+  // Bash has no block comments: a state left from C++ closes at once
+  CodeLexer lexer(grammar("bash"));
+  int state = CodeLexer::InBlockComment;
+  QCOMPARE(describe(lexer, "echo $HOME", &state),
+           QStringList({"Variable:$HOME"}));
+  QCOMPARE(state, int(CodeLexer::Normal));
+}
+
+void TestCodeLexer::benchmarkCppFile() {
+  const QStringList sample = {
+      "#include <QString>",
+      "static int counter = 0; // global",
+      "QString greet(const QString &name) {",
+      "  if (name.isEmpty()) return \"Hello, world\";",
+      "  for (int i = 0; i < 10; ++i) counter += i * 2.5f;",
+      "  return QString(\"Hello, %1\").arg(name);",
+      "}"};
+  QStringList lines;
+  while (lines.size() < 5000)
+    lines << sample;
+
+  CodeLexer lexer(grammar("cpp"));
+  QVector<CodeLexer::Token> tokens;
+  QBENCHMARK {
+    int state = CodeLexer::Normal;
+    for (const QString &line : lines)
+      state = lexer.tokenize(line, tokens, state);
+  }
+}
+
+QTEST_MAIN(TestCodeLexer)
+#include "test_codelexer.moc"
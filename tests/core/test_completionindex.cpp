@@ -0,0 +1,181 @@
+#include "core/CompletionIndex.h"
+#include <QRandomGenerator>
+#include <QTest>
+#include <algorithm>
+
+class TestCompletionIndex : public QObject {
+  Q_OBJECT
+
+private slots:
+  void testComplete();
+  void testCaseInsensitive();
+  void testKindOrder();
+  void testRecencyAndFrequency();
+  void testRemove();
+  void testPrefixIsNoCompletion();
+  void testRandomAgainstScan();
+
+  // Performance
+  void benchmarkLookup();
+};
+
+void TestCompletionIndex::testComplete() {
+  CompletionIndex index;
+  QVERIFY(index.insert("total", CompletionIndex::Variable));
+  QVERIFY(index.insert("tax", CompletionIndex::Variable));
+  QVERIFY(!index.insert("tax", CompletionIndex::Function));
+  QVERIFY(!index.insert("", CompletionIndex::Variable));
+  QCOMPARE(index.size(), 2);
+
+  QCOMPARE(index.complete(u"t"), QStringList({"tax", "total"}));
+  QCOMPARE(index.complete(u"to"), QStringList({"total"}));
+  QCOMPARE(index.complete(u"x"), QStringList());
+  QCOMPARE(index.best(u"ta"), QString("tax"));
+
+  // The prefix itself is no completion
+  QCOMPARE(index.complete(u"tax"), QStringList());
+  QCOMPARE(index.complete(u""), QStringList({"tax", "total"}));
+}
+
+void TestCompletionIndex::testCaseInsensitive() {
+  CompletionIndex index;
+  index.insert("EUR", CompletionIndex::Currency);
+  QCOMPARE(index.best(u"eu"), QString("EUR"));
+  QVERIFY(index.contains(u"eur"));
+  QVERIFY(!index.insert("eur", CompletionIndex::Variable));
+}
+
+void TestCompletionIndex::testKindOrder() {
+  // Unused words: by kind, then shorter first
+  CompletionIndex index;
+  index.insert("/sum", CompletionIndex::Command);
+  index.insert("sum", CompletionIndex::Function);
+  index.insert("summer", CompletionIndex::Variable);
+  index.insert("sumo", CompletionIndex::Variable);
+  QCOMPARE(index.complete(u"s"), QStringList({"sumo", "summer", "sum"}));
+  QCOMPARE(index.best(u"/"), QString("/sum"));
+}
+
+void TestCompletionIndex::testRecencyAndFrequency() {
+  CompletionIndex index;
+  index.insert("alpha", CompletionIndex::Variable);
+  index.insert("apple", CompletionIndex::Variable);
+  index.insert("avg", CompletionIndex::Function);
+  QCOMPARE(index.best(u"a"), QString("alpha"));
+
+  index.touch(u"avg");
+  QCOMPARE(index.best(u"a"), QString("avg"));
+
+  // The latest use outweighs an equal earlier one
+  index.touch(u"apple");
+  QCOMPARE(index.best(u"a"), QString("apple"));
+
+  // Two uses outweigh one more recent
+  index.touch(u"avg");
+  index.touch(u"alpha");
+  QCOMPARE(index.complete(u"a"), QStringList({"avg", "alpha", "apple"}));
+}
+
+void TestCompletionIndex::testRemove() {
+  CompletionIndex index;
+  for (const char *word : {"rate", "rates", "ratio", "rat", "ram", "range"})
+    index.insert(word, CompletionIndex::Variable);
+  index.touch(u"rates");
+  QCOMPARE(index.best(u"ra"), QString("rates"));
+
+  QVERIFY(index.remove(u"RATES"));
+  QVERIFY(!index.remove(u"rates"));
+  QVERIFY(!index.contains(u"rates"));
+  QCOMPARE(index.size(), 5);
+  QCOMPARE(index.complete(u"ra"),
+           QStringList({"ram", "rat", "rate", "range"}));
+
+  // Back in, without its old uses
+  index.insert("rates", CompletionIndex::Variable);
+  QCOMPARE(index.complete(u"rate"), QStringList({"rates"}));
+  QCOMPARE(index.best(u"ra"), QString("ram"));
+}
+
+void TestCompletionIndex::testPrefixIsNoCompletion() {
+  // The prefix is a word that ranks first; it still leaves TopCount others
+  CompletionIndex index;
+  const QStringList words = {"rate", "rates", "rated", "rater", "ratel"};
+  for (const QString &word : words)
+    QVERIFY(index.insert(word, CompletionIndex::Variable));
+  index.touch(u"rate");
+
+  QStringList completions = index.complete(u"rate");
+  QCOMPARE(completions.size(), CompletionIndex::TopCount);
+  QVERIFY(!completions.contains("rate"));
+  QCOMPARE(index.complete(u"rate", 2), QStringList({"rated", "ratel"}));
+  QCOMPARE(index.best(u"rate"), QString("rated"));
+  QCOMPARE(index.complete(u"r"),
+           QStringList({"rate", "rated", "ratel", "rater"}));
+}
+
+void TestCompletionIndex::testRandomAgainstScan() {
+  // Each lookup matches sorting every word with the prefix
+  QRandomGenerator random(7);
+  CompletionIndex index;
+  QStringList words;
+  QHash<QString, double> scores; // Kept the way the index documents it
+  double weight = 1;
+
+  auto randomWord = [&random](int maxLength) {
+    QString word;
+    int length = random.bounded(maxLength + 1);
+    for (int i = 0; i < length; ++i)
+      word += QChar('a' + random.bounded(3));
+    return word;
+  };
+
+  for (int i = 0; i < 3000; ++i) {
+    QString word = randomWord(4);
+    int action = random.bounded(10);
+    if (action < 4) {
+      if (index.insert(word, CompletionIndex::Variable))
+        words << word;
+    } else if (action < 6) {
+      if (index.remove(word)) {
+        words.removeOne(word);
+        scores.remove(word);
+      }
+    } else if (words.contains(word)) {
+      index.touch(word);
+      scores[word] += weight;
+      weight *= 1.02;
+    }
+
+    QString prefix = randomWord(2);
+    QStringList expected;
+    for (const QString &candidate : std::as_const(words)) {
+      if (candidate.startsWith(prefix))
+        expected << candidate;
+    }
+    std::sort(expected.begin(), expected.end(),
+              [&](const QString &a, const QString &b) {
+                if (scores.value(a) != scores.value(b))
+                  return scores.value(a) > scores.value(b);
+                if (a.size() != b.size())
+                  return a.size() < b.size();
+                return a < b;
+              });
+    expected.removeAll(prefix);
+    expected = expected.mid(0, CompletionIndex::TopCount);
+    QCOMPARE(index.complete(prefix), expected);
+  }
+}
+
+void TestCompletionIndex::benchmarkLookup() {
+  // A sheet's worth of words; a lookup is a walk down the prefix
+  CompletionIndex index;
+  for (int i = 0; i < 20000; ++i)
+    index.insert(QStringLiteral("value_%1").arg(i), CompletionIndex::Variable);
+  index.touch(u"value_12345");
+  QString best;
+  QBENCHMARK { best = index.best(u"value_1"); }
+  QCOMPARE(best, QString("value_12345"));
+}
+
+QTEST_MAIN(TestCompletionIndex)
+#include "test_completionindex.moc"
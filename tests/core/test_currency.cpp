@@ -15,12 +15,16 @@ private slots:
   void testParseCurrencySymbols();
   void testParseDecimalAmounts();
   void testParseLargeAmounts();
+  void testParseSymbolPlacement();
+  void testParseInSeparator();
 
   // Invalid input
   void testParseInvalidFormat();
   void testParseEmptyString();
   void testParseNoConversionKeyword();
   void testParseSameCurrency();
+  void testParseHistoricalDate();
+  void testParseUnknownCode();
 
   // Currency utilities
   void testSupportedCurrencies();
@@ -28,6 +32,13 @@ private slots:
 
   // Conversion (will use cached/default rates if available)
   void testConvertSameCurrency();
+  void testConvertDecimalSameCurrency();
+
+  // Currency detection for decimal mode
+  void testMentionsCurrency();
+
+  // Performance
+  void benchmarkParseAndConvert();
 
 private:
   CurrencyConverter *m_converter;
@@ -151,6 +162,60 @@ void TestCurrencyConverter::testParseSameCurrency() {
   }
 }
 
+void TestCurrencyConverter::testParseHistoricalDate() {
+  double result;
+  QString from, to;
+
+  // Parsed, but there are no rates from 1901 to convert with
+  QVERIFY(!m_converter->parseAndConvert("100 USD to EUR @1901-03-01", result,
+                                        from, to));
+  QCOMPARE(from, QString("USD"));
+  QCOMPARE(to, QString("EUR"));
+
+  // Not a date
+  QVERIFY(!m_converter->parseAndConvert("100 USD to EUR @2026-13-45", result,
+                                        from, to));
+
+  // USD is the base, so it needs no stored rate on any day
+  QVERIFY(m_converter->parseAndConvert("100 USD to USD @2026-03-01", result,
+                                       from, to));
+  QCOMPARE(result, 100.0);
+}
+
+void TestCurrencyConverter::testParseSymbolPlacement() {
+  double result;
+  QString from, to;
+
+  QVERIFY(m_converter->parseAndConvert("$100 to EUR", result, from, to));
+  QCOMPARE(from, QString("USD"));
+  QCOMPARE(to, QString("EUR"));
+
+  QVERIFY(m_converter->parseAndConvert("50€ to £", result, from, to));
+  QCOMPARE(from, QString("EUR"));
+  QCOMPARE(to, QString("GBP"));
+}
+
+void TestCurrencyConverter::testParseInSeparator() {
+  double result;
+  QString from, to;
+
+  QVERIFY(m_converter->parseAndConvert("50 eur in try", result, from, to));
+  QCOMPARE(from, QString("EUR"));
+  QCOMPARE(to, QString("TRY"));
+
+  double direct = m_converter->convert(50, "EUR", "TRY");
+  QCOMPARE(result, direct);
+}
+
+void TestCurrencyConverter::testParseUnknownCode() {
+  double result;
+  QString from, to;
+
+  QVERIFY(!m_converter->parseAndConvert("100 USD to XYZ", result, from, to));
+  QVERIFY(!m_converter->parseAndConvert("100 dollars", result, from, to));
+  QCOMPARE(m_converter->convert(1, "USD", "XYZ"), -1.0);
+}
+
 void TestCurrencyConverter::testSupportedCurrencies() {
   QStringList currencies = m_converter->supportedCurrencies();
   // Should have at least some currencies even without network
@@ -169,5 +234,32 @@ void TestCurrencyConverter::testConvertSameCurrency() {
   QCOMPARE(result, 100.0);
 }
 
+void TestCurrencyConverter::testConvertDecimalSameCurrency() {
+  bool ok;
+  Decimal result = m_converter->convertDecimal(Decimal::fromString("19.99", 2),
+                                               "USD", "usd", &ok);
+  QVERIFY(ok);
+  QCOMPARE(result.toString(), QString("19.99"));
+}
+
+void TestCurrencyConverter::testMentionsCurrency() {
+  QVERIFY(m_converter->mentionsCurrency("coffee $4.50"));
+  QVERIFY(m_converter->mentionsCurrency("rent: 1200 eur"));
+  QVERIFY(m_converter->mentionsCurrency("total in USD"));
+  QVERIFY(!m_converter->mentionsCurrency("all done, dot product 2*3"));
+  QVERIFY(!m_converter->mentionsCurrency("x = 10"));
+}
+
+void TestCurrencyConverter::benchmarkParseAndConvert() {
+  const QStringList lines = {"100 USD to EUR", "€50 in GBP", "rent 1200 TRY",
+                             "x = 5 * 3", "1.5 BTC to USD"};
+  double result;
+  QString from, to;
+  QBENCHMARK {
+    for (const QString &line : lines)
+      m_converter->parseAndConvert(line, result, from, to);
+  }
+}
+
 QTEST_MAIN(TestCurrencyConverter)
 #include "test_currency.moc"
@@ -0,0 +1,154 @@
+#include "core/GrammarRegistry.h"
+#include <QFile>
+#include <QRegularExpression>
+#include <QTemporaryDir>
+#include <QTest>
+
+class TestGrammarRegistry : public QObject {
+  Q_OBJECT
+
+private slots:
+  void testShippedGrammars();
+  void testUserOverride();
+  void testBrokenOverrideFallsBack();
+  void testNewLanguage();
+  void testLoadedOnceAndShared();
+  void testUnknownNames();
+  void testParse();
+  void testParseErrors();
+
+private:
+  static void write(const QString &path, const QByteArray &data);
+};
+
+void TestGrammarRegistry::write(const QString &path, const QByteArray &data) {
+  QFile file(path);
+  QVERIFY(file.open(QIODevice::WriteOnly));
+  file.write(data);
+}
+
+void TestGrammarRegistry::testShippedGrammars() {
+  GrammarRegistry registry({":/grammars"});
+  const QStringList languages = registry.languages();
+  QVERIFY(languages.contains("python"));
+  QVERIFY(languages.contains("rust"));
+  for (const QString &name : languages) {
+    QSharedPointer<const CodeLexer::Table> table = registry.table(name);
+    QVERIFY2(table, qPrintable(name));
+    QCOMPARE(table->grammar.name, name);
+  }
+}
+
+void TestGrammarRegistry::testUserOverride() {
+  QTemporaryDir dir;
+  QVERIFY(dir.isValid());
+  write(dir.filePath("python.json"),
+        R"({"name": "python", "keywords": ["banana"]})");
+
+  GrammarRegistry registry({dir.path(), ":/grammars"});
+  QCOMPARE(registry.table("python")->grammar.keywords,
+           QStringList({"banana"}));
+  QCOMPARE(registry.languages().count("python"), 1);
+}
+
+void TestGrammarRegistry::testBrokenOverrideFallsBack() {
+  QTemporaryDir dir;
+  QVERIFY(dir.isValid());
+  write(dir.filePath("python.json"), "{ not json");
+
+  GrammarRegistry registry({dir.path(), ":/grammars"});
+  QTest::ignoreMessage(QtWarningMsg,
+                       QRegularExpression("GrammarRegistry: Skipping"));
+  QSharedPointer<const CodeLexer::Table> table = registry.table("python");
+  QVERIFY(table);
+  QVERIFY(table->grammar.keywords.contains("def"));
+}
+
+void TestGrammarRegistry::testNewLanguage() {
+  QTemporaryDir dir;
+  QVERIFY(dir.isValid());
+  write(dir.filePath("lua.json"), R"({
+    "name": "lua",
+    "keywords": ["local", "end"],
+    "lineComments": ["--"],
+    "quotes": "\"'"
+  })");
+
+  GrammarRegistry registry({dir.path(), ":/grammars"});
+  QVERIFY(registry.contains("lua"));
+  QVERIFY(registry.languages().contains("lua"));
+
+  CodeLexer lexer(registry.table("lua"));
+  QVector<CodeLexer::Token> tokens;
+  lexer.tokenize(u"local x -- note", tokens);
+  QCOMPARE(tokens.size(), 2);
+  QCOMPARE(tokens[0].kind, CodeLexer::Keyword);
+  QCOMPARE(tokens[1].kind, CodeLexer::Comment);
+}
+
+void TestGrammarRegistry::testLoadedOnceAndShared() {
+  GrammarRegistry registry({":/grammars"});
+  QSharedPointer<const CodeLexer::Table> rust = registry.table("rust");
+  QVERIFY(rust);
+  QCOMPARE(registry.table("rust"), rust);
+  QCOMPARE(registry.table("Rust"), rust);
+
+  registry.reload();
+  QVERIFY(registry.table("rust") != rust);
+}
+
+void TestGrammarRegistry::testUnknownNames() {
+  GrammarRegistry registry({":/grammars"});
+  QVERIFY(!registry.table("cobol"));
+  QVERIFY(!registry.table(""));
+  QVERIFY(!registry.table("../grammars/rust"));
+  QVERIFY(!registry.contains("../grammars/rust"));
+
+  QVERIFY(registry.generic());
+  QCOMPARE(registry.generic(), registry.generic());
+}
+
+void TestGrammarRegistry::testParse() {
+  QByteArray json = R"({
+    "name": "sql",
+    "keywords": ["SELECT"],
+    "types": ["INT"],
+    "blockComment": ["/*", "*/"],
+    "caseInsensitive": true,
+    "functionCalls": true
+  })";
+  CodeLexer::Grammar grammar;
+  QVERIFY(GrammarRegistry::parse(json, &grammar));
+  QCOMPARE(grammar.name, QString("sql"));
+  QCOMPARE(grammar.keywords, QStringList({"SELECT", "select"}));
+  QCOMPARE(grammar.types, QStringList({"INT", "int"}));
+  QCOMPARE(grammar.blockCommentStart, QString("/*"));
+  QCOMPARE(grammar.blockCommentEnd, QString("*/"));
+  QVERIFY(grammar.functionCalls);
+  QVERIFY(!grammar.preprocessor);
+}
+
+void TestGrammarRegistry::testParseErrors() {
+  CodeLexer::Grammar grammar;
+  QString error;
+  QVERIFY(!GrammarRegistry::parse("[]", &grammar, &error));
+  QVERIFY(!error.isEmpty());
+  QVERIFY(!GrammarRegistry::parse(R"({"keywords": []})", &grammar, &error));
+  QVERIFY(error.contains("name"));
+  QVERIFY(!GrammarRegistry::parse(R"({"name": "x", "keywords": "if"})",
+                                  &grammar, &error));
+  QVERIFY(error.contains("keywords"));
+  QVERIFY(!GrammarRegistry::parse(R"({"name": "x", "blockComment": ["/*"]})",
+                                  &grammar, &error));
+  QVERIFY(error.contains("blockComment"));
+  QVERIFY(!GrammarRegistry::parse(R"({"name": "x", "lineComments": [""]})",
+                                  &grammar, &error));
+  QVERIFY(error.contains("lineComments"));
+  QVERIFY(!GrammarRegistry::parse(
+      R"({"name": "x", "quotes": "\"'`~|", "multiLineQuotes": "\"'`~|"})",
+      &grammar, &error));
+  QVERIFY(error.contains("multiLineQuotes"));
+}
+
+QTEST_MAIN(TestGrammarRegistry)
+#include "test_grammarregistry.moc"
@@ -0,0 +1,85 @@
+#include "core/KeywordTable.h"
+#include <QTest>
+
+class TestKeywordTable : public QObject {
+  Q_OBJECT
+
+private slots:
+  void testBuiltins();
+  void testCaseAndSlash();
+  void testNotAKeyword();
+  void testAliases();
+  void testAliasShadowsKeyword();
+  void testVersion();
+
+  // Performance
+  void benchmarkLookup();
+};
+
+void TestKeywordTable::testBuiltins() {
+  KeywordTable table;
+  const QStringList &keywords = KeywordTable::builtins();
+  QVERIFY(keywords.contains("checklist"));
+  QVERIFY(keywords.contains("md"));
+  for (int i = 0; i < keywords.size(); ++i)
+    QCOMPARE(table.indexOf(keywords[i]), i);
+}
+
+void TestKeywordTable::testCaseAndSlash() {
+  KeywordTable table;
+  QCOMPARE(table.resolve(u"Code"), QString("code"));
+  QCOMPARE(table.resolve(u"/CALC"), QString("calc"));
+  QCOMPARE(table.resolve(u"/md"), QString("md"));
+}
+
+void TestKeywordTable::testNotAKeyword() {
+  KeywordTable table;
+  QCOMPARE(table.indexOf(u""), -1);
+  QCOMPARE(table.indexOf(u"/"), -1);
+  QCOMPARE(table.indexOf(u"code "), -1); // Callers trim
+  QCOMPARE(table.indexOf(u"timer 5"), -1);
+  QCOMPARE(table.indexOf(u"a much longer line than any keyword"), -1);
+  QVERIFY(table.resolve(u"codes").isEmpty());
+}
+
+void TestKeywordTable::testAliases() {
+  KeywordTable table(QMap<QString, QString>{{"checklist", "Todo"},
+                                            {"calc", "hesap"},
+                                            {"unknown", "nope"},
+                                            {"timer", ""}});
+  QCOMPARE(table.resolve(u"todo"), QString("checklist"));
+  QCOMPARE(table.resolve(u"/TODO"), QString("checklist"));
+  QCOMPARE(table.resolve(u"Hesap"), QString("calc"));
+
+  // Aliases of unknown keywords, and empty aliases, are ignored
+  QVERIFY(table.resolve(u"nope").isEmpty());
+  QCOMPARE(table.resolve(u"timer"), QString("timer"));
+
+  // The keyword itself still works
+  QCOMPARE(table.resolve(u"checklist"), QString("checklist"));
+}
+
+void TestKeywordTable::testAliasShadowsKeyword() {
+  KeywordTable table(QMap<QString, QString>{{"checklist", "list"}});
+  QCOMPARE(table.resolve(u"list"), QString("checklist"));
+}
+
+void TestKeywordTable::testVersion() {
+  QCOMPARE(KeywordTable().version(), 0);
+  QCOMPARE(KeywordTable({}, 7).version(), 7);
+}
+
+void TestKeywordTable::benchmarkLookup() {
+  KeywordTable table(
+      QMap<QString, QString>{{"checklist", "todo"}, {"calc", "hesap"}});
+  const QStringList lines = {"todo", "Calc", "some text here", "/md", "x"};
+  int hits = 0;
+  QBENCHMARK {
+    for (const QString &line : lines)
+      hits += table.indexOf(line) >= 0;
+  }
+  QVERIFY(hits > 0);
+}
+
+QTEST_MAIN(TestKeywordTable)
+#include "test_keywordtable.moc"
@@ -0,0 +1,145 @@
+#include "core/LanguageDetector.h"
+#include <QTest>
+
+class TestLanguageDetector : public QObject {
+  Q_OBJECT
+
+private slots:
+  void testDetect_data();
+  void testDetect();
+  void testShebang();
+  void testNotCode();
+  void testWindowOnly();
+  void testUpdate();
+
+  // Performance
+  void benchmarkLargePaste();
+};
+
+void TestLanguageDetector::testDetect_data() {
+  QTest::addColumn<QString>("code");
+  QTest::addColumn<int>("language");
+
+  QTest::newRow("python") << "import os\n\n"
+                             "def main(args):\n"
+                             "    if args.verbose:\n"
+                             "        print(\"hi\")\n"
+                             "    elif args.quiet:\n"
+                             "        return None\n"
+                          << int(LanguageDetector::Python);
+  QTest::newRow("javascript") << "const add = (a, b) => a + b;\n"
+                                 "console.log(add(1, 2));\n"
+                              << int(LanguageDetector::JavaScript);
+  QTest::newRow("cpp") << "#include <iostream>\n\n"
+                          "int main() {\n"
+                          "  std::cout << \"hi\";\n"
+                          "  return 0;\n"
+                          "}\n"
+                       << int(LanguageDetector::Cpp);
+  QTest::newRow("bash") << "if [ -f \"$1\" ]; then\n"
+                           "  echo \"found $(basename $1)\"\n"
+                           "fi\n"
+                        << int(LanguageDetector::Bash);
+  QTest::newRow("json") << "{\n"
+                           "  \"name\": \"linnote\",\n"
+                           "  \"version\": 1,\n"
+                           "  \"tags\": [\"a\", null]\n"
+                           "}\n"
+                        << int(LanguageDetector::Json);
+  QTest::newRow("rust") << "fn main() {\n"
+                           "    let mut v = Vec::new();\n"
+                           "    v.push(1);\n"
+                           "    println!(\"{:?}\", v);\n"
+                           "}\n"
+                        << int(LanguageDetector::Rust);
+  QTest::newRow("go") << "package main\n\n"
+                         "import \"fmt\"\n\n"
+                         "func main() {\n"
+                         "\tx := 1\n"
+                         "\tfmt.Println(x)\n"
+                         "}\n"
+                      << int(LanguageDetector::Go);
+  QTest::newRow("sql") << "SELECT id, name FROM users WHERE age > 18;\n"
+                       << int(LanguageDetector::Sql);
+  QTest::newRow("sql lower case") << "select * from users where id = 1;\n"
+                                  << int(LanguageDetector::Sql);
+  QTest::newRow("yaml") << "name: linnote\n"
+                           "version: 1.0\n"
+                           "dependencies:\n"
+                           "  - qt6\n"
+                           "  - cmake\n"
+                        << int(LanguageDetector::Yaml);
+  QTest::newRow("toml") << "[package]\n"
+                           "name = \"linnote\"\n"
+                           "version = \"1.0\"\n\n"
+                           "[dependencies]\n"
+                           "serde = \"1\"\n"
+                        << int(LanguageDetector::Toml);
+  QTest::newRow("java") << "public class Main {\n"
+                           "  public static void main(String[] args) {\n"
+                           "    System.out.println(\"hi\");\n"
+                           "  }\n"
+                           "}\n"
+                        << int(LanguageDetector::Java);
+}
+
+void TestLanguageDetector::testDetect() {
+  QFETCH(QString, code);
+  QFETCH(int, language);
+
+  LanguageDetector::Result result = LanguageDetector::detect(code);
+  QCOMPARE(int(result.language), language);
+  QVERIFY2(result.confidence >= LanguageDetector::MinConfidence,
+           qPrintable(QString::number(result.confidence)));
+}
+
+void TestLanguageDetector::testShebang() {
+  QCOMPARE(LanguageDetector::detect(u"#!/usr/bin/env python3\nx = 1\n")
+               .language,
+           LanguageDetector::Python);
+  QCOMPARE(LanguageDetector::detect(u"#!/bin/sh\nls\n").language,
+           LanguageDetector::Bash);
+}
+
+void TestLanguageDetector::testNotCode() {
+  LanguageDetector::Result result =
+      LanguageDetector::detect(u"Buy milk and eggs tomorrow\nCall the bank");
+  QCOMPARE(result.language, LanguageDetector::Unknown);
+  QCOMPARE(result.confidence, 0.0);
+  QCOMPARE(LanguageDetector::detect(u"").language, LanguageDetector::Unknown);
+}
+
+void TestLanguageDetector::testWindowOnly() {
+  // Whatever follows the window doesn't count
+  QString text(LanguageDetector::WindowChars, ' ');
+  text += "#include <cstdio>\nint main() { std::printf(\"x\"); }\n";
+  QCOMPARE(LanguageDetector::detect(text).language, LanguageDetector::Unknown);
+}
+
+void TestLanguageDetector::testUpdate() {
+  LanguageDetector detector;
+  QString rust = "fn main() {\n    let mut x = 1;\n}\n";
+  QString padding(LanguageDetector::WindowChars, ' ');
+  QCOMPARE(detector.update(rust + padding).language, LanguageDetector::Rust);
+
+  // A change past the window keeps the result
+  QCOMPARE(detector.update(rust + padding + "def f(self):\n").language,
+           LanguageDetector::Rust);
+
+  // A change inside it doesn't
+  QString python = "def f(self):\n    return None\n";
+  QCOMPARE(detector.update(python + padding).language,
+           LanguageDetector::Python);
+  QCOMPARE(detector.result().language, LanguageDetector::Python);
+}
+
+void TestLanguageDetector::benchmarkLargePaste() {
+  QString line = "    let total = items.iter().map(|x| x.price).sum();\n";
+  QString text = "fn main() {\n" + line.repeated(100000) + "}\n";
+  LanguageDetector::Result result;
+  QBENCHMARK { result = LanguageDetector::detect(text); }
+  QCOMPARE(result.language, LanguageDetector::Rust);
+}
+
+QTEST_MAIN(TestLanguageDetector)
+#include "test_languagedetector.moc"
@@ -49,6 +49,17 @@ private slots:
   void testIsMathExpression();
   void testIsMathExpression_data();
 
+  // Decimal mode
+  void testDecimalExactSum();
+  void testDecimalArithmetic();
+  void testDecimalVariablesAndAggregates();
+  void testAggregateAssignment();
+  void testDecimalRounding();
+
+  // Throughput: decimal vs double path
+  void benchmarkDoubleSheet();
+  void benchmarkDecimalSheet();
+
 private:
   MathEvaluator *m_evaluator;
 };
@@ -318,5 +329,113 @@ void TestMathEvaluator::testIsMathExpression() {
   QCOMPARE(result, expected);
 }
 
+// ============ Decimal Mode ============
+
+void TestMathEvaluator::testDecimalExactSum() {
+  MathEvaluator eval;
+  bool ok;
+  QCOMPARE(eval.evaluateDecimal("0.1 + 0.2", &ok).toString(),
+           QString("0.3000"));
+  QVERIFY(ok);
+
+  // 1000 cents must add up to exactly 10, unlike the double path
+  Decimal total(0);
+  for (int i = 0; i < 1000; ++i)
+    total += eval.evaluateDecimal("0.01", &ok);
+  QCOMPARE(total.toString(), QString("10.0000"));
+}
+
+void TestMathEvaluator::testDecimalArithmetic() {
+  MathEvaluator eval;
+  bool ok;
+  QCOMPARE(eval.evaluateDecimal("(2+3)*4 - 10/4", &ok).toString(),
+           QString("17.5000"));
+  QVERIFY(ok);
+
+  QCOMPARE(eval.evaluateDecimal("2^10", &ok).toString(), QString("1024.0000"));
+  QCOMPARE(eval.evaluateDecimal("17 % 5", &ok).toString(), QString("2.0000"));
+  QCOMPARE(eval.evaluateDecimal("19.99 * 15%", &ok).toString(),
+           QString("2.9985"));
+  QCOMPARE(eval.evaluateDecimal("sqrt(16)", &ok).toString(),
+           QString("4.0000"));
+
+  eval.evaluateDecimal("10/0", &ok);
+  QVERIFY(!ok);
+}
+
+void TestMathEvaluator::testDecimalVariablesAndAggregates() {
+  MathEvaluator eval;
+  bool ok;
+  eval.evaluateDecimal("price = 19.99", &ok);
+  QVERIFY(ok);
+  QVERIFY(eval.getVariables().contains("price"));
+
+  eval.evaluateDecimal("price * 3", &ok);
+  QCOMPARE(eval.evaluateDecimal("sum", &ok).toString(), QString("79.9600"));
+  QCOMPARE(eval.evaluateDecimal("count()", &ok).toString(),
+           QString("2.0000"));
+  QCOMPARE(eval.evaluateDecimal("max(1.5, 2.25, 0.5)", &ok).toString(),
+           QString("2.2500"));
+}
+
+void TestMathEvaluator::testAggregateAssignment() {
+  // Both modes take an aggregate on the right of an assignment
+  MathEvaluator eval;
+  bool ok;
+  eval.evaluateDecimal("rent = 1200.50", &ok);
+  eval.evaluateDecimal("food: 310.25", &ok);
+  QCOMPARE(eval.evaluateDecimal("total = sum", &ok).toString(),
+           QString("1510.7500"));
+  QVERIFY(ok);
+  QCOMPARE(eval.evaluateDecimal("total", &ok).toString(),
+           QString("1510.7500"));
+  QCOMPARE(eval.evaluateDecimal("mean: avg()", &ok).toString(),
+           QString("1133.0625"));
+  QVERIFY(ok);
+
+  MathEvaluator plain;
+  plain.evaluate("a = 10", &ok);
+  plain.evaluate("b = 20", &ok);
+  QCOMPARE(plain.evaluate("total = sum", &ok), 30.0);
+  QVERIFY(ok);
+  QCOMPARE(plain.evaluate("count", &ok), 3.0);
+}
+
+void TestMathEvaluator::testDecimalRounding() {
+  MathEvaluator eval;
+  eval.setDecimalScale(2);
+  bool ok;
+  // Half away from zero, at the configured scale
+  QCOMPARE(eval.evaluateDecimal("2/3", &ok).toString(), QString("0.67"));
+  QCOMPARE(eval.evaluateDecimal("-0.125 * 1", &ok).toString(),
+           QString("-0.13"));
+  QCOMPARE(eval.evaluateDecimal("round(2.5)", &ok).toString(),
+           QString("3.00"));
+  QCOMPARE(eval.evaluateDecimal("floor(-2.5)", &ok).toString(),
+           QString("-3.00"));
+}
+
+void TestMathEvaluator::benchmarkDoubleSheet() {
+  MathEvaluator eval;
+  bool ok;
+  QBENCHMARK {
+    eval.clear();
+    for (int i = 0; i < 100; ++i)
+      eval.evaluate("19.99 * 3 + 4.50 - 10% * 12.75", &ok);
+    eval.evaluate("sum", &ok);
+  }
+}
+
+void TestMathEvaluator::benchmarkDecimalSheet() {
+  MathEvaluator eval;
+  bool ok;
+  QBENCHMARK {
+    eval.clear();
+    for (int i = 0; i < 100; ++i)
+      eval.evaluateDecimal("19.99 * 3 + 4.50 - 10% * 12.75", &ok);
+    eval.evaluateDecimal("sum", &ok);
+  }
+}
+
 QTEST_MAIN(TestMathEvaluator)
 #include "test_matheval.moc"
@@ -0,0 +1,145 @@
+#include "core/MathSheetWorker.h"
+#include <QTest>
+
+class TestMathSheetWorker : public QObject {
+  Q_OBJECT
+
+private slots:
+  void init();
+  void cleanup();
+
+  // ============ Line Evaluation ============
+  void testEvaluateLineMath();
+  void testEvaluateLineUnit();
+  void testEvaluateLineNotMath();
+
+  // ============ Sheet Runs ============
+  void testSheetVariables();
+  void testOnlyChangedLinesReported();
+  void testSupersededRunIsDropped();
+  void testAllLinesWhenBaseNotShown();
+
+  // ============ Benchmark ============
+  void benchmarkSheet();
+
+private:
+  struct Run {
+    int version = -1;
+    int lineCount = 0;
+    QMap<int, QString> changed;
+  };
+
+  MathSheetWorker *m_worker;
+  QList<Run> m_runs;
+};
+
+void TestMathSheetWorker::init() {
+  m_worker = new MathSheetWorker;
+  m_runs.clear();
+  connect(m_worker, &MathSheetWorker::evaluated, this,
+          [this](int version, int lineCount, const QMap<int, QString> &changed,
+                 const MathEvaluator &) {
+            m_runs.append({version, lineCount, changed});
+          });
+}
+
+void TestMathSheetWorker::cleanup() { delete m_worker; }
+
+// ============ Line Evaluation ============
+
+void TestMathSheetWorker::testEvaluateLineMath() {
+  MathEvaluator eval;
+  QCOMPARE(MathSheetWorker::evaluateLine(eval, "2 + 3"), QString("5"));
+  QCOMPARE(MathSheetWorker::evaluateLine(eval, "10 / 4"), QString("2.5000"));
+}
+
+void TestMathSheetWorker::testEvaluateLineUnit() {
+  MathEvaluator eval;
+  QVERIFY(!MathSheetWorker::evaluateLine(eval, "1 km to m").isEmpty());
+}
+
+void TestMathSheetWorker::testEvaluateLineNotMath() {
+  MathEvaluator eval;
+  QVERIFY(MathSheetWorker::evaluateLine(eval, "").isEmpty());
+  QVERIFY(MathSheetWorker::evaluateLine(eval, "shopping list").isEmpty());
+}
+
+// ============ Sheet Runs ============
+
+void TestMathSheetWorker::testSheetVariables() {
+  m_worker->supersede(1);
+  m_worker->evaluate(1, -1, "x = 10\n\nx * 2", 4);
+
+  QCOMPARE(m_runs.size(), 1);
+  QCOMPARE(m_runs[0].lineCount, 3);
+  QCOMPARE(m_runs[0].changed.value(0), QString("10"));
+  QCOMPARE(m_runs[0].changed.value(2), QString("20"));
+}
+
+void TestMathSheetWorker::testOnlyChangedLinesReported() {
+  m_worker->supersede(1);
+  m_worker->evaluate(1, -1, "1 + 1\n2 + 2\n3 + 3", 4);
+  m_worker->supersede(2);
+  m_worker->evaluate(2, 1, "1 + 1\n2 + 5\n3 + 3", 4);
+
+  QCOMPARE(m_runs.size(), 2);
+  QCOMPARE(m_runs[0].changed.size(), 3);
+  QCOMPARE(m_runs[1].changed.size(), 1);
+  QCOMPARE(m_runs[1].changed.value(1), QString("7"));
+}
+
+void TestMathSheetWorker::testSupersededRunIsDropped() {
+  // A newer keystroke was registered before the old run started
+  m_worker->supersede(2);
+  m_worker->evaluate(1, -1, "1 + 1", 4);
+  QVERIFY(m_runs.isEmpty());
+
+  m_worker->evaluate(2, -1, "1 + 1", 4);
+  QCOMPARE(m_runs.size(), 1);
+  QCOMPARE(m_runs[0].version, 2);
+
+  // Cancel everything
+  m_worker->supersede(-1);
+  m_worker->evaluate(3, 2, "2 + 2", 4);
+  QCOMPARE(m_runs.size(), 1);
+}
+
+void TestMathSheetWorker::testAllLinesWhenBaseNotShown() {
+  m_worker->supersede(1);
+  m_worker->evaluate(1, -1, "1 + 1\n2 + 2", 4);
+
+  // The caller dropped run 1 and still shows nothing: no diff against it
+  m_worker->supersede(2);
+  m_worker->evaluate(2, -1, "1 + 1\n2 + 2", 4);
+  QCOMPARE(m_runs[1].changed.size(), 2);
+
+  // It shows run 1, not run 2
+  m_worker->supersede(3);
+  m_worker->evaluate(3, 1, "1 + 1\n2 + 2", 4);
+  QCOMPARE(m_runs[2].changed.size(), 2);
+
+  // It shows run 3: nothing changed, one line less
+  m_worker->supersede(4);
+  m_worker->evaluate(4, 3, "1 + 1", 4);
+  QVERIFY(m_runs[3].changed.isEmpty());
+  QCOMPARE(m_runs[3].lineCount, 1);
+}
+
+// ============ Benchmark ============
+
+void TestMathSheetWorker::benchmarkSheet() {
+  QStringList lines;
+  for (int i = 0; i < 500; ++i) {
+    lines << QString("item%1 = %2 * 3").arg(i).arg(i);
+  }
+  const QString sheet = lines.join('\n');
+
+  int version = 0;
+  QBENCHMARK {
+    m_worker->supersede(++version);
+    m_worker->evaluate(version, version - 1, sheet, 4);
+  }
+}
+
+QTEST_MAIN(TestMathSheetWorker)
+#include "test_mathsheet.moc"
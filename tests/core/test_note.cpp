@@ -0,0 +1,82 @@
+#include "core/Note.h"
+#include <QTest>
+
+class TestNote : public QObject {
+  Q_OBJECT
+
+private slots:
+  void testApplyEdit_data();
+  void testApplyEdit();
+  void testApplyEditOutOfRange();
+  void testApplyEditMarksModified();
+  void testApplyEditSameText();
+
+  // Performance
+  void benchmarkTyping();
+};
+
+void TestNote::testApplyEdit_data() {
+  QTest::addColumn<QString>("before");
+  QTest::addColumn<int>("position");
+  QTest::addColumn<int>("removed");
+  QTest::addColumn<QString>("added");
+  QTest::addColumn<QString>("after");
+
+  QTest::newRow("insert") << "hello world" << 5 << 0 << "," << "hello, world";
+  QTest::newRow("append") << "code" << 4 << 0 << "\n" << "code\n";
+  QTest::newRow("delete") << "hello world" << 5 << 6 << "" << "hello";
+  QTest::newRow("replace") << "1 + 2" << 4 << 1 << "20" << "1 + 20";
+  QTest::newRow("into empty") << "" << 0 << 0 << "text" << "text";
+  QTest::newRow("everything") << "old" << 0 << 3 << "new" << "new";
+}
+
+void TestNote::testApplyEdit() {
+  QFETCH(QString, before);
+  QFETCH(int, position);
+  QFETCH(int, removed);
+  QFETCH(QString, added);
+  QFETCH(QString, after);
+
+  Note note(before);
+  QVERIFY(note.applyEdit(position, removed, added));
+  QCOMPARE(note.content(), after);
+}
+
+void TestNote::testApplyEditOutOfRange() {
+  Note note("abc");
+  QVERIFY(!note.applyEdit(4, 0, u"x"));
+  QVERIFY(!note.applyEdit(2, 2, u""));
+  QVERIFY(!note.applyEdit(-1, 0, u"x"));
+  QVERIFY(!note.applyEdit(0, -1, u"x"));
+  QCOMPARE(note.content(), QString("abc"));
+}
+
+void TestNote::testApplyEditMarksModified() {
+  Note note("abc");
+  note.markSaved();
+  QVERIFY(!note.isModified());
+  QVERIFY(note.applyEdit(3, 0, u"d"));
+  QVERIFY(note.isModified());
+}
+
+void TestNote::testApplyEditSameText() {
+  // A format-only change reports the text it already has
+  Note note("abc");
+  note.markSaved();
+  QVERIFY(note.applyEdit(0, 3, u"abc"));
+  QVERIFY(!note.isModified());
+}
+
+void TestNote::benchmarkTyping() {
+  // One character at the end of a large note, as the editor reports it
+  const int size = 1 << 20;
+  Note note(QString(size, 'x'));
+  QBENCHMARK {
+    note.applyEdit(size, 0, u"a");
+    note.applyEdit(size, 1, u"");
+  }
+  QCOMPARE(note.content().size(), qsizetype(size));
+}
+
+QTEST_MAIN(TestNote)
+#include "test_note.moc"
@@ -0,0 +1,125 @@
+#include "core/PasteCleaner.h"
+#include <QRandomGenerator>
+#include <QTest>
+
+class TestPasteCleaner : public QObject {
+  Q_OBJECT
+
+private slots:
+  void testNoOptions();
+  void testTrimAndEmptyLines();
+  void testNumbersAndBullets();
+  void testMarkdown();
+  void testChunksMatchClean();
+
+  // Performance
+  void benchmarkClean();
+};
+
+namespace {
+
+PasteCleaner::Options allOptions() {
+  PasteCleaner::Options options;
+  options.trimLines = true;
+  options.removeNumbers = true;
+  options.removeBullets = true;
+  options.removeMarkdown = true;
+  options.removeEmptyLines = true;
+  return options;
+}
+
+} // namespace
+
+void TestPasteCleaner::testNoOptions() {
+  PasteCleaner cleaner;
+  QVERIFY(!PasteCleaner::Options().any());
+  QCOMPARE(cleaner.clean(u""), QString());
+  QCOMPARE(cleaner.clean(u"  - **a**\n\n1. b\n"),
+           QString("  - **a**\n\n1. b\n"));
+}
+
+void TestPasteCleaner::testTrimAndEmptyLines() {
+  PasteCleaner::Options options;
+  options.trimLines = true;
+  QCOMPARE(PasteCleaner(options).clean(u"  a  \n\tb\n \n"),
+           QString("a\nb\n\n"));
+
+  options.removeEmptyLines = true;
+  QCOMPARE(PasteCleaner(options).clean(u"  a  \n\n\tb\n \n"),
+           QString("a\nb"));
+}
+
+void TestPasteCleaner::testNumbersAndBullets() {
+  PasteCleaner::Options options;
+  options.removeNumbers = true;
+  QCOMPARE(PasteCleaner(options).clean(u"1. one\n  12) two\n3 three\n4.5"),
+           QString("one\ntwo\n3 three\n5"));
+
+  options = PasteCleaner::Options();
+  options.removeBullets = true;
+  QCOMPARE(PasteCleaner(options).clean(u"- a\n• b\n  * c\n→d\n+ e"),
+           QString("a\nb\nc\nd\n+ e"));
+}
+
+void TestPasteCleaner::testMarkdown() {
+  PasteCleaner::Options options;
+  options.removeMarkdown = true;
+  PasteCleaner cleaner(options);
+  QCOMPARE(cleaner.clean(u"## Title"), QString("Title"));
+  QCOMPARE(cleaner.clean(u"**bold**, _it_ and `code`"),
+           QString("bold, it and code"));
+  QCOMPARE(cleaner.clean(u"see [the site](https://example.com) now"),
+           QString("see the site now"));
+  QCOMPARE(cleaner.clean(u"**`x`** [**y**](z)"), QString("x y"));
+
+  // Not markup
+  QCOMPARE(cleaner.clean(u"snake_case_name"), QString("snake_case_name"));
+  QCOMPARE(cleaner.clean(u"2 ** 3 and a*b"), QString("2 ** 3 and a*b"));
+  QCOMPARE(cleaner.clean(u"[x] (y) [z]()"), QString("[x] (y) [z]()"));
+  QCOMPARE(cleaner.clean(u"C# and #tag"), QString("C# and #tag"));
+}
+
+void TestPasteCleaner::testChunksMatchClean() {
+  // Pieces of any size add up to the text cleaned at once
+  static const char *const lines[] = {
+      "", "  ", "1. first", "- item", "**bold** text", "  _it_ `code`",
+      "[link](url)", "# Heading", "plain line", "\t2) second"};
+  QRandomGenerator random(3);
+  QString text;
+  for (int i = 0; i < 2000; ++i) {
+    if (i > 0)
+      text += '\n';
+    text += QString::fromUtf8(lines[random.bounded(10)]);
+  }
+
+  for (bool all : {false, true}) {
+    PasteCleaner::Options options =
+        all ? allOptions() : PasteCleaner::Options();
+    QString expected = PasteCleaner(options).clean(text);
+    for (qsizetype minChars : {1, 7, 100, 4096}) {
+      PasteCleaner cleaner(options);
+      QString joined;
+      while (!cleaner.atEnd(text)) {
+        qsizetype position = cleaner.position();
+        joined += cleaner.next(text, minChars);
+        QVERIFY(cleaner.position() > position);
+      }
+      QCOMPARE(joined, expected);
+    }
+  }
+}
+
+void TestPasteCleaner::benchmarkClean() {
+  // About 4 MB of pasted list with every cleanup on
+  QString line = "  3. - **Total** for _March_: `42` [see](https://x.io/r)";
+  QString text;
+  for (int i = 0; i < 70000; ++i)
+    text += line + '\n';
+  PasteCleaner cleaner(allOptions());
+  QString cleaned;
+  QBENCHMARK { cleaned = cleaner.clean(text); }
+  QVERIFY(cleaned.startsWith("Total for March: 42 see\n"));
+}
+
+QTEST_MAIN(TestPasteCleaner)
+#include "test_pastecleaner.moc"
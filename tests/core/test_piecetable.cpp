@@ -0,0 +1,166 @@
+#include "core/PieceTable.h"
+#include <QRandomGenerator>
+#include <QTest>
+
+class TestPieceTable : public QObject {
+  Q_OBJECT
+
+private slots:
+  void testEmpty();
+  void testFromText();
+  void testInsertRemove();
+  void testClamping();
+  void testTypingMergesPieces();
+  void testSnapshot();
+  void testUnchangedTextIsShared();
+  void testMidAndAt();
+  void testEquals();
+  void testRandomEdits();
+
+  // Performance
+  void benchmarkInsertInLargeText();
+};
+
+void TestPieceTable::testEmpty() {
+  PieceTable table;
+  QVERIFY(table.isEmpty());
+  QCOMPARE(table.size(), qsizetype(0));
+  QVERIFY(table.toString().isEmpty());
+  QVERIFY(table.chunks().isEmpty());
+  QCOMPARE(table.at(0), QChar());
+  QVERIFY(PieceTable(QString()).isEmpty());
+}
+
+void TestPieceTable::testFromText() {
+  QString text(PieceTable::MaxPiece * 5 + 17, 'a');
+  PieceTable table(text);
+  QCOMPARE(table.size(), text.size());
+  QCOMPARE(table.toString(), text);
+
+  // Loaded text is split into pieces of at most MaxPiece
+  const QVector<QStringView> chunks = table.chunks();
+  QVERIFY(chunks.size() > 5);
+  for (QStringView chunk : chunks)
+    QVERIFY(chunk.size() <= PieceTable::MaxPiece);
+}
+
+void TestPieceTable::testInsertRemove() {
+  PieceTable table(QStringLiteral("hello world"));
+  table.insert(5, u",");
+  QCOMPARE(table.toString(), QString("hello, world"));
+  table.insert(0, u">> ");
+  table.insert(table.size(), u"!");
+  QCOMPARE(table.toString(), QString(">> hello, world!"));
+  table.remove(0, 3);
+  QCOMPARE(table.toString(), QString("hello, world!"));
+  table.replace(7, 5, u"there");
+  QCOMPARE(table.toString(), QString("hello, there!"));
+  table.remove(0, table.size());
+  QVERIFY(table.isEmpty());
+}
+
+void TestPieceTable::testClamping() {
+  PieceTable table(QStringLiteral("abc"));
+  table.insert(10, u"d");
+  table.insert(-5, u"_");
+  QCOMPARE(table.toString(), QString("_abcd"));
+  table.remove(3, 100);
+  QCOMPARE(table.toString(), QString("_ab"));
+  table.remove(-1, 0);
+  table.remove(5, 1);
+  QCOMPARE(table.toString(), QString("_ab"));
+}
+
+void TestPieceTable::testTypingMergesPieces() {
+  PieceTable table;
+  for (int i = 0; i < 500; ++i)
+    table.insert(table.size(), u"x");
+  QCOMPARE(table.size(), qsizetype(500));
+  QCOMPARE(table.chunks().size(), qsizetype(1));
+
+  // Past MaxPiece a new piece starts
+  for (int i = 0; i < PieceTable::MaxPiece; ++i)
+    table.insert(table.size(), u"y");
+  QCOMPARE(table.chunks().size(), qsizetype(2));
+}
+
+void TestPieceTable::testSnapshot() {
+  PieceTable table(QString(3000, 'a'));
+  PieceTable snapshot = table;
+  table.insert(1500, u"edit");
+  table.remove(0, 10);
+
+  QCOMPARE(snapshot.toString(), QString(3000, 'a'));
+  QCOMPARE(table.size(), qsizetype(2994));
+  QCOMPARE(table.mid(1490, 4), QString("edit"));
+}
+
+void TestPieceTable::testUnchangedTextIsShared() {
+  QString text(PieceTable::MaxPiece * 3, 'z');
+  PieceTable table(text);
+  QCOMPARE(table.toString().constData(), text.constData());
+
+  table.insert(10, u"!");
+  QVERIFY(table.toString().constData() != text.constData());
+}
+
+void TestPieceTable::testMidAndAt() {
+  QString text;
+  for (int i = 0; i < 5000; ++i)
+    text.append(QChar('a' + i % 26));
+  PieceTable table(text);
+  table.insert(2048, u"[]");
+  text.insert(2048, u"[]");
+
+  QCOMPARE(table.mid(2040, 20), text.mid(2040, 20));
+  QCOMPARE(table.mid(4990), text.mid(4990));
+  QCOMPARE(table.mid(0, 0), QString());
+  QCOMPARE(table.at(2048), QChar('['));
+  QCOMPARE(table.at(table.size() - 1), text.back());
+  QCOMPARE(table.at(table.size()), QChar());
+}
+
+void TestPieceTable::testEquals() {
+  PieceTable table(QStringLiteral("one two"));
+  table.insert(3, u" and");
+  QVERIFY(table.equals(u"one and two"));
+  QVERIFY(!table.equals(u"one and tw"));
+  QVERIFY(!table.equals(u"one and twO"));
+  QVERIFY(PieceTable().equals(u""));
+}
+
+void TestPieceTable::testRandomEdits() {
+  QRandomGenerator random(42);
+  QString expected(4000, 'a');
+  PieceTable table(expected);
+
+  for (int i = 0; i < 2000; ++i) {
+    int position = random.bounded(int(expected.size()) + 1);
+    if (random.bounded(3) > 0) {
+      QString text(1 + random.bounded(i % 50 == 0 ? 3000 : 5),
+                   QChar('b' + random.bounded(20)));
+      table.insert(position, text);
+      expected.insert(position, text);
+    } else {
+      int count = random.bounded(40);
+      table.remove(position, count);
+      expected.remove(position, count);
+    }
+    QCOMPARE(table.size(), expected.size());
+  }
+  QCOMPARE(table.toString(), expected);
+}
+
+void TestPieceTable::benchmarkInsertInLargeText() {
+  // A keystroke in the middle of 10 MB
+  PieceTable table(QString(10 * 1024 * 1024, 'a'));
+  const qsizetype middle = table.size() / 2;
+  QBENCHMARK {
+    table.insert(middle, u"x");
+    table.remove(middle, 1);
+  }
+  QCOMPARE(table.size(), qsizetype(10 * 1024 * 1024));
+}
+
+QTEST_MAIN(TestPieceTable)
+#include "test_piecetable.moc"
@@ -0,0 +1,227 @@
+#include "core/RateFetchScheduler.h"
+#include <QNetworkAccessManager>
+#include <QSignalSpy>
+#include <QTcpServer>
+#include <QTcpSocket>
+#include <QTest>
+
+/**
+ * Stand-in for a rate provider: counts requests, answers with an ETag and
+ * honours If-None-Match. failNext makes it return 503 instead.
+ */
+class StandInServer : public QTcpServer {
+public:
+  int requests = 0;
+  int notModified = 0;
+  int failNext = 0;
+  QByteArray etag = "\"rates-v1\"";
+  QByteArray lastIfNoneMatch;
+
+  StandInServer() {
+    connect(this, &QTcpServer::newConnection, this, [this]() {
+      while (QTcpSocket *socket = nextPendingConnection()) {
+        connect(socket, &QTcpSocket::readyRead, this,
+                [this, socket]() { handle(socket); });
+        connect(socket, &QTcpSocket::disconnected, socket,
+                &QObject::deleteLater);
+      }
+    });
+  }
+
+  QUrl url() const {
+    return QUrl(QString("http://127.0.0.1:%1/rates").arg(serverPort()));
+  }
+
+private:
+  void handle(QTcpSocket *socket) {
+    QByteArray head =
+        socket->property("head").toByteArray() + socket->readAll();
+    socket->setProperty("head", head);
+    if (!head.contains("\r\n\r\n"))
+      return;
+    requests++;
+
+    lastIfNoneMatch.clear();
+    for (const QByteArray &line : head.split('\n')) {
+      if (line.toLower().startsWith("if-none-match:"))
+        lastIfNoneMatch = line.mid(14).trimmed();
+    }
+
+    QByteArray response;
+    if (failNext > 0) {
+      failNext--;
+      response = "HTTP/1.1 503 Service Unavailable\r\nContent-Length: 0\r\n"
+                 "Connection: close\r\n\r\n";
+    } else if (lastIfNoneMatch == etag) {
+      notModified++;
+      response = "HTTP/1.1 304 Not Modified\r\nETag: " + etag +
+                 "\r\nConnection: close\r\n\r\n";
+    } else {
+      QByteArray body = R"({"rates":{"EUR":0.9}})";
+      response = "HTTP/1.1 200 OK\r\nContent-Type: application/json\r\nETag: " +
+                 etag + "\r\nContent-Length: " +
+                 QByteArray::number(body.size()) +
+                 "\r\nConnection: close\r\n\r\n" + body;
+    }
+    socket->write(response);
+    socket->disconnectFromHost();
+  }
+};
+
+class TestRateFetchScheduler : public QObject {
+  Q_OBJECT
+
+private slots:
+  void init();
+  void cleanup();
+
+  // ============ Scheduling ============
+  void testFetchesOnRegistration();
+  void testIntervalSuppressesRepeats();
+  void testForcedRefreshIsConditional();
+
+  // ============ Backoff ============
+  void testBackoffAfterFailure();
+  void testSuccessResetsBackoff();
+
+  // ============ State ============
+  void testStateRoundTrip();
+  void testChangedUrlForgetsValidators();
+
+private:
+  StandInServer *m_server;
+  QNetworkAccessManager *m_manager;
+  RateFetchScheduler *m_scheduler;
+};
+
+void TestRateFetchScheduler::init() {
+  m_server = new StandInServer;
+  QVERIFY(m_server->listen(QHostAddress::LocalHost));
+  m_manager = new QNetworkAccessManager;
+  m_scheduler = new RateFetchScheduler(m_manager);
+  m_scheduler->setIntervalMinutes(60);
+  m_scheduler->setBackoffBase(1000);
+}
+
+void TestRateFetchScheduler::cleanup() {
+  delete m_scheduler;
+  delete m_manager;
+  delete m_server;
+}
+
+// ============ Scheduling ============
+
+void TestRateFetchScheduler::testFetchesOnRegistration() {
+  QSignalSpy fetched(m_scheduler, &RateFetchScheduler::fetched);
+  m_scheduler->setEndpoint("fiat", QNetworkRequest(m_server->url()));
+
+  QVERIFY(fetched.wait(5000));
+  QCOMPARE(fetched.first().at(0).toString(), QString("fiat"));
+  QVERIFY(fetched.first().at(1).toByteArray().contains("EUR"));
+  QCOMPARE(m_server->requests, 1);
+}
+
+void TestRateFetchScheduler::testIntervalSuppressesRepeats() {
+  QSignalSpy fetched(m_scheduler, &RateFetchScheduler::fetched);
+  m_scheduler->setEndpoint("fiat", QNetworkRequest(m_server->url()));
+  QVERIFY(fetched.wait(5000));
+
+  // Typing "calc" over and over must not hit the network again
+  for (int i = 0; i < 50; ++i) {
+    m_scheduler->refresh();
+  }
+  QTest::qWait(200);
+
+  QCOMPARE(m_server->requests, 1);
+  QCOMPARE(m_scheduler->requestsSent(), 1);
+  QVERIFY(m_scheduler->nextFetch("fiat") >
+          QDateTime::currentDateTimeUtc().addSecs(59 * 60));
+}
+
+void TestRateFetchScheduler::testForcedRefreshIsConditional() {
+  QSignalSpy fetched(m_scheduler, &RateFetchScheduler::fetched);
+  QSignalSpy notModified(m_scheduler, &RateFetchScheduler::notModified);
+  m_scheduler->setEndpoint("fiat", QNetworkRequest(m_server->url()));
+  QVERIFY(fetched.wait(5000));
+
+  m_scheduler->refresh(true);
+  QVERIFY(notModified.wait(5000));
+
+  QCOMPARE(m_server->requests, 2);
+  QCOMPARE(m_server->notModified, 1);
+  QCOMPARE(m_server->lastIfNoneMatch, m_server->etag);
+  QCOMPARE(fetched.count(), 1);
+}
+
+// ============ Backoff ============
+
+void TestRateFetchScheduler::testBackoffAfterFailure() {
+  m_server->failNext = 2;
+  QSignalSpy failed(m_scheduler, &RateFetchScheduler::failed);
+  m_scheduler->setEndpoint("fiat", QNetworkRequest(m_server->url()));
+  QVERIFY(failed.wait(5000));
+
+  // Equal jitter: between half and all of the base delay
+  QDateTime now = QDateTime::currentDateTimeUtc();
+  qint64 wait = now.msecsTo(m_scheduler->nextFetch("fiat"));
+  QCOMPARE(m_scheduler->failureCount("fiat"), 1);
+  QVERIFY(wait > 300 && wait <= 1000);
+
+  // Not due yet: a non-forced refresh sends nothing
+  m_scheduler->refresh();
+  QCOMPARE(m_server->requests, 1);
+
+  // The retry timer fires by itself; the second delay doubles
+  QVERIFY(failed.wait(5000));
+  QCOMPARE(m_scheduler->failureCount("fiat"), 2);
+  wait = QDateTime::currentDateTimeUtc().msecsTo(m_scheduler->nextFetch("fiat"));
+  QVERIFY(wait > 800 && wait <= 2000);
+}
+
+void TestRateFetchScheduler::testSuccessResetsBackoff() {
+  m_server->failNext = 1;
+  QSignalSpy failed(m_scheduler, &RateFetchScheduler::failed);
+  QSignalSpy fetched(m_scheduler, &RateFetchScheduler::fetched);
+  m_scheduler->setEndpoint("fiat", QNetworkRequest(m_server->url()));
+  QVERIFY(failed.wait(5000));
+  QVERIFY(fetched.wait(5000));
+
+  QCOMPARE(m_scheduler->failureCount("fiat"), 0);
+  QCOMPARE(m_server->requests, 2);
+}
+
+// ============ State ============
+
+void TestRateFetchScheduler::testStateRoundTrip() {
+  QSignalSpy fetched(m_scheduler, &RateFetchScheduler::fetched);
+  m_scheduler->setEndpoint("fiat", QNetworkRequest(m_server->url()));
+  QVERIFY(fetched.wait(5000));
+  QJsonObject state = m_scheduler->saveState();
+
+  // A restarted app with fresh state doesn't fetch at startup
+  RateFetchScheduler restarted(m_manager);
+  restarted.setIntervalMinutes(60);
+  restarted.setEndpoint("fiat", QNetworkRequest(m_server->url()));
+  restarted.restoreState(state);
+  QTest::qWait(200);
+
+  QCOMPARE(m_server->requests, 1);
+  QCOMPARE(restarted.requestsSent(), 0);
+}
+
+void TestRateFetchScheduler::testChangedUrlForgetsValidators() {
+  QSignalSpy fetched(m_scheduler, &RateFetchScheduler::fetched);
+  m_scheduler->setEndpoint("fiat", QNetworkRequest(m_server->url()));
+  QVERIFY(fetched.wait(5000));
+
+  QUrl other = m_server->url();
+  other.setQuery("base=EUR");
+  m_scheduler->setEndpoint("fiat", QNetworkRequest(other));
+  QVERIFY(fetched.wait(5000));
+
+  QVERIFY(m_server->lastIfNoneMatch.isEmpty());
+  QCOMPARE(m_server->requests, 2);
+}
+
+QTEST_MAIN(TestRateFetchScheduler)
+#include "test_ratefetch.moc"
@@ -0,0 +1,352 @@
+#include "core/RateHistory.h"
+#include <QFile>
+#include <QTemporaryDir>
+#include <QTest>
+
+class TestRateHistory : public QObject {
+  Q_OBJECT
+
+private slots:
+  void init();
+
+  // ============ Storage ============
+  void testEmptyHistory();
+  void testMergeAndLookup();
+  void testReopenFromDisk();
+  void testBlockBoundaries();
+  void testMergeOverwrites();
+  void testMergeAtTheEnd();
+  void testUnchangedMergeKeepsFile();
+  void testCorruptFileIgnored();
+  void testLargeRates();
+  void testUnstorableRateReported();
+
+  // ============ Lookup ============
+  void testWeekendUsesPreviousDay();
+  void testGapTooLong();
+  void testMissingCurrencyOnDay();
+  void testUsdIsBase();
+
+  // ============ Import ============
+  void testWideCsv();
+  void testLongCsv();
+  void testCsvBaseRebased();
+  void testCsvWithoutDateColumn();
+  void testFrankfurterTimeSeries();
+
+  // ============ Performance ============
+  void benchmarkLookup();
+
+private:
+  QString historyPath() const { return m_dir->filePath("history.bin"); }
+  RateHistory::Series sampleSeries(int days) const;
+
+  QScopedPointer<QTemporaryDir> m_dir;
+};
+
+void TestRateHistory::init() { m_dir.reset(new QTemporaryDir); }
+
+RateHistory::Series TestRateHistory::sampleSeries(int days) const {
+  RateHistory::Series series;
+  QDate start(2024, 1, 1);
+  for (int i = 0; i < days; ++i) {
+    series[start.addDays(i)]["EUR"] = 0.9 + 0.0001 * (i % 97);
+    series[start.addDays(i)]["JPY"] = 140.0 + 0.37 * ((i * 13) % 41);
+    series[start.addDays(i)]["BTC"] = 0.0000231 - 0.0000001 * (i % 7);
+  }
+  return series;
+}
+
+// ============ Storage ============
+
+void TestRateHistory::testEmptyHistory() {
+  RateHistory history(historyPath());
+  QVERIFY(history.isEmpty());
+  QCOMPARE(history.dayCount(), 0);
+
+  double rate;
+  QVERIFY(!history.rateOn("EUR", QDate(2024, 1, 1), rate));
+}
+
+void TestRateHistory::testMergeAndLookup() {
+  RateHistory history(historyPath());
+  QVERIFY(history.merge(sampleSeries(10)));
+
+  QCOMPARE(history.dayCount(), 10);
+  QCOMPARE(history.firstDate(), QDate(2024, 1, 1));
+  QCOMPARE(history.lastDate(), QDate(2024, 1, 10));
+  QCOMPARE(history.currencies(), QStringList({"BTC", "EUR", "JPY"}));
+
+  double rate;
+  QVERIFY(history.rateOn("eur", QDate(2024, 1, 5), rate));
+  QCOMPARE(rate, 0.9004);
+  QVERIFY(history.rateOn("BTC", QDate(2024, 1, 3), rate));
+  QCOMPARE(rate, 0.0000229);
+}
+
+void TestRateHistory::testReopenFromDisk() {
+  {
+    RateHistory history(historyPath());
+    QVERIFY(history.merge(sampleSeries(40)));
+  }
+
+  RateHistory reopened(historyPath());
+  QCOMPARE(reopened.dayCount(), 40);
+
+  double rate;
+  QVERIFY(reopened.rateOn("JPY", QDate(2024, 2, 9), rate));
+  QCOMPARE(rate, 140.0 + 0.37 * ((39 * 13) % 41));
+}
+
+void TestRateHistory::testBlockBoundaries() {
+  // Days 31, 32 and 33 straddle the first block boundary
+  RateHistory history(historyPath());
+  RateHistory::Series series = sampleSeries(100);
+  QVERIFY(history.merge(series));
+
+  for (auto it = series.constBegin(); it != series.constEnd(); ++it) {
+    for (auto rate = it->constBegin(); rate != it->constEnd(); ++rate) {
+      double stored;
+      QVERIFY(history.rateOn(rate.key(), it.key(), stored));
+      QCOMPARE(stored, rate.value());
+    }
+  }
+
+  QCOMPARE(history.read().size(), series.size());
+  QCOMPARE(history.read(QDate(2024, 2, 1), QDate(2024, 2, 3)).size(), 3);
+}
+
+void TestRateHistory::testMergeOverwrites() {
+  RateHistory history(historyPath());
+  QVERIFY(history.merge(sampleSeries(5)));
+  QVERIFY(history.merge({{QDate(2024, 1, 3), {{"EUR", 0.95}, {"GBP", 0.8}}},
+                         {QDate(2024, 1, 8), {{"EUR", 0.93}}}}));
+
+  QCOMPARE(history.dayCount(), 6);
+
+  double rate;
+  QVERIFY(history.rateOn("EUR", QDate(2024, 1, 3), rate));
+  QCOMPARE(rate, 0.95);
+  QVERIFY(history.rateOn("JPY", QDate(2024, 1, 3), rate)); // Kept
+  QVERIFY(history.rateOn("GBP", QDate(2024, 1, 3), rate));
+  QCOMPARE(rate, 0.8);
+}
+
+void TestRateHistory::testMergeAtTheEnd() {
+  // Day by day, as fetches add them: only the last block is encoded again
+  RateHistory::Series series = sampleSeries(100);
+  RateHistory history(historyPath());
+  QVERIFY(history.merge(series));
+  for (int i = 100; i < 140; ++i) {
+    QDate day = QDate(2024, 1, 1).addDays(i);
+    RateHistory::Series fetched = {
+        {day, {{"EUR", 0.9 + 0.0001 * i}, {"JPY", 150.0 + 0.01 * i}}},
+        {day.addDays(-2), {{"EUR", 0.8 + 0.0001 * i}}}};
+    QVERIFY(history.merge(fetched));
+    for (auto it = fetched.constBegin(); it != fetched.constEnd(); ++it) {
+      for (auto rate = it->constBegin(); rate != it->constEnd(); ++rate)
+        series[it.key()][rate.key()] = rate.value();
+    }
+  }
+  // Then a day at the start, which rewrites everything
+  QVERIFY(history.merge({{QDate(2024, 1, 2), {{"GBP", 0.79}}}}));
+  series[QDate(2024, 1, 2)]["GBP"] = 0.79;
+
+  RateHistory reopened(historyPath());
+  QCOMPARE(reopened.dayCount(), 140);
+  QCOMPARE(reopened.read().size(), series.size());
+  for (auto it = series.constBegin(); it != series.constEnd(); ++it) {
+    for (auto rate = it->constBegin(); rate != it->constEnd(); ++rate) {
+      double stored;
+      QVERIFY(reopened.rateOn(rate.key(), it.key(), stored));
+      QCOMPARE(stored, rate.value());
+    }
+  }
+}
+
+void TestRateHistory::testUnchangedMergeKeepsFile() {
+  RateHistory history(historyPath());
+  QVERIFY(history.merge(sampleSeries(5)));
+  QFile::remove(historyPath());
+
+  // Same values: nothing to write
+  QVERIFY(history.merge(sampleSeries(5)));
+  QVERIFY(!QFile::exists(historyPath()));
+}
+
+void TestRateHistory::testCorruptFileIgnored() {
+  QFile file(historyPath());
+  QVERIFY(file.open(QIODevice::WriteOnly));
+  file.write("LNRH not really a rate history file");
+  file.close();
+
+  RateHistory history(historyPath());
+  QVERIFY(history.isEmpty());
+
+  // Merging replaces it
+  QVERIFY(history.merge(sampleSeries(3)));
+  QCOMPARE(RateHistory(historyPath()).dayCount(), 3);
+}
+
+void TestRateHistory::testLargeRates() {
+  // Far beyond 1e-12 units per USD, as after years of hyperinflation
+  RateHistory history(historyPath());
+  QVERIFY(history.merge({{QDate(2024, 1, 1), {{"VES", 4.5}, {"EUR", 0.9}}}}));
+  QVERIFY(history.merge({{QDate(2024, 1, 2), {{"VES", 2.5e11}}},
+                         {QDate(2024, 1, 3), {{"VES", 2.75e11}}}}));
+
+  RateHistory reopened(historyPath());
+  double rate;
+  QVERIFY(reopened.rateOn("VES", QDate(2024, 1, 1), rate));
+  QCOMPARE(rate, 4.5);
+  QVERIFY(reopened.rateOn("VES", QDate(2024, 1, 3), rate));
+  QCOMPARE(rate, 2.75e11);
+  QVERIFY(reopened.rateOn("EUR", QDate(2024, 1, 1), rate));
+  QCOMPARE(rate, 0.9); // Other currencies keep their precision
+}
+
+void TestRateHistory::testUnstorableRateReported() {
+  RateHistory history(historyPath());
+  QString error;
+  QVERIFY(!history.merge({{QDate(2024, 1, 1), {{"EUR", 0.9}, {"XYZ", 1e-15}}}},
+                         &error));
+  QVERIFY(error.contains("XYZ"));
+
+  // The rest is stored; the rate doesn't turn into a missing one
+  double rate;
+  QVERIFY(history.rateOn("EUR", QDate(2024, 1, 1), rate));
+  QVERIFY(!history.currencies().contains("XYZ"));
+}
+
+// ============ Lookup ============
+
+void TestRateHistory::testWeekendUsesPreviousDay() {
+  RateHistory history(historyPath());
+  // Friday 2026-02-27, then Monday 2026-03-02
+  QVERIFY(history.merge({{QDate(2026, 2, 27), {{"EUR", 0.85}}},
+                         {QDate(2026, 3, 2), {{"EUR", 0.86}}}}));
+
+  double rate;
+  QDate effective;
+  QVERIFY(history.rateOn("EUR", QDate(2026, 3, 1), rate, &effective));
+  QCOMPARE(rate, 0.85);
+  QCOMPARE(effective, QDate(2026, 2, 27));
+
+  QVERIFY(history.rateOn("EUR", QDate(2026, 3, 2), rate, &effective));
+  QCOMPARE(rate, 0.86);
+
+  QVERIFY(!history.rateOn("EUR", QDate(2026, 2, 26), rate)); // Before first
+}
+
+void TestRateHistory::testGapTooLong() {
+  RateHistory history(historyPath());
+  QVERIFY(history.merge({{QDate(2026, 1, 1), {{"EUR", 0.85}}}}));
+
+  double rate;
+  QVERIFY(history.rateOn("EUR", QDate(2026, 1, 8), rate));
+  QVERIFY(!history.rateOn("EUR", QDate(2026, 1, 9), rate));
+}
+
+void TestRateHistory::testMissingCurrencyOnDay() {
+  RateHistory history(historyPath());
+  QVERIFY(history.merge({{QDate(2026, 1, 5), {{"EUR", 0.85}, {"TRY", 43.0}}},
+                         {QDate(2026, 1, 6), {{"EUR", 0.86}}}}));
+
+  // No TRY on the 6th: the 5th's rate is still in effect
+  double rate;
+  QDate effective;
+  QVERIFY(history.rateOn("TRY", QDate(2026, 1, 6), rate, &effective));
+  QCOMPARE(rate, 43.0);
+  QCOMPARE(effective, QDate(2026, 1, 5));
+}
+
+void TestRateHistory::testUsdIsBase() {
+  RateHistory history(historyPath());
+  double rate = 0;
+  QVERIFY(history.rateOn("USD", QDate(2026, 1, 1), rate));
+  QCOMPARE(rate, 1.0);
+  QVERIFY(!history.rateOn("USD", QDate(), rate));
+}
+
+// ============ Import ============
+
+void TestRateHistory::testWideCsv() {
+  QByteArray csv = "date,EUR,GBP\n"
+                   "2026-03-02,0.86,0.74\n"
+                   "2026-03-03,0.87,\n"
+                   "not a date,1,1\n";
+
+  RateHistory::Series series;
+  QVERIFY(RateHistory::parseCsv(csv, series));
+  QCOMPARE(series.size(), 2);
+  QCOMPARE(series[QDate(2026, 3, 2)]["GBP"], 0.74);
+  QVERIFY(!series[QDate(2026, 3, 3)].contains("GBP"));
+}
+
+void TestRateHistory::testLongCsv() {
+  QFile file(m_dir->filePath("rates.csv"));
+  QVERIFY(file.open(QIODevice::WriteOnly));
+  file.write("Date,Currency,Rate\r\n"
+             "2026-03-02,eur,0.86\r\n"
+             "2026-03-02,TRY,43.5\r\n"
+             "2026-03-03,EUR,0.87\r\n");
+  file.close();
+
+  RateHistory history(historyPath());
+  QCOMPARE(history.importCsv(file.fileName()), 2);
+
+  double rate;
+  QVERIFY(history.rateOn("TRY", QDate(2026, 3, 2), rate));
+  QCOMPARE(rate, 43.5);
+}
+
+void TestRateHistory::testCsvBaseRebased() {
+  // ECB style: per EUR, with a USD column
+  QByteArray csv = "# base: EUR\n"
+                   "Date,USD,GBP,\n"
+                   "2026-03-02,1.25,0.85,\n";
+
+  RateHistory::Series series;
+  QVERIFY(RateHistory::parseCsv(csv, series));
+  const RateHistory::DayRates &day = series[QDate(2026, 3, 2)];
+  QCOMPARE(day["EUR"], 0.8);
+  QCOMPARE(day["GBP"], 0.68);
+  QVERIFY(!day.contains("USD"));
+}
+
+void TestRateHistory::testCsvWithoutDateColumn() {
+  RateHistory::Series series;
+  QString error;
+  QVERIFY(!RateHistory::parseCsv("EUR,GBP\n0.8,0.7\n", series, "USD", &error));
+  QVERIFY(!error.isEmpty());
+}
+
+void TestRateHistory::testFrankfurterTimeSeries() {
+  QByteArray json = R"({"amount":1.0,"base":"USD","start_date":"2026-03-02",
+    "end_date":"2026-03-03","rates":{"2026-03-02":{"EUR":0.86,"JPY":150.1},
+    "2026-03-03":{"EUR":0.87,"JPY":149.8}}})";
+
+  RateHistory::Series series;
+  QVERIFY(RateHistory::parseTimeSeries(json, series));
+  QCOMPARE(series.size(), 2);
+  QCOMPARE(series[QDate(2026, 3, 3)]["JPY"], 149.8);
+
+  QVERIFY(!RateHistory::parseTimeSeries("{}", series));
+}
+
+// ============ Performance ============
+
+void TestRateHistory::benchmarkLookup() {
+  RateHistory history(historyPath());
+  QVERIFY(history.merge(sampleSeries(3650)));
+
+  double rate;
+  int day = 0;
+  QBENCHMARK {
+    history.rateOn("EUR", QDate(2024, 1, 1).addDays(day), rate);
+    day = (day + 17) % 3650;
+  }
+}
+
+QTEST_MAIN(TestRateHistory)
+#include "test_ratehistory.moc"
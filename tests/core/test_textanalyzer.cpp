@@ -1,4 +1,5 @@
 #include "core/TextAnalyzer.h"
+#include <QRandomGenerator>
 #include <QTest>
 
 class TestTextAnalyzer : public QObject {
@@ -34,6 +35,16 @@ private slots:
   void testEmptyText();
   void testNoNumbers();
   void testNegativeNumbers();
+  void testWholeNumbers();
+
+  // Single scan
+  void testScan();
+  void testScanAcrossBlocks();
+  void testScanNonAscii();
+  void testScanView();
+
+  // Performance
+  void benchmarkScan();
 
 private:
   TextAnalyzer *m_analyzer;
@@ -151,5 +162,100 @@ void TestTextAnalyzer::testNegativeNumbers() {
   QCOMPARE(sum, 2.0);
 }
 
+void TestTextAnalyzer::testWholeNumbers() {
+  // Long integers stay whole; commas only group after 1-3 digits
+  QCOMPARE(m_analyzer->extractNumbers("12345"), QList<double>{12345});
+  QCOMPARE(m_analyzer->extractNumbers("1,000,000.5"),
+           QList<double>{1000000.5});
+  QCOMPARE(m_analyzer->extractNumbers("1234,567"),
+           (QList<double>{1234, 567}));
+  QCOMPARE(m_analyzer->extractNumbers("- 5 and x-3"),
+           (QList<double>{-5, -3}));
+  QCOMPARE(m_analyzer->extractNumbers("1.2.3 - -"), (QList<double>{1.2, 3}));
+}
+
+// ============ Single Scan ============
+
+void TestTextAnalyzer::testScan() {
+  TextAnalyzer::Scan scan =
+      m_analyzer->scan(u"Buy milk... and bread!\n\n  \nabc123 for $4.50\n");
+  QCOMPARE(scan.items, 2);
+  QCOMPARE(scan.words, 5); // abc123 isn't a word
+  QCOMPARE(scan.syllables, 5);
+  QCOMPARE(scan.characters, 33);
+  QCOMPARE(scan.sentences, 3);
+  QCOMPARE(scan.numbers, (QList<double>{123, 4.5}));
+  QVERIFY(scan.hasCurrency);
+
+  // Silent e, vowel runs and at least one syllable per word
+  QCOMPARE(m_analyzer->scan(u"make").syllables, 1);
+  QCOMPARE(m_analyzer->scan(u"beautiful").syllables, 3);
+  QCOMPARE(m_analyzer->scan(u"rhythm").syllables, 1);
+  QCOMPARE(m_analyzer->scan(u"THE").syllables, 1);
+}
+
+void TestTextAnalyzer::testScanAcrossBlocks() {
+  // Words, numbers and punctuation straddling 16-character blocks
+  QString text;
+  QRandomGenerator random(42);
+  const QStringList pieces = {"extra", "x", " ", "\n", "...", "!",
+                              "12,345", "-", "6.25", "box", "_", "\t"};
+  for (int i = 0; i < 5000; ++i)
+    text += pieces[random.bounded(pieces.size())];
+
+  // A non-ASCII consonant in place of each x keeps every count, but
+  // takes blocks off the ASCII fast path
+  QString mixed = text;
+  mixed.replace('x', QChar(0x015F));
+  TextAnalyzer::Scan ascii = m_analyzer->scan(text);
+  TextAnalyzer::Scan other = m_analyzer->scan(mixed);
+  QVERIFY(ascii.words > 0);
+  QCOMPARE(other.items, ascii.items);
+  QCOMPARE(other.words, ascii.words);
+  QCOMPARE(other.syllables, ascii.syllables);
+  QCOMPARE(other.characters, ascii.characters);
+  QCOMPARE(other.sentences, ascii.sentences);
+  QCOMPARE(other.numbers, ascii.numbers);
+}
+
+void TestTextAnalyzer::testScanNonAscii() {
+  TextAnalyzer::Scan scan = m_analyzer->scan(u"Şeker İçin çok güzel. €5");
+  QCOMPARE(scan.words, 4);
+  QCOMPARE(scan.sentences, 1);
+  QCOMPARE(scan.numbers, QList<double>{5});
+  QVERIFY(scan.hasCurrency);
+  QVERIFY(!m_analyzer->scan(u"café 5").hasCurrency);
+}
+
+void TestTextAnalyzer::testScanView() {
+  // A selection is scanned in place
+  QString text = "sum\n10 20\n30 40";
+  QStringView view = QStringView(text).mid(4, 5);
+  TextAnalyzer::Scan scan = m_analyzer->scan(view);
+  QCOMPARE(scan.numbers, (QList<double>{10, 20}));
+  QCOMPARE(scan.items, 1);
+  QCOMPARE(TextAnalyzer::formatSum(scan), QString("\nTotal: 30.00"));
+  QCOMPARE(TextAnalyzer::formatAvg(scan), QString("\nAvg: 15.00"));
+  QCOMPARE(TextAnalyzer::formatCount(scan),
+           m_analyzer->formatCount(view.toString()));
+}
+
+// ============ Performance ============
+
+void TestTextAnalyzer::benchmarkScan() {
+  // 100 MB of UTF-16 notes
+  const QString paragraph = QStringLiteral(
+      "Groceries: milk $3.49, bread $2.99 and eggs 12.\n"
+      "The quick brown fox jumps over the lazy dog. 1,250 items!\n");
+  QString text;
+  text.reserve(50 * 1024 * 1024 + paragraph.size());
+  while (text.size() < 50 * 1024 * 1024)
+    text += paragraph;
+
+  TextAnalyzer::Scan scan;
+  QBENCHMARK { scan = m_analyzer->scan(text); }
+  QVERIFY(scan.words > 0);
+}
+
 QTEST_MAIN(TestTextAnalyzer)
 #include "test_textanalyzer.moc"
@@ -42,6 +42,14 @@ private slots:
   void testHoursToMinutes();
   void testSecondsToHours();
 
+  // Compound units
+  void testSpeedQuotient();
+  void testDataRateExpression();
+  void testEnergyProduct();
+  void testPowerSuffix();
+  void testDimensionMismatch();
+  void testOffsetUnitInCompound();
+
   // Parsing tests
   void testIsConversion();
   void testIsConversion_data();
@@ -57,6 +65,9 @@ private slots:
   void testCategories();
   void testUnitsInCategory();
 
+  // Benchmark
+  void benchmarkCompoundConversion();
+
 private:
   UnitConverter *m_converter;
 };
@@ -190,6 +201,41 @@ void TestUnitConverter::testSecondsToHours() {
   QVERIFY(result.contains("1"));
 }
 
+// ============ Compound Units ============
+
+void TestUnitConverter::testSpeedQuotient() {
+  QCOMPARE(m_converter->convert("120 km/h to m/s"), QString("33.3333 m/s"));
+  QCOMPARE(m_converter->convert("10 m/s to kmh"),
+           QString("36 kilometers per hour"));
+}
+
+void TestUnitConverter::testDataRateExpression() {
+  // Juxtaposition binds tighter than '/': (3 GB) / (20 s)
+  QCOMPARE(m_converter->convert("3 GB / 20 s to MB/s"), QString("153.6 MB/s"));
+}
+
+void TestUnitConverter::testEnergyProduct() {
+  QCOMPARE(m_converter->convert("2 kW * 3 h to kWh"),
+           QString("6 kilowatt hour"));
+  QCOMPARE(m_converter->convert("9.81 kg m/s^2 to N"), QString("9.81 newton"));
+}
+
+void TestUnitConverter::testPowerSuffix() {
+  QCOMPARE(m_converter->convert("1 m^3 to l"), QString("1000 liter"));
+  QCOMPARE(m_converter->convert("3 cm3 to ml"), QString("3 milliliter"));
+}
+
+void TestUnitConverter::testDimensionMismatch() {
+  QVERIFY(!m_converter->isConversion("5 km to kg"));
+  QVERIFY(!m_converter->isConversion("120 km/h to m"));
+}
+
+void TestUnitConverter::testOffsetUnitInCompound() {
+  // Celsius and Fahrenheit carry an offset and only convert on their own
+  QVERIFY(!m_converter->isConversion("20 C/s to K/s"));
+  QCOMPARE(m_converter->convert("32 F to C"), QString("0 celsius"));
+}
+
 // ============ Parsing Tests ============
 
 void TestUnitConverter::testIsConversion_data() {
@@ -201,6 +247,9 @@ void TestUnitConverter::testIsConversion_data() {
   QTest::newRow("plain text") << "hello world" << false;
   QTest::newRow("math expression") << "2+2" << false;
   QTest::newRow("single number") << "100" << false;
+  QTest::newRow("compound") << "120 km/h to m/s" << true;
+  QTest::newRow("inch before to") << "10 in to cm" << true;
+  QTest::newRow("currency") << "100 USD to EUR" << false;
 }
 
 void TestUnitConverter::testIsConversion() {
@@ -252,5 +301,11 @@ void TestUnitConverter::testUnitsInCategory() {
   QVERIFY(!lengthUnits.isEmpty());
 }
 
+// ============ Benchmark ============
+
+void TestUnitConverter::benchmarkCompoundConversion() {
+  QBENCHMARK { m_converter->convert("3 GB / 20 s to MB/s"); }
+}
+
 QTEST_MAIN(TestUnitConverter)
 #include "test_unitconv.moc"
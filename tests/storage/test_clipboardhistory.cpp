@@ -0,0 +1,167 @@
+#include "storage/ClipboardHistory.h"
+#include <QSignalSpy>
+#include <QTemporaryDir>
+#include <QTest>
+
+class TestClipboardHistory : public QObject {
+  Q_OBJECT
+
+private slots:
+  void init();
+  void cleanup();
+
+  void testAddAndText();
+  void testDedup();
+  void testCompression();
+  void testSearch();
+  void testEvictLeastRecentlyUsed();
+  void testRemoveAndClear();
+  void testPersistence();
+
+  // Performance
+  void benchmarkSearch();
+
+private:
+  QString databasePath() const { return m_tempDir->filePath("clipboard.db"); }
+
+  QTemporaryDir *m_tempDir = nullptr;
+};
+
+void TestClipboardHistory::init() {
+  m_tempDir = new QTemporaryDir();
+  QVERIFY(m_tempDir->isValid());
+}
+
+void TestClipboardHistory::cleanup() {
+  delete m_tempDir;
+  m_tempDir = nullptr;
+}
+
+void TestClipboardHistory::testAddAndText() {
+  ClipboardHistory history(databasePath());
+  QVERIFY(history.isOpen());
+  QVERIFY(history.add("first"));
+  QVERIFY(history.add("second"));
+  QVERIFY(!history.add(""));
+  QCOMPARE(history.count(), 2);
+
+  QList<ClipboardHistory::Entry> entries = history.search(QString());
+  QCOMPARE(entries.size(), 2);
+  QCOMPARE(entries[0].preview, QString("second"));
+  QCOMPARE(history.text(entries[1].id), QString("first"));
+  QCOMPARE(history.text(-1), QString());
+}
+
+void TestClipboardHistory::testDedup() {
+  ClipboardHistory history(databasePath());
+  QSignalSpy changed(&history, &ClipboardHistory::changed);
+  history.add("a");
+  history.add("b");
+  QVERIFY(!history.add("a"));
+  QCOMPARE(history.count(), 2);
+  QCOMPARE(changed.count(), 3);
+
+  // Copied again, so first
+  QList<ClipboardHistory::Entry> entries = history.search(QString());
+  QCOMPARE(entries[0].preview, QString("a"));
+  QCOMPARE(entries[1].preview, QString("b"));
+  QCOMPARE(ClipboardHistory::contentHash(u"a"),
+           ClipboardHistory::contentHash(QString("a")));
+  QVERIFY(ClipboardHistory::contentHash(u"a") !=
+          ClipboardHistory::contentHash(u"b"));
+}
+
+void TestClipboardHistory::testCompression() {
+  ClipboardHistory history(databasePath());
+  QString text;
+  for (int i = 0; i < 2000; ++i)
+    text += QStringLiteral("line %1 ünïcode\n").arg(i);
+  QVERIFY(text.size() >= ClipboardHistory::CompressChars);
+  QVERIFY(history.add(text));
+
+  // Repetitive text shrinks well below its UTF-8 size
+  QVERIFY(history.storedBytes() < text.toUtf8().size() / 4);
+  QList<ClipboardHistory::Entry> entries = history.search("line 500");
+  QCOMPARE(entries.size(), 1);
+  QCOMPARE(entries[0].size, text.size());
+  QCOMPARE(entries[0].preview, text.left(ClipboardHistory::PreviewChars));
+  QCOMPARE(history.text(entries[0].id), text);
+}
+
+void TestClipboardHistory::testSearch() {
+  ClipboardHistory history(databasePath());
+  history.add("Invoice 2024-17 total 420 EUR");
+  history.add("https://example.com/report");
+  history.add("Meeting at 10:30");
+
+  QCOMPARE(history.search("invoice").size(), 1);
+  QCOMPARE(history.search("  EXAMPLE ").size(), 1);
+  QCOMPARE(history.search("%").size(), 0);
+  QCOMPARE(history.search("0").size(), 2);
+  QCOMPARE(history.search(QString(), 2).size(), 2);
+}
+
+void TestClipboardHistory::testEvictLeastRecentlyUsed() {
+  ClipboardHistory history(databasePath());
+  for (int i = 0; i < ClipboardHistory::MaxEntries; ++i)
+    history.add(QString::number(i));
+  QCOMPARE(history.count(), ClipboardHistory::MaxEntries);
+
+  // "0" is used again, so "1" is the oldest
+  history.add("0");
+  QVERIFY(history.add("new"));
+  QCOMPARE(history.count(), ClipboardHistory::MaxEntries);
+  QList<ClipboardHistory::Entry> entries =
+      history.search(QString(), ClipboardHistory::MaxEntries);
+  QStringList previews;
+  for (const ClipboardHistory::Entry &entry : std::as_const(entries))
+    previews << entry.preview;
+  QVERIFY(previews.contains("0"));
+  QVERIFY(!previews.contains("1"));
+  QCOMPARE(previews.first(), QString("new"));
+}
+
+void TestClipboardHistory::testRemoveAndClear() {
+  ClipboardHistory history(databasePath());
+  history.add("keep");
+  history.add("drop");
+  qint64 bytes = history.storedBytes();
+  qint64 id = history.search("drop").first().id;
+  QVERIFY(history.remove(id));
+  QVERIFY(!history.remove(id));
+  QCOMPARE(history.count(), 1);
+  QCOMPARE(history.storedBytes(), bytes - 4);
+
+  history.clear();
+  QCOMPARE(history.count(), 0);
+  QCOMPARE(history.storedBytes(), qint64(0));
+  QVERIFY(history.search(QString()).isEmpty());
+}
+
+void TestClipboardHistory::testPersistence() {
+  {
+    ClipboardHistory history(databasePath());
+    history.add("older");
+    history.add("newer");
+  }
+
+  ClipboardHistory history(databasePath());
+  QCOMPARE(history.count(), 2);
+  QCOMPARE(history.storedBytes(), qint64(10));
+  QVERIFY(!history.add("older"));
+  QCOMPARE(history.search(QString()).first().preview, QString("older"));
+}
+
+void TestClipboardHistory::benchmarkSearch() {
+  // A full history of paragraph-sized copies
+  ClipboardHistory history(databasePath());
+  QString filler(300, 'x');
+  for (int i = 0; i < ClipboardHistory::MaxEntries; ++i)
+    history.add(QStringLiteral("entry %1 %2").arg(i).arg(filler));
+  QList<ClipboardHistory::Entry> entries;
+  QBENCHMARK { entries = history.search("entry 1234"); }
+  QCOMPARE(entries.size(), 1);
+}
+
+QTEST_MAIN(TestClipboardHistory)
+#include "test_clipboardhistory.moc"
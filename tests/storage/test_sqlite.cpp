@@ -33,6 +33,7 @@ private slots:
   void testSpecialCharactersInContent();
   void testUnicodeContent();
   void testManyNotes();
+  void testReadNotes();
 
 private:
   SqliteStorage *m_storage;
@@ -263,5 +264,24 @@ void TestSqliteStorage::testManyNotes() {
   QCOMPARE(idx, 50);
 }
 
+void TestSqliteStorage::testReadNotes() {
+  QList<Note> notes;
+  for (int i = 0; i < 10; i++)
+    notes.append(Note(QString("Streamed %1").arg(i)));
+  QVERIFY(m_storage->save(notes, 0));
+
+  QStringList contents;
+  int read = m_storage->readNotes([&contents](const Note &note) {
+    contents.append(note.content());
+    return true;
+  });
+  QCOMPARE(read, 10);
+  QVERIFY(contents.contains("Streamed 7"));
+
+  // Stops when the visitor says so
+  read = m_storage->readNotes([](const Note &) { return false; });
+  QCOMPARE(read, 1);
+}
+
 QTEST_MAIN(TestSqliteStorage)
 #include "test_sqlite.moc"
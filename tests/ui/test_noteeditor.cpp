@@ -0,0 +1,103 @@
+#include "core/PieceTable.h"
+#include "ui/CodeHighlighter.h"
+#include "ui/ModeHelper.h"
+#include "ui/NoteEditor.h"
+#include <QTemporaryDir>
+#include <QTest>
+
+class TestNoteEditor : public QObject {
+  Q_OBJECT
+
+private slots:
+  void initTestCase();
+  void cleanupTestCase();
+
+  // ============ Cached Documents ============
+  void testSwitchCachedMathNotes();
+  void testCachedCodeNotesKeepLanguage();
+
+private:
+  // The Code mode lexer of the shown document's host, if it runs one
+  static CodeHighlighter *codeHighlighter(const NoteEditor &editor);
+  static void show(NoteEditor &editor, const QString &noteId,
+                   const QString &text, NoteMode mode);
+
+  QTemporaryDir *m_tempDir;
+};
+
+void TestNoteEditor::initTestCase() {
+  m_tempDir = new QTemporaryDir();
+  QVERIFY(m_tempDir->isValid());
+  qputenv("XDG_DATA_HOME", m_tempDir->path().toUtf8());
+  qputenv("XDG_CONFIG_HOME", m_tempDir->path().toUtf8());
+}
+
+void TestNoteEditor::cleanupTestCase() { delete m_tempDir; }
+
+CodeHighlighter *TestNoteEditor::codeHighlighter(const NoteEditor &editor) {
+  auto *host = editor.document()->findChild<HighlighterHost *>();
+  if (!host || host->lexers().isEmpty())
+    return nullptr;
+  return dynamic_cast<CodeHighlighter *>(host->lexers().first());
+}
+
+void TestNoteEditor::show(NoteEditor &editor, const QString &noteId,
+                          const QString &text, NoteMode mode) {
+  // As MainWindow does; the revision never changes, so the cache hits
+  editor.showNote(noteId, 1, PieceTable(text));
+  editor.setMode(mode);
+}
+
+// ============ Cached Documents ============
+
+void TestNoteEditor::testSwitchCachedMathNotes() {
+  NoteEditor editor;
+  ModeHelper *helper = editor.findChild<ModeHelper *>();
+  QVERIFY(helper);
+
+  show(editor, "a", "1 + 1", NoteMode::Math);
+  QTRY_COMPARE(helper->getMathResults(), QString(" = 2\n"));
+  show(editor, "b", "3 * 3\n4 * 4", NoteMode::Math);
+  QTRY_COMPARE(helper->getMathResults(), QString(" = 9\n = 16\n"));
+
+  // Both documents come from the cache now: the mode stays and the text
+  // doesn't change, yet each shows its own results
+  show(editor, "a", "1 + 1", NoteMode::Math);
+  QTRY_COMPARE(helper->getMathResults(), QString(" = 2\n"));
+  show(editor, "b", "3 * 3\n4 * 4", NoteMode::Math);
+  QTRY_COMPARE(helper->getMathResults(), QString(" = 9\n = 16\n"));
+}
+
+void TestNoteEditor::testCachedCodeNotesKeepLanguage() {
+  const QString python = "import os\n\n"
+                         "def main(args):\n"
+                         "    if args.verbose:\n"
+                         "        print(\"hi\")\n";
+  const QString rust = "fn main() {\n"
+                       "    let mut v = Vec::new();\n"
+                       "    v.push(1);\n"
+                       "    println!(\"{:?}\", v);\n"
+                       "}\n";
+  NoteEditor editor;
+
+  show(editor, "py", python, NoteMode::Code);
+  CodeHighlighter *pyCode = codeHighlighter(editor);
+  QVERIFY(pyCode);
+  QCOMPARE(pyCode->language(), CodeHighlighter::Python);
+
+  show(editor, "rs", rust, NoteMode::Code);
+  CodeHighlighter *rsCode = codeHighlighter(editor);
+  QVERIFY(rsCode);
+  QVERIFY(rsCode != pyCode);
+  QCOMPARE(rsCode->language(), CodeHighlighter::Rust);
+
+  // Shown again, each document still runs its own highlighter, so nothing
+  // needs a new language or a rehighlight
+  show(editor, "py", python, NoteMode::Code);
+  QCOMPARE(codeHighlighter(editor), pyCode);
+  QCOMPARE(pyCode->language(), CodeHighlighter::Python);
+  QCOMPARE(rsCode->language(), CodeHighlighter::Rust);
+}
+
+QTEST_MAIN(TestNoteEditor)
+#include "test_noteeditor.moc"
@@ -1,38 +1,68 @@
 #ifndef LINNOTE_CODEHIGHLIGHTER_H
 #define LINNOTE_CODEHIGHLIGHTER_H
 
-#include <QRegularExpression>
-#include <QSyntaxHighlighter>
+#include "HighlighterHost.h"
+#include "core/CodeLexer.h"
+#include "core/LanguageDetector.h"
 #include <QTextCharFormat>
 
 /**
  * @brief Syntax highlighter for programming languages
  *
- * Supports: Python, JavaScript/TypeScript, C/C++, Bash, JSON
+ * Supports: Python, JavaScript/TypeScript, C/C++, Bash, JSON, Rust, Go,
+ * SQL, YAML, TOML, Java
+ *
+ * Each block is tokenized once by a CodeLexer for the current language,
+ * whose grammar comes from GrammarRegistry.
+ * The lexer's end state is the block state, so block comments and
+ * multi-line strings continue into the following blocks.
  */
-class CodeHighlighter : public QSyntaxHighlighter {
-  Q_OBJECT
-
+class CodeHighlighter : public HighlighterHost::Lexer {
 public:
-  enum Language { Generic, Python, JavaScript, CPP, Bash, JSON };
+  enum Language {
+    Generic,
+    Python,
+    JavaScript,
+    CPP,
+    Bash,
+    JSON,
+    Rust,
+    Go,
+    SQL,
+    YAML,
+    TOML,
+    Java
+  };
 
-  explicit CodeHighlighter(QTextDocument *parent = nullptr);
+  CodeHighlighter();
 
+  // Takes effect on the next rehighlight of the host
   void setLanguage(Language lang);
   Language language() const { return m_language; }
 
-  // Auto-detect language from content
-  static Language detectLanguage(const QString &text);
+  // The language to highlight something LanguageDetector recognized as
+  static Language fromDetected(LanguageDetector::Language detected);
 
-protected:
-  void highlightBlock(const QString &text) override;
+  // Name of the grammar file for @p lang; see GrammarRegistry
+  static QString grammarName(Language lang);
+
+  void highlightBlock(const QString &text,
+                      HighlighterHost::Block &block) override;
+
+  /**
+   * @brief Highlight code embedded in another language, e.g. a Markdown fence
+   * @param state The CodeLexer::State the previous line of the code ended in
+   * @return The state this line ends in; the caller keeps it in its own
+   *         block state
+   */
+  int highlightEmbedded(const QSharedPointer<const CodeLexer::Table> &table,
+                        const QString &text, HighlighterHost::Block &block,
+                        int state);
 
 private:
-  struct HighlightingRule {
-    QRegularExpression pattern;
-    QTextCharFormat format;
-  };
-  QVector<HighlightingRule> m_rules;
+  CodeLexer m_lexer;
+  CodeLexer m_embeddedLexer;
+  QVector<CodeLexer::Token> m_tokens; // Reused between blocks
 
   Language m_language;
 
@@ -47,12 +77,7 @@ private:
 
   void setupFormats();
   void setupRules();
-  void setupPythonRules();
-  void setupJavaScriptRules();
-  void setupCppRules();
-  void setupBashRules();
-  void setupJsonRules();
-  void setupGenericRules();
+  const QTextCharFormat &formatFor(CodeLexer::Kind kind) const;
 };
 
 #endif // LINNOTE_CODEHIGHLIGHTER_H
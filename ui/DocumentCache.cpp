@@ -0,0 +1,70 @@
+#include "DocumentCache.h"
+#include <QTextDocument>
+
+DocumentCache::DocumentCache(QObject *parent) : QObject(parent) {}
+
+DocumentCache::Entry DocumentCache::find(const QString &noteId,
+                                         quint64 revision) {
+  auto it = m_entries.find(noteId);
+  if (it == m_entries.end())
+    return Entry();
+  if (it->revision != revision) {
+    remove(noteId);
+    return Entry();
+  }
+
+  m_recent.removeOne(noteId);
+  m_recent.prepend(noteId);
+  return *it;
+}
+
+void DocumentCache::insert(const QString &noteId, const Entry &entry,
+                           bool mostRecent) {
+  auto it = m_entries.find(noteId);
+  if (it != m_entries.end() && it->document != entry.document)
+    release(*it);
+  m_entries.insert(noteId, entry);
+  m_recent.removeOne(noteId);
+  m_recent.insert(mostRecent ? 0 : qMin(qsizetype(1), m_recent.size()),
+                  noteId);
+  evict();
+}
+
+bool DocumentCache::contains(const QString &noteId, quint64 revision) const {
+  auto it = m_entries.constFind(noteId);
+  return it != m_entries.constEnd() && it->revision == revision;
+}
+
+void DocumentCache::evict() {
+  // The most recent entry always stays, however large
+  qsizetype chars = 0;
+  for (const QString &id : std::as_const(m_recent))
+    chars += m_entries.value(id).document->characterCount();
+  while (m_recent.size() > 1 &&
+         (m_recent.size() > MaxDocuments || chars > MaxChars)) {
+    Entry oldest = m_entries.take(m_recent.takeLast());
+    chars -= oldest.document->characterCount();
+    release(oldest);
+  }
+}
+
+DocumentCache::Entry *DocumentCache::entry(const QString &noteId) {
+  auto it = m_entries.find(noteId);
+  return it == m_entries.end() ? nullptr : &*it;
+}
+
+DocumentCache::Entry DocumentCache::take(const QString &noteId) {
+  m_recent.removeOne(noteId);
+  return m_entries.take(noteId);
+}
+
+void DocumentCache::remove(const QString &noteId) {
+  if (m_entries.contains(noteId))
+    release(take(noteId));
+}
+
+void DocumentCache::release(const Entry &entry) {
+  // The editor may still show it until the caller swaps documents
+  if (entry.document)
+    entry.document->deleteLater();
+}
@@ -0,0 +1,75 @@
+#ifndef LINNOTE_DOCUMENTCACHE_H
+#define LINNOTE_DOCUMENTCACHE_H
+
+#include <QHash>
+#include <QObject>
+#include <QStringList>
+#include <QTextCursor>
+
+class CodeHighlighter;
+class HighlighterHost;
+class QTextDocument;
+
+/**
+ * @brief Live documents of the notes shown most recently
+ *
+ * Refilling the editor with setPlainText() throws away the layout, undo
+ * history and highlighting, which takes seconds for a large note. The
+ * cache keeps the last few notes' documents instead, each with its own
+ * HighlighterHost, so showing one of them again is a setDocument(). Code
+ * notes also keep their own CodeHighlighter, still set to their language.
+ *
+ * An entry is only reused while its note is at the revision it was stored
+ * with; changes made anywhere else make it stale. Documents are deleted
+ * with deleteLater(), so the one still in the editor can be dropped as
+ * long as the editor moves to another document right away.
+ */
+class DocumentCache : public QObject {
+  Q_OBJECT
+
+public:
+  static constexpr int MaxDocuments = 8;
+  static constexpr qsizetype MaxChars = 16 * 1024 * 1024; // All together
+
+  struct Entry {
+    QTextDocument *document = nullptr;      // Owned by the cache
+    HighlighterHost *highlighter = nullptr; // Child of the document
+    CodeHighlighter *code = nullptr;        // Once in Code mode; see NoteEditor
+    quint64 revision = 0;                   // Note::revision() it matches
+    QTextCursor cursor;                     // Where the editor left off
+    int scroll = 0;
+  };
+
+  explicit DocumentCache(QObject *parent = nullptr);
+
+  // The entry for @p noteId if it is at @p revision, now the most recent.
+  // A stale entry is dropped.
+  Entry find(const QString &noteId, quint64 revision);
+
+  // Stores @p entry as the most recent, or behind it for a document nobody
+  // asked for yet, then drops the least recently used entries past
+  // MaxDocuments or MaxChars
+  void insert(const QString &noteId, const Entry &entry,
+              bool mostRecent = true);
+
+  // Whether find() would hit, without making the entry more recent
+  bool contains(const QString &noteId, quint64 revision) const;
+
+  // To update revision or view state; null if there is none
+  Entry *entry(const QString &noteId);
+
+  // Removes the entry, leaving its document to the caller
+  Entry take(const QString &noteId);
+  void remove(const QString &noteId);
+
+  int count() const { return int(m_recent.size()); }
+
+private:
+  void evict();
+  void release(const Entry &entry);
+
+  QHash<QString, Entry> m_entries;
+  QStringList m_recent; // Note ids, most recent first
+};
+
+#endif // LINNOTE_DOCUMENTCACHE_H
@@ -0,0 +1,132 @@
+#include "HighlightScheduler.h"
+#include <QPlainTextEdit>
+#include <QScrollBar>
+#include <QSyntaxHighlighter>
+#include <QTextBlock>
+#include <limits>
+
+HighlightScheduler::HighlightScheduler(QPlainTextEdit *editor)
+    : QObject(editor), m_editor(editor),
+      m_nextPending(std::numeric_limits<int>::max()) {
+  m_timer.setSingleShot(true);
+  m_timer.setInterval(0); // Next event loop turn, after input and painting
+  connect(&m_timer, &QTimer::timeout, this, &HighlightScheduler::runSlice);
+
+  m_contentsConnection =
+      connect(m_editor->document(), &QTextDocument::contentsChange, this,
+              &HighlightScheduler::onContentsChange);
+  connect(m_editor->verticalScrollBar(), &QScrollBar::valueChanged, this,
+          &HighlightScheduler::onViewportMoved);
+}
+
+void HighlightScheduler::addHighlighter(QSyntaxHighlighter *highlighter) {
+  m_highlighters.removeAll(QPointer<QSyntaxHighlighter>());
+  if (!m_highlighters.contains(highlighter))
+    m_highlighters.append(highlighter);
+}
+
+void HighlightScheduler::attachDocument() {
+  disconnect(m_contentsConnection);
+  m_contentsConnection =
+      connect(m_editor->document(), &QTextDocument::contentsChange, this,
+              &HighlightScheduler::onContentsChange);
+
+  // A document shown again may still have blocks Pending from before
+  m_nextPending = 0;
+  if (isLarge() && !m_timer.isActive())
+    m_timer.start();
+}
+
+bool HighlightScheduler::admit(const QTextBlock &block) {
+  // Documents off screen are filled in slices by NotePrefetcher already
+  if (block.document() != m_editor->document())
+    return true;
+
+  // Small documents, and anything inside a slice, are highlighted as usual
+  if (!isLarge() || !m_sliceEnd.hasExpired())
+    return true;
+
+  int number = block.blockNumber();
+  if (number >= m_firstVisible && number <= m_lastVisible)
+    return true;
+
+  m_nextPending = qMin(m_nextPending, number);
+  if (!m_timer.isActive())
+    m_timer.start();
+  return false;
+}
+
+void HighlightScheduler::onContentsChange(int position, int charsRemoved,
+                                          int charsAdded) {
+  Q_UNUSED(charsRemoved)
+  Q_UNUSED(charsAdded)
+  if (!isLarge())
+    return;
+
+  // Removed lines shift Pending blocks down, possibly before m_nextPending
+  int number = m_editor->document()->findBlock(position).blockNumber();
+  if (number >= 0)
+    m_nextPending = qMin(m_nextPending, number);
+}
+
+void HighlightScheduler::onViewportMoved() {
+  // Blocks scrolled into view may still be Pending
+  if (isLarge() && !m_timer.isActive())
+    m_timer.start();
+}
+
+void HighlightScheduler::runSlice() {
+  QTextDocument *doc = m_editor->document();
+  updateVisibleRange();
+  m_sliceEnd = QDeadlineTimer(SliceMs);
+
+  // What's on screen first. admit() lets these through even when the
+  // slice runs out, so the viewport is always complete.
+  QTextBlock block = doc->findBlockByNumber(m_firstVisible);
+  for (int number = m_firstVisible; block.isValid() && number <= m_lastVisible;
+       ++number, block = block.next()) {
+    if (block.userState() == Pending)
+      rehighlight(block);
+  }
+
+  // Then the rest in document order, so multi-line state settles as it goes.
+  // Over the budget only what scrolls into view gets highlighted.
+  bool more = false;
+  if (doc->characterCount() <= BackgroundBudgetChars) {
+    block = doc->findBlockByNumber(m_nextPending);
+    while (block.isValid() && !m_sliceEnd.hasExpired()) {
+      if (block.userState() == Pending)
+        rehighlight(block);
+      block = block.next();
+    }
+    more = block.isValid();
+    m_nextPending =
+        more ? block.blockNumber() : std::numeric_limits<int>::max();
+  }
+
+  m_sliceEnd = QDeadlineTimer();
+  if (more)
+    m_timer.start();
+}
+
+bool HighlightScheduler::isLarge() const {
+  return m_editor->document()->characterCount() > LargeDocumentChars;
+}
+
+void HighlightScheduler::updateVisibleRange() {
+  QTextCursor top = m_editor->cursorForPosition(QPoint(0, 0));
+  QTextCursor bottom =
+      m_editor->cursorForPosition(QPoint(0, m_editor->viewport()->height()));
+  m_firstVisible = qMax(0, top.blockNumber() - VisibleMargin);
+  m_lastVisible = bottom.blockNumber() + VisibleMargin;
+}
+
+void HighlightScheduler::rehighlight(const QTextBlock &block) {
+  // Lexing a Pending block changes its state, so QSyntaxHighlighter carries
+  // on into the following blocks until the state settles or the slice ends
+  for (const QPointer<QSyntaxHighlighter> &highlighter :
+       std::as_const(m_highlighters)) {
+    if (highlighter && highlighter->document() == block.document())
+      highlighter->rehighlightBlock(block);
+  }
+}
@@ -0,0 +1,74 @@
+#ifndef LINNOTE_HIGHLIGHTSCHEDULER_H
+#define LINNOTE_HIGHLIGHTSCHEDULER_H
+
+#include <QDeadlineTimer>
+#include <QList>
+#include <QObject>
+#include <QPointer>
+#include <QTimer>
+
+class QPlainTextEdit;
+class QSyntaxHighlighter;
+class QTextBlock;
+
+/**
+ * @brief Keeps syntax highlighting of large documents off the typing path
+ *
+ * QSyntaxHighlighter highlights every changed block synchronously, so
+ * pasting a multi-megabyte log freezes the window. Highlighters given a
+ * scheduler ask admit() before lexing a block. In a large document only
+ * the blocks on screen are admitted right away; the others are marked
+ * Pending and highlighted later in short slices, visible ones first.
+ * Past a size budget the background pass is skipped entirely and only
+ * what scrolls into view gets highlighted.
+ */
+class HighlightScheduler : public QObject {
+  Q_OBJECT
+
+public:
+  // Block state of a block whose highlighting was put off
+  static constexpr int Pending = -2;
+
+  static constexpr int LargeDocumentChars = 256 * 1024; // Below: no deferral
+  static constexpr int BackgroundBudgetChars = 8 * 1024 * 1024;
+  static constexpr int SliceMs = 4;
+  static constexpr int VisibleMargin = 16; // Blocks around the viewport
+
+  explicit HighlightScheduler(QPlainTextEdit *editor);
+
+  // Highlighters of other documents are left alone; see attachDocument()
+  void addHighlighter(QSyntaxHighlighter *highlighter);
+
+  // Call after the editor's document was replaced
+  void attachDocument();
+
+  /**
+   * @brief Whether @p block may be highlighted now
+   *
+   * If not, the caller sets the block state to Pending and returns; the
+   * block is highlighted again from a later slice.
+   */
+  bool admit(const QTextBlock &block);
+
+private slots:
+  void onContentsChange(int position, int charsRemoved, int charsAdded);
+  void onViewportMoved();
+  void runSlice();
+
+private:
+  bool isLarge() const;
+  void updateVisibleRange();
+  void rehighlight(const QTextBlock &block);
+
+  QPlainTextEdit *m_editor;
+  QList<QPointer<QSyntaxHighlighter>> m_highlighters;
+  QMetaObject::Connection m_contentsConnection;
+  QTimer m_timer;
+  QDeadlineTimer m_sliceEnd; // Expired outside of runSlice()
+
+  int m_firstVisible = 0;
+  int m_lastVisible = 0;
+  int m_nextPending; // First block that may still be Pending
+};
+
+#endif // LINNOTE_HIGHLIGHTSCHEDULER_H
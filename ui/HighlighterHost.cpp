@@ -0,0 +1,33 @@
+#include "HighlighterHost.h"
+#include "HighlightScheduler.h"
+
+HighlighterHost::HighlighterHost(QTextDocument *parent)
+    : QSyntaxHighlighter(parent) {}
+
+void HighlighterHost::setLexers(const QList<Lexer *> &lexers) {
+  if (m_lexers == lexers)
+    return;
+  m_lexers = lexers;
+  rehighlight();
+}
+
+void HighlighterHost::setScheduler(HighlightScheduler *scheduler) {
+  m_scheduler = scheduler;
+  if (m_scheduler)
+    m_scheduler->addHighlighter(this);
+}
+
+void HighlighterHost::highlightBlock(const QString &text) {
+  if (m_scheduler && !m_scheduler->admit(currentBlock())) {
+    setCurrentBlockState(HighlightScheduler::Pending);
+    return;
+  }
+
+  // Unset (-1) and Pending both start from a clean state
+  Block block(this, qMax(previousBlockState(), 0));
+  for (Lexer *lexer : std::as_const(m_lexers))
+    lexer->highlightBlock(text, block);
+
+  // QSyntaxHighlighter moves on to the next block only while this changes
+  setCurrentBlockState(block.m_state);
+}
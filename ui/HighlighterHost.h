@@ -0,0 +1,70 @@
+#ifndef LINNOTE_HIGHLIGHTERHOST_H
+#define LINNOTE_HIGHLIGHTERHOST_H
+
+#include <QList>
+#include <QSyntaxHighlighter>
+#include <QTextCharFormat>
+
+class HighlightScheduler;
+
+/**
+ * @brief The one QSyntaxHighlighter on a note's document
+ *
+ * Stacked QSyntaxHighlighters each re-run over every changed block, and each
+ * one's formats replace the others'. The host instead runs a chain of
+ * lexers in order, in a single pass per block: later lexers paint over
+ * earlier ones, and the merged formats are applied to the block once.
+ */
+class HighlighterHost : public QSyntaxHighlighter {
+  Q_OBJECT
+
+public:
+  class Block;
+
+  // One stage of the chain, e.g. Markdown or keyword lines
+  class Lexer {
+  public:
+    virtual ~Lexer() = default;
+    virtual void highlightBlock(const QString &text, Block &block) = 0;
+  };
+
+  // What a lexer sees of the block being highlighted
+  class Block {
+  public:
+    void setFormat(int start, int count, const QTextCharFormat &format) {
+      m_host->setFormat(start, count, format);
+    }
+
+    // Block state for multi-line constructs; 0 at the start of the document.
+    // Only one lexer in a chain should use it.
+    int previousState() const { return m_previousState; }
+    void setState(int state) { m_state = state; }
+
+  private:
+    friend class HighlighterHost;
+    explicit Block(HighlighterHost *host, int previousState)
+        : m_host(host), m_previousState(previousState) {}
+
+    HighlighterHost *m_host;
+    int m_previousState;
+    int m_state = 0;
+  };
+
+  explicit HighlighterHost(QTextDocument *parent = nullptr);
+
+  // Replace the chain and rehighlight; the lexers stay owned by the caller
+  void setLexers(const QList<Lexer *> &lexers);
+  QList<Lexer *> lexers() const { return m_lexers; }
+
+  // Defer blocks in large documents; see HighlightScheduler
+  void setScheduler(HighlightScheduler *scheduler);
+
+protected:
+  void highlightBlock(const QString &text) override;
+
+private:
+  QList<Lexer *> m_lexers;
+  HighlightScheduler *m_scheduler = nullptr;
+};
+
+#endif // LINNOTE_HIGHLIGHTERHOST_H
@@ -1,6 +1,7 @@
 #include "MainWindow.h"
 #include "ConfettiWidget.h"
 
+#include "NotePrefetcher.h"
 #include "PageSelector.h"
 #include "PasswordDialog.h"
 #include "SearchBar.h"
@@ -15,6 +16,7 @@
 #include "core/UrlShortener.h"
 #include "integration/DesktopHelper.h"
 #include "storage/BackupManager.h"
+#include "storage/ClipboardHistory.h"
 #include "storage/Crypto.h"
 #include "storage/Export.h"
 #include <QApplication>
@@ -40,6 +42,7 @@
 #include <QShowEvent>
 #include <QSizeGrip>
 #include <QStandardPaths>
+#include <QTextBlock>
 #include <QTimer>
 #include <QVBoxLayout>
 #include <QWindow>
@@ -62,9 +65,11 @@
 MainWindow::MainWindow(QWidget *parent)
     : QMainWindow(parent), m_editor(nullptr),
       m_clipboardManager(new ClipboardManager(this)),
+      m_clipboardHistory(new ClipboardHistory(QString(), this)),
       m_noteManager(new NoteManager(this)), m_pageSelector(nullptr),
       m_slashCommand(new SlashCommand(m_noteManager, this)), m_state(Hidden),
       m_autoPastedThisSession(false), m_updatingEditor(false),
+      m_editorInSync(false),
       m_titleBar(nullptr), m_dragging(false), m_pinButton(nullptr),
       m_alwaysOnTop(false), m_timerWidget(nullptr), m_confetti(nullptr),
       m_searchModal(nullptr), m_suppressFocusOut(false),
@@ -146,6 +151,8 @@ MainWindow::MainWindow(QWidget *parent)
           });
   connect(m_clipboardManager, &ClipboardManager::contentReceived, m_editor,
           &NoteEditor::onClipboardContent);
+  connect(m_clipboardManager, &ClipboardManager::contentReceived,
+          m_clipboardHistory, &ClipboardHistory::add);
   connect(m_editor, &NoteEditor::autoPasteStopped, this,
           [this]() { m_clipboardManager->stopMonitoring(); });
 
@@ -403,8 +410,15 @@ void MainWindow::setupUi() {
   setCentralWidget(container);
 
   // Connect editor changes
+  connect(m_editor, &NoteEditor::contentsEdited, this,
+          &MainWindow::onEditorContentsEdited);
   connect(m_editor, &NoteEditor::contentChanged, this,
           &MainWindow::onEditorContentChanged);
+  connect(m_noteManager, &NoteManager::noteDeleted, m_editor,
+          &NoteEditor::forgetNote);
+
+  // Builds documents of the notes likely to come next while idle
+  new NotePrefetcher(m_noteManager, m_editor, this);
 
   // Connect command popup signal
   connect(m_editor, &NoteEditor::commandExecuted, this,
@@ -494,11 +508,17 @@ void MainWindow::setupShortcuts() {
   connect(findShortcut, &QShortcut::activated, this, [this]() {
     if (!m_searchModal) {
       m_searchModal = new SearchModal(m_noteManager, centralWidget());
+      m_searchModal->setClipboardHistory(m_clipboardHistory);
       connect(m_searchModal, &SearchModal::noteSelected, this,
               [this](int index) {
                 m_noteManager->setCurrentIndex(index);
                 onCurrentNoteChanged(index);
               });
+      connect(m_searchModal, &SearchModal::clipboardEntrySelected, this,
+              [this](qint64 id) {
+                m_editor->insertPlainText(m_clipboardHistory->text(id));
+                m_editor->setFocus();
+              });
     }
     m_searchModal->showAndFocus();
   });
@@ -530,10 +550,13 @@ void MainWindow::onCurrentNoteChanged(int index) {
   if (index < 0)
     return;
 
+  leaveEditorNote();
   Note note = m_noteManager->noteAt(index);
 
   // Check if note is locked (has password hash)
   if (note.isLocked()) {
+    // Its plain text must not stay around in a cached document
+    m_editor->forgetNote(note.id());
     // Check if note is session unlocked (temporarily unlocked in this session)
     if (m_noteManager->isSessionUnlocked(note.id())) {
       // Show decrypted content from cache
@@ -553,16 +576,40 @@ void MainWindow::onCurrentNoteChanged(int index) {
     }
   } else {
     m_updatingEditor = true;
-    m_editor->setContent(note.content());
+    m_editor->showNote(note.id(), note.revision(), note.contentSnapshot());
     m_editor->setMode(note.mode());
     m_editor->setReadOnly(false);
     m_updatingEditor = false;
+    // The editor was just filled from the note
+    m_editor->takeUnreportedEdits();
+    m_editorInSync = true;
   }
 
   qDebug() << "Switched to note:" << note.title()
            << "mode:" << noteModeName(note.mode());
 }
 
+void MainWindow::leaveEditorNote() {
+  // The editor keeps the document of the note it leaves. Bring the note up
+  // to date with it and record the note's revision, so the document is only
+  // reused while nothing else changes the note.
+  QString id = m_editor->noteId();
+  int index = m_noteManager->indexOfNote(id);
+  if (index < 0)
+    return;
+  if (m_noteManager->noteAt(index).isLocked()) {
+    m_editor->forgetNote(id);
+    return;
+  }
+
+  m_editor->hideTutorial();
+  if (m_editor->takeUnreportedEdits() || !m_editorInSync) {
+    m_noteManager->setNoteContentAt(index, m_editor->content());
+    m_editorInSync = true;
+  }
+  m_editor->setNoteRevision(m_noteManager->noteAt(index).revision());
+}
+
 void MainWindow::onNoteModeChanged(const QString &id, NoteMode mode) {
   // Update editor mode if this is the current note
   Note current = m_noteManager->currentNote();
@@ -611,21 +658,25 @@ void MainWindow::onEditorContentChanged() {
     return;
   isProcessing = true;
 
-  // Check for keywords/commands - look at the last line after Enter press
-  QString text = m_editor->content();
-  if (text.endsWith('\n')) {
+  // Check for keywords/commands - look at the last line after Enter press.
+  // Only the trailing blocks are read, never the whole text.
+  QTextBlock block = m_editor->document()->lastBlock();
+  if (block.isValid() && block.text().isEmpty()) {
     // Get the last complete line (before the final newline)
-    QStringList lines = text.split('\n', Qt::SkipEmptyParts);
-    if (!lines.isEmpty()) {
-      QString lastLine = lines.last().trimmed();
+    block = block.previous();
+    while (block.isValid() && block.text().isEmpty())
+      block = block.previous();
+    if (block.isValid()) {
+      QString lastLine = block.text().trimmed();
+      int lineNumber = block.blockNumber();
 
       // Skip if this line was already processed as a keyword
       // (prevents infinite loop when highlighter triggers textChanged)
       static QString lastProcessedKeyword;
-      static int lastLineCount = 0;
+      static int lastLineNumber = -1;
 
-      if (lastLine == lastProcessedKeyword && lines.count() == lastLineCount) {
-        // Same keyword, same line count - skip to prevent re-entrancy
+      if (lastLine == lastProcessedKeyword && lineNumber == lastLineNumber) {
+        // Same keyword, same line - skip to prevent re-entrancy
         saveCurrentNoteContent();
         isProcessing = false;
         return;
@@ -676,7 +727,7 @@ void MainWindow::onEditorContentChanged() {
 
         if (timerCmdProcessed) {
           lastProcessedKeyword = lastLine;
-          lastLineCount = lines.count();
+          lastLineNumber = lineNumber;
           saveCurrentNoteContent();
           isProcessing = false;
           return;
@@ -691,7 +742,7 @@ void MainWindow::onEditorContentChanged() {
         // Set guard BEFORE execute to prevent re-entrancy
         m_updatingEditor = true;
         lastProcessedKeyword = lastLine;
-        lastLineCount = lines.count();
+        lastLineNumber = lineNumber;
 
         // Execute the command but keep the keyword visible as section header
         m_slashCommand->execute(lastLine);
@@ -722,10 +773,25 @@ void MainWindow::saveCurrentNoteContent() {
     // This prevents tutorial placeholder text from being persisted
     m_editor->hideTutorial();
 
-    m_noteManager->updateNoteContent(current.id(), m_editor->content());
+    // Edits normally reach the note as deltas; only copy the whole text
+    // when some were missed
+    if (m_editor->takeUnreportedEdits() || !m_editorInSync) {
+      m_noteManager->updateNoteContent(current.id(), m_editor->content());
+      m_editorInSync = true;
+    }
   }
 }
 
+void MainWindow::onEditorContentsEdited(int position, int removed,
+                                        const QString &added) {
+  // Changes made while the editor is being filled, or for locked notes,
+  // aren't the note's own; the next save compares the whole text
+  if (m_updatingEditor || !m_editorInSync ||
+      !m_noteManager->applyNoteEditAt(m_noteManager->currentIndex(), position,
+                                      removed, added))
+    m_editorInSync = false;
+}
+
 void MainWindow::toggleVisibility() {
   qDebug() << "toggleVisibility called, isVisible:" << isVisible()
            << "state:" << m_state;
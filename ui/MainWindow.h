@@ -13,6 +13,7 @@ class TimerWidget;
 class SearchBar;
 class QSizeGrip;
 class BackupManager;
+class ClipboardHistory;
 
 /**
  * @brief Main application window with frameless design
@@ -63,6 +64,7 @@ private slots:
   void onCurrentNoteChanged(int index);
   void onNoteModeChanged(const QString &id, NoteMode mode);
   void onEditorContentChanged();
+  void onEditorContentsEdited(int position, int removed, const QString &added);
   void checkForSlashCommand();
   void applyTheme();
   void onAutoLockTimeout();
@@ -74,6 +76,7 @@ private:
   void setState(State newState);
   void performAutoPaste();
   void saveCurrentNoteContent();
+  void leaveEditorNote(); // Before the editor shows another note
   void updatePinButtonState();
   void updateToolbarVisibility();
   bool tryKWinKeepAbove(bool enable); // KDE Wayland DBus method
@@ -84,12 +87,14 @@ private:
 
   NoteEditor *m_editor;
   ClipboardManager *m_clipboardManager;
+  ClipboardHistory *m_clipboardHistory; // What AutoPaste received
   NoteManager *m_noteManager;
   PageSelector *m_pageSelector;
   SlashCommand *m_slashCommand;
   State m_state;
   bool m_autoPastedThisSession;
   bool m_updatingEditor;
+  bool m_editorInSync; // Note content matches the editor, kept by deltas
 
   // Frameless window dragging
   QWidget *m_titleBar;
@@ -1,11 +1,90 @@
 #include "MarkdownHighlighter.h"
+#include "core/GrammarRegistry.h"
 #include <QColor>
 
-MarkdownHighlighter::MarkdownHighlighter(QTextDocument *parent)
-    : QSyntaxHighlighter(parent) {
+namespace {
+
+// Block state: 0 outside fenced code. Inside:
+//   bits 0-1   fence kind
+//   bits 2-4   CodeLexer::State of the fence's language
+//   bits 5-12  fence length
+//   bits 13-29 fence language, 0 if none
+// An edit inside a fence changes the following states only as far as the
+// embedded lexer's state changes, so re-lexing stays within the fence.
+constexpr int BacktickFence = 1;
+constexpr int TildeFence = 2;
+constexpr int FenceKindMask = 3;
+constexpr int LexerStateShift = 2;
+constexpr int LexerStateMask = 7;
+constexpr int FenceLengthShift = 5;
+constexpr int MaxFenceLength = 0xFF;
+constexpr int LanguageShift = 13;
+constexpr int MaxLanguage = 0x1FFFF;
+static_assert(CodeLexer::InTemplate + CodeLexer::MaxMultiLineQuotes - 1 <=
+                  LexerStateMask,
+              "CodeLexer::State doesn't fit the fence state");
+
+int fenceState(int kind, int length, int language, int lexerState) {
+  return (language << LanguageShift) |
+         (qMin(length, MaxFenceLength) << FenceLengthShift) |
+         (lexerState << LexerStateShift) | kind;
+}
+
+struct Fence {
+  int kind = 0;   // 0 if the line is not a fence
+  int length = 0; // Number of fence characters
+  int end = 0;    // Index after them
+};
+
+// ``` or ~~~ (three or more), indented by at most three spaces
+Fence fenceAt(QStringView line) {
+  Fence fence;
+  int i = 0;
+  while (i < line.size() && i < 3 && line[i] == ' ')
+    ++i;
+  if (i >= line.size() || (line[i] != '`' && line[i] != '~'))
+    return fence;
+
+  QChar marker = line[i];
+  int start = i;
+  while (i < line.size() && line[i] == marker)
+    ++i;
+  if (i - start < 3)
+    return fence;
+
+  // A backtick fence's info string can't contain backticks
+  if (marker == '`' && line.mid(i).contains(QLatin1Char('`')))
+    return fence;
+
+  fence.kind = marker == '`' ? BacktickFence : TildeFence;
+  fence.length = i - start;
+  fence.end = i;
+  return fence;
+}
+
+// Grammar name for a fence's info string, e.g. "sh" -> "bash"
+QString grammarName(QStringView info) {
+  static const QHash<QString, QString> aliases = {
+      {"sh", "bash"},         {"shell", "bash"},
+      {"zsh", "bash"},        {"console", "bash"},
+      {"py", "python"},       {"python3", "python"},
+      {"js", "javascript"},   {"jsx", "javascript"},
+      {"ts", "javascript"},   {"typescript", "javascript"},
+      {"c", "cpp"},           {"c++", "cpp"},
+      {"cc", "cpp"},          {"h", "cpp"},
+      {"hpp", "cpp"},         {"yml", "yaml"},
+      {"rs", "rust"},         {"golang", "go"},
+      {"psql", "sql"},        {"mysql", "sql"},
+      {"sqlite", "sql"},      {"postgresql", "sql"}};
+  QString name = info.toString().toLower();
+  return aliases.value(name, name);
+}
+
+} // namespace
+
+MarkdownHighlighter::MarkdownHighlighter() {
   setupFormats();
   setupRules();
-  setupKeywordHighlighting();
 }
 
 void MarkdownHighlighter::setupFormats() {
@@ -109,36 +188,67 @@ void MarkdownHighlighter::setupRules() {
   m_rules.append(rule);
 }
 
-void MarkdownHighlighter::setupKeywordHighlighting() {
-  // Define keyword colors matching CommandPopup (Catppuccin Mocha palette)
-  QMap<QString, QString> keywordColors = {
-      {"list", "#a6e3a1"},      // Green
-      {"checklist", "#a6e3a1"}, // Green
-      {"calc", "#89b4fa"},      // Blue
-      {"sum", "#f5c2e7"},       // Pink
-      {"avg", "#cba6f7"},       // Mauve
-      {"count", "#fab387"},     // Peach
-      {"code", "#f9e2af"},      // Yellow
-      {"markdown", "#cba6f7"},  // Mauve
-      {"md", "#cba6f7"},        // Mauve
-      {"paste", "#94e2d5"},     // Teal
-      {"timer", "#f38ba8"},     // Red
-      {"plain", "#a6adc8"},     // Overlay
-      {"text", "#a6adc8"},      // Overlay
-      {"settings", "#b4befe"},  // Lavender
-      {"ocr", "#74c7ec"}        // Sapphire
-  };
-
-  for (auto it = keywordColors.constBegin(); it != keywordColors.constEnd();
-       ++it) {
-    QTextCharFormat format;
-    format.setForeground(QColor(it.value()));
-    format.setFontWeight(QFont::Bold);
-    m_keywordFormats[it.key()] = format;
-  }
+int MarkdownHighlighter::fenceLanguage(QStringView info) {
+  // The first word of the info string, as in ```python {.numberLines}
+  info = info.trimmed();
+  qsizetype end = 0;
+  while (end < info.size() && !info[end].isSpace() && info[end] != '{')
+    ++end;
+  if (end == 0)
+    return 0;
+
+  QString name = grammarName(info.left(end));
+  int index = int(m_fenceLanguages.indexOf(name));
+  if (index >= 0)
+    return index + 1;
+
+  // Unknown languages stay plain code; the registry remembers them
+  QSharedPointer<const CodeLexer::Table> table =
+      GrammarRegistry::instance()->table(name);
+  if (!table || m_fenceLanguages.size() >= MaxLanguage)
+    return 0;
+  m_fenceLanguages.append(name);
+  m_fenceTables.append(table);
+  return int(m_fenceLanguages.size());
 }
 
-void MarkdownHighlighter::highlightBlock(const QString &text) {
+void MarkdownHighlighter::highlightBlock(const QString &text,
+                                         HighlighterHost::Block &block) {
+  // Fenced code spans blocks; QSyntaxHighlighter re-highlights following
+  // blocks only while their state changes, so an edit stops at the fence
+  int previous = block.previousState();
+  Fence fence = fenceAt(text);
+
+  if (previous != 0) {
+    int kind = previous & FenceKindMask;
+    int length = (previous >> FenceLengthShift) & MaxFenceLength;
+    int language = previous >> LanguageShift;
+
+    // Closed by the same kind of fence, at least as long, with nothing after
+    bool closes = fence.kind == kind && fence.length >= length &&
+                  QStringView(text).mid(fence.end).trimmed().isEmpty();
+    block.setFormat(0, int(text.length()), m_codeFormat);
+    if (closes) {
+      block.setState(0);
+      return;
+    }
+
+    int lexerState = (previous >> LexerStateShift) & LexerStateMask;
+    if (language > 0 && language <= m_fenceTables.size()) {
+      lexerState = m_fenceCode.highlightEmbedded(m_fenceTables[language - 1],
+                                                 text, block, lexerState);
+    }
+    block.setState(fenceState(kind, length, language, lexerState));
+    return;
+  }
+
+  if (fence.kind != 0) {
+    block.setFormat(0, int(text.length()), m_codeFormat);
+    int language = fenceLanguage(QStringView(text).mid(fence.end));
+    block.setState(fenceState(fence.kind, fence.length, language, 0));
+    return;
+  }
+
   // Apply markdown rules
   for (const HighlightingRule &rule : m_rules) {
     QRegularExpressionMatchIterator matchIterator =
@@ -148,19 +258,8 @@ void MarkdownHighlighter::highlightBlock(const QString &text) {
       int start = match.capturedStart(rule.captureGroup);
       int length = match.capturedLength(rule.captureGroup);
       if (length > 0) {
-        setFormat(start, length, rule.format);
+        block.setFormat(start, length, rule.format);
       }
     }
   }
-
-  // Highlight keywords (only if line is just the keyword)
-  QString trimmed = text.trimmed().toLower();
-  if (m_keywordFormats.contains(trimmed)) {
-    // Find position of the keyword in the line
-    int pos = text.indexOf(QRegularExpression(
-        "\\b" + trimmed + "\\b", QRegularExpression::CaseInsensitiveOption));
-    if (pos >= 0) {
-      setFormat(pos, trimmed.length(), m_keywordFormats[trimmed]);
-    }
-  }
 }
@@ -1,9 +1,9 @@
 #ifndef LINNOTE_MARKDOWNHIGHLIGHTER_H
 #define LINNOTE_MARKDOWNHIGHLIGHTER_H
 
-#include <QMap>
+#include "CodeHighlighter.h"
+#include "HighlighterHost.h"
 #include <QRegularExpression>
-#include <QSyntaxHighlighter>
 #include <QTextCharFormat>
 
 /**
@@ -13,20 +13,19 @@
  * - Headings (# ## ### etc)
  * - Bold (**text** or __text__)
  * - Italic (*text* or _text_)
- * - Code (`code` and ```blocks```)
+ * - Code (`code` and ```blocks```); a fence's language, e.g. ```sql, is
+ *   highlighted by CodeHighlighter
  * - Links [text](url)
  * - Lists (- item, * item, 1. item)
  * - Blockquotes (> text)
  * - Strikethrough (~~text~~)
  */
-class MarkdownHighlighter : public QSyntaxHighlighter {
-  Q_OBJECT
-
+class MarkdownHighlighter : public HighlighterHost::Lexer {
 public:
-  explicit MarkdownHighlighter(QTextDocument *parent = nullptr);
+  MarkdownHighlighter();
 
-protected:
-  void highlightBlock(const QString &text) override;
+  void highlightBlock(const QString &text,
+                      HighlighterHost::Block &block) override;
 
 private:
   struct HighlightingRule {
@@ -36,6 +35,12 @@ private:
   };
   QVector<HighlightingRule> m_rules;
 
+  // Languages seen in fence info strings; the block state holds the index
+  // plus one, and the embedded lexer's state
+  CodeHighlighter m_fenceCode;
+  QStringList m_fenceLanguages; // Grammar names
+  QVector<QSharedPointer<const CodeLexer::Table>> m_fenceTables;
+
   // Formats
   QTextCharFormat m_headingFormat;
   QTextCharFormat m_boldFormat;
@@ -45,11 +50,10 @@ private:
   QTextCharFormat m_listFormat;
   QTextCharFormat m_blockquoteFormat;
   QTextCharFormat m_strikethroughFormat;
-  QMap<QString, QTextCharFormat> m_keywordFormats;
 
   void setupFormats();
   void setupRules();
-  void setupKeywordHighlighting();
+  int fenceLanguage(QStringView info);
 };
 
 #endif // LINNOTE_MARKDOWNHIGHLIGHTER_H
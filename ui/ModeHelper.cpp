@@ -1,69 +1,21 @@
 #include "ModeHelper.h"
 #include "core/CurrencyConverter.h"
+#include "core/KeywordTable.h"
+#include "core/MathSheetWorker.h"
 #include "core/Settings.h"
 #include "core/UnitConverter.h"
 #include <QDebug>
 #include <QRegularExpression>
 #include <QTextBlock>
-
-// Static helper: Check if line is a keyword and return its color
-static bool getKeywordColor(const QString &text, QColor &outColor) {
-  QString line = text.trimmed();
-  if (line.isEmpty())
-    return false;
-
-  QString checkLine = line;
-  if (checkLine.startsWith('/')) {
-    checkLine = checkLine.mid(1);
-  }
-  checkLine = checkLine.toLower();
-
-  // Resolve alias
-  Settings *s = Settings::instance();
-  QMap<QString, QString> aliases = s->keywordAliases();
-  QString resolved = checkLine;
-  for (auto it = aliases.constBegin(); it != aliases.constEnd(); ++it) {
-    if (!it.value().isEmpty() && it.value().toLower() == checkLine) {
-      resolved = it.key();
-      break;
-    }
-  }
-
-  // Keyword color mapping
-  static QMap<QString, QString> colorMap = {
-      {"list", "#a6e3a1"},     {"checklist", "#a6e3a1"},
-      {"calc", "#89b4fa"},     {"sum", "#f5c2e7"},
-      {"avg", "#cba6f7"},      {"count", "#fab387"},
-      {"code", "#f9e2af"},     {"paste", "#94e2d5"},
-      {"timer", "#f38ba8"},    {"plain", "#a6adc8"},
-      {"text", "#a6adc8"},     {"settings", "#b4befe"},
-      {"markdown", "#cba6f7"}, {"md", "#cba6f7"},
-      {"ocr", "#94e2d5"}};
-
-  if (colorMap.contains(resolved)) {
-    outColor = QColor(colorMap[resolved]);
-    return true;
-  }
-  if (colorMap.contains(checkLine)) {
-    outColor = QColor(colorMap[checkLine]);
-    return true;
-  }
-  return false;
-}
+#include <algorithm>
 
 // ============================================================================
 // KeywordHighlighter
 // ============================================================================
 
-KeywordHighlighter::KeywordHighlighter(QTextDocument *parent)
-    : QSyntaxHighlighter(parent) {
+KeywordHighlighter::KeywordHighlighter() {
   // Define keyword colors (Catppuccin Mocha palette)
-  struct KeywordColor {
-    QString keyword;
-    QString color;
-  };
-
-  QList<KeywordColor> keywordColors = {
+  static const QMap<QString, QString> keywordColors = {
       {"list", "#a6e3a1"},      // Green
       {"checklist", "#a6e3a1"}, // Green
       {"calc", "#89b4fa"},      // Blue
@@ -75,52 +27,31 @@ KeywordHighlighter::KeywordHighlighter(QTextDocument *parent)
       {"timer", "#f38ba8"},     // Red
       {"plain", "#a6adc8"},     // Overlay
       {"text", "#a6adc8"},      // Overlay
-      {"settings", "#b4befe"}   // Lavender
+      {"settings", "#b4befe"},  // Lavender
+      {"markdown", "#cba6f7"},  // Mauve
+      {"md", "#cba6f7"},        // Mauve
+      {"ocr", "#94e2d5"}        // Teal
   };
 
-  for (const auto &kc : keywordColors) {
-    KeywordFormat kf;
-    kf.keyword = kc.keyword;
-    kf.format.setForeground(QColor(kc.color));
-    kf.format.setFontWeight(QFont::Bold);
-    m_keywords.append(kf);
+  for (const QString &keyword : KeywordTable::builtins()) {
+    QTextCharFormat format;
+    format.setForeground(QColor(keywordColors.value(keyword, "#a6adc8")));
+    format.setFontWeight(QFont::Bold);
+    m_formats.append(format);
   }
 }
 
-void KeywordHighlighter::highlightBlock(const QString &text) {
-  QString line = text.trimmed();
-
-  // Skip empty lines
-  if (line.isEmpty()) {
+void KeywordHighlighter::highlightBlock(const QString &text,
+                                        HighlighterHost::Block &block) {
+  // Only a line that is exactly a keyword or alias (with or without /)
+  QStringView line = QStringView(text).trimmed();
+  if (line.isEmpty())
     return;
-  }
 
-  // Check if line is exactly a keyword (without or with /)
-  QString checkLine = line;
-  if (checkLine.startsWith('/')) {
-    checkLine = checkLine.mid(1);
-  }
-  checkLine = checkLine.toLower();
-
-  // Get aliases from settings
-  Settings *s = Settings::instance();
-  QMap<QString, QString> aliases = s->keywordAliases();
-
-  // Check if the input matches an alias, resolve to original keyword
-  QString resolvedKeyword = checkLine;
-  for (auto it = aliases.constBegin(); it != aliases.constEnd(); ++it) {
-    if (!it.value().isEmpty() && it.value().toLower() == checkLine) {
-      resolvedKeyword = it.key();
-      break;
-    }
-  }
-
-  for (const KeywordFormat &kf : m_keywords) {
-    if (resolvedKeyword == kf.keyword || checkLine == kf.keyword) {
-      // Highlight entire line
-      setFormat(0, text.length(), kf.format);
-      return;
-    }
+  int index = Settings::instance()->keywordTable()->indexOf(line);
+  if (index >= 0) {
+    // Highlight entire line
+    block.setFormat(0, text.length(), m_formats.at(index));
   }
 }
 
@@ -128,8 +59,7 @@ void KeywordHighlighter::highlightBlock(const QString &text) {
 // ChecklistHighlighter
 // ============================================================================
 
-ChecklistHighlighter::ChecklistHighlighter(QTextDocument *parent)
-    : QSyntaxHighlighter(parent) {
+ChecklistHighlighter::ChecklistHighlighter() {
   // Unchecked items: normal color
   m_uncheckedFormat.setForeground(QColor("#cdd6f4"));
 
@@ -150,28 +80,20 @@ ChecklistHighlighter::ChecklistHighlighter(QTextDocument *parent)
   m_headingFormat.setFontWeight(QFont::Bold);
 }
 
-void ChecklistHighlighter::highlightBlock(const QString &text) {
-  // Always check for keyword first
-  QColor keywordColor;
-  if (getKeywordColor(text, keywordColor)) {
-    QTextCharFormat fmt;
-    fmt.setForeground(keywordColor);
-    fmt.setFontWeight(QFont::Bold);
-    setFormat(0, text.length(), fmt);
-    return;
-  }
-
+void ChecklistHighlighter::highlightBlock(const QString &text,
+                                          HighlighterHost::Block &block) {
+  // Keyword lines are colored by KeywordHighlighter, which runs after this
   QString trimmed = text.trimmed();
 
   // # Heading lines
   if (trimmed.startsWith('#')) {
-    setFormat(0, text.length(), m_headingFormat);
+    block.setFormat(0, text.length(), m_headingFormat);
     return;
   }
 
   // // Comment lines
   if (trimmed.startsWith("//")) {
-    setFormat(0, text.length(), m_commentFormat);
+    block.setFormat(0, text.length(), m_commentFormat);
     return;
   }
 
@@ -181,7 +103,7 @@ void ChecklistHighlighter::highlightBlock(const QString &text) {
   QRegularExpressionMatch triggerMatch = checkTriggerPattern.match(text);
   if (triggerMatch.hasMatch()) {
     // Treat as checked item
-    setFormat(0, text.length(), m_checkedFormat);
+    block.setFormat(0, text.length(), m_checkedFormat);
     return;
   }
 
@@ -192,19 +114,19 @@ void ChecklistHighlighter::highlightBlock(const QString &text) {
   QRegularExpressionMatch checkedMatch = checkedPattern.match(text);
   if (checkedMatch.hasMatch()) {
     // Highlight checkbox
-    setFormat(checkedMatch.capturedStart(1), checkedMatch.capturedLength(1),
-              m_checkboxFormat);
+    block.setFormat(checkedMatch.capturedStart(1),
+                    checkedMatch.capturedLength(1), m_checkboxFormat);
     // Highlight text (strikethrough)
-    setFormat(checkedMatch.capturedStart(2), checkedMatch.capturedLength(2),
-              m_checkedFormat);
+    block.setFormat(checkedMatch.capturedStart(2),
+                    checkedMatch.capturedLength(2), m_checkedFormat);
     return;
   }
 
   QRegularExpressionMatch uncheckedMatch = uncheckedPattern.match(text);
   if (uncheckedMatch.hasMatch()) {
     // Highlight checkbox
-    setFormat(uncheckedMatch.capturedStart(1), uncheckedMatch.capturedLength(1),
-              m_checkboxFormat);
+    block.setFormat(uncheckedMatch.capturedStart(1),
+                    uncheckedMatch.capturedLength(1), m_checkboxFormat);
     // Normal text format (already default)
   }
 }
@@ -213,36 +135,35 @@ void ChecklistHighlighter::highlightBlock(const QString &text) {
 // MathHighlighter
 // ============================================================================
 
-MathHighlighter::MathHighlighter(QTextDocument *parent)
-    : QSyntaxHighlighter(parent), m_evaluator(nullptr) {
+MathHighlighter::MathHighlighter() : m_evaluator(nullptr) {
   m_numberFormat.setForeground(QColor("#fab387"));   // Orange for numbers
   m_operatorFormat.setForeground(QColor("#89b4fa")); // Blue for operators
   m_resultFormat.setForeground(QColor("#a6e3a1"));   // Green for results
   m_resultFormat.setFontWeight(QFont::Bold);
   m_currencyFormat.setForeground(QColor("#f5c2e7")); // Pink for currency
+  setCurrencies(CurrencyConverter::instance()->supportedCurrencies());
 }
 
 void MathHighlighter::setEvaluator(MathEvaluator *evaluator) {
   m_evaluator = evaluator;
 }
 
-void MathHighlighter::highlightBlock(const QString &text) {
-  // Always check for keyword first
-  QColor keywordColor;
-  if (getKeywordColor(text, keywordColor)) {
-    QTextCharFormat fmt;
-    fmt.setForeground(keywordColor);
-    fmt.setFontWeight(QFont::Bold);
-    setFormat(0, text.length(), fmt);
-    return;
-  }
+void MathHighlighter::setCurrencies(const QStringList &codes) {
+  m_currencyCodes = AhoCorasick(
+      codes, AhoCorasick::CaseInsensitive | AhoCorasick::WholeWords);
+}
+
+void MathHighlighter::highlightBlock(const QString &text,
+                                     HighlighterHost::Block &block) {
+  // Keyword lines are colored by KeywordHighlighter, which runs after this
 
   // Highlight numbers
   static QRegularExpression numberPattern(R"(\b\d+(?:[.,]\d+)?\b)");
   QRegularExpressionMatchIterator numIt = numberPattern.globalMatch(text);
   while (numIt.hasNext()) {
     QRegularExpressionMatch match = numIt.next();
-    setFormat(match.capturedStart(), match.capturedLength(), m_numberFormat);
+    block.setFormat(match.capturedStart(), match.capturedLength(),
+                    m_numberFormat);
   }
 
   // Highlight operators
@@ -250,33 +171,29 @@ void MathHighlighter::highlightBlock(const QString &text) {
   QRegularExpressionMatchIterator opIt = opPattern.globalMatch(text);
   while (opIt.hasNext()) {
     QRegularExpressionMatch match = opIt.next();
-    setFormat(match.capturedStart(), match.capturedLength(), m_operatorFormat);
+    block.setFormat(match.capturedStart(), match.capturedLength(),
+                    m_operatorFormat);
   }
 
   // Highlight currency codes (fiat + crypto)
-  static QRegularExpression currencyPattern(
-      R"(\b(USD|EUR|TRY|GBP|JPY|CNY|RUB|AUD|CAD|CHF|INR|KRW|BRL|MXN|PLN|SEK|NOK|DKK|SGD|HKD|NZD|ZAR|THB|AED|SAR|ALL|BTC|ETH|USDT|USDC|XRP|BNB|SOL|ADA|DOGE|TRX|DOT|MATIC|LTC)\b)",
-      QRegularExpression::CaseInsensitiveOption);
-  QRegularExpressionMatchIterator currIt = currencyPattern.globalMatch(text);
-  while (currIt.hasNext()) {
-    QRegularExpressionMatch match = currIt.next();
-    setFormat(match.capturedStart(), match.capturedLength(), m_currencyFormat);
-  }
+  for (const AhoCorasick::Match &match : m_currencyCodes.findAll(text))
+    block.setFormat(match.start, match.length, m_currencyFormat);
 
   // Highlight currency symbols (€$₺£¥₽₿Ξ)
   static QRegularExpression symbolPattern(R"([$€₺£¥₽₿Ξ])");
   QRegularExpressionMatchIterator symIt = symbolPattern.globalMatch(text);
   while (symIt.hasNext()) {
     QRegularExpressionMatch match = symIt.next();
-    setFormat(match.capturedStart(), match.capturedLength(), m_currencyFormat);
+    block.setFormat(match.capturedStart(), match.capturedLength(),
+                    m_currencyFormat);
   }
 
   // Highlight result comments (= result)
   static QRegularExpression resultPattern(R"(=\s*[\d.,]+\s*$)");
   QRegularExpressionMatch resultMatch = resultPattern.match(text);
   if (resultMatch.hasMatch()) {
-    setFormat(resultMatch.capturedStart(), resultMatch.capturedLength(),
-              m_resultFormat);
+    block.setFormat(resultMatch.capturedStart(), resultMatch.capturedLength(),
+                    m_resultFormat);
   }
 }
 
@@ -286,58 +203,70 @@ void MathHighlighter::highlightBlock(const QString &text) {
 
 ModeHelper::ModeHelper(QPlainTextEdit *editor, QObject *parent)
     : QObject(parent), m_editor(editor), m_mode(NoteMode::PlainText),
-      m_keywordHighlighter(nullptr), m_checklistHighlighter(nullptr),
-      m_mathHighlighter(nullptr) {
-  // Always enable keyword highlighting
-  m_keywordHighlighter = new KeywordHighlighter(m_editor->document());
+      m_mathWorker(new MathSheetWorker), m_mathVersion(0),
+      m_appliedVersion(-1) {
+  m_mathHighlighter.setEvaluator(&m_evaluator);
+
+  // Create the converter singletons here so the worker only ever reads them
+  UnitConverter::instance();
+  CurrencyConverter *converter = CurrencyConverter::instance();
+
+  // Fetched rates can bring currencies the cached ones didn't have
+  connect(converter, &CurrencyConverter::ratesUpdated, this, [this]() {
+    m_mathHighlighter.setCurrencies(
+        CurrencyConverter::instance()->supportedCurrencies());
+    if (m_completionsBuilt)
+      addCurrencyCompletions();
+  });
+
+  // Math sheets are evaluated off the GUI thread
+  m_mathWorker->moveToThread(&m_mathThread);
+  connect(&m_mathThread, &QThread::finished, m_mathWorker,
+          &QObject::deleteLater);
+  connect(this, &ModeHelper::sheetEvaluationRequested, m_mathWorker,
+          &MathSheetWorker::evaluate, Qt::QueuedConnection);
+  connect(m_mathWorker, &MathSheetWorker::evaluated, this,
+          &ModeHelper::onSheetEvaluated, Qt::QueuedConnection);
+  m_mathThread.start();
+}
+
+ModeHelper::~ModeHelper() {
+  m_mathWorker->supersede(-1);
+  m_mathThread.quit();
+  m_mathThread.wait();
 }
 
 void ModeHelper::setMode(NoteMode mode) {
   if (m_mode == mode)
     return;
 
-  // CRITICAL: Disconnect highlighters from document BEFORE deleting
-  // This prevents Qt from accessing deleted memory during rehighlight
-  if (m_checklistHighlighter) {
-    m_checklistHighlighter->setDocument(nullptr);
-    delete m_checklistHighlighter;
-    m_checklistHighlighter = nullptr;
-  }
-  if (m_mathHighlighter) {
-    m_mathHighlighter->setDocument(nullptr);
-    delete m_mathHighlighter;
-    m_mathHighlighter = nullptr;
-  }
-
+  // The editor picks up modeLexer() for its HighlighterHost afterwards
   m_mode = mode;
   m_evaluator.clear();
+  m_mathResults.clear();
+  m_appliedVersion = -1;
+  updateVariableCompletions();
+  m_mathWorker->supersede(++m_mathVersion);
 
-  // Apply new highlighter based on mode
-  switch (mode) {
-  case NoteMode::Checklist:
-    m_checklistHighlighter = new ChecklistHighlighter(m_editor->document());
-    break;
+  qDebug() << "ModeHelper: Set mode to" << noteModeName(mode);
 
-  case NoteMode::Math:
-    m_mathHighlighter = new MathHighlighter(m_editor->document());
-    m_mathHighlighter->setEvaluator(&m_evaluator);
-    break;
+  requestMathResults();
+}
 
-  case NoteMode::Code:
-    // Basic code mode - could add syntax highlighting later
-    break;
+NoteMode ModeHelper::mode() const { return m_mode; }
 
-  case NoteMode::PlainText:
+HighlighterHost::Lexer *ModeHelper::modeLexer(NoteMode mode) {
+  switch (mode) {
+  case NoteMode::Checklist:
+    return &m_checklistHighlighter;
+  case NoteMode::Math:
+    return &m_mathHighlighter;
   default:
-    // No special highlighting
-    break;
+    // Code and Markdown highlighting belong to the editor
+    return nullptr;
   }
-
-  qDebug() << "ModeHelper: Set mode to" << noteModeName(mode);
 }
 
-NoteMode ModeHelper::mode() const { return m_mode; }
-
 void ModeHelper::handleEnterKey() {
   if (m_mode != NoteMode::Checklist)
     return;
@@ -387,62 +316,69 @@ QString ModeHelper::getMathResults() const {
   if (m_mode != NoteMode::Math)
     return QString();
 
+  // Built from the worker's last completed run, never evaluated here
   QString results;
-  // Use mutable evaluator for proper variable tracking
-  MathEvaluator &eval = const_cast<MathEvaluator &>(m_evaluator);
-
-  QString text = m_editor->toPlainText();
-  QStringList lines = text.split('\n');
-
-  for (const QString &line : lines) {
-    QString trimmed = line.trimmed();
-    if (trimmed.isEmpty() || trimmed == "---") {
+  for (const QString &result : m_mathResults) {
+    if (result.isEmpty()) {
       results += "\n";
-      continue;
+    } else {
+      results += QString(" = %1\n").arg(result);
     }
+  }
+  return results;
+}
 
-    // Skip if already has result (= at end)
-    static QRegularExpression resultPattern(R"(=\s*[\d.,]+\s*$)");
-    if (resultPattern.match(trimmed).hasMatch()) {
-      results += "\n";
-      continue;
-    }
+void ModeHelper::requestMathResults() {
+  if (m_mode != NoteMode::Math)
+    return;
 
-    // Try unit conversion first (e.g., "5 km to mile")
-    if (UnitConverter::instance()->isConversion(trimmed)) {
-      QString unitResult = UnitConverter::instance()->convert(trimmed);
-      if (!unitResult.isEmpty()) {
-        results += QString(" = %1\n").arg(unitResult);
-        continue;
-      }
-    }
+  // Older runs still in the worker stop at their next line. The worker
+  // diffs against m_appliedVersion, so dropped runs don't leave gaps.
+  int version = ++m_mathVersion;
+  m_mathWorker->supersede(version);
+  emit sheetEvaluationRequested(version, m_appliedVersion,
+                                m_editor->toPlainText(),
+                                Settings::instance()->decimalScale());
+}
 
-    // Try currency conversion (e.g., "100 USD to EUR")
-    double currencyResult;
-    QString fromCur, toCur;
-    if (CurrencyConverter::instance()->parseAndConvert(trimmed, currencyResult,
-                                                       fromCur, toCur)) {
-      results +=
-          QString(" = %1 %2\n").arg(currencyResult, 0, 'f', 2).arg(toCur);
-      continue;
-    }
+void ModeHelper::resetMathResults() {
+  m_evaluator.clear();
+  m_mathResults.clear();
+  m_appliedVersion = -1;
+  updateVariableCompletions();
+  emit mathResultsChanged(QList<int>());
+  requestMathResults();
+}
 
-    // Try math evaluation (using member evaluator for variable support)
-    bool ok;
-    double mathResult = eval.evaluate(trimmed, &ok);
-    if (ok) {
-      // Format nicely
-      if (mathResult == static_cast<int>(mathResult)) {
-        results += QString(" = %1\n").arg(static_cast<int>(mathResult));
-      } else {
-        results += QString(" = %1\n").arg(mathResult, 0, 'f', 4);
-      }
-    } else {
-      results += "\n";
+void ModeHelper::onSheetEvaluated(int version, int lineCount,
+                                  const QMap<int, QString> &changedLines,
+                                  const MathEvaluator &state) {
+  // Drop results that were overtaken while queued
+  if (version != m_mathVersion || m_mode != NoteMode::Math)
+    return;
+
+  m_appliedVersion = version;
+  bool resized = m_mathResults.size() != lineCount;
+  while (m_mathResults.size() > lineCount)
+    m_mathResults.removeLast();
+  while (m_mathResults.size() < lineCount)
+    m_mathResults.append(QString());
+
+  QList<int> changed;
+  for (auto it = changedLines.constBegin(); it != changedLines.constEnd();
+       ++it) {
+    if (it.key() < lineCount) {
+      m_mathResults[it.key()] = it.value();
+      changed.append(it.key());
     }
   }
 
-  return results;
+  // Variables and number mode of the sheet, for calculateExpression/ghost text
+  m_evaluator = state;
+  updateVariableCompletions();
+
+  if (!changed.isEmpty() || resized)
+    emit mathResultsChanged(changed);
 }
 
 QString ModeHelper::calculateExpression(const QString &expression) {
@@ -452,37 +388,81 @@ QString ModeHelper::calculateExpression(const QString &expression) {
     return QString();
   }
 
-  // Try unit conversion first (e.g., "5 km to mile")
-  if (UnitConverter::instance()->isConversion(trimmed)) {
-    QString unitResult = UnitConverter::instance()->convert(trimmed);
-    if (!unitResult.isEmpty()) {
-      return unitResult;
-    }
-  }
+  MathSheetWorker::selectNumberMode(m_evaluator, m_editor->toPlainText(),
+                                    Settings::instance()->decimalScale());
+  return MathSheetWorker::evaluateLine(m_evaluator, trimmed);
+}
 
-  // Try currency conversion (e.g., "100 USD to EUR")
-  double currencyResult;
-  QString fromCur, toCur;
-  if (CurrencyConverter::instance()->parseAndConvert(trimmed, currencyResult,
-                                                     fromCur, toCur)) {
-    return QString("%1 %2").arg(currencyResult, 0, 'f', 2).arg(toCur);
-  }
+QStringList ModeHelper::getVariables() const {
+  return m_evaluator.getVariables();
+}
 
-  // Try math evaluation
-  bool ok;
-  double mathResult = m_evaluator.evaluate(trimmed, &ok);
-  if (ok) {
-    // Format nicely
-    if (mathResult == static_cast<int>(mathResult)) {
-      return QString::number(static_cast<int>(mathResult));
-    } else {
-      return QString::number(mathResult, 'f', 4);
+QString ModeHelper::completion(const QString &prefix) {
+  buildCompletions();
+  return m_completions.best(prefix);
+}
+
+void ModeHelper::completionAccepted(const QString &word) {
+  m_completions.touch(word);
+}
+
+void ModeHelper::buildCompletions() {
+  if (m_completionsBuilt)
+    return;
+  m_completionsBuilt = true;
+
+  for (const QString &name : MathEvaluator::functionNames())
+    m_completions.insert(name, CompletionIndex::Function);
+
+  // Ghost text completes words, so "fl oz" or "m/s" can't be offered
+  auto isWord = [](const QString &alias) {
+    return std::all_of(alias.begin(), alias.end(), [](QChar c) {
+      return c.isLetterOrNumber() || c == '_';
+    });
+  };
+  UnitConverter *units = UnitConverter::instance();
+  for (const QString &category : units->categories()) {
+    for (const QString &alias : units->unitsInCategory(category)) {
+      if (isWord(alias))
+        m_completions.insert(alias, CompletionIndex::Unit);
     }
   }
 
-  return QString();
+  addCurrencyCompletions();
+  for (const QString &keyword : KeywordTable::builtins())
+    m_completions.insert('/' + keyword, CompletionIndex::Command);
+  updateVariableCompletions();
 }
 
-QStringList ModeHelper::getVariables() const {
-  return m_evaluator.getVariables();
+void ModeHelper::addCurrencyCompletions() {
+  // Codes already in stay as they are
+  const QStringList codes =
+      CurrencyConverter::instance()->supportedCurrencies();
+  for (const QString &code : codes)
+    m_completions.insert(code, CompletionIndex::Currency);
+}
+
+void ModeHelper::updateVariableCompletions() {
+  // Only the difference to the last run goes into the index; a variable
+  // that appears counts as a use, so the newest rank first
+  if (!m_completionsBuilt)
+    return; // buildCompletions() adds them
+  const QStringList names = m_evaluator.getVariables();
+  QSet<QString> variables(names.begin(), names.end());
+  for (auto it = m_variableCompletions.begin();
+       it != m_variableCompletions.end();) {
+    if (variables.contains(*it)) {
+      ++it;
+    } else {
+      m_completions.remove(*it);
+      it = m_variableCompletions.erase(it);
+    }
+  }
+  for (const QString &name : names) {
+    if (!m_variableCompletions.contains(name) &&
+        m_completions.insert(name, CompletionIndex::Variable)) {
+      m_variableCompletions.insert(name);
+      m_completions.touch(name);
+    }
+  }
 }
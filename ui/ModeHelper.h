@@ -1,46 +1,44 @@
 #ifndef LINNOTE_MODEHELPER_H
 #define LINNOTE_MODEHELPER_H
 
+#include "HighlighterHost.h"
+#include "core/AhoCorasick.h"
+#include "core/CompletionIndex.h"
 #include "core/MathEvaluator.h"
 #include "core/NoteMode.h"
 #include <QPlainTextEdit>
-#include <QSyntaxHighlighter>
+#include <QSet>
 #include <QTextDocument>
+#include <QThread>
 
 class CurrencyConverter;
+class MathSheetWorker;
 
 /**
  * @brief Syntax highlighter for command keywords
- * Highlights keywords like list, math, code in their respective colors
+ * Highlights keywords like list, math, code in their respective colors.
+ * Runs last in every mode, so a keyword line wins over mode formatting.
  */
-class KeywordHighlighter : public QSyntaxHighlighter {
-  Q_OBJECT
-
+class KeywordHighlighter : public HighlighterHost::Lexer {
 public:
-  explicit KeywordHighlighter(QTextDocument *parent = nullptr);
+  KeywordHighlighter();
 
-protected:
-  void highlightBlock(const QString &text) override;
+  void highlightBlock(const QString &text,
+                      HighlighterHost::Block &block) override;
 
 private:
-  struct KeywordFormat {
-    QString keyword;
-    QTextCharFormat format;
-  };
-  QList<KeywordFormat> m_keywords;
+  QVector<QTextCharFormat> m_formats; // Per KeywordTable::builtins() entry
 };
 
 /**
  * @brief Syntax highlighter for checklist mode
  */
-class ChecklistHighlighter : public QSyntaxHighlighter {
-  Q_OBJECT
-
+class ChecklistHighlighter : public HighlighterHost::Lexer {
 public:
-  explicit ChecklistHighlighter(QTextDocument *parent = nullptr);
+  ChecklistHighlighter();
 
-protected:
-  void highlightBlock(const QString &text) override;
+  void highlightBlock(const QString &text,
+                      HighlighterHost::Block &block) override;
 
 private:
   QTextCharFormat m_uncheckedFormat;
@@ -54,22 +52,24 @@ private:
  * @brief Syntax highlighter for math mode
  * Shows calculation results inline
  */
-class MathHighlighter : public QSyntaxHighlighter {
-  Q_OBJECT
-
+class MathHighlighter : public HighlighterHost::Lexer {
 public:
-  explicit MathHighlighter(QTextDocument *parent = nullptr);
+  MathHighlighter();
 
   void setEvaluator(MathEvaluator *evaluator);
 
-protected:
-  void highlightBlock(const QString &text) override;
+  // Currency codes to color, e.g. CurrencyConverter::supportedCurrencies()
+  void setCurrencies(const QStringList &codes);
+
+  void highlightBlock(const QString &text,
+                      HighlighterHost::Block &block) override;
 
 private:
   QTextCharFormat m_numberFormat;
   QTextCharFormat m_operatorFormat;
   QTextCharFormat m_resultFormat;
   QTextCharFormat m_currencyFormat;
+  AhoCorasick m_currencyCodes;
   MathEvaluator *m_evaluator;
 };
 
@@ -81,6 +81,7 @@ class ModeHelper : public QObject {
 
 public:
   explicit ModeHelper(QPlainTextEdit *editor, QObject *parent = nullptr);
+  ~ModeHelper() override;
 
   void setMode(NoteMode mode);
   NoteMode mode() const;
@@ -91,7 +92,7 @@ public:
   // Called when a checkbox is clicked
   void toggleCheckboxAtCursor();
 
-  // Get math results overlay text
+  // Get math results overlay text (from the last completed evaluation)
   QString getMathResults() const;
 
   // Calculate a single expression and return result string
@@ -100,13 +101,57 @@ public:
   // Get defined variable names (for autocomplete)
   QStringList getVariables() const;
 
+  // Ghost text: the best completion of @p prefix among the sheet's
+  // variables, functions, units, currency codes and, after '/', commands.
+  // Ranked by how often and how lately each was used.
+  QString completion(const QString &prefix);
+  void completionAccepted(const QString &word);
+
+  // Lexers for the editor's HighlighterHost: the one for the current mode
+  // (nullptr if the editor supplies it), and the keyword lexer that runs last
+  HighlighterHost::Lexer *modeLexer() { return modeLexer(m_mode); }
+  HighlighterHost::Lexer *modeLexer(NoteMode mode); // For another note's
+  HighlighterHost::Lexer *keywordLexer() { return &m_keywordHighlighter; }
+
+public slots:
+  // Re-evaluate the Math sheet in the background (cancels older requests)
+  void requestMathResults();
+
+  // Forget the shown results, e.g. for another note, and re-evaluate
+  void resetMathResults();
+
+signals:
+  void sheetEvaluationRequested(int version, int baseVersion,
+                                const QString &text, int decimalScale);
+  // Emitted with the line numbers whose result changed; empty if lines
+  // were only removed or all results were cleared
+  void mathResultsChanged(const QList<int> &changedLines);
+
+private slots:
+  void onSheetEvaluated(int version, int lineCount,
+                        const QMap<int, QString> &changedLines,
+                        const MathEvaluator &state);
+
 private:
+  void buildCompletions();
+  void addCurrencyCompletions();
+  void updateVariableCompletions();
+
   QPlainTextEdit *m_editor;
   NoteMode m_mode;
   MathEvaluator m_evaluator;
-  KeywordHighlighter *m_keywordHighlighter;
-  ChecklistHighlighter *m_checklistHighlighter;
-  MathHighlighter *m_mathHighlighter;
+  CompletionIndex m_completions;       // Built on first use
+  bool m_completionsBuilt = false;
+  QSet<QString> m_variableCompletions; // The sheet's, in m_completions
+  KeywordHighlighter m_keywordHighlighter;
+  ChecklistHighlighter m_checklistHighlighter;
+  MathHighlighter m_mathHighlighter;
+
+  QThread m_mathThread;
+  MathSheetWorker *m_mathWorker; // Lives in m_mathThread
+  int m_mathVersion;
+  QStringList m_mathResults; // One entry per line, empty if no result
+  int m_appliedVersion;      // Run m_mathResults came from, -1 if none
 };
 
 #endif // LINNOTE_MODEHELPER_H
@@ -1,12 +1,19 @@
 #include "NoteEditor.h"
 #include "CodeHighlighter.h"
 #include "CommandPopup.h"
+#include "HighlightScheduler.h"
+#include "HighlighterHost.h"
 #include "MarkdownHighlighter.h"
 #include "ModeHelper.h"
+#include "PasteStreamer.h"
+#include "core/AhoCorasick.h"
 #include "core/CurrencyConverter.h"
+#include "core/KeywordTable.h"
+#include "core/LinkShortener.h"
+#include "core/PasteCleaner.h"
+#include "core/PieceTable.h"
 #include "core/Settings.h"
 #include "core/TextAnalyzer.h"
-#include "core/UrlShortener.h"
 #include <QApplication>
 #include <QClipboard>
 #include <QDebug>
@@ -20,11 +27,16 @@
 #include <QRegularExpression>
 #include <QScrollBar>
 #include <QTextBlock>
+#include <QTextDocument>
 #include <QUrl>
 
 NoteEditor::NoteEditor(QWidget *parent)
     : QPlainTextEdit(parent), m_modeHelper(new ModeHelper(this, this)),
       m_markdownHighlighter(nullptr), m_codeHighlighter(nullptr),
+      m_highlighter(nullptr),
+      m_highlightScheduler(new HighlightScheduler(this)),
+      m_documents(new DocumentCache(this)),
+      m_pasteStreamer(new PasteStreamer(this)),
       m_mathOverlay(nullptr), m_tutorialLabel(nullptr), m_ghostLabel(nullptr),
       m_currentMode(NoteMode::PlainText), m_commandPopup(nullptr),
       m_popupActive(false), m_tutorialStartPos(-1), m_tutorialLength(0),
@@ -41,21 +53,201 @@ NoteEditor::NoteEditor(QWidget *parent)
       "color: rgba(166, 173, 200, 0.5); background: transparent;");
   m_ghostLabel->hide();
 
-  // Setup Markdown syntax highlighting
-  m_markdownHighlighter = new MarkdownHighlighter(document());
+  // One highlighter per document; the mode decides which lexers it runs.
+  // Text that isn't a note's goes into the scratch document.
+  m_markdownHighlighter = new MarkdownHighlighter;
+  m_scratch = createDocument();
+  attachDocument(m_scratch);
+  updateHighlighting();
 
   // Forward text changes
   connect(this, &QPlainTextEdit::textChanged, this,
           &NoteEditor::contentChanged);
-  connect(this, &QPlainTextEdit::textChanged, this,
+  connect(this, &QPlainTextEdit::textChanged, m_modeHelper,
+          &ModeHelper::requestMathResults);
+  connect(m_modeHelper, &ModeHelper::mathResultsChanged, this,
           &NoteEditor::updateMathOverlay);
   connect(this, &QPlainTextEdit::textChanged, this,
           &NoteEditor::checkForKeywordTutorial);
   connect(this, &QPlainTextEdit::textChanged, this,
           &NoteEditor::updateGhostText);
+
+  // Pasted links are shortened in the background
+  connect(LinkShortener::instance(), &LinkShortener::shortened, this,
+          &NoteEditor::replaceShortenedLink);
+  connect(LinkShortener::instance(), &LinkShortener::failed, this,
+          [this](const QString &url) { m_pendingLinks.remove(url); });
+}
+
+NoteEditor::~NoteEditor() {
+  // Let go of our documents, then delete them and their hosts (and code
+  // highlighters) before the other lexers the hosts run go away
+  setDocument(nullptr);
+  delete m_documents;
+  delete m_markdownHighlighter;
+}
+
+DocumentCache::Entry NoteEditor::createDocument() {
+  DocumentCache::Entry entry;
+  entry.document = new QTextDocument(m_documents);
+  entry.document->setDocumentLayout(
+      new QPlainTextDocumentLayout(entry.document));
+  applyDocumentFormat(entry.document);
+
+  // Same lexers as the current document until setMode() says otherwise
+  entry.highlighter = new HighlighterHost(entry.document);
+  if (m_highlighter)
+    entry.highlighter->setLexers(lexersFor(m_currentMode, entry));
+  entry.highlighter->setScheduler(m_highlightScheduler);
+  return entry;
+}
+
+void NoteEditor::addCodeHighlighter(DocumentCache::Entry &entry) {
+  // One per document, so a cached Code note keeps its language and its
+  // highlighting when shown again. It goes away after the host running it.
+  if (entry.code)
+    return;
+  CodeHighlighter *code = new CodeHighlighter;
+  connect(entry.highlighter, &QObject::destroyed, [code] { delete code; });
+  entry.code = code;
 }
 
-NoteEditor::~NoteEditor() {}
+DocumentCache::Entry &NoteEditor::shownEntry() {
+  DocumentCache::Entry *entry = m_documents->entry(m_noteId);
+  return entry ? *entry : m_scratch;
+}
+
+void NoteEditor::applyDocumentFormat(QTextDocument *doc) {
+  // Font and tab stops are kept per document; carry the editor's over
+  if (doc->defaultFont() != font())
+    doc->setDefaultFont(font());
+  QTextOption option = doc->defaultTextOption();
+  if (option.tabStopDistance() != tabStopDistance()) {
+    option.setTabStopDistance(tabStopDistance());
+    doc->setDefaultTextOption(option);
+  }
+}
+
+void NoteEditor::attachDocument(const DocumentCache::Entry &entry) {
+  // A paste keeps going only into the document it started in, and so
+  // does shortening its links
+  m_pasteStreamer->cancel();
+  m_pendingLinks.clear();
+
+  QTextDocument *doc = entry.document;
+  applyDocumentFormat(doc);
+
+  for (const QMetaObject::Connection &connection :
+       std::as_const(m_documentConnections))
+    disconnect(connection);
+  m_documentConnections.clear();
+
+  setDocument(doc);
+  m_highlighter = entry.highlighter;
+  m_codeHighlighter = entry.code;
+  m_highlightScheduler->attachDocument();
+  m_unreportedEdits = false;
+  if (!entry.cursor.isNull())
+    setTextCursor(entry.cursor);
+  verticalScrollBar()->setValue(entry.scroll);
+
+  // setDocument() emits no textChanged. The last document's Math results
+  // must neither stay up nor be what the next run is diffed against.
+  m_modeHelper->resetMathResults();
+
+  // The delta comes before textChanged, so listeners of contentChanged
+  // see it applied
+  m_documentConnections << connect(doc, &QTextDocument::contentsChange, this,
+                                   &NoteEditor::reportContentsChange);
+
+  // Code notes follow edits to their first few KB, e.g. a paste. Queued so
+  // a rehighlight doesn't run inside the change.
+  m_documentConnections << connect(
+      doc, &QTextDocument::contentsChange, this,
+      [this](int position, int, int) {
+        if (m_currentMode == NoteMode::Code && m_codeHighlighter &&
+            position < LanguageDetector::WindowChars)
+          updateCodeLanguage(true);
+      },
+      Qt::QueuedConnection);
+}
+
+void NoteEditor::showNote(const QString &noteId, quint64 revision,
+                          const PieceTable &content) {
+  hideTutorial();
+  clearGhostText();
+  saveViewState();
+
+  DocumentCache::Entry entry = m_documents->find(noteId, revision);
+  if (!entry.document) {
+    entry = createDocument();
+    entry.revision = revision;
+    // Filled once shown, so large notes get deferred highlighting
+    attachDocument(entry);
+    setPlainText(content.toString());
+  } else if (entry.document != document()) {
+    attachDocument(entry);
+  }
+  m_noteId = noteId;
+  m_documents->insert(noteId, entry);
+  m_unreportedEdits = false;
+}
+
+void NoteEditor::setNoteRevision(quint64 revision) {
+  if (DocumentCache::Entry *entry = m_documents->entry(m_noteId))
+    entry->revision = revision;
+}
+
+void NoteEditor::forgetNote(const QString &noteId) {
+  if (noteId.isEmpty())
+    return;
+  if (noteId != m_noteId) {
+    m_documents->remove(noteId);
+    return;
+  }
+
+  // Still on screen: it becomes the scratch document
+  m_scratch.document->deleteLater();
+  m_scratch = m_documents->take(noteId);
+  m_noteId.clear();
+}
+
+DocumentCache::Entry NoteEditor::createNoteDocument(NoteMode mode) {
+  DocumentCache::Entry entry = createDocument();
+  entry.highlighter->setLexers(lexersFor(mode, entry));
+  return entry;
+}
+
+void NoteEditor::addNoteDocument(const QString &noteId,
+                                 const DocumentCache::Entry &entry) {
+  if (noteId == m_noteId || m_documents->contains(noteId, entry.revision)) {
+    entry.document->deleteLater();
+    return;
+  }
+  m_documents->insert(noteId, entry, false);
+}
+
+bool NoteEditor::hasNoteDocument(const QString &noteId,
+                                 quint64 revision) const {
+  return noteId == m_noteId || m_documents->contains(noteId, revision);
+}
+
+void NoteEditor::showScratch() {
+  if (m_noteId.isEmpty())
+    return;
+  hideTutorial();
+  clearGhostText();
+  saveViewState();
+  m_noteId.clear();
+  attachDocument(m_scratch);
+}
+
+void NoteEditor::saveViewState() {
+  if (DocumentCache::Entry *entry = m_documents->entry(m_noteId)) {
+    entry->cursor = textCursor();
+    entry->scroll = verticalScrollBar()->value();
+  }
+}
 
 void NoteEditor::setupAppearance() {
   // Apply font from Settings
@@ -155,33 +347,45 @@ void NoteEditor::applyFontSettings() {
 }
 
 void NoteEditor::performTextAnalysis(const QString &type) {
-  // Get current text (excluding the command line itself)
-  QString text = toPlainText();
-
-  // Find and remove the command line (first line if it's the command)
-  QStringList lines = text.split('\n');
-  if (!lines.isEmpty()) {
-    QString firstLine = lines.first().trimmed().toLower();
-    if (firstLine == type || firstLine == "/" + type) {
-      lines.removeFirst();
-      text = lines.join('\n');
+  const QString text = toPlainText();
+  QStringView view(text);
+
+  // A selection is analyzed on its own; positions match the plain text
+  QTextCursor selection = textCursor();
+  if (selection.hasSelection()) {
+    view = view.mid(selection.selectionStart(),
+                    selection.selectionEnd() - selection.selectionStart());
+  } else {
+    // Skip the command line (first line if it's the command)
+    qsizetype firstLineEnd = view.indexOf(u'\n');
+    QStringView firstLine =
+        firstLineEnd < 0 ? view : view.first(firstLineEnd);
+    QString command = firstLine.trimmed().toString().toLower();
+    if (command == type || command == "/" + type) {
+      view = firstLineEnd < 0 ? QStringView() : view.mid(firstLineEnd + 1);
     }
   }
 
   TextAnalyzer analyzer;
+  TextAnalyzer::Scan scan = analyzer.scan(view);
   QString result;
 
   if (type == "sum") {
-    result = analyzer.formatSum(text);
+    result = TextAnalyzer::formatSum(scan);
   } else if (type == "avg") {
-    result = analyzer.formatAvg(text);
+    result = TextAnalyzer::formatAvg(scan);
   } else if (type == "count") {
-    result = analyzer.formatCount(text);
+    result = TextAnalyzer::formatCount(scan);
   }
 
-  // Append result to end of text
+  // Result goes after the selection, or at the end of the text
   if (!result.isEmpty()) {
-    moveCursor(QTextCursor::End);
+    if (selection.hasSelection()) {
+      selection.setPosition(selection.selectionEnd());
+      setTextCursor(selection);
+    } else {
+      moveCursor(QTextCursor::End);
+    }
     insertPlainText(result);
   }
 
@@ -262,7 +466,51 @@ void NoteEditor::setupMathOverlay() {
 
 QString NoteEditor::content() const { return toPlainText(); }
 
-void NoteEditor::setContent(const QString &content) { setPlainText(content); }
+void NoteEditor::setContent(const QString &content) {
+  // Never into a note's cached document
+  showScratch();
+  setPlainText(content);
+}
+
+bool NoteEditor::takeUnreportedEdits() {
+  bool unreported = m_unreportedEdits;
+  m_unreportedEdits = false;
+  return unreported;
+}
+
+void NoteEditor::reportContentsChange(int position, int charsRemoved,
+                                      int charsAdded) {
+  // The document counts a final paragraph separator that toPlainText()
+  // leaves out; a change that replaces everything reports it too
+  int length = document()->characterCount() - 1;
+  int oldLength = length - charsAdded + charsRemoved;
+  int removed = qMin(charsRemoved, oldLength - position);
+  int added = qMin(charsAdded, length - position);
+
+  // Edits made with signals blocked (tutorial text, math results) and
+  // whole-document replacements are picked up by reading content() once
+  if (signalsBlocked() || m_unreportedEdits ||
+      (position == 0 && removed == oldLength && added == length)) {
+    m_unreportedEdits = true;
+    return;
+  }
+
+  QString text;
+  if (added > 0) {
+    QTextCursor cursor(document());
+    cursor.setPosition(position);
+    cursor.setPosition(position + added, QTextCursor::KeepAnchor);
+    text = cursor.selectedText();
+    // Same mapping as QTextDocument::toPlainText()
+    for (QChar &c : text) {
+      if (c == QChar::ParagraphSeparator || c == QChar::LineSeparator)
+        c = '\n';
+      else if (c == QChar::Nbsp)
+        c = ' ';
+    }
+  }
+  emit contentsEdited(position, removed, text);
+}
 
 void NoteEditor::appendContent(const QString &text) {
   if (text.isEmpty()) {
@@ -298,37 +546,100 @@ void NoteEditor::setMode(NoteMode mode) {
     break;
   case NoteMode::Code: {
     setPlaceholderText(tr("// Paste your code here..."));
-    // Activate code highlighting
-    if (!m_codeHighlighter) {
-      m_codeHighlighter = new CodeHighlighter(document());
-    }
+    // Activate code highlighting, with the document's own highlighter
+    DocumentCache::Entry &entry = shownEntry();
+    addCodeHighlighter(entry);
+    m_codeHighlighter = entry.code;
     // Detect language and apply highlighting
-    QString text = toPlainText();
-    auto lang = CodeHighlighter::detectLanguage(text);
-    m_codeHighlighter->setLanguage(lang);
+    updateCodeLanguage(false);
     break;
   }
   case NoteMode::Markdown: {
     setPlaceholderText(tr("# Heading\n**bold** *italic*\n- list item"));
-    // Activate markdown highlighting
-    if (!m_markdownHighlighter) {
-      m_markdownHighlighter = new MarkdownHighlighter(document());
-    }
     break;
   }
   default:
     setPlaceholderText(tr("Start typing... (try: list, calc, code, md)"));
     break;
   }
+
+  updateHighlighting();
+}
+
+void NoteEditor::updateHighlighting() {
+  m_highlighter->setLexers(lexersFor(m_currentMode, shownEntry()));
+}
+
+QList<HighlighterHost::Lexer *>
+NoteEditor::lexersFor(NoteMode mode, DocumentCache::Entry &entry) {
+  // Mode lexer first, keyword lines painted over it last
+  QList<HighlighterHost::Lexer *> lexers;
+  if (HighlighterHost::Lexer *modeLexer = m_modeHelper->modeLexer(mode)) {
+    lexers << modeLexer;
+  } else if (mode == NoteMode::Code) {
+    addCodeHighlighter(entry);
+    lexers << entry.code;
+  } else {
+    lexers << m_markdownHighlighter;
+  }
+  lexers << m_modeHelper->keywordLexer();
+  return lexers;
+}
+
+void NoteEditor::updateCodeLanguage(bool keepIfUnsure) {
+  // Only the start of the note decides, and only when it changed
+  LanguageDetector::Result detected =
+      m_languageDetector.update(leadingText(LanguageDetector::WindowChars));
+  bool sure = detected.confidence >= LanguageDetector::MinConfidence;
+  if (!sure && keepIfUnsure)
+    return;
+
+  auto lang = sure ? CodeHighlighter::fromDetected(detected.language)
+                   : CodeHighlighter::Generic;
+  if (m_codeHighlighter->language() != lang) {
+    m_codeHighlighter->setLanguage(lang);
+    // Otherwise updateHighlighting() in setMode() rehighlights
+    if (m_highlighter->lexers().contains(m_codeHighlighter))
+      m_highlighter->rehighlight();
+  }
+}
+
+QString NoteEditor::leadingText(int maxChars) const {
+  // Without the toPlainText() copy of the whole document
+  QString text;
+  for (QTextBlock block = document()->begin();
+       block.isValid() && text.size() < maxChars; block = block.next()) {
+    if (block != document()->begin())
+      text += '\n';
+    text += block.text();
+  }
+  text.truncate(maxChars);
+  return text;
 }
 
 NoteMode NoteEditor::mode() const { return m_currentMode; }
 
+static PasteCleaner::Options pasteOptions(Settings *s) {
+  PasteCleaner::Options options;
+  options.trimLines = s->pasteRemoveLeadingSpaces();
+  options.removeNumbers = s->pasteRemoveNumbers();
+  options.removeBullets = s->pasteRemoveBullets();
+  options.removeMarkdown = s->pasteRemoveMarkdown();
+  options.removeEmptyLines = s->pasteRemoveEmptyLines();
+  return options;
+}
+
 void NoteEditor::pasteFromClipboard() {
   QClipboard *clipboard = QApplication::clipboard();
   QString text = clipboard->text();
 
-  if (!text.isEmpty()) {
+  if (text.size() >= PasteStreamer::StreamChars) {
+    // Cleaned and appended a chunk at a time
+    QTextCursor cursor(document());
+    cursor.movePosition(QTextCursor::End);
+    m_pasteStreamer->start(text, pasteOptions(Settings::instance()), cursor,
+                           document()->isEmpty() ? QString() : "\n");
+  } else if (!text.isEmpty()) {
     // Apply paste cleanup based on settings
     Settings *s = Settings::instance();
     text = cleanupPastedText(text, s);
@@ -339,86 +650,17 @@ void NoteEditor::pasteFromClipboard() {
 QString NoteEditor::cleanupPastedText(const QString &text, Settings *s) {
   if (!s)
     return text;
-
-  qDebug() << "cleanupPastedText: Input:" << text.left(100);
-  qDebug() << "cleanupPastedText: Settings - spaces:"
-           << s->pasteRemoveLeadingSpaces()
-           << "numbers:" << s->pasteRemoveNumbers()
-           << "bullets:" << s->pasteRemoveBullets()
-           << "markdown:" << s->pasteRemoveMarkdown()
-           << "empty:" << s->pasteRemoveEmptyLines();
-
-  QStringList lines = text.split('\n');
-  QStringList result;
-
-  for (QString line : lines) {
-    // Remove empty lines (check first before other modifications)
-    if (s->pasteRemoveEmptyLines() && line.trimmed().isEmpty()) {
-      qDebug() << "cleanupPastedText: Skipping empty line";
-      continue;
-    }
-
-    // Remove leading spaces/tabs
-    if (s->pasteRemoveLeadingSpaces()) {
-      line = line.trimmed();
-    }
-
-    // Remove leading numbers (1. 2. 3. etc)
-    if (s->pasteRemoveNumbers()) {
-      static QRegularExpression numPattern(R"(^\s*\d+[\.\)]\s*)");
-      line.remove(numPattern);
-    }
-
-    // Remove bullets (-, *, •, etc)
-    if (s->pasteRemoveBullets()) {
-      static QRegularExpression bulletPattern(R"(^\s*[-\*•◦▪▸►→]\s*)");
-      line.remove(bulletPattern);
-    }
-
-    // Remove markdown formatting
-    if (s->pasteRemoveMarkdown()) {
-      // Bold **text** -> text
-      static QRegularExpression boldPattern(R"(\*\*([^\*]+)\*\*)");
-      QRegularExpressionMatch m = boldPattern.match(line);
-      while (m.hasMatch()) {
-        line.replace(m.captured(0), m.captured(1));
-        m = boldPattern.match(line);
-      }
-      // Italic _text_ -> text (single underscore)
-      static QRegularExpression underscorePattern(R"(\b_([^_]+)_\b)");
-      m = underscorePattern.match(line);
-      while (m.hasMatch()) {
-        line.replace(m.captured(0), m.captured(1));
-        m = underscorePattern.match(line);
-      }
-      // Inline code `text` -> text
-      static QRegularExpression codePattern(R"(`([^`]+)`)");
-      m = codePattern.match(line);
-      while (m.hasMatch()) {
-        line.replace(m.captured(0), m.captured(1));
-        m = codePattern.match(line);
-      }
-      // Links [text](url) -> text
-      static QRegularExpression linkPattern(R"(\[([^\]]+)\]\([^\)]+\))");
-      m = linkPattern.match(line);
-      while (m.hasMatch()) {
-        line.replace(m.captured(0), m.captured(1));
-        m = linkPattern.match(line);
-      }
-      // Headings # ## ### -> remove
-      static QRegularExpression headingPattern(R"(^#{1,6}\s*)");
-      line.remove(headingPattern);
-    }
-
-    result.append(line);
-  }
-
-  QString output = result.join('\n');
-  qDebug() << "cleanupPastedText: Output:" << output.left(100);
-  return output;
+  return PasteCleaner(pasteOptions(s)).clean(text);
 }
 
 void NoteEditor::keyPressEvent(QKeyEvent *event) {
+  // Stop a large paste on ESC, keeping what is in
+  if (event->key() == Qt::Key_Escape && m_pasteStreamer->isActive()) {
+    m_pasteStreamer->cancel();
+    event->accept();
+    return;
+  }
+
   // Stop AutoPaste on ESC
   if (event->key() == Qt::Key_Escape && m_autoPasteActive) {
     stopAutoPaste();
@@ -681,25 +923,15 @@ void NoteEditor::keyPressEvent(QKeyEvent *event) {
   // available)
   if (m_currentMode == NoteMode::Math && event->key() == Qt::Key_Tab) {
     if (!m_ghostCompletion.isEmpty()) {
-      // Get current prefix and replace with full completion
-      QTextCursor cursor = textCursor();
-      QString lineText = cursor.block().text();
-      int posInLine = cursor.positionInBlock();
-
-      // Find word start
-      int wordStart = posInLine;
-      while (wordStart > 0 && (lineText[wordStart - 1].isLetterOrNumber() ||
-                               lineText[wordStart - 1] == '_')) {
-        wordStart--;
-      }
-
-      QString prefix = lineText.mid(wordStart, posInLine - wordStart);
       // Replace prefix with full completion
+      QTextCursor cursor = textCursor();
+      QString prefix = completionPrefix();
       cursor.setPosition(cursor.position() - prefix.length());
       cursor.setPosition(cursor.position() + prefix.length(),
                          QTextCursor::KeepAnchor);
       cursor.insertText(m_ghostCompletion);
       setTextCursor(cursor);
+      m_modeHelper->completionAccepted(m_ghostCompletion);
       clearGhostText();
       return;
     }
@@ -790,58 +1022,95 @@ void NoteEditor::mousePressEvent(QMouseEvent *event) {
 }
 
 void NoteEditor::insertFromMimeData(const QMimeData *source) {
-  if (source->hasText()) {
+  if (source->hasText() &&
+      source->text().size() >= PasteStreamer::StreamChars) {
+    // Too large to clean and insert at once; skips URL shortening
+    m_pasteStreamer->start(source->text(), pasteOptions(Settings::instance()),
+                           textCursor());
+  } else if (source->hasText()) {
     QString text = source->text();
     // Apply cleanup based on settings
     Settings *s = Settings::instance();
     text = cleanupPastedText(text, s);
 
     // Auto-shorten URLs on paste if enabled
+    QList<QPair<int, QString>> links;
     if (s->linkAutoShortenEnabled()) {
-      // Pattern for long URLs (not already shortened)
-      static QRegularExpression longUrlPattern(
-          R"((https?://(?!is\.gd|v\.gd|tinyurl\.com|bit\.ly|t\.co|goo\.gl|ow\.ly|buff\.ly)[^\s<>\[\]]{40,}))",
-          QRegularExpression::CaseInsensitiveOption);
-
-      QRegularExpressionMatchIterator it = longUrlPattern.globalMatch(text);
-      while (it.hasNext()) {
-        QRegularExpressionMatch match = it.next();
-        QString longUrl = match.captured(1);
-
-        // Shorten asynchronously and replace in editor after insert
-        QString serviceName = s->urlShortenerService();
-        UrlShortener::Service service =
-            UrlShortener::stringToService(serviceName);
-
-        auto *shortener = new UrlShortener(const_cast<NoteEditor *>(this));
-        connect(shortener, &UrlShortener::shortened, this,
-                [this, shortener, longUrl](const QString &shortUrl) {
-                  // Find and replace the long URL in the text
-                  QString content = toPlainText();
-                  if (content.contains(longUrl)) {
-                    content.replace(longUrl, shortUrl);
-                    QTextCursor cursor = textCursor();
-                    int pos = cursor.position();
-                    setPlainText(content);
-                    cursor.setPosition(qMin(pos, content.length()));
-                    setTextCursor(cursor);
-                  }
-                  shortener->deleteLater();
-                });
-        connect(shortener, &UrlShortener::error, shortener,
-                &QObject::deleteLater);
-        shortener->shortenUrl(longUrl, service);
-      }
+      text = shortenPastedLinks(text, links);
     }
 
     // Insert cleaned text
-    textCursor().insertText(text);
+    QTextCursor cursor = textCursor();
+    int start = cursor.selectionStart();
+    cursor.insertText(text);
+
+    // Each link is swapped for its short URL in place once that arrives
+    UrlShortener::Service service =
+        UrlShortener::stringToService(s->urlShortenerService());
+    for (const auto &[offset, url] : std::as_const(links)) {
+      QTextCursor link(document());
+      link.setPosition(start + offset);
+      link.setPosition(start + offset + url.size(), QTextCursor::KeepAnchor);
+      m_pendingLinks[url].append(link);
+      LinkShortener::instance()->shorten(url, service);
+    }
   } else {
     // Fall back to default handling for non-text (images, etc)
     QPlainTextEdit::insertFromMimeData(source);
   }
 }
 
+QString NoteEditor::shortenPastedLinks(const QString &text,
+                                      QList<QPair<int, QString>> &links) {
+  // Pattern for long URLs (not already shortened)
+  static QRegularExpression longUrlPattern(
+      R"((https?://(?!is\.gd|v\.gd|tinyurl\.com|bit\.ly|t\.co|goo\.gl|ow\.ly|buff\.ly)[^\s<>\[\]]{40,}))",
+      QRegularExpression::CaseInsensitiveOption);
+
+  // Links shortened before go in short right away; the others are
+  // collected with their offsets in the returned text
+  UrlShortener::Service service = UrlShortener::stringToService(
+      Settings::instance()->urlShortenerService());
+  QString result;
+  qsizetype last = 0;
+  QRegularExpressionMatchIterator it = longUrlPattern.globalMatch(text);
+  while (it.hasNext()) {
+    QRegularExpressionMatch match = it.next();
+    QString longUrl = match.captured(1);
+    result += QStringView(text).mid(last, match.capturedStart(1) - last);
+    last = match.capturedEnd(1);
+
+    QString shortUrl = LinkShortener::instance()->cached(longUrl, service);
+    if (shortUrl.isEmpty()) {
+      links.append({int(result.size()), longUrl});
+      result += longUrl;
+    } else {
+      result += shortUrl;
+    }
+  }
+  result += QStringView(text).mid(last);
+  return result;
+}
+
+void NoteEditor::replaceShortenedLink(const QString &url,
+                                      const QString &shortUrl) {
+  // Only where the long URL still is, in the shown document
+  QList<QTextCursor> links;
+  for (const QTextCursor &link : m_pendingLinks.take(url)) {
+    if (link.document() == document() && link.selectedText() == url)
+      links.append(link);
+  }
+  if (links.isEmpty())
+    return;
+
+  // One undo step per URL, however often it was pasted
+  QTextCursor block(document());
+  block.beginEditBlock();
+  for (QTextCursor &link : links)
+    link.insertText(shortUrl);
+  block.endEditBlock();
+}
+
 QMimeData *NoteEditor::createMimeDataFromSelection() const {
   QMimeData *mimeData = QPlainTextEdit::createMimeDataFromSelection();
   if (!mimeData || !mimeData->hasText())
@@ -854,15 +1123,28 @@ QMimeData *NoteEditor::createMimeDataFromSelection() const {
   // Skip keywords on copy (math, calc, code, checklist, etc)
   if (s->skipKeywordsOnCopy()) {
     // Remove mode keywords at the start of lines (like "math", "calc", "code")
-    static QRegularExpression keywordPattern(
-        R"(^(math|calc|calculator|hesap|kod|code|checklist|liste|check|todo|"
-        R"kontrol|currency|doviz|döviz|para|timer|zamanlayici|zamanlayıcı|"
-        R"reminder|hatirlatici|hatırlatıcı)\s*\n?)",
-        QRegularExpression::CaseInsensitiveOption |
-            QRegularExpression::MultilineOption);
-    QString cleaned = text;
-    cleaned.remove(keywordPattern);
-    if (cleaned != text) {
+    static const AhoCorasick keywords(
+        {"math", "calc", "calculator", "hesap", "kod", "code", "checklist",
+         "liste", "check", "todo", "kontrol", "currency", "doviz", "döviz",
+         "para", "timer", "zamanlayici", "zamanlayıcı", "reminder",
+         "hatirlatici", "hatırlatıcı"},
+        AhoCorasick::CaseInsensitive | AhoCorasick::WholeWords);
+    QString cleaned;
+    int copied = 0;
+    for (const AhoCorasick::Match &match : keywords.findAll(text)) {
+      if (match.start < copied ||
+          (match.start != 0 && text[match.start - 1] != '\n'))
+        continue;
+
+      // The keyword and the whitespace after it
+      int end = match.start + match.length;
+      while (end < text.size() && text[end].isSpace())
+        ++end;
+      cleaned += QStringView(text).mid(copied, match.start - copied);
+      copied = end;
+    }
+    if (copied > 0) {
+      cleaned += QStringView(text).mid(copied);
       text = cleaned;
       modified = true;
     }
@@ -984,8 +1266,8 @@ void NoteEditor::showKeywordTutorial(const QString &keyword) {
   QString lowerKeyword = keyword.toLower();
 
   if (lowerKeyword == "calc") {
-    // Auto-refresh currency/crypto rates when entering calc mode
-    CurrencyConverter::instance()->refreshRates();
+    // Refresh currency/crypto rates if the refresh interval has passed
+    CurrencyConverter::instance()->refreshRatesIfStale();
 
     placeholder = "\n━━━ CALC MODE ━━━\n\n"
                   "CALCULATE: Add '=' at end of line\n"
@@ -1184,23 +1466,13 @@ void NoteEditor::checkForKeywordTutorial() {
     qDebug() << "  Tutorial active but no hide triggered";
   }
 
-  // Get aliases and try to resolve
-  Settings *s = Settings::instance();
-  QMap<QString, QString> aliases = s->keywordAliases();
-  QString resolvedKeyword = checkLine;
-  for (auto it = aliases.constBegin(); it != aliases.constEnd(); ++it) {
-    if (!it.value().isEmpty() && it.value().toLower() == checkLine) {
-      resolvedKeyword = it.key();
-      break;
-    }
-  }
-
-  for (const QString &kw : keywords) {
-    if (resolvedKeyword == kw || checkLine == kw) {
-      // Show tutorial every time the keyword is typed EXACTLY
-      showKeywordTutorial(kw);
-      return;
-    }
+  // Resolve aliases through the shared keyword table
+  QString resolvedKeyword =
+      Settings::instance()->keywordTable()->resolve(checkLine);
+  if (keywords.contains(resolvedKeyword)) {
+    // Show tutorial every time the keyword is typed EXACTLY
+    showKeywordTutorial(resolvedKeyword);
+    return;
   }
 
   // For timer/paste with arguments (timer 5, paste(,)), clear tutorial and
@@ -1273,45 +1545,50 @@ void NoteEditor::updateGhostText() {
     return;
   }
 
-  // Get current word (from start of word to cursor)
+  // The command popup completes commands while it is open
+  QString prefix = completionPrefix();
+  QString completion;
+  if (!prefix.isEmpty() && !(m_popupActive && prefix.startsWith('/')))
+    completion = m_modeHelper->completion(prefix);
+
+  if (!completion.isEmpty()) {
+    // Show ghost text (remainder after prefix)
+    QString remainder = completion.mid(prefix.length());
+    m_ghostCompletion = completion;
+
+    // Position ghost label inline right after cursor
+    QRect cursorRect = this->cursorRect();
+    m_ghostLabel->setText(remainder);
+    m_ghostLabel->setFont(font());
+    m_ghostLabel->adjustSize();
+    // Position at cursor location within viewport
+    int x = cursorRect.right() + 1; // Just after cursor
+    int y = cursorRect.top();       // Same line as cursor
+    m_ghostLabel->move(x, y);
+    m_ghostLabel->raise(); // Ensure it's on top
+    m_ghostLabel->show();
+    return;
+  }
+
+  clearGhostText();
+}
+
+QString NoteEditor::completionPrefix() const {
+  // The word before the cursor, with the '/' of a command at line start
   QTextCursor cursor = textCursor();
   QString lineText = cursor.block().text();
   int posInLine = cursor.positionInBlock();
 
-  // Find word start
   int wordStart = posInLine;
   while (wordStart > 0 && (lineText[wordStart - 1].isLetterOrNumber() ||
                            lineText[wordStart - 1] == '_')) {
     wordStart--;
   }
-
-  QString prefix = lineText.mid(wordStart, posInLine - wordStart);
-  if (prefix.length() >= 1) {
-    QStringList variables = m_modeHelper->getVariables();
-    // Find first matching variable
-    for (const QString &var : variables) {
-      if (var.startsWith(prefix, Qt::CaseInsensitive) && var != prefix) {
-        // Show ghost text (remainder after prefix)
-        QString remainder = var.mid(prefix.length());
-        m_ghostCompletion = var;
-
-        // Position ghost label inline right after cursor
-        QRect cursorRect = this->cursorRect();
-        m_ghostLabel->setText(remainder);
-        m_ghostLabel->setFont(font());
-        m_ghostLabel->adjustSize();
-        // Position at cursor location within viewport
-        int x = cursorRect.right() + 1; // Just after cursor
-        int y = cursorRect.top();       // Same line as cursor
-        m_ghostLabel->move(x, y);
-        m_ghostLabel->raise(); // Ensure it's on top
-        m_ghostLabel->show();
-        return;
-      }
-    }
+  if (wordStart > 0 && lineText[wordStart - 1] == '/' &&
+      lineText.left(wordStart - 1).trimmed().isEmpty()) {
+    wordStart--;
   }
-
-  clearGhostText();
+  return lineText.mid(wordStart, posInLine - wordStart);
 }
 
 void NoteEditor::clearGhostText() {
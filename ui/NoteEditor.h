@@ -1,6 +1,9 @@
 #ifndef LINNOTE_NOTEEDITOR_H
 #define LINNOTE_NOTEEDITOR_H
 
+#include "DocumentCache.h"
+#include "HighlighterHost.h"
+#include "core/LanguageDetector.h"
 #include "core/NoteMode.h"
 #include <QPlainTextEdit>
 
@@ -9,6 +12,9 @@ class QLabel;
 class CommandPopup;
 class MarkdownHighlighter;
 class CodeHighlighter;
+class HighlightScheduler;
+class PasteStreamer;
+class PieceTable;
 class Settings;
 class QMimeData;
 
@@ -34,6 +40,28 @@ public:
   void setContent(const QString &content);
   void appendContent(const QString &text);
 
+  // True, once, if the document changed without a contentsEdited signal:
+  // while signals were blocked, or when the whole text was replaced
+  bool takeUnreportedEdits();
+
+  // Show a note in its own document. Documents of recently shown notes are
+  // kept with their undo history and highlighting (see DocumentCache), and
+  // reused while the note is still at @p revision. setContent() moves to a
+  // scratch document that belongs to no note.
+  void showNote(const QString &noteId, quint64 revision,
+                const PieceTable &content);
+  QString noteId() const { return m_noteId; } // Empty for the scratch one
+  void setNoteRevision(quint64 revision);     // The shown document matches
+  void forgetNote(const QString &noteId);
+
+  // Documents filled ahead of time by NotePrefetcher: an empty one set up
+  // for a note in @p mode, and handing it to the cache once filled, behind
+  // the shown note. A note that got a document meanwhile keeps that one.
+  DocumentCache::Entry createNoteDocument(NoteMode mode);
+  void addNoteDocument(const QString &noteId,
+                       const DocumentCache::Entry &entry);
+  bool hasNoteDocument(const QString &noteId, quint64 revision) const;
+
   // Mode support
   void setMode(NoteMode mode);
   NoteMode mode() const;
@@ -61,6 +89,8 @@ public slots:
 
 signals:
   void contentChanged();
+  // One document change in plain text terms, before contentChanged
+  void contentsEdited(int position, int charsRemoved, const QString &added);
   void checkboxToggled();
   void commandExecuted(const QString &command);
   void autoPasteStarted();
@@ -78,6 +108,7 @@ private slots:
   void onPopupDismissed();
   void checkForKeywordTutorial();
   void checkForAutoConversion();
+  void replaceShortenedLink(const QString &url, const QString &shortUrl);
 
 private:
   void setupAppearance();
@@ -88,11 +119,37 @@ private:
   void hideCommandPopup();
   void updateGhostText(); // Ghost text autocomplete
   void clearGhostText();
+  QString completionPrefix() const; // What ghost text completes
   QString cleanupPastedText(const QString &text, Settings *s);
+  // Swaps in known short URLs; the other long ones are returned in @p links
+  QString shortenPastedLinks(const QString &text,
+                             QList<QPair<int, QString>> &links);
+  void updateHighlighting();
+  // For @p entry's document, which gets a CodeHighlighter if it needs one
+  QList<HighlighterHost::Lexer *> lexersFor(NoteMode mode,
+                                            DocumentCache::Entry &entry);
+  void addCodeHighlighter(DocumentCache::Entry &entry);
+  void updateCodeLanguage(bool keepIfUnsure);
+  QString leadingText(int maxChars) const;
+  void reportContentsChange(int position, int charsRemoved, int charsAdded);
+  DocumentCache::Entry createDocument();
+  void applyDocumentFormat(QTextDocument *doc);
+  void attachDocument(const DocumentCache::Entry &entry);
+  void showScratch();
+  void saveViewState();
+  DocumentCache::Entry &shownEntry(); // The scratch one if no note's
 
   ModeHelper *m_modeHelper;
   MarkdownHighlighter *m_markdownHighlighter; // Markdown syntax highlighting
-  CodeHighlighter *m_codeHighlighter;         // Code syntax highlighting
+  CodeHighlighter *m_codeHighlighter;         // The shown document's
+  HighlighterHost *m_highlighter;             // The shown document's host
+  HighlightScheduler *m_highlightScheduler;   // Defers large documents
+  DocumentCache *m_documents;                 // Recent notes' documents
+  PasteStreamer *m_pasteStreamer;             // Large pastes, in chunks
+  DocumentCache::Entry m_scratch;             // For text of no note
+  QString m_noteId;                           // Whose document is shown
+  QList<QMetaObject::Connection> m_documentConnections;
+  LanguageDetector m_languageDetector;        // Picks the code language
   QLabel *m_mathOverlay;                      // Legacy, kept for compatibility
   QLabel *m_tutorialLabel;                    // Shows keyword tutorials
   QLabel *m_ghostLabel;                       // Ghost text autocomplete
@@ -107,7 +164,10 @@ private:
   QString m_tutorialContent;   // Actual tutorial text content
   QString m_ghostCompletion;   // Current ghost text completion
   bool m_autoPasteActive = false;
+  bool m_unreportedEdits = false;
   QString m_autoPasteDelimiter;
+  // Pasted long URLs being shortened, and where they are in the document
+  QHash<QString, QList<QTextCursor>> m_pendingLinks;
 };
 
 #endif // LINNOTE_NOTEEDITOR_H
@@ -0,0 +1,214 @@
+#include "NotePrefetcher.h"
+#include "NoteEditor.h"
+#include "core/NoteManager.h"
+#include "core/PieceTable.h"
+#include <QDeadlineTimer>
+#include <QTextCursor>
+#include <QTextDocument>
+
+namespace {
+
+// Ends of the pieces a note is appended in, each up to ChunkChars and
+// ending after a line break when there is one, so each append starts a
+// block instead of re-highlighting the last one
+QVector<qsizetype> chunkEnds(const QString &text) {
+  QVector<qsizetype> ends;
+  qsizetype start = 0;
+  while (start < text.size()) {
+    qsizetype end = qMin(start + NotePrefetcher::ChunkChars, text.size());
+    if (end < text.size()) {
+      qsizetype lineBreak = text.lastIndexOf(QLatin1Char('\n'), end - 1);
+      if (lineBreak >= start)
+        end = lineBreak + 1;
+    }
+    ends.append(end);
+    start = end;
+  }
+  return ends;
+}
+
+} // namespace
+
+NotePrefetcher::NotePrefetcher(NoteManager *notes, NoteEditor *editor,
+                               QObject *parent)
+    : QObject(parent), m_notes(notes), m_editor(editor) {
+  m_idleTimer.setSingleShot(true);
+  m_idleTimer.setInterval(IdleDelayMs);
+  connect(&m_idleTimer, &QTimer::timeout, this,
+          &NotePrefetcher::prefetchNext);
+
+  m_sliceTimer.setSingleShot(true);
+  m_sliceTimer.setInterval(0); // Next event loop turn, after input
+  connect(&m_sliceTimer, &QTimer::timeout, this, &NotePrefetcher::fillSlice);
+
+  m_pool.setMaxThreadCount(1);
+
+  connect(m_notes, &NoteManager::currentNoteChanged, this,
+          &NotePrefetcher::onCurrentNoteChanged);
+  connect(m_notes, &NoteManager::noteContentChanged, this,
+          &NotePrefetcher::onNoteChanged);
+  connect(m_notes, &NoteManager::noteDeleted, this,
+          &NotePrefetcher::onNoteChanged);
+  connect(m_editor, &NoteEditor::contentChanged, this,
+          &NotePrefetcher::postpone);
+}
+
+NotePrefetcher::~NotePrefetcher() {
+  // The worker posts its result to this object
+  m_pool.waitForDone();
+}
+
+void NotePrefetcher::onCurrentNoteChanged(int index, const Note &note) {
+  Q_UNUSED(index)
+  m_recent.removeOne(note.id());
+  m_recent.prepend(note.id());
+  while (m_recent.size() > RecentNotes + 1)
+    m_recent.removeLast();
+
+  // Shown now, so the editor fills its own document
+  if (note.id() == m_noteId)
+    cancel();
+  m_tried.clear();
+  postpone();
+}
+
+void NotePrefetcher::onNoteChanged(const QString &id) {
+  if (m_notes->indexOfNote(id) < 0)
+    m_recent.removeOne(id);
+  if (id == m_noteId) {
+    // Started over from the new text later
+    cancel();
+    m_tried.remove(id);
+    postpone();
+  }
+}
+
+void NotePrefetcher::postpone() {
+  // A note being filled carries on once things are quiet again
+  m_sliceTimer.stop();
+  m_idleTimer.start();
+}
+
+void NotePrefetcher::prefetchNext() {
+  if (m_waiting)
+    return;
+  if (m_entry.document) {
+    m_sliceTimer.start();
+    return;
+  }
+
+  for (const QString &id : candidates()) {
+    Note note = m_notes->noteAt(m_notes->indexOfNote(id));
+    if (!wants(note))
+      continue;
+
+    m_tried.insert(id);
+    m_noteId = id;
+    m_revision = note.revision();
+    m_mode = note.mode();
+    m_waiting = true;
+
+    // A snapshot can be read on another thread while the note is edited
+    quint64 generation = m_generation;
+    PieceTable snapshot = note.contentSnapshot();
+    m_pool.start([this, generation, snapshot]() {
+      QString text = snapshot.toString();
+      QVector<qsizetype> ends = chunkEnds(text);
+      QMetaObject::invokeMethod(
+          this, [this, generation, text, ends]() {
+            onTextReady(generation, text, ends);
+          },
+          Qt::QueuedConnection);
+    });
+    return;
+  }
+}
+
+QStringList NotePrefetcher::candidates() const {
+  // Where next/previous go first, then back to the notes shown before
+  QStringList ids;
+  int count = m_notes->noteCount();
+  int current = m_notes->currentIndex();
+  if (current < 0 || count < 2)
+    return ids;
+  for (int step = 1; step <= Neighbours; ++step) {
+    ids << m_notes->noteAt((current + step) % count).id();
+    ids << m_notes->noteAt(((current - step) % count + count) % count).id();
+  }
+  ids << m_recent;
+  ids.removeDuplicates();
+  ids.removeAll(m_notes->noteAt(current).id());
+  return ids;
+}
+
+bool NotePrefetcher::wants(const Note &note) const {
+  if (m_notes->indexOfNote(note.id()) < 0 || m_tried.contains(note.id()))
+    return false;
+  if (note.isLocked() || note.mode() == NoteMode::Code)
+    return false;
+  if (note.contentSnapshot().size() > MaxNoteChars)
+    return false;
+  return !m_editor->hasNoteDocument(note.id(), note.revision());
+}
+
+void NotePrefetcher::onTextReady(quint64 generation, const QString &text,
+                                 const QVector<qsizetype> &chunkEnds) {
+  if (generation != m_generation)
+    return;
+  m_waiting = false;
+
+  // Like setPlainText(), the fill doesn't go on the undo stack
+  m_entry = m_editor->createNoteDocument(m_mode);
+  m_entry.revision = m_revision;
+  m_entry.document->setUndoRedoEnabled(false);
+  m_text = text;
+  m_chunkEnds = chunkEnds;
+  m_nextChunk = 0;
+  if (!m_idleTimer.isActive())
+    m_sliceTimer.start();
+}
+
+void NotePrefetcher::fillSlice() {
+  // Each append is highlighted as it goes in, so it counts against the slice
+  QDeadlineTimer sliceEnd(SliceMs);
+  QTextCursor cursor(m_entry.document);
+  cursor.movePosition(QTextCursor::End);
+  while (m_nextChunk < m_chunkEnds.size() && !sliceEnd.hasExpired()) {
+    qsizetype start = m_nextChunk > 0 ? m_chunkEnds[m_nextChunk - 1] : 0;
+    cursor.insertText(m_text.mid(start, m_chunkEnds[m_nextChunk] - start));
+    ++m_nextChunk;
+  }
+
+  if (m_nextChunk < m_chunkEnds.size())
+    m_sliceTimer.start();
+  else
+    finish();
+}
+
+void NotePrefetcher::finish() {
+  m_entry.document->setUndoRedoEnabled(true);
+
+  // Only if the note is still what the document was filled from
+  int index = m_notes->indexOfNote(m_noteId);
+  Note note = m_notes->noteAt(index);
+  if (index >= 0 && !note.isLocked() && note.revision() == m_revision)
+    m_editor->addNoteDocument(m_noteId, m_entry);
+  else
+    m_entry.document->deleteLater();
+
+  m_entry = DocumentCache::Entry();
+  cancel(); // Nothing left to cancel, just the rest to clear
+  prefetchNext();
+}
+
+void NotePrefetcher::cancel() {
+  ++m_generation;
+  m_waiting = false;
+  m_sliceTimer.stop();
+  if (m_entry.document)
+    m_entry.document->deleteLater();
+  m_entry = DocumentCache::Entry();
+  m_noteId.clear();
+  m_text.clear();
+  m_chunkEnds.clear();
+}
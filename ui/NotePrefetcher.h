@@ -0,0 +1,87 @@
+#ifndef LINNOTE_NOTEPREFETCHER_H
+#define LINNOTE_NOTEPREFETCHER_H
+
+#include "DocumentCache.h"
+#include "core/NoteMode.h"
+#include <QObject>
+#include <QSet>
+#include <QStringList>
+#include <QThreadPool>
+#include <QTimer>
+#include <QVector>
+
+class Note;
+class NoteEditor;
+class NoteManager;
+
+/**
+ * @brief Fills the documents of the notes likely to be shown next
+ *
+ * Switching to a note the editor has no document for fills and highlights
+ * one on the spot. Once the app has been idle for IdleDelayMs, the
+ * prefetcher takes the notes either side of the current one (where
+ * next/previous go) and the most recently shown ones, and builds their
+ * documents ahead of time: the text is put together on a worker thread,
+ * then appended and highlighted in SliceMs slices from the event loop.
+ * Finished documents go to the editor's DocumentCache, behind the note on
+ * screen.
+ *
+ * Typing or switching notes puts the work off again. Locked notes, Code
+ * notes and notes over MaxNoteChars are left alone. A Code note's language
+ * is only detected once it is shown, and a change from the fallback
+ * highlights the whole document again, so filling one early saves little.
+ */
+class NotePrefetcher : public QObject {
+  Q_OBJECT
+
+public:
+  static constexpr int IdleDelayMs = 500;
+  static constexpr int SliceMs = 4;
+  static constexpr int Neighbours = 1;  // Each side of the current note
+  static constexpr int RecentNotes = 3; // Shown before the current one
+  static constexpr qsizetype ChunkChars = 16 * 1024; // Appended at a time
+  static constexpr qsizetype MaxNoteChars =
+      DocumentCache::MaxChars / DocumentCache::MaxDocuments;
+
+  NotePrefetcher(NoteManager *notes, NoteEditor *editor,
+                 QObject *parent = nullptr);
+  ~NotePrefetcher() override;
+
+private slots:
+  void onCurrentNoteChanged(int index, const Note &note);
+  void onNoteChanged(const QString &id);
+  void postpone();
+  void prefetchNext();
+  void fillSlice();
+
+private:
+  QStringList candidates() const;
+  bool wants(const Note &note) const;
+  void onTextReady(quint64 generation, const QString &text,
+                   const QVector<qsizetype> &chunkEnds);
+  void finish();
+  void cancel();
+
+  NoteManager *m_notes;
+  NoteEditor *m_editor;
+  QStringList m_recent; // Shown note ids, most recent first
+  // Prefetched since the current note was shown, so documents the cache
+  // evicts aren't built over and over
+  QSet<QString> m_tried;
+  QTimer m_idleTimer;
+  QTimer m_sliceTimer;
+  QThreadPool m_pool;       // One worker, waited for on destruction
+  quint64 m_generation = 0; // Bumped to drop the worker's result
+
+  // The note being prefetched
+  QString m_noteId;
+  quint64 m_revision = 0;
+  NoteMode m_mode = NoteMode::PlainText;
+  bool m_waiting = false;       // For the worker
+  DocumentCache::Entry m_entry; // Being filled
+  QString m_text;
+  QVector<qsizetype> m_chunkEnds; // At line breaks where possible
+  int m_nextChunk = 0;
+};
+
+#endif // LINNOTE_NOTEPREFETCHER_H
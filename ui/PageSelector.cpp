@@ -340,7 +340,7 @@ void PageSelector::updateList() {
       title = note.created().toString("ddd hh:mm");
       break;
     case 2: { // FirstLine only
-      QString content = note.content().trimmed();
+      QString content = note.leadingContent(Note::TitleChars).trimmed();
       if (content.isEmpty()) {
         title = note.created().toString("ddd hh:mm");
       } else {
@@ -0,0 +1,146 @@
+#include "PasteStreamer.h"
+#include <QFrame>
+#include <QHBoxLayout>
+#include <QLabel>
+#include <QPlainTextEdit>
+#include <QProgressBar>
+#include <QPushButton>
+
+PasteStreamer::PasteStreamer(QPlainTextEdit *editor)
+    : QObject(editor), m_editor(editor) {
+  m_pool.setMaxThreadCount(1);
+  m_progressTimer.setSingleShot(true);
+  m_progressTimer.setInterval(ProgressDelayMs);
+  connect(&m_progressTimer, &QTimer::timeout, this,
+          &PasteStreamer::showProgress);
+}
+
+PasteStreamer::~PasteStreamer() {
+  // The worker posts to this object; stop it and wait
+  m_generation.fetchAndAddOrdered(1);
+  m_pool.waitForDone();
+}
+
+void PasteStreamer::start(const QString &text,
+                          const PasteCleaner::Options &options,
+                          const QTextCursor &cursor, const QString &leading) {
+  cancel();
+  m_cursor = cursor;
+  m_leading = leading;
+  m_size = text.size();
+  m_consumed = 0;
+  m_firstChunk = true;
+  m_wasReadOnly = m_editor->isReadOnly();
+  m_editor->setReadOnly(true);
+  m_progressTimer.start();
+
+  int generation = m_generation.loadAcquire();
+  m_pool.start([this, generation, text, options]() {
+    PasteCleaner cleaner(options);
+    while (!cleaner.atEnd(text)) {
+      // Stay at most ChunksInFlight ahead of the editor
+      while (!m_freeChunks.tryAcquire(1, 50)) {
+        if (m_generation.loadAcquire() != generation)
+          return;
+      }
+      if (m_generation.loadAcquire() != generation) {
+        m_freeChunks.release();
+        return;
+      }
+
+      QString chunk = cleaner.next(text, ChunkChars);
+      qsizetype consumed = qMin(cleaner.position(), text.size());
+      bool last = cleaner.atEnd(text);
+      QMetaObject::invokeMethod(
+          this,
+          [this, generation, chunk, consumed, last]() {
+            insertChunk(generation, chunk, consumed, last);
+          },
+          Qt::QueuedConnection);
+    }
+  });
+}
+
+void PasteStreamer::cancel() {
+  if (!isActive())
+    return;
+  m_generation.fetchAndAddOrdered(1);
+  stop();
+}
+
+void PasteStreamer::insertChunk(int generation, const QString &chunk,
+                                qsizetype consumed, bool last) {
+  m_freeChunks.release();
+  if (generation != m_generation.loadAcquire() || m_cursor.isNull())
+    return;
+
+  // Each chunk is laid out and highlighted on its own, but all of them
+  // undo as one
+  if (m_firstChunk) {
+    m_cursor.beginEditBlock();
+    m_cursor.insertText(m_leading + chunk);
+    m_firstChunk = false;
+  } else {
+    m_cursor.joinPreviousEditBlock();
+    m_cursor.insertText(chunk);
+  }
+  m_cursor.endEditBlock();
+
+  m_consumed = consumed;
+  if (m_progressBar)
+    m_progressBar->setValue(m_size > 0 ? int(m_consumed * 1000 / m_size) : 0);
+  if (!last)
+    return;
+
+  QTextCursor cursor = m_cursor;
+  stop();
+  if (cursor.document() == m_editor->document())
+    m_editor->setTextCursor(cursor);
+  emit finished();
+}
+
+void PasteStreamer::showProgress() {
+  if (!m_progress) {
+    m_progress = new QFrame(m_editor);
+    m_progress->setStyleSheet(R"(
+      QFrame {
+        background: rgba(30, 30, 46, 0.9);
+        border: 1px solid #45475a;
+        border-radius: 6px;
+      }
+      QLabel {
+        color: #cdd6f4;
+        border: none;
+        background: transparent;
+      }
+    )");
+    auto *layout = new QHBoxLayout(m_progress);
+    layout->setContentsMargins(10, 6, 6, 6);
+    layout->addWidget(new QLabel(tr("Pasting..."), m_progress));
+    m_progressBar = new QProgressBar(m_progress);
+    m_progressBar->setRange(0, 1000);
+    m_progressBar->setTextVisible(false);
+    layout->addWidget(m_progressBar, 1);
+    auto *cancelButton = new QPushButton(tr("Cancel"), m_progress);
+    connect(cancelButton, &QPushButton::clicked, this, &PasteStreamer::cancel);
+    layout->addWidget(cancelButton);
+  }
+
+  // Along the bottom of the editor
+  const int margin = 8;
+  int height = m_progress->sizeHint().height();
+  m_progress->setGeometry(margin, m_editor->height() - height - margin,
+                          m_editor->width() - 2 * margin, height);
+  m_progressBar->setValue(m_size > 0 ? int(m_consumed * 1000 / m_size) : 0);
+  m_progress->show();
+  m_progress->raise();
+}
+
+void PasteStreamer::stop() {
+  m_cursor = QTextCursor();
+  m_leading.clear();
+  m_progressTimer.stop();
+  if (m_progress)
+    m_progress->hide();
+  m_editor->setReadOnly(m_wasReadOnly);
+}
@@ -0,0 +1,78 @@
+#ifndef LINNOTE_PASTESTREAMER_H
+#define LINNOTE_PASTESTREAMER_H
+
+#include "core/PasteCleaner.h"
+#include <QAtomicInt>
+#include <QObject>
+#include <QSemaphore>
+#include <QTextCursor>
+#include <QThreadPool>
+#include <QTimer>
+
+class QFrame;
+class QPlainTextEdit;
+class QProgressBar;
+
+/**
+ * @brief Cleans and inserts a large paste without freezing the editor
+ *
+ * The paste is cleaned on a worker thread, ChunkChars of output at a time,
+ * and each chunk is inserted from the event loop as it arrives. The chunks
+ * share one undo step. The editor is read-only meanwhile. A paste that
+ * takes longer than ProgressDelayMs shows a progress bar with a Cancel
+ * button over the editor. Cancelling keeps what was inserted so far.
+ */
+class PasteStreamer : public QObject {
+  Q_OBJECT
+
+public:
+  static constexpr qsizetype StreamChars = 256 * 1024; // Less: paste at once
+  static constexpr qsizetype ChunkChars = 256 * 1024;
+  static constexpr int ChunksInFlight = 4; // Cleaned, not inserted yet
+  static constexpr int ProgressDelayMs = 300;
+
+  explicit PasteStreamer(QPlainTextEdit *editor);
+  ~PasteStreamer() override;
+
+  /**
+   * @brief Insert @p text, cleaned with @p options, at @p cursor
+   *
+   * Replaces the cursor's selection. @p leading goes in before the first
+   * chunk, e.g. a line break to append with.
+   */
+  void start(const QString &text, const PasteCleaner::Options &options,
+             const QTextCursor &cursor, const QString &leading = QString());
+
+  bool isActive() const { return !m_cursor.isNull(); }
+
+public slots:
+  void cancel();
+
+signals:
+  void finished();
+
+private:
+  void insertChunk(int generation, const QString &chunk, qsizetype consumed,
+                   bool last);
+  void showProgress();
+  void stop();
+
+  QPlainTextEdit *m_editor;
+  QThreadPool m_pool; // One worker, waited for on destruction
+  QAtomicInt m_generation;
+  QSemaphore m_freeChunks{ChunksInFlight};
+  QTimer m_progressTimer;
+
+  // The paste in progress
+  QTextCursor m_cursor; // Null when there is none
+  QString m_leading;
+  qsizetype m_size = 0;
+  qsizetype m_consumed = 0; // Of m_size, inserted so far
+  bool m_firstChunk = true;
+  bool m_wasReadOnly = false;
+
+  QFrame *m_progress = nullptr; // Created on first use
+  QProgressBar *m_progressBar = nullptr;
+};
+
+#endif // LINNOTE_PASTESTREAMER_H
@@ -1,6 +1,7 @@
 #include "SearchModal.h"
 #include "core/NoteManager.h"
 #include "core/Theme.h"
+#include "storage/ClipboardHistory.h"
 #include <QApplication>
 #include <QLabel>
 #include <QScrollBar>
@@ -156,6 +157,10 @@ void SearchModal::applyTheme() {
 
 void SearchModal::updateTheme() { applyTheme(); }
 
+void SearchModal::setClipboardHistory(ClipboardHistory *history) {
+  m_clipboardHistory = history;
+}
+
 void SearchModal::showAndFocus() {
   applyTheme(); // Refresh theme
   populateNotes();
@@ -199,9 +204,7 @@ void SearchModal::keyPressEvent(QKeyEvent *event) {
   }
   if (event->key() == Qt::Key_Return || event->key() == Qt::Key_Enter) {
     if (m_noteList->currentItem()) {
-      int index = m_noteList->currentItem()->data(Qt::UserRole).toInt();
-      emit noteSelected(index);
-      hideModal();
+      activate(m_noteList->currentItem());
     }
     return;
   }
@@ -231,8 +234,17 @@ void SearchModal::onItemClicked(QListWidgetItem *item) {
 }
 
 void SearchModal::onItemDoubleClicked(QListWidgetItem *item) {
+  activate(item);
+}
+
+void SearchModal::activate(QListWidgetItem *item) {
+  // Clipboard entries have no note index
   int index = item->data(Qt::UserRole).toInt();
-  emit noteSelected(index);
+  if (index >= 0) {
+    emit noteSelected(index);
+  } else {
+    emit clipboardEntrySelected(item->data(Qt::UserRole + 1).toLongLong());
+  }
   hideModal();
 }
 
@@ -329,12 +341,68 @@ void SearchModal::filterNotes(const QString &filter) {
     m_noteList->setItemWidget(item, itemWidget);
   }
 
+  // Copied texts matching the filter, after the notes
+  if (!lowerFilter.isEmpty()) {
+    addClipboardEntries(lowerFilter);
+  }
+
   // Select first item
   if (m_noteList->count() > 0) {
     m_noteList->setCurrentRow(0);
   }
 }
 
+void SearchModal::addClipboardEntries(const QString &filter) {
+  if (!m_clipboardHistory)
+    return;
+
+  ThemeManager &tm = ThemeManager::instance();
+  ThemeColors themeColors = tm.currentTheme().colors(tm.isDarkMode());
+  QString textColor = themeColors.foreground.name();
+  QString subtextColor = themeColors.comment.name();
+  QString greenColor = themeColors.result.name();
+
+  const QList<ClipboardHistory::Entry> entries =
+      m_clipboardHistory->search(filter, 20);
+  for (const ClipboardHistory::Entry &entry : entries) {
+    QListWidgetItem *item = new QListWidgetItem();
+    item->setData(Qt::UserRole, -1);
+    item->setData(Qt::UserRole + 1, entry.id);
+
+    QWidget *itemWidget = new QWidget();
+    QVBoxLayout *itemLayout = new QVBoxLayout(itemWidget);
+    itemLayout->setContentsMargins(0, 4, 0, 4);
+    itemLayout->setSpacing(4);
+
+    QHBoxLayout *titleRow = new QHBoxLayout();
+    titleRow->setSpacing(8);
+    QLabel *kindLabel = new QLabel(tr("clipboard"));
+    kindLabel->setStyleSheet(
+        QString("color: %1; font-size: 11px; font-weight: bold; background: "
+                "transparent;")
+            .arg(greenColor));
+    titleRow->addWidget(kindLabel);
+
+    QString preview = entry.preview.simplified();
+    QLabel *previewLabel = new QLabel(truncateText(preview, 60));
+    previewLabel->setStyleSheet(
+        QString("color: %1; font-size: 13px; background: transparent;")
+            .arg(textColor));
+    titleRow->addWidget(previewLabel, 1);
+    itemLayout->addLayout(titleRow);
+
+    QLabel *dateLabel = new QLabel(formatDate(entry.usedAt));
+    dateLabel->setStyleSheet(
+        QString("color: %1; font-size: 11px; background: transparent;")
+            .arg(subtextColor));
+    itemLayout->addWidget(dateLabel);
+
+    item->setSizeHint(itemWidget->sizeHint() + QSize(0, 20));
+    m_noteList->addItem(item);
+    m_noteList->setItemWidget(item, itemWidget);
+  }
+}
+
 QString SearchModal::truncateText(const QString &text, int maxLength) const {
   if (text.length() <= maxLength) {
     return text;
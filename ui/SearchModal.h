@@ -9,6 +9,7 @@
 #include <QPushButton>
 #include <QVBoxLayout>
 
+class ClipboardHistory;
 class NoteManager;
 
 /**
@@ -25,9 +26,11 @@ public:
   void showAndFocus();
   void hideModal();
   void updateTheme(); // Call when theme changes
+  void setClipboardHistory(ClipboardHistory *history); // Searched too
 
 signals:
   void noteSelected(int noteIndex);
+  void clipboardEntrySelected(qint64 id);
   void dismissed();
 
 protected:
@@ -44,10 +47,13 @@ private:
   void applyTheme();
   void populateNotes();
   void filterNotes(const QString &filter);
+  void addClipboardEntries(const QString &filter);
+  void activate(QListWidgetItem *item);
   QString truncateText(const QString &text, int maxLength) const;
   QString formatDate(const QDateTime &date) const;
 
   NoteManager *m_noteManager;
+  ClipboardHistory *m_clipboardHistory = nullptr;
   QLineEdit *m_searchEdit;
   QListWidget *m_noteList;
   QPushButton *m_cancelBtn;
@@ -809,6 +809,19 @@ QWidget *SettingsDialog::createCalculatorPage() {
           &SettingsDialog::onAutoMathToggled);
   layout->addWidget(m_autoMathCheck);
 
+  // Exact decimal math (used automatically when a sheet has currencies)
+  QHBoxLayout *scaleRow = new QHBoxLayout();
+  scaleRow->addWidget(new QLabel(tr("Money decimal places:")));
+  m_decimalScaleSpin = new QSpinBox();
+  m_decimalScaleSpin->setRange(0, 18);
+  m_decimalScaleSpin->setToolTip(
+      tr("Sheets with currencies use exact decimal math at this precision"));
+  connect(m_decimalScaleSpin, QOverload<int>::of(&QSpinBox::valueChanged),
+          this, [](int value) { Settings::instance()->setDecimalScale(value); });
+  scaleRow->addWidget(m_decimalScaleSpin);
+  scaleRow->addStretch();
+  layout->addLayout(scaleRow);
+
   m_currencyCheck = new QCheckBox(tr("Enable currency conversion"));
   connect(m_currencyCheck, &QCheckBox::toggled, this,
           &SettingsDialog::onCurrencyToggled);
@@ -914,6 +927,71 @@ QWidget *SettingsDialog::createCalculatorPage() {
   updateLastRefreshLabel();
   layout->addWidget(m_lastRefreshLabel);
 
+  // Rate history, for "100 USD to EUR @2026-03-01"
+  QHBoxLayout *historyRow = new QHBoxLayout();
+  historyRow->addWidget(new QLabel(tr("History:")));
+
+  QPushButton *backfillBtn = new QPushButton(tr("Download Last Year"));
+  backfillBtn->setToolTip(
+      tr("Download daily rates for the past year (Frankfurter, free)"));
+  historyRow->addWidget(backfillBtn);
+
+  QPushButton *importBtn = new QPushButton(tr("Import CSV..."));
+  importBtn->setToolTip(tr("Import daily rates: date,currency,rate or "
+                           "date,EUR,GBP,... per USD"));
+  historyRow->addWidget(importBtn);
+
+  QLabel *historyStatus = new QLabel();
+  historyStatus->setStyleSheet("font-style: italic;");
+  historyRow->addWidget(historyStatus);
+  historyRow->addStretch();
+  layout->addLayout(historyRow);
+
+  connect(backfillBtn, &QPushButton::clicked, this, [this, historyStatus]() {
+    historyStatus->setText(tr("Downloading..."));
+    historyStatus->setStyleSheet("color: gray;");
+
+    CurrencyConverter *conv = CurrencyConverter::instance();
+    // One context per download, deleted when it ends: Qt drops both
+    // connections with it, and with the dialog if it closes first
+    QObject *request = new QObject(this);
+    // Only the backfill's own outcome: CSV imports and live rate fetches
+    // report through historyUpdated() and error() too
+    connect(conv, &CurrencyConverter::backfillFinished, request,
+            [historyStatus, request](int days) {
+              historyStatus->setText(tr("✅ %1 days").arg(days));
+              historyStatus->setStyleSheet("color: green;");
+              request->deleteLater();
+            });
+    connect(conv, &CurrencyConverter::backfillFailed, request,
+            [historyStatus, request](const QString &message) {
+              historyStatus->setText(tr("❌ %1").arg(message));
+              historyStatus->setStyleSheet("color: red;");
+              request->deleteLater();
+            });
+
+    QDate today = QDate::currentDate();
+    conv->backfillHistory(today.addYears(-1), today);
+  });
+
+  connect(importBtn, &QPushButton::clicked, this, [this, historyStatus]() {
+    QString path = QFileDialog::getOpenFileName(
+        this, tr("Import Rate History"), QDir::homePath(),
+        tr("CSV files (*.csv);;All files (*)"));
+    if (path.isEmpty())
+      return;
+
+    QString error;
+    int days = CurrencyConverter::instance()->importHistoryCsv(path, &error);
+    if (days < 0) {
+      historyStatus->setText(tr("❌ %1").arg(error));
+      historyStatus->setStyleSheet("color: red;");
+    } else {
+      historyStatus->setText(tr("✅ %1 days").arg(days));
+      historyStatus->setStyleSheet("color: green;");
+    }
+  });
+
   // Test API button
   QHBoxLayout *testRow = new QHBoxLayout();
   m_testApiBtn = new QPushButton(tr("Test API"));
@@ -1328,6 +1406,7 @@ void SettingsDialog::loadSettings() {
 
   // Calculator
   m_autoMathCheck->setChecked(s->autoMathEnabled());
+  m_decimalScaleSpin->setValue(s->decimalScale());
   m_currencyCheck->setChecked(s->currencyConversionEnabled());
   m_currencyCombo->setCurrentText(s->baseCurrency());
   m_apiKeyEdit->setText(s->currencyApiKey());
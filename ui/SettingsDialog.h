@@ -147,6 +147,7 @@ private:
 
   // Calculator page
   QCheckBox *m_autoMathCheck;
+  QSpinBox *m_decimalScaleSpin;
   QCheckBox *m_currencyCheck;
   QComboBox *m_currencyCombo;
   QComboBox *m_providerCombo;